@@ -63,6 +63,10 @@ if(USE_VOIP)
     list(APPEND CLIENT_DEFINITIONS USE_VOIP)
 endif()
 
+if(USE_WORLD_BENCH)
+    list(APPEND CLIENT_DEFINITIONS USE_WORLD_BENCH)
+endif()
+
 if(USE_MUMBLE)
     list(APPEND CLIENT_DEFINITIONS USE_MUMBLE)
     list(APPEND CLIENT_LIBRARY_SOURCES ${SOURCE_DIR}/client/libmumblelink.c)
@@ -0,0 +1,36 @@
+if(NOT BUILD_MULTIVIEW_TEST)
+    return()
+endif()
+
+if(NOT BUILD_CLIENT OR NOT BUILD_RENDERER_GL2)
+    message(FATAL_ERROR "BUILD_MULTIVIEW_TEST needs BUILD_CLIENT and BUILD_RENDERER_GL2")
+endif()
+
+# Headless EGL context in place of SDL, so this runs on llvmpipe
+find_package(OpenGL REQUIRED COMPONENTS EGL)
+
+set(MULTIVIEW_TEST_BINARY multiview_test)
+
+list(APPEND MULTIVIEW_TEST_BINARY_SOURCES
+    ${SOURCE_DIR}/tests/multiview_test.c
+    ${RENDERER_COMMON_SOURCES}
+    ${RENDERER_GL2_SOURCES}
+    ${RENDERER_GL2_SHADER_C_SOURCES}
+    ${DYNAMIC_RENDERER_SOURCES}
+    ${RENDERER_LIBRARY_SOURCES})
+
+add_executable(${MULTIVIEW_TEST_BINARY} ${MULTIVIEW_TEST_BINARY_SOURCES})
+
+# The test stands in for the client through refimport_t, like a renderer
+# library, and provides the GLimp and SDL_GL functions itself
+target_include_directories(     ${MULTIVIEW_TEST_BINARY} PRIVATE ${RENDERER_INCLUDE_DIRS})
+target_compile_definitions(     ${MULTIVIEW_TEST_BINARY} PRIVATE ${RENDERER_DEFINITIONS} USE_RENDERER_DLOPEN)
+target_compile_options(         ${MULTIVIEW_TEST_BINARY} PRIVATE ${RENDERER_COMPILE_OPTIONS})
+target_link_libraries(          ${MULTIVIEW_TEST_BINARY} PRIVATE ${COMMON_LIBRARIES} ${JPEG_LIBRARIES} OpenGL::EGL)
+
+enable_testing()
+
+add_test(NAME multiview COMMAND ${MULTIVIEW_TEST_BINARY})
+
+# No EGL context with OpenGL 4.5
+set_tests_properties(multiview PROPERTIES SKIP_RETURN_CODE 77)
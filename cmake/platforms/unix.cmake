@@ -21,5 +21,11 @@ list(APPEND COMMON_LIBRARIES
     m   # Math library
 )
 
+if(NOT EMSCRIPTEN)
+    list(APPEND COMMON_LIBRARIES
+        pthread # Job pool worker threads
+    )
+endif()
+
 list(APPEND CLIENT_DEFINITIONS USE_ICON)
 list(APPEND RENDERER_DEFINITIONS USE_ICON)
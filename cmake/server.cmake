@@ -25,6 +25,10 @@ if(USE_VOIP)
     list(APPEND SERVER_DEFINITIONS USE_VOIP)
 endif()
 
+if(USE_WORLD_BENCH)
+    list(APPEND SERVER_DEFINITIONS USE_WORLD_BENCH)
+endif()
+
 list(APPEND SERVER_BINARY_SOURCES
     ${SERVER_SOURCES}
     ${NULL_SOURCES}
@@ -7,18 +7,21 @@ set(COMMON_SOURCES
     ${SOURCE_DIR}/qcommon/cm_load.c
     ${SOURCE_DIR}/qcommon/cm_patch.c
     ${SOURCE_DIR}/qcommon/cm_polylib.c
+    ${SOURCE_DIR}/qcommon/cm_simd.c
     ${SOURCE_DIR}/qcommon/cm_test.c
     ${SOURCE_DIR}/qcommon/cm_trace.c
     ${SOURCE_DIR}/qcommon/cmd.c
     ${SOURCE_DIR}/qcommon/common.c
     ${SOURCE_DIR}/qcommon/cvar.c
     ${SOURCE_DIR}/qcommon/files.c
+    ${SOURCE_DIR}/qcommon/jobs.c
     ${SOURCE_DIR}/qcommon/md4.c
     ${SOURCE_DIR}/qcommon/md5.c
     ${SOURCE_DIR}/qcommon/msg.c
     ${SOURCE_DIR}/qcommon/net_chan.c
     ${SOURCE_DIR}/qcommon/net_ip.c
     ${SOURCE_DIR}/qcommon/huffman.c
+    ${SOURCE_DIR}/qcommon/profile.c
     ${SOURCE_DIR}/qcommon/q_math.c
     ${SOURCE_DIR}/qcommon/q_shared.c
     ${SOURCE_DIR}/qcommon/unzip.c
@@ -27,6 +30,7 @@ set(COMMON_SOURCES
     ${SOURCE_DIR}/qcommon/vm_armv7l.c
     ${SOURCE_DIR}/qcommon/vm_interpreted.c
     ${SOURCE_DIR}/qcommon/vm_powerpc.c
+    ${SOURCE_DIR}/qcommon/vm_prof.c
     ${SOURCE_DIR}/qcommon/vm_sparc.c
     ${SOURCE_DIR}/qcommon/vm_x86.c
 )
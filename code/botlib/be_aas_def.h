@@ -136,7 +136,7 @@ typedef struct aas_routingcache_s
 	struct aas_routingcache_s *prev, *next;
 	struct aas_routingcache_s *time_prev, *time_next;
 	unsigned char *reachabilities;				//reachabilities used for routing
-	unsigned short int traveltimes[1];			//travel time for every area (variable sized)
+	unsigned short int *traveltimes;			//travel time for every area
 } aas_routingcache_t;
 
 //fields for the routing algorithm
@@ -152,6 +152,25 @@ typedef struct aas_routingupdate_s
 	struct aas_routingupdate_s *prev;
 } aas_routingupdate_t;
 
+//routing updates bucketed on travel time
+typedef struct aas_routingqueue_s
+{
+	aas_routingupdate_t **buckets;				//circular array with a bucket per travel time
+	int mask;									//number of buckets minus one
+	int current;								//bucket with the lowest travel time in the queue
+	int numupdates;								//number of updates in the queue
+} aas_routingqueue_t;
+
+//BSP node with its plane packed in for the point and trace queries
+typedef struct aas_samplenode_s
+{
+	vec3_t normal;								//normal of the node plane
+	float dist;									//distance of the node plane
+	int children[2];							//same as the aas_node_t children
+	int planenum;								//plane of the node
+	int pad;
+} aas_samplenode_t;
+
 //reversed reachability link
 typedef struct aas_reversedlink_s
 {
@@ -246,6 +265,19 @@ typedef struct aas_s
 	//routing update
 	aas_routingupdate_t *areaupdate;
 	aas_routingupdate_t *portalupdate;
+	aas_routingqueue_t portalqueue;
+	//routing updates of the job threads prefetching routing caches
+	int numroutingthreads;
+	aas_routingupdate_t **threadareaupdate;
+	//BSP nodes with the planes packed in
+	aas_samplenode_t *samplenodes;
+	//deepest node every cell of the grid is completely inside of
+	int *samplegrid;
+	vec3_t samplegridorigin;
+	int samplegridshift;
+	int samplegridsize[3];
+	//number of times areas were enabled or disabled for routing
+	int routingchanges;
 	//number of routing updates during a frame (reset every frame)
 	int frameroutingupdates;
 	//reversed reachability links
@@ -258,6 +290,13 @@ typedef struct aas_s
 	//cache list sorted on time
 	aas_routingcache_t *oldestcache;		// start of cache list sorted on time
 	aas_routingcache_t *newestcache;		// end of cache list sorted on time
+	//routing cache read from the route cache file, the travel times
+	//and reachabilities of these point into the file data
+	aas_routingcache_t *filecache;
+	int numfilecache;
+	void *routecachefile;
+	int routecachefilesize;
+	int routecachemapped;
 	//maximum travel time through portal areas
 	int *portalmaxtraveltimes;
 	//areas the reachabilities go through
@@ -80,6 +80,16 @@ int AAS_Loaded(void)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+int AAS_NumAreas(void)
+{
+	return aasworld.numareas;
+} //end of the function AAS_NumAreas
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 int AAS_Initialized(void)
 {
 	return aasworld.initialized;
@@ -271,6 +281,8 @@ int AAS_LoadMap(const char *mapname)
 	} //end if
 	//
 	AAS_InitSettings();
+	//pack the BSP tree for the point and trace queries
+	AAS_InitSampling();
 	//initialize the AAS link heap for the new map
 	AAS_InitAASLinkHeap();
 	//initialize the AAS linked entities for the new map
@@ -323,6 +335,8 @@ void AAS_Shutdown(void)
 	AAS_FreeAASLinkHeap();
 	//free aas linked entities
 	AAS_FreeAASLinkedEntities();
+	//free the packed BSP tree
+	AAS_FreeSampling();
 	//free the aas data
 	AAS_DumpAASData();
 	//free the entities
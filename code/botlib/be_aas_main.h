@@ -51,6 +51,8 @@ int AAS_StartFrame(float time);
 int AAS_Initialized(void);
 //returns true if the AAS file is loaded
 int AAS_Loaded(void);
+//returns the number of areas in the AAS file
+int AAS_NumAreas(void);
 //returns the current time
 float AAS_Time(void);
 //
@@ -61,6 +61,15 @@ extern botlib_import_t botimport;
 #define INSIDEUNITS_WATERJUMP				15
 //area flag used for weapon jumping
 #define AREA_WEAPONJUMP						8192	//valid area to weapon jump to
+
+#ifndef BSPC
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AAS_AtomicIncrement(x)				(_InterlockedIncrement((volatile long *) &(x)) - 1)
+#else
+#define AAS_AtomicIncrement(x)				__sync_fetch_and_add(&(x), 1)
+#endif
+#endif //BSPC
 //number of reachabilities of each type
 int reach_swim;			//swim
 int reach_equalfloor;	//walk on floors with equal height
@@ -101,6 +110,12 @@ aas_lreachability_t *reachabilityheap;	//heap with reachabilities
 aas_lreachability_t *nextreachability;	//next free reachability from the heap
 aas_lreachability_t **areareachability;	//reachability links for every area
 int numlreachabilities;
+//areas calculated in parallel, see AAS_CalculateAreaReachabilities
+static int reach_threaded;				//true while the area jobs are running
+static volatile int reach_nextlink;		//next unused heap link while threaded
+static int reach_overflow;				//ran out of heap links while threaded
+static int *reach_pairarea;				//other area of the pair each link was created for
+static int **reach_linkcounter;			//counter of each link, they're counted after the merge
 
 //===========================================================================
 // returns the surface area of the given face
@@ -487,6 +502,22 @@ void AAS_ShutDownReachabilityHeap(void)
 aas_lreachability_t *AAS_AllocReachability(void)
 {
 	aas_lreachability_t *r;
+#ifndef BSPC
+	int index;
+
+	//the heap hasn't been touched since it was set up, so
+	//handing out consecutive links needs no free list
+	if (reach_threaded)
+	{
+		index = AAS_AtomicIncrement(reach_nextlink);
+		if (index >= AAS_MAX_REACHABILITYSIZE - 1)
+		{
+			reach_overflow = qtrue;
+			return NULL;
+		} //end if
+		return &reachabilityheap[index];
+	} //end if
+#endif //BSPC
 
 	if (!nextreachability) return NULL;
 	//make sure the error message only shows up once
@@ -513,6 +544,23 @@ void AAS_FreeReachability(aas_lreachability_t *lreach)
 	numlreachabilities--;
 } //end of the function AAS_FreeReachability
 //===========================================================================
+// the area jobs don't touch the shared counters, the links they create
+// are counted when they're merged so dropped links aren't counted
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_CountReachability(int *counter, aas_lreachability_t *lreach)
+{
+	if (reach_threaded)
+	{
+		reach_linkcounter[lreach - reachabilityheap] = counter;
+		return;
+	} //end if
+	(*counter)++;
+} //end of the function AAS_CountReachability
+//===========================================================================
 // returns qtrue if the area has reachability links
 //
 // Parameter:				-
@@ -891,7 +939,7 @@ int AAS_Reachability_Swim(int area1num, int area2num)
 					//link the reachability
 					lreach->next = areareachability[area1num];
 					areareachability[area1num] = lreach;
-					reach_swim++;
+					AAS_CountReachability(&reach_swim, lreach);
 					return qtrue;
 				} //end if
 			} //end if
@@ -1041,7 +1089,7 @@ int AAS_Reachability_EqualFloorHeight(int area1num, int area2num)
 		//avoid rather small areas
 		//if (AAS_AreaGroundFaceArea(lreach->areanum) < 500) lreach->traveltime += 100;
 		//
-		reach_equalfloor++;
+		AAS_CountReachability(&reach_equalfloor, lreach);
 		return qtrue;
 	} //end if
 	return qfalse;
@@ -1384,7 +1432,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 			//avoid rather small areas
 			//if (AAS_AreaGroundFaceArea(lreach->areanum) < 500) lreach->traveltime += 100;
 			//
-			reach_step++;
+			AAS_CountReachability(&reach_step, lreach);
 			return qtrue;
 		} //end if
 	} //end if
@@ -1437,7 +1485,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 					lreach->next = areareachability[area1num];
 					areareachability[area1num] = lreach;
 					//we've got another waterjump reachability
-					reach_waterjump++;
+					AAS_CountReachability(&reach_waterjump, lreach);
 					return qtrue;
 				} //end if
 			} //end if
@@ -1485,7 +1533,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 					lreach->next = areareachability[area1num];
 					areareachability[area1num] = lreach;
 					//we've got another barrierjump reachability
-					reach_barrier++;
+					AAS_CountReachability(&reach_barrier, lreach);
 					return qtrue;
 				} //end if
 			} //end if
@@ -1532,7 +1580,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 				lreach->next = areareachability[area1num];
 				areareachability[area1num] = lreach;
 				//we've got another walk reachability
-				reach_walk++;
+				AAS_CountReachability(&reach_walk, lreach);
 				return qtrue;
 			} //end if
 			// if no maximum fall height set or less than the max
@@ -1583,7 +1631,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 							lreach->next = areareachability[area1num];
 							areareachability[area1num] = lreach;
 							//
-							reach_walkoffledge++;
+							AAS_CountReachability(&reach_walkoffledge, lreach);
 							//NOTE: don't create a weapon (rl, bfg) jump reachability here
 							//because it interferes with other reachabilities
 							//like the ladder reachability
@@ -2360,9 +2408,9 @@ int AAS_Reachability_Jump(int area1num, int area2num)
 		areareachability[area1num] = lreach;
 		//
 		if ((traveltype & TRAVELTYPE_MASK) == TRAVEL_JUMP)
-			reach_jump++;
+			AAS_CountReachability(&reach_jump, lreach);
 		else
-			reach_walkoffledge++;
+			AAS_CountReachability(&reach_walkoffledge, lreach);
 	} //end if
 	return qfalse;
 } //end of the function AAS_Reachability_Jump
@@ -3909,7 +3957,7 @@ int AAS_Reachability_Grapple(int area1num, int area2num)
 		lreach->next = areareachability[area1num];
 		areareachability[area1num] = lreach;
 		//
-		reach_grapple++;
+		AAS_CountReachability(&reach_grapple, lreach);
 	} //end for
 	//
 	return qfalse;
@@ -4101,7 +4149,7 @@ int AAS_Reachability_WeaponJump(int area1num, int area2num)
 						lreach->next = areareachability[area1num];
 						areareachability[area1num] = lreach;
 						//
-						reach_rocketjump++;
+						AAS_CountReachability(&reach_rocketjump, lreach);
 						return qtrue;
 					} //end if
 				} //end if
@@ -4332,6 +4380,290 @@ void AAS_StoreReachability(void)
 	} //end for
 } //end of the function AAS_StoreReachability
 //===========================================================================
+// remembers which area pair the links added in front of first were
+// created for
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_TagPairReachability(int area1num, int area2num, aas_lreachability_t *first)
+{
+	aas_lreachability_t *lreach;
+
+	for (lreach = areareachability[area1num]; lreach != first; lreach = lreach->next)
+	{
+		reach_pairarea[lreach - reachabilityheap] = area2num;
+	} //end for
+} //end of the function AAS_TagPairReachability
+//===========================================================================
+// calculates the reachabilities from the given area towards every other
+// area, the ones that need all areas done first are created afterwards
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_AreaReachabilities(int area1num)
+{
+	int area2num;
+	aas_lreachability_t *first;
+
+	//only create jumppad reachabilities from jumppad areas
+	if (aasworld.areasettings[area1num].contents & AREACONTENTS_JUMPPAD)
+	{
+		return;
+	} //end if
+	//loop over the areas
+	for (area2num = 1; area2num < aasworld.numareas; area2num++)
+	{
+		if (area1num == area2num) continue;
+		//never create reachabilities from teleporter or jumppad areas to regular areas
+		if (aasworld.areasettings[area1num].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD))
+		{
+			if (!(aasworld.areasettings[area2num].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD)))
+			{
+				continue;
+			} //end if
+		} //end if
+		//if there already is a reachability link from area1num to area2num
+		if (AAS_ReachabilityExists(area1num, area2num)) continue;
+		//
+		first = areareachability[area1num];
+		//check for a swim reachability
+		//check for a simple walk on equal floor height reachability
+		//check for step, barrier, waterjump and walk off ledge reachabilities
+		//check for ladder reachabilities
+		//check for a jump reachability
+		if (!AAS_Reachability_Swim(area1num, area2num) &&
+			!AAS_Reachability_EqualFloorHeight(area1num, area2num) &&
+			!AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(area1num, area2num) &&
+			!AAS_Reachability_Ladder(area1num, area2num))
+		{
+			AAS_Reachability_Jump(area1num, area2num);
+		} //end if
+		if (reach_threaded) AAS_TagPairReachability(area1num, area2num, first);
+	} //end for
+	//never create these reachabilities from teleporter or jumppad areas
+	if (aasworld.areasettings[area1num].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD))
+	{
+		return;
+	} //end if
+	//loop over the areas
+	for (area2num = 1; area2num < aasworld.numareas; area2num++)
+	{
+		if (area1num == area2num) continue;
+		//
+		if (AAS_ReachabilityExists(area1num, area2num)) continue;
+		//
+		first = areareachability[area1num];
+		//check for a grapple hook reachability
+		if (calcgrapplereach) AAS_Reachability_Grapple(area1num, area2num);
+		//check for a weapon jump reachability
+		AAS_Reachability_WeaponJump(area1num, area2num);
+		if (reach_threaded) AAS_TagPairReachability(area1num, area2num, first);
+	} //end for
+} //end of the function AAS_AreaReachabilities
+
+#ifndef BSPC
+//===========================================================================
+// Areas only ever add links to their own list, except for ladder areas
+// which also add the reverse links and look at the links of other areas.
+// So every other area is calculated in parallel, each link tagged with
+// the area pair it was created for.  The lists are then rebuilt in area
+// order, running the ladder areas in between, and links for pairs that
+// an earlier ladder area already linked are dropped.  That leaves every
+// list exactly as the one area at a time calculation would have.
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_AreaReachabilityJob(void *data, int index)
+{
+	int areanum = index + 1;
+
+	//ladder areas are done while the lists are merged
+	if (AAS_AreaLadder(areanum)) return;
+	AAS_AreaReachabilities(areanum);
+} //end of the function AAS_AreaReachabilityJob
+
+static void AAS_CalculateAreaReachabilities(int numthreads)
+{
+	int i, first, last, *skip;
+	aas_lreachability_t **computed, *lreach, *next, *list;
+
+	first = nextreachability - reachabilityheap;
+	reach_pairarea = (int *) GetClearedMemory(AAS_MAX_REACHABILITYSIZE * sizeof(int));
+	reach_linkcounter = (int **) GetClearedMemory(AAS_MAX_REACHABILITYSIZE * sizeof(int *));
+	reach_nextlink = first;
+	reach_overflow = qfalse;
+	//
+	reach_threaded = qtrue;
+	botimport.RunJobs(AAS_AreaReachabilityJob, NULL, aasworld.numareas - 1, numthreads);
+	reach_threaded = qfalse;
+	//
+	if (reach_overflow) AAS_Error("AAS_MAX_REACHABILITYSIZE\n");
+	last = reach_nextlink;
+	if (last > AAS_MAX_REACHABILITYSIZE - 1) last = AAS_MAX_REACHABILITYSIZE - 1;
+	numlreachabilities += last - first;
+	nextreachability = &reachabilityheap[last];
+	//
+	computed = (aas_lreachability_t **) GetClearedMemory(aasworld.numareas * sizeof(aas_lreachability_t *));
+	Com_Memcpy(computed, areareachability, aasworld.numareas * sizeof(aas_lreachability_t *));
+	Com_Memset(areareachability, 0, aasworld.numareas * sizeof(aas_lreachability_t *));
+	skip = (int *) GetClearedMemory(aasworld.numareas * sizeof(int));
+	//
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		if (AAS_AreaLadder(i))
+		{
+			AAS_AreaReachabilities(i);
+			continue;
+		} //end if
+		//pairs an earlier ladder area already created a link for
+		for (lreach = areareachability[i]; lreach; lreach = lreach->next)
+		{
+			skip[lreach->areanum] = i;
+		} //end for
+		//the list is newest first, add the links in the order they were created
+		list = NULL;
+		for (lreach = computed[i]; lreach; lreach = next)
+		{
+			next = lreach->next;
+			lreach->next = list;
+			list = lreach;
+		} //end for
+		for (lreach = list; lreach; lreach = next)
+		{
+			next = lreach->next;
+			if (skip[reach_pairarea[lreach - reachabilityheap]] == i)
+			{
+				AAS_FreeReachability(lreach);
+				continue;
+			} //end if
+			if (reach_linkcounter[lreach - reachabilityheap])
+			{
+				(*reach_linkcounter[lreach - reachabilityheap])++;
+			} //end if
+			lreach->next = areareachability[i];
+			areareachability[i] = lreach;
+		} //end for
+	} //end for
+	//
+	FreeMemory(skip);
+	FreeMemory(computed);
+	FreeMemory(reach_pairarea);
+	reach_pairarea = NULL;
+	FreeMemory(reach_linkcounter);
+	reach_linkcounter = NULL;
+} //end of the function AAS_CalculateAreaReachabilities
+//===========================================================================
+// FNV-1a
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static unsigned int AAS_HashData(unsigned int hash, const void *data, int size)
+{
+	const unsigned char *bytes = (const unsigned char *) data;
+	int i;
+
+	for (i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 16777619u;
+	} //end for
+	return hash;
+} //end of the function AAS_HashData
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static unsigned int AAS_HashAreaReachabilities(void)
+{
+	aas_lreachability_t *lreach;
+	unsigned int hash;
+	int i;
+
+	hash = 2166136261u;
+	for (i = 0; i < aasworld.numareas; i++)
+	{
+		hash = AAS_HashData(hash, &i, sizeof(i));
+		for (lreach = areareachability[i]; lreach; lreach = lreach->next)
+		{
+			hash = AAS_HashData(hash, &lreach->areanum, sizeof(int) * 3);
+			hash = AAS_HashData(hash, lreach->start, sizeof(vec3_t));
+			hash = AAS_HashData(hash, lreach->end, sizeof(vec3_t));
+			hash = AAS_HashData(hash, &lreach->traveltype, sizeof(int));
+			hash = AAS_HashData(hash, &lreach->traveltime, sizeof(unsigned short));
+		} //end for
+	} //end for
+	return hash;
+} //end of the function AAS_HashAreaReachabilities
+//===========================================================================
+// times the per area reachability calculation for the loaded map one
+// area at a time and on numthreads threads, and checks both agree
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_ReachabilityBench(int numthreads)
+{
+	int i, run, start, msec[2], links[2];
+	unsigned int hash[2];
+
+	if (!aasworld.loaded)
+	{
+		botimport.Print(PRT_MESSAGE, "no AAS file loaded\n");
+		return;
+	} //end if
+	if (aasworld.numreachabilityareas < aasworld.numareas + 2)
+	{
+		botimport.Print(PRT_MESSAGE, "reachability is still being calculated\n");
+		return;
+	} //end if
+	if (numthreads < 2) numthreads = 2;
+	//
+	for (run = 0; run < 2; run++)
+	{
+		AAS_SetupReachabilityHeap();
+		areareachability = (aas_lreachability_t **) GetClearedMemory(
+										aasworld.numareas * sizeof(aas_lreachability_t *));
+		start = botimport.Milliseconds();
+		if (run)
+		{
+			AAS_CalculateAreaReachabilities(numthreads);
+		} //end if
+		else
+		{
+			for (i = 1; i < aasworld.numareas; i++)
+			{
+				AAS_AreaReachabilities(i);
+			} //end for
+		} //end else
+		msec[run] = botimport.Milliseconds() - start;
+		links[run] = numlreachabilities;
+		hash[run] = AAS_HashAreaReachabilities();
+		AAS_ShutDownReachabilityHeap();
+		FreeMemory(areareachability);
+		areareachability = NULL;
+	} //end for
+	//
+	botimport.Print(PRT_MESSAGE, "%s: %d areas, %d links\n", aasworld.mapname, aasworld.numareas, links[0]);
+	botimport.Print(PRT_MESSAGE, "  1 thread  %6d msec\n", msec[0]);
+	botimport.Print(PRT_MESSAGE, "%3d threads %6d msec  %1.2fx\n", numthreads, msec[1],
+					msec[1] ? (float) msec[0] / msec[1] : 0);
+	if (links[0] != links[1] || hash[0] != hash[1])
+	{
+		botimport.Print(PRT_WARNING, "threaded reachabilities differ (%d links)\n", links[1]);
+	} //end if
+} //end of the function AAS_ReachabilityBench
+#endif //BSPC
+//===========================================================================
 //
 // TRAVEL_WALK					100%	equal floor height + steps
 // TRAVEL_CROUCH				100%
@@ -4358,7 +4690,10 @@ void AAS_StoreReachability(void)
 //===========================================================================
 int AAS_ContinueInitReachability(float time)
 {
-	int i, j, todo, start_time;
+	int i, todo, start_time;
+#ifndef BSPC
+	int numthreads;
+#endif //BSPC
 	static float framereachability, reachability_delay;
 	static int lastpercentage;
 
@@ -4372,6 +4707,18 @@ int AAS_ContinueInitReachability(float time)
 		lastpercentage = 0;
 		framereachability = 2000;
 		reachability_delay = 1000;
+#ifndef BSPC
+		//with worker threads do all the areas right away
+		numthreads = LibVarValue("reachabilitythreads", "0");
+		if (numthreads > 1)
+		{
+			start_time = botimport.Milliseconds();
+			AAS_CalculateAreaReachabilities(numthreads);
+			aasworld.numreachabilityareas = aasworld.numareas;
+			botimport.Print(PRT_MESSAGE, "%d areas in %d msec with %d threads\n",
+							aasworld.numareas, botimport.Milliseconds() - start_time, numthreads);
+		} //end if
+#endif //BSPC
 	} //end if
 	//number of areas to calculate reachability for this cycle
 	todo = aasworld.numreachabilityareas + (int) framereachability;
@@ -4380,52 +4727,7 @@ int AAS_ContinueInitReachability(float time)
 	for (i = aasworld.numreachabilityareas; i < aasworld.numareas && i < todo; i++)
 	{
 		aasworld.numreachabilityareas++;
-		//only create jumppad reachabilities from jumppad areas
-		if (aasworld.areasettings[i].contents & AREACONTENTS_JUMPPAD)
-		{
-			continue;
-		} //end if
-		//loop over the areas
-		for (j = 1; j < aasworld.numareas; j++)
-		{
-			if (i == j) continue;
-			//never create reachabilities from teleporter or jumppad areas to regular areas
-			if (aasworld.areasettings[i].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD))
-			{
-				if (!(aasworld.areasettings[j].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD)))
-				{
-					continue;
-				} //end if
-			} //end if
-			//if there already is a reachability link from area i to j
-			if (AAS_ReachabilityExists(i, j)) continue;
-			//check for a swim reachability
-			if (AAS_Reachability_Swim(i, j)) continue;
-			//check for a simple walk on equal floor height reachability
-			if (AAS_Reachability_EqualFloorHeight(i, j)) continue;
-			//check for step, barrier, waterjump and walk off ledge reachabilities
-			if (AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(i, j)) continue;
-			//check for ladder reachabilities
-			if (AAS_Reachability_Ladder(i, j)) continue;
-			//check for a jump reachability
-			if (AAS_Reachability_Jump(i, j)) continue;
-		} //end for
-		//never create these reachabilities from teleporter or jumppad areas
-		if (aasworld.areasettings[i].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD))
-		{
-			continue;
-		} //end if
-		//loop over the areas
-		for (j = 1; j < aasworld.numareas; j++)
-		{
-			if (i == j) continue;
-			//
-			if (AAS_ReachabilityExists(i, j)) continue;
-			//check for a grapple hook reachability
-			if (calcgrapplereach) AAS_Reachability_Grapple(i, j);
-			//check for a weapon jump reachability
-			AAS_Reachability_WeaponJump(i, j);
-		} //end for
+		AAS_AreaReachabilities(i);
 		//if the calculation took more time than the max reachability delay
 		if (Sys_MilliSeconds() - start_time > (int) reachability_delay) break;
 		//
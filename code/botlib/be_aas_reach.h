@@ -66,3 +66,5 @@ int AAS_AreaLadder(int areanum);
 int AAS_AreaJumpPad(int areanum);
 //returns true if the area is donotenter
 int AAS_AreaDoNotEnter(int areanum);
+//times the reachability calculation for the loaded map
+void AAS_ReachabilityBench(int numthreads);
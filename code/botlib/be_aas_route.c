@@ -236,6 +236,8 @@ void AAS_FreeRoutingCache(aas_routingcache_t *cache)
 {
 	AAS_UnlinkCache(cache);
 	routingcachesize -= cache->size;
+	//cache read from the route cache file is freed all at once
+	if (cache >= aasworld.filecache && cache < aasworld.filecache + aasworld.numfilecache) return;
 	FreeMemory(cache);
 } //end of the function AAS_FreeRoutingCache
 //===========================================================================
@@ -286,6 +288,7 @@ void AAS_RemoveRoutingCacheUsingArea( int areanum )
 		AAS_RemoveRoutingCacheInCluster( aasworld.portals[-clusternum].frontcluster );
 		AAS_RemoveRoutingCacheInCluster( aasworld.portals[-clusternum].backcluster );
 	} //end else
+	aasworld.routingchanges++;
 	// remove all portal cache
 	for (i = 0; i < aasworld.numareas; i++)
 	{
@@ -299,6 +302,18 @@ void AAS_RemoveRoutingCacheUsingArea( int areanum )
 	} //end for
 } //end of the function AAS_RemoveRoutingCacheUsingArea
 //===========================================================================
+// the number changes whenever areas are enabled or disabled for routing
+// so anything derived from travel times knows it has to be recalculated
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+int AAS_RoutingChanges(void)
+{
+	return aasworld.routingchanges;
+} //end of the function AAS_RoutingChanges
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -746,6 +761,7 @@ aas_routingcache_t *AAS_AllocRoutingCache(int numtraveltimes)
 	routingcachesize += size;
 	//
 	cache = (aas_routingcache_t *) GetClearedMemory(size);
+	cache->traveltimes = (unsigned short int *) ((unsigned char *) cache + sizeof(aas_routingcache_t));
 	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t)
 								+ numtraveltimes * sizeof(unsigned short int);
 	cache->size = size;
@@ -881,6 +897,152 @@ void AAS_InitRoutingUpdate(void)
 									(aasworld.numportals+1) * sizeof(aas_routingupdate_t));
 } //end of the function AAS_InitRoutingUpdate
 //===========================================================================
+// the portal routing updates are Dijkstra searches with a bucket queue
+// (Dial's algorithm), the queue only ever holds travel times between the
+// lowest one and that plus the largest single step so the buckets wrap around
+//
+// Parameter:			queue			: queue to allocate
+//						maxstep			: largest travel time added in one step
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_InitRoutingQueue(aas_routingqueue_t *queue, int maxstep)
+{
+	int numbuckets;
+
+	if (queue->buckets) FreeMemory(queue->buckets);
+	//travel times are unsigned shorts, more buckets are never needed
+	for (numbuckets = 2; numbuckets <= maxstep && numbuckets < 0x10000; numbuckets <<= 1)
+		;
+	queue->buckets = (aas_routingupdate_t **) GetClearedMemory(
+									numbuckets * sizeof(aas_routingupdate_t *));
+	queue->mask = numbuckets - 1;
+	queue->current = 0;
+	queue->numupdates = 0;
+} //end of the function AAS_InitRoutingQueue
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FreeRoutingQueue(aas_routingqueue_t *queue)
+{
+	if (queue->buckets) FreeMemory(queue->buckets);
+	queue->buckets = NULL;
+	queue->numupdates = 0;
+} //end of the function AAS_FreeRoutingQueue
+//===========================================================================
+// the portal update steps are whole area routing caches so the portal
+// queue gets a bucket for every travel time
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_InitRoutingQueues(void)
+{
+	AAS_InitRoutingQueue(&aasworld.portalqueue, 0xffff);
+} //end of the function AAS_InitRoutingQueues
+//===========================================================================
+// per thread routing updates and queues for AAS_PrefetchRoutes, these are
+// only (re)allocated on the main thread
+//
+// Parameter:			numthreads		: number of job threads
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FreeRoutingThreads(void)
+{
+	int i;
+
+	for (i = 0; i < aasworld.numroutingthreads; i++)
+	{
+		FreeMemory(aasworld.threadareaupdate[i]);
+	} //end for
+	if (aasworld.threadareaupdate) FreeMemory(aasworld.threadareaupdate);
+	aasworld.threadareaupdate = NULL;
+	aasworld.numroutingthreads = 0;
+} //end of the function AAS_FreeRoutingThreads
+
+static void AAS_InitRoutingThreads(int numthreads)
+{
+	int i, maxreachabilityareas;
+
+	AAS_FreeRoutingThreads();
+	//
+	maxreachabilityareas = 0;
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		if (aasworld.clusters[i].numreachabilityareas > maxreachabilityareas)
+		{
+			maxreachabilityareas = aasworld.clusters[i].numreachabilityareas;
+		} //end if
+	} //end for
+	aasworld.threadareaupdate = (aas_routingupdate_t **) GetClearedMemory(
+									numthreads * sizeof(aas_routingupdate_t *));
+	for (i = 0; i < numthreads; i++)
+	{
+		aasworld.threadareaupdate[i] = (aas_routingupdate_t *) GetClearedMemory(
+									maxreachabilityareas * sizeof(aas_routingupdate_t));
+	} //end for
+	aasworld.numroutingthreads = numthreads;
+} //end of the function AAS_InitRoutingThreads
+//===========================================================================
+// adds the update to the queue with the travel time in update->tmptraveltime
+// which may not be lower than that of the last update taken from the queue
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE void AAS_RoutingQueueAdd(aas_routingqueue_t *queue, aas_routingupdate_t *update)
+{
+	aas_routingupdate_t **bucket;
+
+	bucket = &queue->buckets[update->tmptraveltime & queue->mask];
+	update->prev = NULL;
+	update->next = *bucket;
+	if (*bucket) (*bucket)->prev = update;
+	*bucket = update;
+	update->inlist = qtrue;
+	queue->numupdates++;
+} //end of the function AAS_RoutingQueueAdd
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE void AAS_RoutingQueueRemove(aas_routingqueue_t *queue, aas_routingupdate_t *update)
+{
+	if (update->prev) update->prev->next = update->next;
+	else queue->buckets[update->tmptraveltime & queue->mask] = update->next;
+	if (update->next) update->next->prev = update->prev;
+	update->inlist = qfalse;
+	queue->numupdates--;
+} //end of the function AAS_RoutingQueueRemove
+//===========================================================================
+// returns the update with the lowest travel time or NULL when empty
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE aas_routingupdate_t *AAS_RoutingQueuePop(aas_routingqueue_t *queue)
+{
+	aas_routingupdate_t *update;
+
+	if (!queue->numupdates) return NULL;
+	while (!queue->buckets[queue->current])
+	{
+		queue->current = (queue->current + 1) & queue->mask;
+	} //end while
+	update = queue->buckets[queue->current];
+	AAS_RoutingQueueRemove(queue, update);
+	return update;
+} //end of the function AAS_RoutingQueuePop
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -915,40 +1077,164 @@ void AAS_CreateAllRoutingCache(void)
 //===========================================================================
 
 //the route cache header
-//this header is followed by numportalcache + numareacache aas_routingcache_t
-//structures that store routing cache
+//this header is followed by numportalcache + numareacache routecacheentry_t
+//structures, then the travel times of all the caches and then their
+//reachabilities. All offsets are from the start of the file so the file
+//can be used in place. It is mapped read only when possible, which lets
+//all the servers on a machine running the same map share one copy.
+//The file is in the byte order of the machine that wrote it.
 typedef struct routecacheheader_s
 {
 	int ident;
 	int version;
 	int numareas;
 	int numclusters;
+	int numportals;
 	int areacrc;
 	int clustercrc;
 	int numportalcache;
 	int numareacache;
+	int filesize;
 } routecacheheader_t;
 
+typedef struct routecacheentry_s
+{
+	int type;									//portal or area cache
+	int cluster;								//cluster the cache is for
+	int areanum;								//area the cache is created for
+	int travelflags;							//combinations of the travel flags
+	vec3_t origin;								//origin within the area
+	float starttraveltime;						//travel time to start with
+	int numtraveltimes;							//number of travel times and reachabilities
+	int traveltimesofs;							//file offset of the travel times
+	int reachabilitiesofs;						//file offset of the reachabilities
+} routecacheentry_t;
+
 #define RCID						(('C'<<24)+('R'<<16)+('E'<<8)+'M')
-#define RCVERSION					2
+#define RCVERSION					3
+
+#define RCLUMP_ENTRIES				0
+#define RCLUMP_TRAVELTIMES			1
+#define RCLUMP_REACHABILITIES		2
 
 //void AAS_DecompressVis(byte *in, int numareas, byte *decompressed);
 //int AAS_CompressVis(byte *vis, int numareas, byte *dest);
 
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RoutingCacheNumTravelTimes(aas_routingcache_t *cache)
+{
+	if (cache->type == CACHETYPE_PORTAL) return aasworld.numportals;
+	return aasworld.clusters[cache->cluster].numreachabilityareas;
+} //end of the function AAS_RoutingCacheNumTravelTimes
+//===========================================================================
+// writes one lump of the given cache, first is the number of travel
+// times written for the caches before this one
+//
+// Parameter:			-
+// Returns:				number of travel times of the cache
+// Changes Globals:		-
+//===========================================================================
+static int AAS_WriteRoutingCacheLump(fileHandle_t fp, aas_routingcache_t *cache, int lump,
+										int first, int traveltimesofs, int reachabilitiesofs)
+{
+	routecacheentry_t entry;
+	int numtraveltimes;
+
+	numtraveltimes = AAS_RoutingCacheNumTravelTimes(cache);
+	switch(lump)
+	{
+		case RCLUMP_ENTRIES:
+		{
+			Com_Memset(&entry, 0, sizeof(entry));
+			entry.type = cache->type;
+			entry.cluster = cache->cluster;
+			entry.areanum = cache->areanum;
+			entry.travelflags = cache->travelflags;
+			VectorCopy(cache->origin, entry.origin);
+			entry.starttraveltime = cache->starttraveltime;
+			entry.numtraveltimes = numtraveltimes;
+			entry.traveltimesofs = traveltimesofs + first * sizeof(unsigned short int);
+			entry.reachabilitiesofs = reachabilitiesofs + first * sizeof(unsigned char);
+			botimport.FS_Write(&entry, sizeof(entry), fp);
+			break;
+		} //end case
+		case RCLUMP_TRAVELTIMES:
+		{
+			botimport.FS_Write(cache->traveltimes, numtraveltimes * sizeof(unsigned short int), fp);
+			break;
+		} //end case
+		case RCLUMP_REACHABILITIES:
+		{
+			botimport.FS_Write(cache->reachabilities, numtraveltimes * sizeof(unsigned char), fp);
+			break;
+		} //end case
+	} //end switch
+	return numtraveltimes;
+} //end of the function AAS_WriteRoutingCacheLump
+//===========================================================================
+// writes one lump of all the portal cache followed by all the cluster
+// area cache
+//
+// Parameter:			-
+// Returns:				total number of travel times
+// Changes Globals:		-
+//===========================================================================
+static int AAS_WriteRouteCacheLump(fileHandle_t fp, int lump, int traveltimesofs, int reachabilitiesofs)
+{
+	int i, j, total;
+	aas_routingcache_t *cache;
+	aas_cluster_t *cluster;
+
+	total = 0;
+	for (i = 0; i < aasworld.numareas; i++)
+	{
+		for (cache = aasworld.portalcache[i]; cache; cache = cache->next)
+		{
+			total += AAS_WriteRoutingCacheLump(fp, cache, lump, total, traveltimesofs, reachabilitiesofs);
+		} //end for
+	} //end for
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		cluster = &aasworld.clusters[i];
+		for (j = 0; j < cluster->numareas; j++)
+		{
+			for (cache = aasworld.clusterareacache[i][j]; cache; cache = cache->next)
+			{
+				total += AAS_WriteRoutingCacheLump(fp, cache, lump, total, traveltimesofs, reachabilitiesofs);
+			} //end for
+		} //end for
+	} //end for
+	return total;
+} //end of the function AAS_WriteRouteCacheLump
+//===========================================================================
+// the file is written under a temporary name and then renamed, servers
+// that have the old file mapped keep using the old one
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void AAS_WriteRouteCache(void)
 {
-	int i, j, numportalcache, numareacache, totalsize;
+	int i, j, numportalcache, numareacache, numtraveltimes, entriesofs, traveltimesofs, reachabilitiesofs;
 	aas_routingcache_t *cache;
 	aas_cluster_t *cluster;
 	fileHandle_t fp;
-	char filename[MAX_QPATH];
+	char filename[MAX_QPATH], tmpfilename[MAX_QPATH];
 	routecacheheader_t routecacheheader;
 
+	numtraveltimes = 0;
 	numportalcache = 0;
 	for (i = 0; i < aasworld.numareas; i++)
 	{
 		for (cache = aasworld.portalcache[i]; cache; cache = cache->next)
 		{
+			numtraveltimes += AAS_RoutingCacheNumTravelTimes(cache);
 			numportalcache++;
 		} //end for
 	} //end for
@@ -960,52 +1246,42 @@ void AAS_WriteRouteCache(void)
 		{
 			for (cache = aasworld.clusterareacache[i][j]; cache; cache = cache->next)
 			{
+				numtraveltimes += AAS_RoutingCacheNumTravelTimes(cache);
 				numareacache++;
 			} //end for
 		} //end for
 	} //end for
+	//layout of the file
+	entriesofs = sizeof(routecacheheader_t);
+	traveltimesofs = entriesofs + (numportalcache + numareacache) * sizeof(routecacheentry_t);
+	reachabilitiesofs = traveltimesofs + numtraveltimes * sizeof(unsigned short int);
 	// open the file for writing
 	Com_sprintf(filename, MAX_QPATH, "maps/%s.rcd", aasworld.mapname);
-	botimport.FS_FOpenFile( filename, &fp, FS_WRITE );
+	Com_sprintf(tmpfilename, MAX_QPATH, "maps/%s.rcd.tmp", aasworld.mapname);
+	botimport.FS_FOpenFile( tmpfilename, &fp, FS_WRITE );
 	if (!fp)
 	{
-		AAS_Error("Unable to open file: %s\n", filename);
+		AAS_Error("Unable to open file: %s\n", tmpfilename);
 		return;
 	} //end if
 	//create the header
+	Com_Memset(&routecacheheader, 0, sizeof(routecacheheader));
 	routecacheheader.ident = RCID;
 	routecacheheader.version = RCVERSION;
 	routecacheheader.numareas = aasworld.numareas;
 	routecacheheader.numclusters = aasworld.numclusters;
+	routecacheheader.numportals = aasworld.numportals;
 	routecacheheader.areacrc = CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas );
 	routecacheheader.clustercrc = CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters );
 	routecacheheader.numportalcache = numportalcache;
 	routecacheheader.numareacache = numareacache;
+	routecacheheader.filesize = reachabilitiesofs + numtraveltimes * sizeof(unsigned char);
 	//write the header
 	botimport.FS_Write(&routecacheheader, sizeof(routecacheheader_t), fp);
-	//
-	totalsize = 0;
 	//write all the cache
-	for (i = 0; i < aasworld.numareas; i++)
-	{
-		for (cache = aasworld.portalcache[i]; cache; cache = cache->next)
-		{
-			botimport.FS_Write(cache, cache->size, fp);
-			totalsize += cache->size;
-		} //end for
-	} //end for
-	for (i = 0; i < aasworld.numclusters; i++)
-	{
-		cluster = &aasworld.clusters[i];
-		for (j = 0; j < cluster->numareas; j++)
-		{
-			for (cache = aasworld.clusterareacache[i][j]; cache; cache = cache->next)
-			{
-				botimport.FS_Write(cache, cache->size, fp);
-				totalsize += cache->size;
-			} //end for
-		} //end for
-	} //end for
+	AAS_WriteRouteCacheLump(fp, RCLUMP_ENTRIES, traveltimesofs, reachabilitiesofs);
+	AAS_WriteRouteCacheLump(fp, RCLUMP_TRAVELTIMES, traveltimesofs, reachabilitiesofs);
+	AAS_WriteRouteCacheLump(fp, RCLUMP_REACHABILITIES, traveltimesofs, reachabilitiesofs);
 	// write the visareas
 	/*
 	for (i = 0; i < aasworld.numareas; i++)
@@ -1023,8 +1299,13 @@ void AAS_WriteRouteCache(void)
 	*/
 	//
 	botimport.FS_FCloseFile(fp);
+	if (!botimport.FS_Rename(tmpfilename, filename))
+	{
+		AAS_Error("Unable to replace file: %s\n", filename);
+		return;
+	} //end if
 	botimport.Print(PRT_MESSAGE, "\nroute cache written to %s\n", filename);
-	botimport.Print(PRT_MESSAGE, "written %d bytes of routing cache\n", totalsize);
+	botimport.Print(PRT_MESSAGE, "written %d bytes of routing cache\n", routecacheheader.filesize);
 } //end of the function AAS_WriteRouteCache
 //===========================================================================
 //
@@ -1032,92 +1313,194 @@ void AAS_WriteRouteCache(void)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
+static void AAS_FreeRouteCacheFile(void)
 {
-	int size;
-	aas_routingcache_t *cache;
-
-	botimport.FS_Read(&size, sizeof(size), fp);
-	cache = (aas_routingcache_t *) GetMemory(size);
-	cache->size = size;
-	botimport.FS_Read((unsigned char *)cache + sizeof(size), size - sizeof(size), fp);
-	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t) - sizeof(unsigned short) +
-		(size - sizeof(aas_routingcache_t) + sizeof(unsigned short)) / 3 * 2;
-	return cache;
-} //end of the function AAS_ReadCache
+	if (aasworld.filecache) FreeMemory(aasworld.filecache);
+	aasworld.filecache = NULL;
+	aasworld.numfilecache = 0;
+	//
+	if (aasworld.routecachefile)
+	{
+		if (aasworld.routecachemapped)
+		{
+			botimport.FS_UnmapFile(aasworld.routecachefile, aasworld.routecachefilesize);
+		} //end if
+		else
+		{
+			FreeMemory(aasworld.routecachefile);
+		} //end else
+	} //end if
+	aasworld.routecachefile = NULL;
+	aasworld.routecachefilesize = 0;
+	aasworld.routecachemapped = qfalse;
+} //end of the function AAS_FreeRouteCacheFile
 //===========================================================================
+// checks the route cache file is for the loaded map and every entry
+// fits inside the file
 //
 // Parameter:			-
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-int AAS_ReadRouteCache(void)
+static int AAS_ValidRouteCache(const char *filename, byte *data, int length)
 {
-	int i, clusterareanum;//, size;
-	fileHandle_t fp;
-	char filename[MAX_QPATH];
-	routecacheheader_t routecacheheader;
-	aas_routingcache_t *cache;
+	routecacheheader_t *routecacheheader;
+	routecacheentry_t *entry;
+	int i, numcache, numtraveltimes, clusterareanum;
 
-	Com_sprintf(filename, MAX_QPATH, "maps/%s.rcd", aasworld.mapname);
-	botimport.FS_FOpenFile( filename, &fp, FS_READ );
-	if (!fp)
+	if (length < (int) sizeof(routecacheheader_t)) return qfalse;
+	routecacheheader = (routecacheheader_t *) data;
+	if (routecacheheader->ident != RCID)
 	{
+		botimport.Print(PRT_WARNING, "%s is not a route cache dump\n", filename);
 		return qfalse;
 	} //end if
-	botimport.FS_Read(&routecacheheader, sizeof(routecacheheader_t), fp );
-	if (routecacheheader.ident != RCID)
+	if (routecacheheader->version != RCVERSION)
 	{
-		AAS_Error("%s is not a route cache dump\n", filename);
+		botimport.Print(PRT_WARNING, "route cache dump has wrong version %d, should be %d\n", routecacheheader->version, RCVERSION);
 		return qfalse;
 	} //end if
-	if (routecacheheader.version != RCVERSION)
+	if (routecacheheader->numareas != aasworld.numareas) return qfalse;
+	if (routecacheheader->numclusters != aasworld.numclusters) return qfalse;
+	if (routecacheheader->numportals != aasworld.numportals) return qfalse;
+	if (routecacheheader->areacrc !=
+		CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas ))
 	{
-		AAS_Error("route cache dump has wrong version %d, should be %d\n", routecacheheader.version, RCVERSION);
 		return qfalse;
 	} //end if
-	if (routecacheheader.numareas != aasworld.numareas)
+	if (routecacheheader->clustercrc !=
+		CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters ))
 	{
-		//AAS_Error("route cache dump has wrong number of areas\n");
 		return qfalse;
 	} //end if
-	if (routecacheheader.numclusters != aasworld.numclusters)
+	numcache = routecacheheader->numportalcache + routecacheheader->numareacache;
+	if (routecacheheader->filesize != length || routecacheheader->numportalcache < 0 ||
+		routecacheheader->numareacache < 0 ||
+		numcache > (length - (int) sizeof(routecacheheader_t)) / (int) sizeof(routecacheentry_t))
 	{
-		//AAS_Error("route cache dump has wrong number of clusters\n");
+		botimport.Print(PRT_WARNING, "%s is truncated\n", filename);
 		return qfalse;
 	} //end if
-	if (routecacheheader.areacrc !=
-		CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas ))
+	//
+	entry = (routecacheentry_t *) (data + sizeof(routecacheheader_t));
+	for (i = 0; i < numcache; i++, entry++)
+	{
+		if (entry->areanum <= 0 || entry->areanum >= aasworld.numareas) break;
+		if (entry->cluster < 0 || entry->cluster >= aasworld.numclusters) break;
+		if (i < routecacheheader->numportalcache)
+		{
+			if (entry->type != CACHETYPE_PORTAL) break;
+			numtraveltimes = aasworld.numportals;
+		} //end if
+		else
+		{
+			if (entry->type != CACHETYPE_AREA) break;
+			numtraveltimes = aasworld.clusters[entry->cluster].numreachabilityareas;
+			clusterareanum = AAS_ClusterAreaNum(entry->cluster, entry->areanum);
+			if (clusterareanum < 0 || clusterareanum >= aasworld.clusters[entry->cluster].numareas) break;
+		} //end else
+		if (entry->numtraveltimes != numtraveltimes) break;
+		if (entry->traveltimesofs < 0 || (entry->traveltimesofs & 1) ||
+			entry->traveltimesofs > length - numtraveltimes * (int) sizeof(unsigned short int)) break;
+		if (entry->reachabilitiesofs < 0 ||
+			entry->reachabilitiesofs > length - numtraveltimes * (int) sizeof(unsigned char)) break;
+	} //end for
+	if (i < numcache)
 	{
-		//AAS_Error("route cache dump area CRC incorrect\n");
+		botimport.Print(PRT_WARNING, "%s is corrupt\n", filename);
 		return qfalse;
 	} //end if
-	if (routecacheheader.clustercrc !=
-		CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters ))
+	return qtrue;
+} //end of the function AAS_ValidRouteCache
+//===========================================================================
+// the caches only get a private header, their travel times and
+// reachabilities stay in the file data, caches that are missing are
+// calculated into private memory as usual
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+int AAS_ReadRouteCache(void)
+{
+	int i, length, mapped, clusterareanum, numcache;
+	fileHandle_t fp;
+	char filename[MAX_QPATH];
+	routecacheheader_t *routecacheheader;
+	routecacheentry_t *entry;
+	aas_routingcache_t *cache;
+	byte *data;
+
+	Com_sprintf(filename, MAX_QPATH, "maps/%s.rcd", aasworld.mapname);
+	//map the file if it's a plain file, otherwise read it
+	mapped = qtrue;
+	data = (byte *) botimport.FS_MapFile(filename, &length);
+	if (!data)
+	{
+		mapped = qfalse;
+		length = botimport.FS_FOpenFile( filename, &fp, FS_READ );
+		if (!fp)
+		{
+			return qfalse;
+		} //end if
+		if (length <= 0)
+		{
+			botimport.FS_FCloseFile(fp);
+			return qfalse;
+		} //end if
+		data = (byte *) GetMemory(length);
+		botimport.FS_Read(data, length, fp);
+		botimport.FS_FCloseFile(fp);
+	} //end if
+	if (!AAS_ValidRouteCache(filename, data, length))
 	{
-		//AAS_Error("route cache dump cluster CRC incorrect\n");
+		if (mapped) botimport.FS_UnmapFile(data, length);
+		else FreeMemory(data);
 		return qfalse;
 	} //end if
-	//read all the portal cache
-	for (i = 0; i < routecacheheader.numportalcache; i++)
-	{
-		cache = AAS_ReadCache(fp);
-		cache->next = aasworld.portalcache[cache->areanum];
-		cache->prev = NULL;
-		if (aasworld.portalcache[cache->areanum])
-			aasworld.portalcache[cache->areanum]->prev = cache;
-		aasworld.portalcache[cache->areanum] = cache;
-	} //end for
-	//read all the cluster area cache
-	for (i = 0; i < routecacheheader.numareacache; i++)
-	{
-		cache = AAS_ReadCache(fp);
-		clusterareanum = AAS_ClusterAreaNum(cache->cluster, cache->areanum);
-		cache->next = aasworld.clusterareacache[cache->cluster][clusterareanum];
-		cache->prev = NULL;
-		if (aasworld.clusterareacache[cache->cluster][clusterareanum])
-			aasworld.clusterareacache[cache->cluster][clusterareanum]->prev = cache;
-		aasworld.clusterareacache[cache->cluster][clusterareanum] = cache;
+	//
+	AAS_FreeRouteCacheFile();
+	aasworld.routecachefile = data;
+	aasworld.routecachefilesize = length;
+	aasworld.routecachemapped = mapped;
+	//
+	routecacheheader = (routecacheheader_t *) data;
+	numcache = routecacheheader->numportalcache + routecacheheader->numareacache;
+	aasworld.filecache = (aas_routingcache_t *) GetClearedMemory(numcache * sizeof(aas_routingcache_t));
+	aasworld.numfilecache = numcache;
+	entry = (routecacheentry_t *) (data + sizeof(routecacheheader_t));
+	for (i = 0; i < numcache; i++, entry++)
+	{
+		cache = &aasworld.filecache[i];
+		cache->type = entry->type;
+		cache->size = sizeof(aas_routingcache_t);
+		cache->cluster = entry->cluster;
+		cache->areanum = entry->areanum;
+		VectorCopy(entry->origin, cache->origin);
+		cache->starttraveltime = entry->starttraveltime;
+		cache->travelflags = entry->travelflags;
+		cache->traveltimes = (unsigned short int *) (data + entry->traveltimesofs);
+		cache->reachabilities = data + entry->reachabilitiesofs;
+		routingcachesize += cache->size;
+		//
+		if (cache->type == CACHETYPE_PORTAL)
+		{
+			cache->next = aasworld.portalcache[cache->areanum];
+			cache->prev = NULL;
+			if (aasworld.portalcache[cache->areanum])
+				aasworld.portalcache[cache->areanum]->prev = cache;
+			aasworld.portalcache[cache->areanum] = cache;
+		} //end if
+		else
+		{
+			clusterareanum = AAS_ClusterAreaNum(cache->cluster, cache->areanum);
+			cache->next = aasworld.clusterareacache[cache->cluster][clusterareanum];
+			cache->prev = NULL;
+			if (aasworld.clusterareacache[cache->cluster][clusterareanum])
+				aasworld.clusterareacache[cache->cluster][clusterareanum]->prev = cache;
+			aasworld.clusterareacache[cache->cluster][clusterareanum] = cache;
+		} //end else
+		AAS_LinkCache(cache);
 	} //end for
 	// read the visareas
 	/*
@@ -1133,7 +1516,7 @@ int AAS_ReadRouteCache(void)
 	}
 	*/
 	//
-	botimport.FS_FCloseFile(fp);
+	botimport.Print(PRT_MESSAGE, "%s %d routing caches from %s\n", mapped ? "mapped" : "loaded", numcache, filename);
 	return qtrue;
 } //end of the function AAS_ReadRouteCache
 //===========================================================================
@@ -1235,6 +1618,8 @@ void AAS_InitRouting(void)
 	AAS_InitPortalMaxTravelTimes();
 	//get the areas reachabilities go through
 	AAS_InitReachabilityAreas();
+	//allocate the routing update queues
+	AAS_InitRoutingQueues();
 	//
 #ifdef ROUTING_DEBUG
 	numareacacheupdates = 0;
@@ -1258,6 +1643,8 @@ void AAS_FreeRoutingCaches(void)
 	AAS_FreeAllClusterAreaCache();
 	// free all the existing portal cache
 	AAS_FreeAllPortalCache();
+	// free the route cache file the caches were read from
+	AAS_FreeRouteCacheFile();
 	// free cached travel times within areas
 	if (aasworld.areatraveltimes) FreeMemory(aasworld.areatraveltimes);
 	aasworld.areatraveltimes = NULL;
@@ -1272,6 +1659,8 @@ void AAS_FreeRoutingCaches(void)
 	aasworld.areaupdate = NULL;
 	if (aasworld.portalupdate) FreeMemory(aasworld.portalupdate);
 	aasworld.portalupdate = NULL;
+	AAS_FreeRoutingQueue(&aasworld.portalqueue);
+	AAS_FreeRoutingThreads();
 	// free lists with areas the reachabilities go through
 	if (aasworld.reachabilityareas) FreeMemory(aasworld.reachabilityareas);
 	aasworld.reachabilityareas = NULL;
@@ -1289,7 +1678,7 @@ void AAS_FreeRoutingCaches(void)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
+static void AAS_FillAreaRoutingCache(aas_routingcache_t *areacache, aas_routingupdate_t *areaupdate)
 {
 	int i, nextareanum, cluster, badtravelflags, clusterareanum, linknum;
 	int numreachabilityareas;
@@ -1299,13 +1688,8 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 	aas_reversedreachability_t *revreach;
 	aas_reversedlink_t *revlink;
 
-#ifdef ROUTING_DEBUG
-	numareacacheupdates++;
-#endif //ROUTING_DEBUG
 	//number of reachability areas within this cluster
 	numreachabilityareas = aasworld.clusters[areacache->cluster].numreachabilityareas;
-	//
-	aasworld.frameroutingupdates++;
 	//clear the routing update fields
 //	Com_Memset(aasworld.areaupdate, 0, aasworld.numareas * sizeof(aas_routingupdate_t));
 	//
@@ -1316,7 +1700,7 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 	//
 	Com_Memset(startareatraveltimes, 0, sizeof(startareatraveltimes));
 	//
-	curupdate = &aasworld.areaupdate[clusterareanum];
+	curupdate = &areaupdate[clusterareanum];
 	curupdate->areanum = areacache->areanum;
 	//VectorCopy(areacache->origin, curupdate->start);
 	curupdate->areatraveltimes = startareatraveltimes;
@@ -1328,6 +1712,9 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 	curupdate->prev = NULL;
 	updateliststart = curupdate;
 	updatelistend = curupdate;
+	//the travel time through an area depends on the reachability it was
+	//entered through, so areas go back on the list every time a shorter
+	//travel time turns up, the order of the list decides the routes
 	//while there are updates in the current list
 	while (updateliststart)
 	{
@@ -1372,7 +1759,7 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 			{
 				areacache->traveltimes[clusterareanum] = t;
 				areacache->reachabilities[clusterareanum] = linknum - aasworld.areasettings[nextareanum].firstreachablearea;
-				nextupdate = &aasworld.areaupdate[clusterareanum];
+				nextupdate = &areaupdate[clusterareanum];
 				nextupdate->areanum = nextareanum;
 				nextupdate->tmptraveltime = t;
 				//VectorCopy(reach->start, nextupdate->start);
@@ -1393,6 +1780,23 @@ void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
 			} //end if
 		} //end for
 	} //end while
+} //end of the function AAS_FillAreaRoutingCache
+//===========================================================================
+// update the given routing cache
+//
+// Parameter:			areacache		: routing cache to update
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_UpdateAreaRoutingCache(aas_routingcache_t *areacache)
+{
+#ifdef ROUTING_DEBUG
+	numareacacheupdates++;
+#endif //ROUTING_DEBUG
+	//
+	aasworld.frameroutingupdates++;
+	//
+	AAS_FillAreaRoutingCache(areacache, aasworld.areaupdate);
 } //end of the function AAS_UpdateAreaRoutingCache
 //===========================================================================
 //
@@ -1448,12 +1852,12 @@ aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int tra
 //===========================================================================
 void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 {
-	int i, portalnum, clusterareanum, clusternum;
-	unsigned short int t;
+	int i, portalnum, clusterareanum, clusternum, t;
 	aas_portal_t *portal;
 	aas_cluster_t *cluster;
 	aas_routingcache_t *cache;
-	aas_routingupdate_t *updateliststart, *updatelistend, *curupdate, *nextupdate;
+	aas_routingqueue_t *queue;
+	aas_routingupdate_t *curupdate, *nextupdate;
 
 #ifdef ROUTING_DEBUG
 	numportalcacheupdates++;
@@ -1471,22 +1875,13 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 	{
 		portalcache->traveltimes[-clusternum] = portalcache->starttraveltime;
 	} //end if
-	//put the area to start with in the current read list
-	curupdate->next = NULL;
-	curupdate->prev = NULL;
-	updateliststart = curupdate;
-	updatelistend = curupdate;
-	//while there are updates in the current list
-	while (updateliststart)
+	//put the area to start with in the queue
+	queue = &aasworld.portalqueue;
+	queue->current = curupdate->tmptraveltime & queue->mask;
+	AAS_RoutingQueueAdd(queue, curupdate);
+	//while there are updates in the queue
+	while ((curupdate = AAS_RoutingQueuePop(queue)) != NULL)
 	{
-		curupdate = updateliststart;
-		//remove the current update from the list
-		if (curupdate->next) curupdate->next->prev = NULL;
-		else updatelistend = NULL;
-		updateliststart = curupdate->next;
-		//current update is removed from the list
-		curupdate->inlist = qfalse;
-		//
 		cluster = &aasworld.clusters[curupdate->cluster];
 		//
 		cache = AAS_GetAreaRoutingCache(curupdate->cluster,
@@ -1505,12 +1900,16 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 			t = cache->traveltimes[clusterareanum];
 			if (!t) continue;
 			t += curupdate->tmptraveltime;
+			//travel times are stored as unsigned shorts
+			if (t + aasworld.portalmaxtraveltimes[portalnum] > 0xffff) continue;
 			//
 			if (!portalcache->traveltimes[portalnum] ||
 					portalcache->traveltimes[portalnum] > t)
 			{
 				portalcache->traveltimes[portalnum] = t;
 				nextupdate = &aasworld.portalupdate[portalnum];
+				//move the update to the bucket of the new travel time
+				if (nextupdate->inlist) AAS_RoutingQueueRemove(queue, nextupdate);
 				if (portal->frontcluster == curupdate->cluster)
 				{
 					nextupdate->cluster = portal->backcluster;
@@ -1522,18 +1921,7 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 				nextupdate->areanum = portal->areanum;
 				//add travel time through the actual portal area for the next update
 				nextupdate->tmptraveltime = t + aasworld.portalmaxtraveltimes[portalnum];
-				if (!nextupdate->inlist)
-				{
-					// we add the update to the end of the list
-					// we could also use a B+ tree to have a real sorted list
-					// on travel time which makes for faster routing updates
-					nextupdate->next = NULL;
-					nextupdate->prev = updatelistend;
-					if (updatelistend) updatelistend->next = nextupdate;
-					else updateliststart = nextupdate;
-					updatelistend = nextupdate;
-					nextupdate->inlist = qtrue;
-				} //end if
+				AAS_RoutingQueueAdd(queue, nextupdate);
 			} //end if
 		} //end for
 	} //end while
@@ -1581,6 +1969,235 @@ aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int t
 	return cache;
 } //end of the function AAS_GetPortalRoutingCache
 //===========================================================================
+// allocates and links an empty area routing cache unless there already is
+// one, the cache is stored in the fill list when it still has to be filled
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+#define MAX_PREFETCHFILLS		1024
+
+typedef struct aas_prefetch_s
+{
+	aas_routingcache_t *fills[MAX_PREFETCHFILLS];
+	int numfills;
+	int numthreads;
+} aas_prefetch_t;
+
+static void AAS_PrefetchAreaRoutingCache(aas_prefetch_t *prefetch, int clusternum, int areanum, int travelflags)
+{
+	int clusterareanum;
+	aas_routingcache_t *cache, *clustercache;
+
+	if (prefetch->numfills >= MAX_PREFETCHFILLS) return;
+	//
+	clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
+	clustercache = aasworld.clusterareacache[clusternum][clusterareanum];
+	for (cache = clustercache; cache; cache = cache->next)
+	{
+		if (cache->travelflags == travelflags) return;
+	} //end for
+	//
+	cache = AAS_AllocRoutingCache(aasworld.clusters[clusternum].numreachabilityareas);
+	cache->cluster = clusternum;
+	cache->areanum = areanum;
+	VectorCopy(aasworld.areas[areanum].center, cache->origin);
+	cache->starttraveltime = 1;
+	cache->travelflags = travelflags;
+	cache->prev = NULL;
+	cache->next = clustercache;
+	if (clustercache) clustercache->prev = cache;
+	aasworld.clusterareacache[clusternum][clusterareanum] = cache;
+	cache->time = AAS_RoutingTime();
+	cache->type = CACHETYPE_AREA;
+	AAS_LinkCache(cache);
+	//
+	prefetch->fills[prefetch->numfills++] = cache;
+} //end of the function AAS_PrefetchAreaRoutingCache
+//===========================================================================
+// job j fills the caches j, j + numthreads, ... with its own routing
+// updates, the caches are already linked so only their contents change
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_PrefetchRoutesJob(void *data, int index)
+{
+	aas_prefetch_t *prefetch = (aas_prefetch_t *) data;
+	int i;
+
+	for (i = index; i < prefetch->numfills; i += prefetch->numthreads)
+	{
+		AAS_FillAreaRoutingCache(prefetch->fills[i], aasworld.threadareaupdate[index]);
+	} //end for
+} //end of the function AAS_PrefetchRoutesJob
+//===========================================================================
+// looks up the area routing caches AAS_AreaRouteToGoalArea will use for
+// each of the routes and fills the missing ones on the job threads, the
+// portal routing cache is left to be filled on demand because filling it
+// needs the area caches of every cluster it passes through
+//
+// Parameter:			areas			: start area of each route
+//						goalareas		: goal area of each route
+//						travelflags		: travel flags of each route
+//						num				: number of routes
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_PrefetchRoutes(int *areas, int *goalareas, int *travelflags, int num)
+{
+	static aas_prefetch_t prefetch;
+	int i, j, areanum, goalareanum, tfl, clusternum, goalclusternum, numthreads;
+	aas_portal_t *portal;
+	aas_cluster_t *cluster;
+
+	if (!aasworld.initialized) return;
+	numthreads = LibVarValue("routingthreads", "0");
+	if (numthreads <= 1) return;
+	//
+	if (aasworld.numroutingthreads != numthreads) AAS_InitRoutingThreads(numthreads);
+	// make sure the routing cache doesn't grow to large
+	while(AvailableMemory() < 1 * 1024 * 1024) {
+		if (!AAS_FreeOldestCache()) break;
+	}
+	//
+	prefetch.numfills = 0;
+	prefetch.numthreads = numthreads;
+	for (i = 0; i < num; i++)
+	{
+		areanum = areas[i];
+		goalareanum = goalareas[i];
+		tfl = travelflags[i];
+		//
+		if (areanum <= 0 || areanum >= aasworld.numareas) continue;
+		if (goalareanum <= 0 || goalareanum >= aasworld.numareas) continue;
+		if (areanum == goalareanum) continue;
+		if (!aasworld.areasettings[areanum].numreachableareas ||
+				!aasworld.areasettings[goalareanum].numreachableareas) continue;
+		//
+		if (AAS_AreaDoNotEnter(areanum) || AAS_AreaDoNotEnter(goalareanum))
+		{
+			tfl |= TFL_DONOTENTER;
+		} //end if
+		//
+		clusternum = aasworld.areasettings[areanum].cluster;
+		goalclusternum = aasworld.areasettings[goalareanum].cluster;
+		//same cluster adjustments for portals as AAS_AreaRouteToGoalArea
+		if (clusternum < 0 && goalclusternum > 0)
+		{
+			portal = &aasworld.portals[-clusternum];
+			if (portal->frontcluster == goalclusternum ||
+					portal->backcluster == goalclusternum)
+			{
+				clusternum = goalclusternum;
+			} //end if
+		} //end if
+		else if (clusternum > 0 && goalclusternum < 0)
+		{
+			portal = &aasworld.portals[-goalclusternum];
+			if (portal->frontcluster == clusternum ||
+					portal->backcluster == clusternum)
+			{
+				goalclusternum = clusternum;
+			} //end if
+		} //end if
+		//
+		if (clusternum > 0 && goalclusternum > 0 && clusternum == goalclusternum)
+		{
+			AAS_PrefetchAreaRoutingCache(&prefetch, clusternum, goalareanum, tfl);
+			continue;
+		} //end if
+		//
+		clusternum = aasworld.areasettings[areanum].cluster;
+		goalclusternum = aasworld.areasettings[goalareanum].cluster;
+		if (goalclusternum < 0)
+		{
+			goalclusternum = aasworld.portals[-goalclusternum].frontcluster;
+		} //end if
+		//the portal routing cache starts with the goal area cache
+		if (goalclusternum > 0)
+		{
+			AAS_PrefetchAreaRoutingCache(&prefetch, goalclusternum, goalareanum, tfl);
+		} //end if
+		if (clusternum <= 0) continue;
+		//the caches towards the portals of the cluster the route starts in
+		cluster = &aasworld.clusters[clusternum];
+		for (j = 0; j < cluster->numportals; j++)
+		{
+			portal = &aasworld.portals[aasworld.portalindex[cluster->firstportal + j]];
+			AAS_PrefetchAreaRoutingCache(&prefetch, clusternum, portal->areanum, tfl);
+		} //end for
+	} //end for
+	//
+	if (!prefetch.numfills) return;
+	botimport.RunJobs(AAS_PrefetchRoutesJob, &prefetch, numthreads, numthreads);
+	//
+#ifdef ROUTING_DEBUG
+	numareacacheupdates += prefetch.numfills;
+#endif //ROUTING_DEBUG
+	aasworld.frameroutingupdates += prefetch.numfills;
+} //end of the function AAS_PrefetchRoutes
+//===========================================================================
+// throws away all routing caches and times filling the area and portal
+// caches towards every area of the loaded map, the travel time checksum
+// should not change between builds unless the routing itself changes
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_RoutingBench(void)
+{
+	int i, j, cluster, start, msec, areafills, portalfills;
+	unsigned int checksum;
+	aas_routingcache_t *cache;
+
+	if (!aasworld.loaded || !aasworld.initialized)
+	{
+		botimport.Print(PRT_MESSAGE, "no AAS file loaded\n");
+		return;
+	} //end if
+	AAS_FreeAllClusterAreaCache();
+	AAS_InitClusterAreaCache();
+	AAS_FreeAllPortalCache();
+	AAS_InitPortalCache();
+	//
+	//every area cache filled adds a routing update, every portal cache is
+	//filled once because all of them were just thrown away
+	areafills = aasworld.frameroutingupdates;
+	portalfills = 0;
+	checksum = 0;
+	start = botimport.Milliseconds();
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		cluster = aasworld.areasettings[i].cluster;
+		if (cluster <= 0) continue;
+		if (!aasworld.areasettings[i].numreachableareas) continue;
+		//
+		cache = AAS_GetAreaRoutingCache(cluster, i, TFL_DEFAULT);
+		for (j = 0; j < aasworld.clusters[cluster].numreachabilityareas; j++)
+		{
+			checksum = checksum * 31 + cache->traveltimes[j];
+		} //end for
+		cache = AAS_GetPortalRoutingCache(cluster, i, TFL_DEFAULT);
+		portalfills++;
+		for (j = 0; j < aasworld.numportals; j++)
+		{
+			checksum = checksum * 31 + cache->traveltimes[j];
+		} //end for
+	} //end for
+	msec = botimport.Milliseconds() - start;
+	areafills = aasworld.frameroutingupdates - areafills;
+	//
+	botimport.Print(PRT_MESSAGE, "%s: %d areas, %d clusters, %d portals\n", aasworld.mapname,
+					aasworld.numareas, aasworld.numclusters, aasworld.numportals);
+	botimport.Print(PRT_MESSAGE, "%d area and %d portal cache fills in %d msec, %1.0f fills/sec\n",
+					areafills, portalfills, msec, msec ? (areafills + portalfills) * 1000.0f / msec : 0);
+	botimport.Print(PRT_MESSAGE, "travel time checksum %08x\n", checksum);
+} //end of the function AAS_RoutingBench
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -1767,6 +2384,146 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 	return qtrue;
 } //end of the function AAS_AreaRouteToGoalArea
 //===========================================================================
+// returns the travel times from the area to the goal area through each of
+// the reachabilities the area can be left through, without the travel time
+// from an origin within the area to the start of the reachability.  Adding
+// that travel time and taking the smallest gives the same travel time as
+// AAS_AreaTravelTimeToGoalArea.  A reachability number of zero means no
+// travel time within the area is added.
+//
+// Parameter:			areanum			: start area
+//						goalareanum		: goal area
+//						travelflags		: travel flags
+//						reachnums		: reachability of each route
+//						traveltimes		: travel time of each route
+//						maxroutes		: maximum number of routes
+// Returns:				number of routes, -1 with more than maxroutes routes
+// Changes Globals:		-
+//===========================================================================
+int AAS_AreaRoutesToGoalArea(int areanum, int goalareanum, int travelflags,
+								int *reachnums, int *traveltimes, int maxroutes)
+{
+	int clusternum, goalclusternum, portalnum, i, j, numroutes, clusterareanum, reachnum, t;
+	aas_portal_t *portal;
+	aas_cluster_t *cluster;
+	aas_routingcache_t *areacache, *portalcache;
+
+	if (!aasworld.initialized) return 0;
+	if (maxroutes < 1) return -1;
+	//
+	if (areanum == goalareanum)
+	{
+		reachnums[0] = 0;
+		traveltimes[0] = 1;
+		return 1;
+	} //end if
+	if (areanum <= 0 || areanum >= aasworld.numareas) return 0;
+	if (goalareanum <= 0 || goalareanum >= aasworld.numareas) return 0;
+	if (!aasworld.areasettings[areanum].numreachableareas || !aasworld.areasettings[goalareanum].numreachableareas)
+	{
+		return 0;
+	} //end if
+	// make sure the routing cache doesn't grow to large
+	while(AvailableMemory() < 1 * 1024 * 1024) {
+		if (!AAS_FreeOldestCache()) break;
+	}
+	//
+	if (AAS_AreaDoNotEnter(areanum) || AAS_AreaDoNotEnter(goalareanum))
+	{
+		travelflags |= TFL_DONOTENTER;
+	} //end if
+	//
+	clusternum = aasworld.areasettings[areanum].cluster;
+	goalclusternum = aasworld.areasettings[goalareanum].cluster;
+	//check if the area is a portal of the goal area cluster
+	if (clusternum < 0 && goalclusternum > 0)
+	{
+		portal = &aasworld.portals[-clusternum];
+		if (portal->frontcluster == goalclusternum ||
+				portal->backcluster == goalclusternum)
+		{
+			clusternum = goalclusternum;
+		} //end if
+	} //end if
+	//check if the goalarea is a portal of the area cluster
+	else if (clusternum > 0 && goalclusternum < 0)
+	{
+		portal = &aasworld.portals[-goalclusternum];
+		if (portal->frontcluster == clusternum ||
+				portal->backcluster == clusternum)
+		{
+			goalclusternum = clusternum;
+		} //end if
+	} //end if
+	//if both areas are in the same cluster there's only one route
+	if (clusternum > 0 && goalclusternum > 0 && clusternum == goalclusternum)
+	{
+		areacache = AAS_GetAreaRoutingCache(clusternum, goalareanum, travelflags);
+		clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
+		cluster = &aasworld.clusters[clusternum];
+		if (clusterareanum >= cluster->numreachabilityareas) return 0;
+		if (areacache->traveltimes[clusterareanum] != 0)
+		{
+			reachnums[0] = aasworld.areasettings[areanum].firstreachablearea +
+							areacache->reachabilities[clusterareanum];
+			traveltimes[0] = areacache->traveltimes[clusterareanum];
+			return 1;
+		} //end if
+	} //end if
+	//
+	clusternum = aasworld.areasettings[areanum].cluster;
+	goalclusternum = aasworld.areasettings[goalareanum].cluster;
+	//if the goal area is a portal
+	if (goalclusternum < 0)
+	{
+		//just assume the goal area is part of the front cluster
+		portal = &aasworld.portals[-goalclusternum];
+		goalclusternum = portal->frontcluster;
+	} //end if
+	portalcache = AAS_GetPortalRoutingCache(goalclusternum, goalareanum, travelflags);
+	//from a cluster portal the travel time is read directly from the portal cache
+	if (clusternum < 0)
+	{
+		reachnums[0] = 0;
+		traveltimes[0] = portalcache->traveltimes[-clusternum];
+		return 1;
+	} //end if
+	//
+	numroutes = 0;
+	cluster = &aasworld.clusters[clusternum];
+	clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
+	if (clusterareanum >= cluster->numreachabilityareas) return 0;
+	for (i = 0; i < cluster->numportals; i++)
+	{
+		portalnum = aasworld.portalindex[cluster->firstportal + i];
+		if (!portalcache->traveltimes[portalnum]) continue;
+		//
+		portal = &aasworld.portals[portalnum];
+		areacache = AAS_GetAreaRoutingCache(clusternum, portal->areanum, travelflags);
+		if (!areacache->traveltimes[clusterareanum]) continue;
+		//same travel time as AAS_AreaRouteToGoalArea
+		t = (unsigned short) (portalcache->traveltimes[portalnum] + areacache->traveltimes[clusterareanum] +
+								aasworld.portalmaxtraveltimes[portalnum]);
+		reachnum = aasworld.areasettings[areanum].firstreachablearea +
+						areacache->reachabilities[clusterareanum];
+		//keep the best travel time for every reachability
+		for (j = 0; j < numroutes; j++)
+		{
+			if (reachnums[j] == reachnum) break;
+		} //end for
+		if (j < numroutes)
+		{
+			if (t < traveltimes[j]) traveltimes[j] = t;
+			continue;
+		} //end if
+		if (numroutes >= maxroutes) return -1;
+		reachnums[numroutes] = reachnum;
+		traveltimes[numroutes] = t;
+		numroutes++;
+	} //end for
+	return numroutes;
+} //end of the function AAS_AreaRoutesToGoalArea
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
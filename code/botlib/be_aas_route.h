@@ -55,10 +55,19 @@ void AAS_ReachabilityFromNum(int num, struct aas_reachability_s *reach);
 int AAS_RandomGoalArea(int areanum, int travelflags, int *goalareanum, vec3_t goalorigin);
 //enable or disable an area for routing
 int AAS_EnableRoutingArea(int areanum, int enable);
+//returns a number that changes whenever areas are enabled or disabled for routing
+int AAS_RoutingChanges(void);
 //returns the travel time within the given area from start to end
 unsigned short int AAS_AreaTravelTime(int areanum, vec3_t start, vec3_t end);
 //returns the travel time from the area to the goal area using the given travel flags
 int AAS_AreaTravelTimeToGoalArea(int areanum, vec3_t origin, int goalareanum, int travelflags);
+//returns the travel times from the area to the goal area through each reachability leaving the area
+int AAS_AreaRoutesToGoalArea(int areanum, int goalareanum, int travelflags,
+								int *reachnums, int *traveltimes, int maxroutes);
+//times filling the routing caches for the loaded map
+void AAS_RoutingBench(void);
+//fills the routing caches needed to route from the areas to the goal areas on the job threads
+void AAS_PrefetchRoutes(int *areas, int *goalareas, int *travelflags, int num);
 //predict a route up to a stop event
 int AAS_PredictRoute(struct aas_predictroute_s *route, int areanum, vec3_t origin,
 							int goalareanum, int travelflags, int maxareas, int maxtime,
@@ -203,6 +203,166 @@ void AAS_FreeAASLinkedEntities(void)
 	aasworld.arealinkedentities = NULL;
 } //end of the function AAS_InitAASLinkedEntities
 //===========================================================================
+// the point and trace queries descend the BSP tree, the packed nodes keep
+// the plane with the children so every step touches a single node record.
+// The grid stores for every cell the deepest node the whole cell is on one
+// side of all the planes above it, queries within a cell start there
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+#define SAMPLEGRID_MAXCELLS			(1 << 18)
+#define SAMPLEGRID_MINSHIFT			6
+#define SAMPLEGRID_EPSILON			1
+
+static int AAS_BoxStartNode(vec3_t mins, vec3_t maxs)
+{
+	int nodenum, i;
+	float front, back;
+	aas_samplenode_t *node;
+
+	nodenum = 1;
+	while (nodenum > 0)
+	{
+		node = &aasworld.samplenodes[nodenum];
+		front = back = -node->dist;
+		for (i = 0; i < 3; i++)
+		{
+			if (node->normal[i] > 0)
+			{
+				front += node->normal[i] * mins[i];
+				back += node->normal[i] * maxs[i];
+			} //end if
+			else
+			{
+				front += node->normal[i] * maxs[i];
+				back += node->normal[i] * mins[i];
+			} //end else
+		} //end for
+		//the box is completely at the front or back of the plane
+		if (front > SAMPLEGRID_EPSILON) nodenum = node->children[0];
+		else if (back < -SAMPLEGRID_EPSILON) nodenum = node->children[1];
+		else break;
+	} //end while
+	return nodenum;
+} //end of the function AAS_BoxStartNode
+
+void AAS_InitSampling(void)
+{
+	int i, x, y, z, numcells, cellsize;
+	vec3_t mins, maxs, cellmins, cellmaxs;
+	aas_node_t *node;
+	aas_plane_t *plane;
+
+	AAS_FreeSampling();
+	if (aasworld.numnodes <= 1) return;
+	//
+	aasworld.samplenodes = (aas_samplenode_t *) GetClearedHunkMemory(
+									aasworld.numnodes * sizeof(aas_samplenode_t));
+	for (i = 0; i < aasworld.numnodes; i++)
+	{
+		node = &aasworld.nodes[i];
+		plane = &aasworld.planes[node->planenum];
+		VectorCopy(plane->normal, aasworld.samplenodes[i].normal);
+		aasworld.samplenodes[i].dist = plane->dist;
+		aasworld.samplenodes[i].children[0] = node->children[0];
+		aasworld.samplenodes[i].children[1] = node->children[1];
+		aasworld.samplenodes[i].planenum = node->planenum;
+	} //end for
+	//the grid covers all the areas
+	ClearBounds(mins, maxs);
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		AddPointToBounds(aasworld.areas[i].mins, mins, maxs);
+		AddPointToBounds(aasworld.areas[i].maxs, mins, maxs);
+	} //end for
+	if (mins[0] > maxs[0]) return;
+	//
+	for (aasworld.samplegridshift = SAMPLEGRID_MINSHIFT; ; aasworld.samplegridshift++)
+	{
+		numcells = 1;
+		for (i = 0; i < 3; i++)
+		{
+			aasworld.samplegridsize[i] = ((int) (maxs[i] - mins[i]) >> aasworld.samplegridshift) + 1;
+			numcells *= aasworld.samplegridsize[i];
+		} //end for
+		if (numcells <= SAMPLEGRID_MAXCELLS) break;
+	} //end for
+	VectorCopy(mins, aasworld.samplegridorigin);
+	cellsize = 1 << aasworld.samplegridshift;
+	aasworld.samplegrid = (int *) GetClearedHunkMemory(numcells * sizeof(int));
+	//
+	i = 0;
+	for (z = 0; z < aasworld.samplegridsize[2]; z++)
+	{
+		for (y = 0; y < aasworld.samplegridsize[1]; y++)
+		{
+			for (x = 0; x < aasworld.samplegridsize[0]; x++)
+			{
+				cellmins[0] = mins[0] + x * cellsize;
+				cellmins[1] = mins[1] + y * cellsize;
+				cellmins[2] = mins[2] + z * cellsize;
+				VectorSet(cellmaxs, cellmins[0] + cellsize, cellmins[1] + cellsize, cellmins[2] + cellsize);
+				aasworld.samplegrid[i++] = AAS_BoxStartNode(cellmins, cellmaxs);
+			} //end for
+		} //end for
+	} //end for
+} //end of the function AAS_InitSampling
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FreeSampling(void)
+{
+	if (aasworld.samplenodes) FreeMemory(aasworld.samplenodes);
+	aasworld.samplenodes = NULL;
+	if (aasworld.samplegrid) FreeMemory(aasworld.samplegrid);
+	aasworld.samplegrid = NULL;
+} //end of the function AAS_FreeSampling
+//===========================================================================
+// returns the grid cell the point is in or -1 outside the grid
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE int AAS_SampleGridCell(vec3_t point)
+{
+	int i, c[3];
+	float f;
+
+	for (i = 0; i < 3; i++)
+	{
+		f = point[i] - aasworld.samplegridorigin[i];
+		//also false for NaN
+		if (!(f >= 0 && f < (float) (aasworld.samplegridsize[i] << aasworld.samplegridshift))) return -1;
+		c[i] = (int) f >> aasworld.samplegridshift;
+		if (c[i] >= aasworld.samplegridsize[i]) return -1;
+	} //end for
+	return (c[2] * aasworld.samplegridsize[1] + c[1]) * aasworld.samplegridsize[0] + c[0];
+} //end of the function AAS_SampleGridCell
+//===========================================================================
+// returns the node a query for the line from start to end can start at,
+// for a point start and end are the same
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE int AAS_LineStartNode(vec3_t start, vec3_t end)
+{
+	int cell;
+
+	if (!aasworld.samplegrid) return 1;
+	cell = AAS_SampleGridCell(start);
+	if (cell < 0) return 1;
+	if (end != start && AAS_SampleGridCell(end) != cell) return 1;
+	return aasworld.samplegrid[cell];
+} //end of the function AAS_LineStartNode
+//===========================================================================
 // returns the AAS area the point is in
 //
 // Parameter:				-
@@ -213,8 +373,7 @@ int AAS_PointAreaNum(vec3_t point)
 {
 	int nodenum;
 	vec_t	dist;
-	aas_node_t *node;
-	aas_plane_t *plane;
+	aas_samplenode_t *node;
 
 	if (!aasworld.loaded)
 	{
@@ -223,7 +382,7 @@ int AAS_PointAreaNum(vec3_t point)
 	} //end if
 
 	//start with node 1 because node zero is a dummy used for solid leafs
-	nodenum = 1;
+	nodenum = AAS_LineStartNode(point, point);
 	while (nodenum > 0)
 	{
 //		botimport.Print(PRT_MESSAGE, "[%d]", nodenum);
@@ -234,16 +393,8 @@ int AAS_PointAreaNum(vec3_t point)
 			return 0;
 		} //end if
 #endif //AAS_SAMPLE_DEBUG
-		node = &aasworld.nodes[nodenum];
-#ifdef AAS_SAMPLE_DEBUG
-		if (node->planenum < 0 || node->planenum >= aasworld.numplanes)
-		{
-			botimport.Print(PRT_ERROR, "node->planenum = %d >= aasworld.numplanes = %d\n", node->planenum, aasworld.numplanes);
-			return 0;
-		} //end if
-#endif //AAS_SAMPLE_DEBUG
-		plane = &aasworld.planes[node->planenum];
-		dist = DotProduct(point, plane->normal) - plane->dist;
+		node = &aasworld.samplenodes[nodenum];
+		dist = DotProduct(point, node->normal) - node->dist;
 		if (dist > 0) nodenum = node->children[0];
 		else nodenum = node->children[1];
 	} //end while
@@ -257,6 +408,103 @@ int AAS_PointAreaNum(vec3_t point)
 	return -nodenum;
 } //end of the function AAS_PointAreaNum
 //===========================================================================
+// times point area lookups and client bbox traces at random spots within
+// the areas, once starting at the grid cells and once at the root node
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+#define SAMPLEBENCH_POINTS			1000000
+#define SAMPLEBENCH_TRACES			100000
+
+void AAS_SampleBench(void)
+{
+	int i, pass, seed, start, msec[2][2], different, *grid, *results[2];
+	float *fractions[2];
+	vec3_t mins, maxs, point, end;
+	aas_trace_t trace;
+
+	if (!aasworld.loaded || !aasworld.samplegrid)
+	{
+		botimport.Print(PRT_MESSAGE, "no AAS file loaded\n");
+		return;
+	} //end if
+	VectorCopy(aasworld.samplegridorigin, mins);
+	for (i = 0; i < 3; i++)
+	{
+		maxs[i] = mins[i] + (aasworld.samplegridsize[i] << aasworld.samplegridshift);
+	} //end for
+	results[0] = (int *) GetMemory(SAMPLEBENCH_POINTS * sizeof(int));
+	results[1] = (int *) GetMemory(SAMPLEBENCH_POINTS * sizeof(int));
+	fractions[0] = (float *) GetMemory(SAMPLEBENCH_TRACES * sizeof(float));
+	fractions[1] = (float *) GetMemory(SAMPLEBENCH_TRACES * sizeof(float));
+	//the second pass starts every query at the root
+	grid = aasworld.samplegrid;
+	for (pass = 0; pass < 2; pass++)
+	{
+		aasworld.samplegrid = pass ? NULL : grid;
+		//the same random points both passes
+		seed = 12345;
+		start = botimport.Milliseconds();
+		for (i = 0; i < SAMPLEBENCH_POINTS; i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			point[0] = mins[0] + (maxs[0] - mins[0]) * ((seed >> 8) & 0xffff) / 65536.0f;
+			seed = seed * 1103515245 + 12345;
+			point[1] = mins[1] + (maxs[1] - mins[1]) * ((seed >> 8) & 0xffff) / 65536.0f;
+			seed = seed * 1103515245 + 12345;
+			point[2] = mins[2] + (maxs[2] - mins[2]) * ((seed >> 8) & 0xffff) / 65536.0f;
+			results[pass][i] = AAS_PointAreaNum(point);
+		} //end for
+		msec[pass][0] = botimport.Milliseconds() - start;
+		//short traces like the movement prediction does
+		start = botimport.Milliseconds();
+		for (i = 0; i < SAMPLEBENCH_TRACES; i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			point[0] = mins[0] + (maxs[0] - mins[0]) * ((seed >> 8) & 0xffff) / 65536.0f;
+			seed = seed * 1103515245 + 12345;
+			point[1] = mins[1] + (maxs[1] - mins[1]) * ((seed >> 8) & 0xffff) / 65536.0f;
+			seed = seed * 1103515245 + 12345;
+			point[2] = mins[2] + (maxs[2] - mins[2]) * ((seed >> 8) & 0xffff) / 65536.0f;
+			seed = seed * 1103515245 + 12345;
+			end[0] = point[0] + ((seed >> 8) & 63) - 32;
+			end[1] = point[1] + ((seed >> 14) & 63) - 32;
+			end[2] = point[2] - ((seed >> 20) & 31);
+			trace = AAS_TraceClientBBox(point, end, PRESENCE_NORMAL, -1);
+			fractions[pass][i] = trace.startsolid ? -1 : trace.fraction;
+		} //end for
+		msec[pass][1] = botimport.Milliseconds() - start;
+	} //end for
+	aasworld.samplegrid = grid;
+	//
+	different = 0;
+	for (i = 0; i < SAMPLEBENCH_POINTS; i++)
+	{
+		if (results[0][i] != results[1][i]) different++;
+	} //end for
+	for (i = 0; i < SAMPLEBENCH_TRACES; i++)
+	{
+		if (fractions[0][i] != fractions[1][i]) different++;
+	} //end for
+	botimport.Print(PRT_MESSAGE, "%s: %d nodes, %dx%dx%d grid of %d unit cells\n", aasworld.mapname,
+					aasworld.numnodes, aasworld.samplegridsize[0], aasworld.samplegridsize[1],
+					aasworld.samplegridsize[2], 1 << aasworld.samplegridshift);
+	for (pass = 0; pass < 2; pass++)
+	{
+		botimport.Print(PRT_MESSAGE, "%s: %1.0f points/sec, %1.0f traces/sec\n", pass ? "root" : "grid",
+					msec[pass][0] ? SAMPLEBENCH_POINTS * 1000.0f / msec[pass][0] : 0,
+					msec[pass][1] ? SAMPLEBENCH_TRACES * 1000.0f / msec[pass][1] : 0);
+	} //end for
+	botimport.Print(PRT_MESSAGE, "%d results differ\n", different);
+	//
+	FreeMemory(results[0]);
+	FreeMemory(results[1]);
+	FreeMemory(fractions[0]);
+	FreeMemory(fractions[1]);
+} //end of the function AAS_SampleBench
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -453,7 +701,7 @@ aas_trace_t AAS_TraceClientBBox(vec3_t start, vec3_t end, int presencetype,
 	vec3_t cur_start, cur_end, cur_mid, v1, v2;
 	aas_tracestack_t tracestack[127];
 	aas_tracestack_t *tstack_p;
-	aas_node_t *aasnode;
+	aas_samplenode_t *aasnode;
 	aas_plane_t *plane;
 	aas_trace_t trace;
 
@@ -468,7 +716,8 @@ aas_trace_t AAS_TraceClientBBox(vec3_t start, vec3_t end, int presencetype,
 	VectorCopy(end, tstack_p->end);
 	tstack_p->planenum = 0;
 	//start with node 1 because node zero is a dummy for a solid leaf
-	tstack_p->nodenum = 1;		//starting at the root of the tree
+	//or a node further down when the line is within one grid cell
+	tstack_p->nodenum = AAS_LineStartNode(start, end);
 	tstack_p++;
 	
 	while (1)
@@ -597,42 +846,15 @@ aas_trace_t AAS_TraceClientBBox(vec3_t start, vec3_t end, int presencetype,
 		} //end if
 #endif //AAS_SAMPLE_DEBUG
 		//the node to test against
-		aasnode = &aasworld.nodes[nodenum];
+		aasnode = &aasworld.samplenodes[nodenum];
 		//start point of current line to test against node
 		VectorCopy(tstack_p->start, cur_start);
 		//end point of the current line to test against node
 		VectorCopy(tstack_p->end, cur_end);
-		//the current node plane
-		plane = &aasworld.planes[aasnode->planenum];
-
-		switch(plane->type)
-		{/*FIXME: wtf doesn't this work? obviously the axial node planes aren't always facing positive!!!
-			//check for axial planes
-			case PLANE_X:
-			{
-				front = cur_start[0] - plane->dist;
-				back = cur_end[0] - plane->dist;
-				break;
-			} //end case
-			case PLANE_Y:
-			{
-				front = cur_start[1] - plane->dist;
-				back = cur_end[1] - plane->dist;
-				break;
-			} //end case
-			case PLANE_Z:
-			{
-				front = cur_start[2] - plane->dist;
-				back = cur_end[2] - plane->dist;
-				break;
-			} //end case*/
-			default: //gee it's not an axial plane
-			{
-				front = DotProduct(cur_start, plane->normal) - plane->dist;
-				back = DotProduct(cur_end, plane->normal) - plane->dist;
-				break;
-			} //end default
-		} //end switch
+		//the node plane, the axial planes don't always face positive
+		//so there's no shortcut for them
+		front = DotProduct(cur_start, aasnode->normal) - aasnode->dist;
+		back = DotProduct(cur_end, aasnode->normal) - aasnode->dist;
 		// bk010221 - old location of FPE hack and divide by zero expression
 		//if the whole to be traced line is totally at the front of this node
 		//only go down the tree with the front child
@@ -730,8 +952,7 @@ int AAS_TraceAreas(vec3_t start, vec3_t end, int *areas, vec3_t *points, int max
 	vec3_t cur_start, cur_end, cur_mid;
 	aas_tracestack_t tracestack[127];
 	aas_tracestack_t *tstack_p;
-	aas_node_t *aasnode;
-	aas_plane_t *plane;
+	aas_samplenode_t *aasnode;
 
 	numareas = 0;
 	areas[0] = 0;
@@ -743,7 +964,8 @@ int AAS_TraceAreas(vec3_t start, vec3_t end, int *areas, vec3_t *points, int max
 	VectorCopy(end, tstack_p->end);
 	tstack_p->planenum = 0;
 	//start with node 1 because node zero is a dummy for a solid leaf
-	tstack_p->nodenum = 1;		//starting at the root of the tree
+	//or a node further down when the line is within one grid cell
+	tstack_p->nodenum = AAS_LineStartNode(start, end);
 	tstack_p++;
 
 	while (1)
@@ -788,42 +1010,15 @@ int AAS_TraceAreas(vec3_t start, vec3_t end, int *areas, vec3_t *points, int max
 		} //end if
 #endif //AAS_SAMPLE_DEBUG
 		//the node to test against
-		aasnode = &aasworld.nodes[nodenum];
+		aasnode = &aasworld.samplenodes[nodenum];
 		//start point of current line to test against node
 		VectorCopy(tstack_p->start, cur_start);
 		//end point of the current line to test against node
 		VectorCopy(tstack_p->end, cur_end);
-		//the current node plane
-		plane = &aasworld.planes[aasnode->planenum];
-
-		switch(plane->type)
-		{/*FIXME: wtf doesn't this work? obviously the node planes aren't always facing positive!!!
-			//check for axial planes
-			case PLANE_X:
-			{
-				front = cur_start[0] - plane->dist;
-				back = cur_end[0] - plane->dist;
-				break;
-			} //end case
-			case PLANE_Y:
-			{
-				front = cur_start[1] - plane->dist;
-				back = cur_end[1] - plane->dist;
-				break;
-			} //end case
-			case PLANE_Z:
-			{
-				front = cur_start[2] - plane->dist;
-				back = cur_end[2] - plane->dist;
-				break;
-			} //end case*/
-			default: //gee it's not an axial plane
-			{
-				front = DotProduct(cur_start, plane->normal) - plane->dist;
-				back = DotProduct(cur_end, plane->normal) - plane->dist;
-				break;
-			} //end default
-		} //end switch
+		//the node plane, the axial planes don't always face positive
+		//so there's no shortcut for them
+		front = DotProduct(cur_start, aasnode->normal) - aasnode->dist;
+		back = DotProduct(cur_end, aasnode->normal) - aasnode->dist;
 
 		//if the whole to be traced line is totally at the front of this node
 		//only go down the tree with the front child
@@ -69,6 +69,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define RCKFL_GENDERLESS			256		//bot must be genderless
 //time to ignore a chat message after using it
 #define CHATMESSAGE_RECENTTIME	20
+//number of buckets words are hashed into, must be a power of two
+#define CHATWORD_HASHSIZE			1024
 
 //the actuall chat messages
 typedef struct bot_chatmessage_s
@@ -111,6 +113,7 @@ typedef struct bot_synonym_s
 {
 	char *string;
 	float weight;
+	int wordhash;						//hash of the first word
 	struct bot_synonym_s *next;
 } bot_synonym_t;
 //list with synonyms
@@ -165,6 +168,42 @@ typedef struct bot_replychat_s
 	struct bot_replychat_s *next;
 } bot_replychat_t;
 
+//synonym in the bucket of its first word
+typedef struct bot_synonymindex_s
+{
+	bot_synonymlist_t *syn;				//list the synonym is in
+	bot_synonym_t *synonym;
+	struct bot_synonymindex_s *next;	//next synonym in the same bucket
+} bot_synonymindex_t;
+
+//state of a chat automaton
+typedef struct bot_chatnode_s
+{
+	int c;								//upper case character leading to this state
+	int child;							//first state following this one
+	int sibling;						//next state with the same parent
+	int fail;							//state of the longest proper suffix
+	int output;							//first key ending in this state
+	int dictionary;						//next state on the fail chain with keys ending in it
+} bot_chatnode_t;
+//key ending in a state of a chat automaton
+typedef struct bot_chatoutput_s
+{
+	int owner;							//number of the template or reply chat with the key
+	int next;							//next key ending in the same state
+} bot_chatoutput_t;
+//automaton finding the keys of all templates or reply chats in one pass over a message
+typedef struct bot_chatautomaton_s
+{
+	int numnodes;
+	bot_chatnode_t *nodes;
+	int numoutputs;
+	bot_chatoutput_t *outputs;
+	int numowners;
+	char *always;						//owners tested whatever the message
+	char *candidates;					//owners that may match the last message
+} bot_chatautomaton_t;
+
 //string list
 typedef struct bot_stringlist_s
 {
@@ -209,6 +248,11 @@ bot_synonymlist_t *synonyms = NULL;
 bot_randomlist_t *randomstrings = NULL;
 //reply chats
 bot_replychat_t *replychats = NULL;
+//keys of the match templates and reply chats
+bot_chatautomaton_t *matchautomaton = NULL;
+bot_chatautomaton_t *replyautomaton = NULL;
+//reply synonyms in the buckets of their first word
+bot_synonymindex_t **synonymindex = NULL;
 
 //========================================================================
 //
@@ -544,12 +588,15 @@ char *StringContainsWord(char *str1, char *str2, int casesensitive)
 //===========================================================================
 //
 // Parameter:				-
-// Returns:					-
+// Returns:					qtrue if the string changed
 // Changes Globals:		-
 //===========================================================================
-void StringReplaceWords(char *string, char *synonym, char *replacement)
+int StringReplaceWords(char *string, char *synonym, char *replacement)
 {
 	char *str, *str2;
+	int replaced;
+
+	replaced = qfalse;
 
 	//find the synonym in the string
 	str = StringContainsWord(string, synonym, qfalse);
@@ -569,12 +616,215 @@ void StringReplaceWords(char *string, char *synonym, char *replacement)
 			memmove(str + strlen(replacement), str+strlen(synonym), strlen(str+strlen(synonym))+1);
 			//append the synonum replacement
 			Com_Memcpy(str, replacement, strlen(replacement));
+			replaced = qtrue;
 		} //end if
 		//find the next synonym in the string
 		str = StringContainsWord(str+strlen(replacement), synonym, qfalse);
 	} //end if
+	return replaced;
 } //end of the function StringReplaceWords
 //===========================================================================
+// hash of the word at the start of the string, words end where
+// StringContainsWord expects them to
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int BotChatWordHash(char *string)
+{
+	unsigned int hash;
+
+	hash = 0;
+	while(*string && *string != ' ' && *string != '.' && *string != ',' && *string != '!')
+	{
+		hash = hash * 31 + toupper(*string++);
+	} //end while
+	return hash & (CHATWORD_HASHSIZE-1);
+} //end of the function BotChatWordHash
+//===========================================================================
+// sets a bit for every word in the string, a word that can be found
+// with StringContainsWord always has its bit set
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void BotChatWordBits(char *string, unsigned char *bits)
+{
+	int hash;
+
+	Com_Memset(bits, 0, CHATWORD_HASHSIZE / 8);
+	while(1)
+	{
+		hash = BotChatWordHash(string);
+		bits[hash >> 3] |= 1 << (hash & 7);
+		//skip to the start of the next word
+		while(*string && *string != ' ' && *string != '.' && *string != ',' && *string != '!') string++;
+		if (!*string) break;
+		string++;
+	} //end while
+} //end of the function BotChatWordBits
+//===========================================================================
+//
+// Parameter:				numowners	: number of templates or reply chats
+//								numkeys		: number of keys that will be added
+//								numchars		: total length of those keys
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_chatautomaton_t *BotAllocChatAutomaton(int numowners, int numkeys, int numchars)
+{
+	bot_chatautomaton_t *ca;
+	char *ptr;
+
+	ptr = (char *) GetClearedMemory(sizeof(bot_chatautomaton_t) +
+						(numchars + 1) * sizeof(bot_chatnode_t) +
+						numkeys * sizeof(bot_chatoutput_t) +
+						numowners * 2);
+	ca = (bot_chatautomaton_t *) ptr;
+	ptr += sizeof(bot_chatautomaton_t);
+	ca->nodes = (bot_chatnode_t *) ptr;
+	ptr += (numchars + 1) * sizeof(bot_chatnode_t);
+	ca->outputs = (bot_chatoutput_t *) ptr;
+	ptr += numkeys * sizeof(bot_chatoutput_t);
+	ca->always = ptr;
+	ptr += numowners;
+	ca->candidates = ptr;
+	//the root state
+	ca->numnodes = 1;
+	ca->nodes[0].output = -1;
+	ca->numowners = numowners;
+	return ca;
+} //end of the function BotAllocChatAutomaton
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int BotChatAutomatonChild(bot_chatautomaton_t *ca, int nodenum, int c)
+{
+	int child;
+
+	for (child = ca->nodes[nodenum].child; child; child = ca->nodes[child].sibling)
+	{
+		if (ca->nodes[child].c == c) return child;
+	} //end for
+	return 0;
+} //end of the function BotChatAutomatonChild
+//===========================================================================
+// the key must not be empty
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void BotAddChatAutomatonKey(bot_chatautomaton_t *ca, char *key, int owner)
+{
+	int nodenum, child, c;
+	bot_chatnode_t *node;
+	bot_chatoutput_t *output;
+
+	nodenum = 0;
+	for (; *key; key++)
+	{
+		c = toupper(*key);
+		child = BotChatAutomatonChild(ca, nodenum, c);
+		if (!child)
+		{
+			child = ca->numnodes++;
+			node = &ca->nodes[child];
+			node->c = c;
+			node->child = 0;
+			node->sibling = ca->nodes[nodenum].child;
+			node->output = -1;
+			ca->nodes[nodenum].child = child;
+		} //end if
+		nodenum = child;
+	} //end for
+	output = &ca->outputs[ca->numoutputs];
+	output->owner = owner;
+	output->next = ca->nodes[nodenum].output;
+	ca->nodes[nodenum].output = ca->numoutputs++;
+} //end of the function BotAddChatAutomatonKey
+//===========================================================================
+// sets the fail and dictionary links breadth first after all keys are added
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void BotFinishChatAutomaton(bot_chatautomaton_t *ca)
+{
+	int *queue, head, tail, nodenum, child, fail, next;
+	bot_chatnode_t *node;
+
+	queue = (int *) GetMemory(ca->numnodes * sizeof(int));
+	head = tail = 0;
+	for (child = ca->nodes[0].child; child; child = ca->nodes[child].sibling)
+	{
+		ca->nodes[child].fail = 0;
+		ca->nodes[child].dictionary = 0;
+		queue[tail++] = child;
+	} //end for
+	while(head < tail)
+	{
+		nodenum = queue[head++];
+		for (child = ca->nodes[nodenum].child; child; child = ca->nodes[child].sibling)
+		{
+			node = &ca->nodes[child];
+			//longest proper suffix followed by the same character
+			fail = ca->nodes[nodenum].fail;
+			while(1)
+			{
+				next = BotChatAutomatonChild(ca, fail, node->c);
+				if (next || !fail) break;
+				fail = ca->nodes[fail].fail;
+			} //end while
+			node->fail = next;
+			if (ca->nodes[next].output >= 0) node->dictionary = next;
+			else node->dictionary = ca->nodes[next].dictionary;
+			queue[tail++] = child;
+		} //end for
+	} //end while
+	FreeMemory(queue);
+} //end of the function BotFinishChatAutomaton
+//===========================================================================
+// marks the templates or reply chats with a key anywhere in the string,
+// case insensitive like StringContains, and those that are always tested
+//
+// Parameter:				-
+// Returns:					array with a non-zero entry per candidate
+// Changes Globals:		-
+//===========================================================================
+char *BotChatAutomatonCandidates(bot_chatautomaton_t *ca, char *string)
+{
+	int nodenum, next, statenum, outputnum, c;
+
+	Com_Memcpy(ca->candidates, ca->always, ca->numowners);
+	nodenum = 0;
+	for (; *string; string++)
+	{
+		c = toupper(*string);
+		while(1)
+		{
+			next = BotChatAutomatonChild(ca, nodenum, c);
+			if (next || !nodenum) break;
+			nodenum = ca->nodes[nodenum].fail;
+		} //end while
+		nodenum = next;
+		for (statenum = nodenum; statenum; statenum = ca->nodes[statenum].dictionary)
+		{
+			for (outputnum = ca->nodes[statenum].output; outputnum >= 0; outputnum = ca->outputs[outputnum].next)
+			{
+				ca->candidates[ca->outputs[outputnum].owner] = 1;
+			} //end for
+		} //end for
+	} //end for
+	return ca->candidates;
+} //end of the function BotChatAutomatonCandidates
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -626,7 +876,7 @@ bot_synonymlist_t *BotLoadSynonyms(char *filename)
 		if (pass && size) ptr = (char *) GetClearedHunkMemory(size);
 		//
 		PC_SetBaseFolder(BOTFILESBASEFOLDER);
-		source = LoadSourceFile(filename);
+		source = LoadCachedSourceFile(filename);
 		if (!source)
 		{
 			botimport.Print(PRT_ERROR, "couldn't load %s\n", filename);
@@ -712,6 +962,7 @@ bot_synonymlist_t *BotLoadSynonyms(char *filename)
 							synonym->string = ptr;
 							ptr += len;
 							strcpy(synonym->string, token.string);
+							synonym->wordhash = BotChatWordHash(synonym->string);
 							//
 							if (lastsynonym) lastsynonym->next = synonym;
 							else syn->firstsynonym = synonym;
@@ -768,6 +1019,45 @@ bot_synonymlist_t *BotLoadSynonyms(char *filename)
 	return synlist;
 } //end of the function BotLoadSynonyms
 //===========================================================================
+// puts every synonym that can be replaced by BotReplaceReplySynonyms in the
+// bucket of its first word, the buckets keep the order of the synonym lists
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_synonymindex_t **BotIndexSynonyms(bot_synonymlist_t *synlist)
+{
+	int numsynonyms;
+	bot_synonymlist_t *syn;
+	bot_synonym_t *synonym;
+	bot_synonymindex_t **index, **last, *entry;
+
+	numsynonyms = 0;
+	for (syn = synlist; syn; syn = syn->next)
+	{
+		for (synonym = syn->firstsynonym->next; synonym; synonym = synonym->next) numsynonyms++;
+	} //end for
+	index = (bot_synonymindex_t **) GetClearedMemory(CHATWORD_HASHSIZE * sizeof(bot_synonymindex_t *) * 2 +
+											numsynonyms * sizeof(bot_synonymindex_t));
+	last = index + CHATWORD_HASHSIZE;
+	entry = (bot_synonymindex_t *) (last + CHATWORD_HASHSIZE);
+	for (syn = synlist; syn; syn = syn->next)
+	{
+		for (synonym = syn->firstsynonym->next; synonym; synonym = synonym->next)
+		{
+			entry->syn = syn;
+			entry->synonym = synonym;
+			entry->next = NULL;
+			if (last[synonym->wordhash]) last[synonym->wordhash]->next = entry;
+			else index[synonym->wordhash] = entry;
+			last[synonym->wordhash] = entry;
+			entry++;
+		} //end for
+	} //end for
+	return index;
+} //end of the function BotIndexSynonyms
+//===========================================================================
 // replace all the synonyms in the string
 //
 // Parameter:				-
@@ -778,13 +1068,21 @@ void BotReplaceSynonyms(char *string, unsigned long int context)
 {
 	bot_synonymlist_t *syn;
 	bot_synonym_t *synonym;
+	unsigned char words[CHATWORD_HASHSIZE / 8];
 
+	BotChatWordBits(string, words);
 	for (syn = synonyms; syn; syn = syn->next)
 	{
 		if (!(syn->context & context)) continue;
 		for (synonym = syn->firstsynonym->next; synonym; synonym = synonym->next)
 		{
-			StringReplaceWords(string, synonym->string, syn->firstsynonym->string);
+			//skip synonyms of which the first word isn't in the string
+			if (synonymindex && !(words[synonym->wordhash >> 3] & (1 << (synonym->wordhash & 7)))) continue;
+			//the replacement may have added words
+			if (StringReplaceWords(string, synonym->string, syn->firstsynonym->string))
+			{
+				BotChatWordBits(string, words);
+			} //end if
 		} //end for
 	} //end for
 } //end of the function BotReplaceSynonyms
@@ -799,7 +1097,9 @@ void BotReplaceWeightedSynonyms(char *string, unsigned long int context)
 	bot_synonymlist_t *syn;
 	bot_synonym_t *synonym, *replacement;
 	float weight, curweight;
+	unsigned char words[CHATWORD_HASHSIZE / 8];
 
+	BotChatWordBits(string, words);
 	for (syn = synonyms; syn; syn = syn->next)
 	{
 		if (!(syn->context & context)) continue;
@@ -817,7 +1117,13 @@ void BotReplaceWeightedSynonyms(char *string, unsigned long int context)
 		for (synonym = syn->firstsynonym; synonym; synonym = synonym->next)
 		{
 			if (synonym == replacement) continue;
-			StringReplaceWords(string, synonym->string, replacement->string);
+			//skip synonyms of which the first word isn't in the string
+			if (synonymindex && !(words[synonym->wordhash >> 3] & (1 << (synonym->wordhash & 7)))) continue;
+			//the replacement may have added words
+			if (StringReplaceWords(string, synonym->string, replacement->string))
+			{
+				BotChatWordBits(string, words);
+			} //end if
 		} //end for
 	} //end for
 } //end of the function BotReplaceWeightedSynonyms
@@ -827,11 +1133,44 @@ void BotReplaceWeightedSynonyms(char *string, unsigned long int context)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+// replaces the synonym with the first synonym of its list when it is at the
+// front of the string and the replacement isn't
+//
+// Parameter:				-
+// Returns:					qtrue if the synonym was replaced
+// Changes Globals:		-
+//===========================================================================
+int BotReplaceFrontSynonym(char *str1, bot_synonymlist_t *syn, bot_synonym_t *synonym)
+{
+	char *str2, *replacement;
+
+	//if the synonym is not at the front of the string continue
+	str2 = StringContainsWord(str1, synonym->string, qfalse);
+	if (!str2 || str2 != str1) return qfalse;
+	//
+	replacement = syn->firstsynonym->string;
+	//if the replacement IS in front of the string continue
+	str2 = StringContainsWord(str1, replacement, qfalse);
+	if (str2 && str2 == str1) return qfalse;
+	//
+	memmove(str1 + strlen(replacement), str1+strlen(synonym->string),
+				strlen(str1+strlen(synonym->string)) + 1);
+	//append the synonum replacement
+	Com_Memcpy(str1, replacement, strlen(replacement));
+	return qtrue;
+} //end of the function BotReplaceFrontSynonym
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 void BotReplaceReplySynonyms(char *string, unsigned long int context)
 {
-	char *str1, *str2, *replacement;
+	char *str1;
 	bot_synonymlist_t *syn;
 	bot_synonym_t *synonym;
+	bot_synonymindex_t *entry;
 
 	for (str1 = string; *str1; )
 	{
@@ -839,30 +1178,28 @@ void BotReplaceReplySynonyms(char *string, unsigned long int context)
 		while(*str1 && *str1 <= ' ') str1++;
 		if (!*str1) break;
 		//
-		for (syn = synonyms; syn; syn = syn->next)
+		if (synonymindex)
 		{
-			if (!(syn->context & context)) continue;
-			for (synonym = syn->firstsynonym->next; synonym; synonym = synonym->next)
+			//only synonyms starting with this word can be at the front
+			for (entry = synonymindex[BotChatWordHash(str1)]; entry; entry = entry->next)
 			{
-				//if the synonym is not at the front of the string continue
-				str2 = StringContainsWord(str1, synonym->string, qfalse);
-				if (!str2 || str2 != str1) continue;
-				//
-				replacement = syn->firstsynonym->string;
-				//if the replacement IS in front of the string continue
-				str2 = StringContainsWord(str1, replacement, qfalse);
-				if (str2 && str2 == str1) continue;
-				//
-				memmove(str1 + strlen(replacement), str1+strlen(synonym->string),
-							strlen(str1+strlen(synonym->string)) + 1);
-				//append the synonum replacement
-				Com_Memcpy(str1, replacement, strlen(replacement));
-				//
-				break;
+				if (!(entry->syn->context & context)) continue;
+				if (BotReplaceFrontSynonym(str1, entry->syn, entry->synonym)) break;
 			} //end for
-			//if a synonym has been replaced
-			if (synonym) break;
-		} //end for
+		} //end if
+		else
+		{
+			for (syn = synonyms; syn; syn = syn->next)
+			{
+				if (!(syn->context & context)) continue;
+				for (synonym = syn->firstsynonym->next; synonym; synonym = synonym->next)
+				{
+					if (BotReplaceFrontSynonym(str1, syn, synonym)) break;
+				} //end for
+				//if a synonym has been replaced
+				if (synonym) break;
+			} //end for
+		} //end else
 		//skip over this word
 		while(*str1 && *str1 > ' ') str1++;
 		if (!*str1) break;
@@ -981,7 +1318,7 @@ bot_randomlist_t *BotLoadRandomStrings(char *filename)
 		if (pass && size) ptr = (char *) GetClearedHunkMemory(size);
 		//
 		PC_SetBaseFolder(BOTFILESBASEFOLDER);
-		source = LoadSourceFile(filename);
+		source = LoadCachedSourceFile(filename);
 		if (!source)
 		{
 			botimport.Print(PRT_ERROR, "couldn't load %s\n", filename);
@@ -1283,7 +1620,7 @@ bot_matchtemplate_t *BotLoadMatchTemplates(char *matchfile)
 	unsigned long int context;
 
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
-	source = LoadSourceFile(matchfile);
+	source = LoadCachedSourceFile(matchfile);
 	if (!source)
 	{
 		botimport.Print(PRT_ERROR, "couldn't load %s\n", matchfile);
@@ -1369,6 +1706,85 @@ bot_matchtemplate_t *BotLoadMatchTemplates(char *matchfile)
 	return matches;
 } //end of the function BotLoadMatchTemplates
 //===========================================================================
+// the string piece most likely to be absent from a message, one of its
+// strings is in every message matching the pieces
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_matchpiece_t *BotMatchPiecesKey(bot_matchpiece_t *pieces)
+{
+	int len, minlen, bestlen;
+	bot_matchpiece_t *mp, *best;
+	bot_matchstring_t *ms;
+
+	best = NULL;
+	bestlen = 0;
+	for (mp = pieces; mp; mp = mp->next)
+	{
+		if (mp->type != MT_STRING) continue;
+		//the shortest string of the piece
+		minlen = 0;
+		for (ms = mp->firststring; ms; ms = ms->next)
+		{
+			len = strlen(ms->string);
+			if (ms == mp->firststring || len < minlen) minlen = len;
+		} //end for
+		//an empty string matches any message
+		if (minlen > bestlen)
+		{
+			best = mp;
+			bestlen = minlen;
+		} //end if
+	} //end for
+	return best;
+} //end of the function BotMatchPiecesKey
+//===========================================================================
+// compiles the key strings of all the match templates into one automaton
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_chatautomaton_t *BotCompileMatchTemplates(bot_matchtemplate_t *matches)
+{
+	int pass, numtemplates, numkeys, numchars;
+	bot_matchtemplate_t *mt;
+	bot_matchpiece_t *mp;
+	bot_matchstring_t *ms;
+	bot_chatautomaton_t *ca;
+
+	ca = NULL;
+	numkeys = numchars = 0;
+	//first count the keys then add them
+	for (pass = 0; pass < 2; pass++)
+	{
+		numtemplates = 0;
+		for (mt = matches; mt; mt = mt->next, numtemplates++)
+		{
+			mp = BotMatchPiecesKey(mt->first);
+			if (!mp)
+			{
+				if (pass) ca->always[numtemplates] = 1;
+				continue;
+			} //end if
+			for (ms = mp->firststring; ms; ms = ms->next)
+			{
+				if (pass) BotAddChatAutomatonKey(ca, ms->string, numtemplates);
+				else
+				{
+					numkeys++;
+					numchars += strlen(ms->string);
+				} //end else
+			} //end for
+		} //end for
+		if (!pass) ca = BotAllocChatAutomaton(numtemplates, numkeys, numchars);
+	} //end for
+	BotFinishChatAutomaton(ca);
+	return ca;
+} //end of the function BotCompileMatchTemplates
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -1453,8 +1869,9 @@ int StringsMatch(bot_matchpiece_t *pieces, bot_match_t *match)
 //===========================================================================
 int BotFindMatch(char *str, bot_match_t *match, unsigned long int context)
 {
-	int i;
+	int i, n;
 	bot_matchtemplate_t *ms;
+	char *candidates;
 
 	Q_strncpyz(match->string, str, MAX_MESSAGE_SIZE);
 	//remove any trailing enters
@@ -1463,10 +1880,14 @@ int BotFindMatch(char *str, bot_match_t *match, unsigned long int context)
 	{
 		match->string[strlen(match->string)-1] = '\0';
 	} //end while
+	//find the templates with a key in the string
+	candidates = NULL;
+	if (matchautomaton) candidates = BotChatAutomatonCandidates(matchautomaton, match->string);
 	//compare the string with all the match strings
-	for (ms = matchtemplates; ms; ms = ms->next)
+	for (ms = matchtemplates, n = 0; ms; ms = ms->next, n++)
 	{
 		if (!(ms->context & context)) continue;
+		if (candidates && !candidates[n]) continue;
 		//reset the match variable offsets
 		for (i = 0; i < MAX_MATCHVARIABLES; i++) match->variables[i].offset = -1;
 		//
@@ -1854,7 +2275,7 @@ bot_replychat_t *BotLoadReplyChat(char *filename)
 	bot_replychatkey_t *key;
 
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
-	source = LoadSourceFile(filename);
+	source = LoadCachedSourceFile(filename);
 	if (!source)
 	{
 		botimport.Print(PRT_ERROR, "couldn't load %s\n", filename);
@@ -1998,6 +2419,73 @@ bot_replychat_t *BotLoadReplyChat(char *filename)
 	return replychatlist;
 } //end of the function BotLoadReplyChat
 //===========================================================================
+// compiles the string keys of all the reply chats into one automaton, a
+// reply chat is only tested when the message has its longest must be
+// present string or any of its other strings
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_chatautomaton_t *BotCompileReplyChats(bot_replychat_t *replychatlist)
+{
+	int pass, numreplychats, numkeys, numchars, always, unindexed;
+	bot_replychat_t *rchat;
+	bot_replychatkey_t *key, *andkey;
+	bot_chatautomaton_t *ca;
+
+	ca = NULL;
+	numkeys = numchars = 0;
+	//first count the keys then add them
+	for (pass = 0; pass < 2; pass++)
+	{
+		numreplychats = 0;
+		for (rchat = replychatlist; rchat; rchat = rchat->next, numreplychats++)
+		{
+			always = unindexed = qfalse;
+			andkey = NULL;
+			for (key = rchat->keys; key; key = key->next)
+			{
+				//a failed match key still sets variables used by later replies
+				if (key->flags & RCKFL_VARIABLES) always = qtrue;
+				if (key->flags & RCKFL_NOT) continue;
+				if (!(key->flags & RCKFL_STRING) || !strlen(key->string))
+				{
+					if (!(key->flags & RCKFL_AND)) unindexed = qtrue;
+					continue;
+				} //end if
+				if (key->flags & RCKFL_AND)
+				{
+					if (!andkey || strlen(key->string) > strlen(andkey->string)) andkey = key;
+				} //end if
+			} //end for
+			if (unindexed && !andkey) always = qtrue;
+			if (always)
+			{
+				if (pass) ca->always[numreplychats] = 1;
+				continue;
+			} //end if
+			for (key = rchat->keys; key; key = key->next)
+			{
+				if (andkey)
+				{
+					if (key != andkey) continue;
+				} //end if
+				else if (key->flags & (RCKFL_AND|RCKFL_NOT)) continue;
+				if (pass) BotAddChatAutomatonKey(ca, key->string, numreplychats);
+				else
+				{
+					numkeys++;
+					numchars += strlen(key->string);
+				} //end else
+			} //end for
+		} //end for
+		if (!pass) ca = BotAllocChatAutomaton(numreplychats, numkeys, numchars);
+	} //end for
+	BotFinishChatAutomaton(ca);
+	return ca;
+} //end of the function BotCompileReplyChats
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -2053,7 +2541,7 @@ bot_chat_t *BotLoadInitialChat(char *chatfile, char *chatname)
 		if (pass && size) ptr = (char *) GetClearedMemory(size);
 		//load the source file
 		PC_SetBaseFolder(BOTFILESBASEFOLDER);
-		source = LoadSourceFile(chatfile);
+		source = LoadCachedSourceFile(chatfile);
 		if (!source)
 		{
 			botimport.Print(PRT_ERROR, "couldn't load %s\n", chatfile);
@@ -2628,17 +3116,57 @@ void BotPrintReplyChatKeys(bot_replychat_t *replychat)
 //===========================================================================
 //
 // Parameter:				-
+// Returns:					qtrue if the keys of the reply chat match the message
+// Changes Globals:		-
+//===========================================================================
+int BotReplyChatKeysMatch(bot_chatstate_t *cs, bot_replychat_t *rchat, char *message, bot_match_t *match)
+{
+	bot_replychatkey_t *key;
+	int found, res;
+
+	found = qfalse;
+	for (key = rchat->keys; key; key = key->next)
+	{
+		res = qfalse;
+		//get the match result
+		if (key->flags & RCKFL_NAME) res = (StringContains(message, cs->name, qfalse) != -1);
+		else if (key->flags & RCKFL_BOTNAMES) res = (StringContains(key->string, cs->name, qfalse) != -1);
+		else if (key->flags & RCKFL_GENDERFEMALE) res = (cs->gender == CHAT_GENDERFEMALE);
+		else if (key->flags & RCKFL_GENDERMALE) res = (cs->gender == CHAT_GENDERMALE);
+		else if (key->flags & RCKFL_GENDERLESS) res = (cs->gender == CHAT_GENDERLESS);
+		else if (key->flags & RCKFL_VARIABLES) res = StringsMatch(key->match, match);
+		else if (key->flags & RCKFL_STRING) res = (StringContainsWord(message, key->string, qfalse) != NULL);
+		//if the key must be present
+		if (key->flags & RCKFL_AND)
+		{
+			if (!res) return qfalse;
+		} //end else if
+		//if the key must be absent
+		else if (key->flags & RCKFL_NOT)
+		{
+			if (res) return qfalse;
+		} //end if
+		else if (res)
+		{
+			found = qtrue;
+		} //end else
+	} //end for
+	return found;
+} //end of the function BotReplyChatKeysMatch
+//===========================================================================
+//
+// Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
 int BotReplyChat(int chatstate, char *message, int mcontext, int vcontext, char *var0, char *var1, char *var2, char *var3, char *var4, char *var5, char *var6, char *var7)
 {
 	bot_replychat_t *rchat, *bestrchat;
-	bot_replychatkey_t *key;
 	bot_chatmessage_t *m, *bestchatmessage;
 	bot_match_t match, bestmatch;
-	int bestpriority, num, found, res, numchatmessages, index;
+	int bestpriority, num, found, numchatmessages, index, n;
 	bot_chatstate_t *cs;
+	char *candidates;
 
 	cs = BotChatStateFromHandle(chatstate);
 	if (!cs) return qfalse;
@@ -2647,44 +3175,14 @@ int BotReplyChat(int chatstate, char *message, int mcontext, int vcontext, char
 	bestpriority = -1;
 	bestchatmessage = NULL;
 	bestrchat = NULL;
+	//find the reply chats with a key in the message
+	candidates = NULL;
+	if (replyautomaton) candidates = BotChatAutomatonCandidates(replyautomaton, message);
 	//go through all the reply chats
-	for (rchat = replychats; rchat; rchat = rchat->next)
+	for (rchat = replychats, n = 0; rchat; rchat = rchat->next, n++)
 	{
-		found = qfalse;
-		for (key = rchat->keys; key; key = key->next)
-		{
-			res = qfalse;
-			//get the match result
-			if (key->flags & RCKFL_NAME) res = (StringContains(message, cs->name, qfalse) != -1);
-			else if (key->flags & RCKFL_BOTNAMES) res = (StringContains(key->string, cs->name, qfalse) != -1);
-			else if (key->flags & RCKFL_GENDERFEMALE) res = (cs->gender == CHAT_GENDERFEMALE);
-			else if (key->flags & RCKFL_GENDERMALE) res = (cs->gender == CHAT_GENDERMALE);
-			else if (key->flags & RCKFL_GENDERLESS) res = (cs->gender == CHAT_GENDERLESS);
-			else if (key->flags & RCKFL_VARIABLES) res = StringsMatch(key->match, &match);
-			else if (key->flags & RCKFL_STRING) res = (StringContainsWord(message, key->string, qfalse) != NULL);
-			//if the key must be present
-			if (key->flags & RCKFL_AND)
-			{
-				if (!res)
-				{
-					found = qfalse;
-					break;
-				} //end if
-			} //end else if
-			//if the key must be absent
-			else if (key->flags & RCKFL_NOT)
-			{
-				if (res)
-				{
-					found = qfalse;
-					break;
-				} //end if
-			} //end if
-			else if (res)
-			{
-				found = qtrue;
-			} //end else
-		} //end for
+		if (candidates && !candidates[n]) continue;
+		found = BotReplyChatKeysMatch(cs, rchat, message, &match);
 		//
 		if (found)
 		{
@@ -2957,6 +3455,164 @@ void BotFreeChatState(int handle)
 	botchatstates[handle] = NULL;
 } //end of the function BotFreeChatState
 //===========================================================================
+// times matching messages against the match templates, reply chats and
+// synonyms, once with and once without the compiled keys, the messages
+// are the reply chat lines and a message built from every match template
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+#define CHATBENCH_PASSES			8
+#define CHATBENCH_CONTEXTS			16
+
+void BotChatBench(void)
+{
+	int i, j, n, pass, indexed, start, msec[3][2], different[3], nummessages, best;
+	unsigned int hash, *results[3][2];
+	char *messages, *message, *candidates, buf[MAX_MESSAGE_SIZE];
+	bot_matchtemplate_t *mt;
+	bot_matchpiece_t *mp;
+	bot_replychat_t *rchat;
+	bot_chatmessage_t *m;
+	bot_chatstate_t cs;
+	bot_match_t match;
+	bot_chatautomaton_t *matchca, *replyca;
+	bot_synonymindex_t **synindex;
+
+	if (!matchtemplates && !replychats)
+	{
+		botimport.Print(PRT_MESSAGE, "no chat files loaded\n");
+		return;
+	} //end if
+	nummessages = 0;
+	for (mt = matchtemplates; mt; mt = mt->next) nummessages++;
+	for (rchat = replychats; rchat; rchat = rchat->next) nummessages += rchat->numchatmessages;
+	messages = (char *) GetClearedMemory(nummessages * MAX_MESSAGE_SIZE);
+	for (i = 0; i < 3; i++)
+	{
+		for (j = 0; j < 2; j++) results[i][j] = (unsigned int *) GetClearedMemory(nummessages * sizeof(unsigned int));
+	} //end for
+	//fill in the first string of every piece and a name for the variables
+	message = messages;
+	for (mt = matchtemplates; mt; mt = mt->next, message += MAX_MESSAGE_SIZE)
+	{
+		for (mp = mt->first; mp; mp = mp->next)
+		{
+			if (mp->type == MT_STRING) Q_strcat(message, MAX_MESSAGE_SIZE, mp->firststring->string);
+			else Q_strcat(message, MAX_MESSAGE_SIZE, "Sarge");
+		} //end for
+	} //end for
+	for (rchat = replychats; rchat; rchat = rchat->next)
+	{
+		for (m = rchat->firstchatmessage; m; m = m->next, message += MAX_MESSAGE_SIZE)
+		{
+			Com_sprintf(message, MAX_MESSAGE_SIZE, "Sarge: %s", m->chatmessage);
+		} //end for
+	} //end for
+	Com_Memset(&cs, 0, sizeof(bot_chatstate_t));
+	strcpy(cs.name, "Grunt");
+	cs.gender = CHAT_GENDERMALE;
+	//
+	matchca = matchautomaton;
+	replyca = replyautomaton;
+	synindex = synonymindex;
+	for (pass = 0; pass < 2; pass++)
+	{
+		//the first pass tests everything
+		indexed = (pass == 1);
+		matchautomaton = indexed ? matchca : NULL;
+		replyautomaton = indexed ? replyca : NULL;
+		synonymindex = indexed ? synindex : NULL;
+		//match templates
+		start = botimport.Milliseconds();
+		for (j = 0; j < CHATBENCH_PASSES; j++)
+		{
+			for (i = 0; i < nummessages; i++)
+			{
+				hash = 0;
+				for (n = 0; n < CHATBENCH_CONTEXTS; n++)
+				{
+					if (!BotFindMatch(&messages[i * MAX_MESSAGE_SIZE], &match, 1 << n)) continue;
+					hash = hash * 31 + match.type * 256 + match.subtype;
+					hash = hash * 31 + match.variables[0].offset * 256 + match.variables[0].length;
+					hash = hash * 31 + match.variables[1].offset * 256 + match.variables[1].length;
+				} //end for
+				results[0][indexed][i] = hash;
+			} //end for
+		} //end for
+		msec[0][indexed] = botimport.Milliseconds() - start;
+		//reply chats
+		start = botimport.Milliseconds();
+		for (j = 0; j < CHATBENCH_PASSES; j++)
+		{
+			for (i = 0; i < nummessages; i++)
+			{
+				message = &messages[i * MAX_MESSAGE_SIZE];
+				Com_Memset(&match, 0, sizeof(bot_match_t));
+				strcpy(match.string, message);
+				candidates = NULL;
+				if (replyautomaton) candidates = BotChatAutomatonCandidates(replyautomaton, message);
+				hash = 0;
+				best = -1;
+				for (rchat = replychats, n = 0; rchat; rchat = rchat->next, n++)
+				{
+					if (candidates && !candidates[n]) continue;
+					if (!BotReplyChatKeysMatch(&cs, rchat, message, &match)) continue;
+					//the reply chat BotReplyChat would choose a line from
+					if (rchat->priority > best)
+					{
+						best = rchat->priority;
+						hash = n + 1;
+					} //end if
+				} //end for
+				results[1][indexed][i] = hash;
+			} //end for
+		} //end for
+		msec[1][indexed] = botimport.Milliseconds() - start;
+		//synonyms
+		start = botimport.Milliseconds();
+		for (j = 0; j < CHATBENCH_PASSES; j++)
+		{
+			for (i = 0; i < nummessages; i++)
+			{
+				Q_strncpyz(buf, &messages[i * MAX_MESSAGE_SIZE], MAX_MESSAGE_SIZE);
+				BotReplaceSynonyms(buf, 0xFFFFFFFF);
+				BotReplaceReplySynonyms(buf, 0xFFFFFFFF);
+				hash = 0;
+				for (message = buf; *message; message++) hash = hash * 31 + *message;
+				results[2][indexed][i] = hash;
+			} //end for
+		} //end for
+		msec[2][indexed] = botimport.Milliseconds() - start;
+	} //end for
+	matchautomaton = matchca;
+	replyautomaton = replyca;
+	synonymindex = synindex;
+	//
+	for (i = 0; i < 3; i++)
+	{
+		different[i] = 0;
+		for (j = 0; j < nummessages; j++)
+		{
+			if (results[i][0][j] != results[i][1][j]) different[i]++;
+		} //end for
+	} //end for
+	botimport.Print(PRT_MESSAGE, "%d messages, %d times\n", nummessages, CHATBENCH_PASSES);
+	botimport.Print(PRT_MESSAGE, "match templates: %d msec linear, %d msec compiled, %d results differ\n",
+									msec[0][0], msec[0][1], different[0]);
+	botimport.Print(PRT_MESSAGE, "reply chats:     %d msec linear, %d msec compiled, %d results differ\n",
+									msec[1][0], msec[1][1], different[1]);
+	botimport.Print(PRT_MESSAGE, "synonyms:        %d msec linear, %d msec indexed, %d results differ\n",
+									msec[2][0], msec[2][1], different[2]);
+	//
+	FreeMemory(messages);
+	for (i = 0; i < 3; i++)
+	{
+		for (j = 0; j < 2; j++) FreeMemory(results[i][j]);
+	} //end for
+} //end of the function BotChatBench
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -2982,6 +3638,10 @@ int BotSetupChatAI(void)
 		file = LibVarString("rchatfile", "rchat.c");
 		replychats = BotLoadReplyChat(file);
 	} //end if
+	//index the keys of the templates, reply chats and synonyms
+	if (matchtemplates) matchautomaton = BotCompileMatchTemplates(matchtemplates);
+	if (replychats) replyautomaton = BotCompileReplyChats(replychats);
+	if (synonyms) synonymindex = BotIndexSynonyms(synonyms);
 
 	InitConsoleMessageHeap();
 
@@ -3028,4 +3688,10 @@ void BotShutdownChatAI(void)
 	synonyms = NULL;
 	if (replychats) BotFreeReplyChat(replychats);
 	replychats = NULL;
+	if (matchautomaton) FreeMemory(matchautomaton);
+	matchautomaton = NULL;
+	if (replyautomaton) FreeMemory(replyautomaton);
+	replyautomaton = NULL;
+	if (synonymindex) FreeMemory(synonymindex);
+	synonymindex = NULL;
 } //end of the function BotShutdownChatAI
@@ -110,4 +110,6 @@ int BotLoadChatFile(int chatstate, char *chatfile, char *chatname);
 void BotSetChatGender(int chatstate, int gender);
 //store the bot name in the chat state
 void BotSetChatName(int chatstate, char *name, int client);
+//time matching messages with and without the compiled chat keys
+void BotChatBench(void);
 
@@ -51,6 +51,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define UNDECIDEDFUZZY
 #endif //RANDOMIZE
 #define DROPPEDWEIGHT
+//number of travel flag sets with a table of item travel times
+#define MAX_ITEMTRAVELTABLES	4
+//routes towards an item stored per area, one for every way out of the area
+#define MAX_ITEMROUTES			4
+//areas with item travel times per table before the table is cleared
+#define MAX_ITEMTRAVELROWS		256
 //minimum avoid goal time
 #define AVOID_MINIMUM_TIME		10
 //default avoid goal time
@@ -120,6 +126,25 @@ typedef struct levelitem_s
 	struct levelitem_s *prev, *next;
 } levelitem_t;
 
+//travel times from an area towards a level item
+typedef struct itemtraveltime_s
+{
+	int goalareanum;					//goal area the travel times are for
+	int numroutes;						//number of routes, -1 if too many
+	int reachnums[MAX_ITEMROUTES];		//reachability the route leaves the area through
+	int traveltimes[MAX_ITEMROUTES];	//travel time without the start area
+} itemtraveltime_t;
+
+//travel times from the areas towards the level items for a set of travel flags
+typedef struct itemtraveltable_s
+{
+	int travelflags;					//travel flags the table is for
+	int routingchanges;					//AAS_RoutingChanges when filled
+	int numareas;						//number of areas
+	int numrows;						//number of areas with a row
+	itemtraveltime_t **areas;			//row with a travel time per level item
+} itemtraveltable_t;
+
 typedef struct iteminfo_s
 {
 	char classname[32];					//classname of the item
@@ -184,6 +209,13 @@ levelitem_t *levelitemheap = NULL;
 levelitem_t *freelevelitems = NULL;
 levelitem_t *levelitems = NULL;
 int numlevelitems = 0;
+int maxlevelitems = 0;
+//level items a bot may go for and their fuzzy weights
+levelitem_t **candidateitems = NULL;
+int *candidateweightnums = NULL;
+float *candidateweights = NULL;
+//travel times towards the level items
+itemtraveltable_t itemtraveltables[MAX_ITEMTRAVELTABLES];
 //map locations
 maplocation_t *maplocations = NULL;
 //camp spots
@@ -286,7 +318,7 @@ itemconfig_t *LoadItemConfig(char *filename)
 
 	Q_strncpyz(path, filename, sizeof(path));
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
-	source = LoadSourceFile( path );
+	source = LoadCachedSourceFile( path );
 	if( !source ) {
 		botimport.Print( PRT_ERROR, "couldn't load %s\n", path );
 		return NULL;
@@ -371,14 +403,149 @@ int *ItemWeightIndex(weightconfig_t *iwc, itemconfig_t *ic)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+// the travel times from the areas the bots pick goals in towards the level
+// items are kept in a table per set of travel flags, a row of the table is
+// allocated the first time a bot chooses a goal from that area and an entry
+// is calculated the first time it's looked up or when the item moved to
+// another area, the tables are cleared when areas are enabled or disabled
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void BotClearItemTravelTable(itemtraveltable_t *table)
+{
+	int i;
+
+	for (i = 0; i < table->numareas; i++)
+	{
+		if (table->areas[i]) FreeMemory(table->areas[i]);
+		table->areas[i] = NULL;
+	} //end for
+	table->numrows = 0;
+} //end of the function BotClearItemTravelTable
+
+static void BotFreeItemTravelTables(void)
+{
+	int i;
+	itemtraveltable_t *table;
+
+	for (i = 0; i < MAX_ITEMTRAVELTABLES; i++)
+	{
+		table = &itemtraveltables[i];
+		if (!table->areas) continue;
+		BotClearItemTravelTable(table);
+		FreeMemory(table->areas);
+		table->areas = NULL;
+		table->numareas = 0;
+	} //end for
+} //end of the function BotFreeItemTravelTables
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static itemtraveltable_t *BotItemTravelTable(int travelflags)
+{
+	int i, routingchanges;
+	itemtraveltable_t *table;
+
+	routingchanges = AAS_RoutingChanges();
+	for (i = 0; i < MAX_ITEMTRAVELTABLES; i++)
+	{
+		table = &itemtraveltables[i];
+		if (!table->areas)
+		{
+			table->areas = (itemtraveltime_t **) GetClearedMemory(AAS_NumAreas() * sizeof(itemtraveltime_t *));
+			table->numareas = AAS_NumAreas();
+			table->travelflags = travelflags;
+			table->routingchanges = routingchanges;
+			return table;
+		} //end if
+		if (table->travelflags != travelflags) continue;
+		//throw away the rows when areas were enabled or disabled
+		if (table->routingchanges != routingchanges)
+		{
+			BotClearItemTravelTable(table);
+			table->routingchanges = routingchanges;
+		} //end if
+		return table;
+	} //end for
+	return NULL;
+} //end of the function BotItemTravelTable
+//===========================================================================
+// returns the same travel time as AAS_AreaTravelTimeToGoalArea
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static int BotItemTravelTime(int areanum, vec3_t origin, levelitem_t *li, int travelflags)
+{
+	int i, t, besttime;
+	itemtraveltable_t *table;
+	itemtraveltime_t *row, *entry;
+	aas_reachability_t reach;
+
+	table = BotItemTravelTable(travelflags);
+	if (!table || areanum <= 0 || areanum >= table->numareas)
+	{
+		return AAS_AreaTravelTimeToGoalArea(areanum, origin, li->goalareanum, travelflags);
+	} //end if
+	//
+	row = table->areas[areanum];
+	if (!row)
+	{
+		//start over when the bots have been in too many areas
+		if (table->numrows >= MAX_ITEMTRAVELROWS) BotClearItemTravelTable(table);
+		row = (itemtraveltime_t *) GetClearedMemory(maxlevelitems * sizeof(itemtraveltime_t));
+		table->areas[areanum] = row;
+		table->numrows++;
+	} //end if
+	entry = &row[li - levelitemheap];
+	if (entry->goalareanum != li->goalareanum)
+	{
+		entry->goalareanum = li->goalareanum;
+		entry->numroutes = AAS_AreaRoutesToGoalArea(areanum, li->goalareanum, travelflags,
+										entry->reachnums, entry->traveltimes, MAX_ITEMROUTES);
+	} //end if
+	//too many ways out of the area to store
+	if (entry->numroutes < 0)
+	{
+		return AAS_AreaTravelTimeToGoalArea(areanum, origin, li->goalareanum, travelflags);
+	} //end if
+	//add the travel time from the origin to the start of each route
+	besttime = 0;
+	for (i = 0; i < entry->numroutes; i++)
+	{
+		t = entry->traveltimes[i];
+		if (entry->reachnums[i])
+		{
+			AAS_ReachabilityFromNum(entry->reachnums[i], &reach);
+			t = (unsigned short) (t + AAS_AreaTravelTime(areanum, origin, reach.start));
+		} //end if
+		if (!besttime || t < besttime) besttime = t;
+	} //end for
+	return besttime;
+} //end of the function BotItemTravelTime
+//===========================================================================
 void InitLevelItemHeap(void)
 {
 	int i, max_levelitems;
 
 	if (levelitemheap) FreeMemory(levelitemheap);
+	if (candidateitems) FreeMemory(candidateitems);
 
 	max_levelitems = (int) LibVarValue("max_levelitems", "256");
 	levelitemheap = (levelitem_t *) GetClearedMemory(max_levelitems * sizeof(levelitem_t));
+	maxlevelitems = max_levelitems;
+	candidateitems = (levelitem_t **) GetClearedMemory(max_levelitems *
+						(sizeof(levelitem_t *) + sizeof(int) + sizeof(float)));
+	candidateweightnums = (int *) (candidateitems + max_levelitems);
+	candidateweights = (float *) (candidateweightnums + max_levelitems);
+	//the item travel times are indexed with the heap
+	BotFreeItemTravelTables();
 
 	for (i = 0; i < max_levelitems-1; i++)
 	{
@@ -1282,6 +1449,71 @@ int BotGetSecondGoal(int goalstate, bot_goal_t *goal)
 	return qtrue;
 } //end of the function BotGetSecondGoal
 //===========================================================================
+// collects the level items the bot may go for and evaluates their fuzzy
+// weights in one pass, in the order of the level item list so the
+// undecided weights draw the same random numbers as one call per item
+//
+// Parameter:				-
+// Returns:					number of candidate items
+// Changes Globals:		candidateitems, candidateweightnums, candidateweights
+//===========================================================================
+static int BotCandidateGoalItems(bot_goalstate_t *gs, int *inventory)
+{
+	int i, numitems, weightnum;
+	levelitem_t *li;
+
+	if (!itemconfig) return 0;
+	numitems = 0;
+	for (li = levelitems; li && numitems < maxlevelitems; li = li->next)
+	{
+		if (g_gametype == GT_SINGLE_PLAYER) {
+			if (li->flags & IFL_NOTSINGLE)
+				continue;
+		}
+		else if (g_gametype >= GT_TEAM) {
+			if (li->flags & IFL_NOTTEAM)
+				continue;
+		}
+		else {
+			if (li->flags & IFL_NOTFREE)
+				continue;
+		}
+		if (li->flags & IFL_NOTBOT)
+			continue;
+		//if the item is not in a possible goal area
+		if (!li->goalareanum)
+			continue;
+		//FIXME: is this a good thing? added this for items that never spawned into the game (f.i. CTF flags in obelisk)
+		if (!li->entitynum && !(li->flags & IFL_ROAM))
+			continue;
+		//get the fuzzy weight function for this item
+		weightnum = gs->itemweightindex[itemconfig->iteminfo[li->iteminfo].number];
+		if (weightnum < 0)
+			continue;
+		candidateitems[numitems] = li;
+		candidateweightnums[numitems] = weightnum;
+		numitems++;
+	} //end for
+	//
+#ifdef UNDECIDEDFUZZY
+	FuzzyWeightsUndecided(inventory, gs->itemweightconfig, candidateweightnums, candidateweights, numitems);
+#else
+	FuzzyWeights(inventory, gs->itemweightconfig, candidateweightnums, candidateweights, numitems);
+#endif //UNDECIDEDFUZZY
+	for (i = 0; i < numitems; i++)
+	{
+		li = candidateitems[i];
+#ifdef DROPPEDWEIGHT
+		//HACK: to make dropped items more attractive
+		if (li->timeout)
+			candidateweights[i] += droppedweight->value;
+#endif //DROPPEDWEIGHT
+		//use weight scale for item_botroam
+		if (li->flags & IFL_ROAM) candidateweights[i] *= li->weight;
+	} //end for
+	return numitems;
+} //end of the function BotCandidateGoalItems
+//===========================================================================
 // pops a new long term goal on the goal stack in the goalstate
 //
 // Parameter:				-
@@ -1290,7 +1522,7 @@ int BotGetSecondGoal(int goalstate, bot_goal_t *goal)
 //===========================================================================
 int BotChooseLTGItem(int goalstate, vec3_t origin, int *inventory, int travelflags)
 {
-	int areanum, t, weightnum;
+	int areanum, t, i, numitems;
 	float weight, bestweight, avoidtime;
 	iteminfo_t *iteminfo;
 	itemconfig_t *ic;
@@ -1325,51 +1557,16 @@ int BotChooseLTGItem(int goalstate, vec3_t origin, int *inventory, int travelfla
 	bestitem = NULL;
 	Com_Memset(&goal, 0, sizeof(bot_goal_t));
 	//go through the items in the level
-	for (li = levelitems; li; li = li->next)
+	numitems = BotCandidateGoalItems(gs, inventory);
+	for (i = 0; i < numitems; i++)
 	{
-		if (g_gametype == GT_SINGLE_PLAYER) {
-			if (li->flags & IFL_NOTSINGLE)
-				continue;
-		}
-		else if (g_gametype >= GT_TEAM) {
-			if (li->flags & IFL_NOTTEAM)
-				continue;
-		}
-		else {
-			if (li->flags & IFL_NOTFREE)
-				continue;
-		}
-		if (li->flags & IFL_NOTBOT)
-			continue;
-		//if the item is not in a possible goal area
-		if (!li->goalareanum)
-			continue;
-		//FIXME: is this a good thing? added this for items that never spawned into the game (f.i. CTF flags in obelisk)
-		if (!li->entitynum && !(li->flags & IFL_ROAM))
-			continue;
-		//get the fuzzy weight function for this item
-		iteminfo = &ic->iteminfo[li->iteminfo];
-		weightnum = gs->itemweightindex[iteminfo->number];
-		if (weightnum < 0)
-			continue;
-
-#ifdef UNDECIDEDFUZZY
-		weight = FuzzyWeightUndecided(inventory, gs->itemweightconfig, weightnum);
-#else
-		weight = FuzzyWeight(inventory, gs->itemweightconfig, weightnum);
-#endif //UNDECIDEDFUZZY
-#ifdef DROPPEDWEIGHT
-		//HACK: to make dropped items more attractive
-		if (li->timeout)
-			weight += droppedweight->value;
-#endif //DROPPEDWEIGHT
-		//use weight scale for item_botroam
-		if (li->flags & IFL_ROAM) weight *= li->weight;
+		li = candidateitems[i];
+		weight = candidateweights[i];
 		//
 		if (weight > 0)
 		{
 			//get the travel time towards the goal area
-			t = AAS_AreaTravelTimeToGoalArea(areanum, origin, li->goalareanum, travelflags);
+			t = BotItemTravelTime(areanum, origin, li, travelflags);
 			//if the goal is reachable
 			if (t > 0)
 			{
@@ -1458,7 +1655,7 @@ int BotChooseLTGItem(int goalstate, vec3_t origin, int *inventory, int travelfla
 int BotChooseNBGItem(int goalstate, vec3_t origin, int *inventory, int travelflags,
 														bot_goal_t *ltg, float maxtime)
 {
-	int areanum, t, weightnum, ltg_time;
+	int areanum, t, i, numitems, ltg_time;
 	float weight, bestweight, avoidtime;
 	iteminfo_t *iteminfo;
 	itemconfig_t *ic;
@@ -1496,51 +1693,16 @@ int BotChooseNBGItem(int goalstate, vec3_t origin, int *inventory, int travelfla
 	bestitem = NULL;
 	Com_Memset(&goal, 0, sizeof(bot_goal_t));
 	//go through the items in the level
-	for (li = levelitems; li; li = li->next)
+	numitems = BotCandidateGoalItems(gs, inventory);
+	for (i = 0; i < numitems; i++)
 	{
-		if (g_gametype == GT_SINGLE_PLAYER) {
-			if (li->flags & IFL_NOTSINGLE)
-				continue;
-		}
-		else if (g_gametype >= GT_TEAM) {
-			if (li->flags & IFL_NOTTEAM)
-				continue;
-		}
-		else {
-			if (li->flags & IFL_NOTFREE)
-				continue;
-		}
-		if (li->flags & IFL_NOTBOT)
-			continue;
-		//if the item is in a possible goal area
-		if (!li->goalareanum)
-			continue;
-		//FIXME: is this a good thing? added this for items that never spawned into the game (f.i. CTF flags in obelisk)
-		if (!li->entitynum && !(li->flags & IFL_ROAM))
-			continue;
-		//get the fuzzy weight function for this item
-		iteminfo = &ic->iteminfo[li->iteminfo];
-		weightnum = gs->itemweightindex[iteminfo->number];
-		if (weightnum < 0)
-			continue;
-		//
-#ifdef UNDECIDEDFUZZY
-		weight = FuzzyWeightUndecided(inventory, gs->itemweightconfig, weightnum);
-#else
-		weight = FuzzyWeight(inventory, gs->itemweightconfig, weightnum);
-#endif //UNDECIDEDFUZZY
-#ifdef DROPPEDWEIGHT
-		//HACK: to make dropped items more attractive
-		if (li->timeout)
-			weight += droppedweight->value;
-#endif //DROPPEDWEIGHT
-		//use weight scale for item_botroam
-		if (li->flags & IFL_ROAM) weight *= li->weight;
+		li = candidateitems[i];
+		weight = candidateweights[i];
 		//
 		if (weight > 0)
 		{
 			//get the travel time towards the goal area
-			t = AAS_AreaTravelTimeToGoalArea(areanum, origin, li->goalareanum, travelflags);
+			t = BotItemTravelTime(areanum, origin, li, travelflags);
 			//if the goal is reachable
 			if (t > 0 && t < maxtime)
 			{
@@ -1607,6 +1769,93 @@ int BotChooseNBGItem(int goalstate, vec3_t origin, int *inventory, int travelfla
 	return qtrue;
 } //end of the function BotChooseNBGItem
 //===========================================================================
+// times the item travel time lookups of numbots bots choosing goals from
+// random areas, once straight from the routing and once with the tables,
+// a goal selection looks up the travel time towards every level item
+//
+// Parameter:				numbots		: number of bots choosing goals
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+#define ITEMBENCH_SELECTIONS		32
+
+void BotItemGoalBench(int numbots)
+{
+	int i, j, pass, table, numareas, numitems, seed, start, msec[2], different;
+	int *areas, *times[2];
+	vec3_t *origins;
+	levelitem_t *li;
+	aas_areainfo_t info;
+
+	if (!AAS_Loaded() || !levelitemheap)
+	{
+		botimport.Print(PRT_MESSAGE, "no AAS file loaded\n");
+		return;
+	} //end if
+	if (numbots <= 0) numbots = 32;
+	numareas = AAS_NumAreas();
+	//
+	areas = (int *) GetClearedMemory(numbots * sizeof(int));
+	origins = (vec3_t *) GetClearedMemory(numbots * sizeof(vec3_t));
+	times[0] = (int *) GetClearedMemory(numbots * maxlevelitems * sizeof(int));
+	times[1] = (int *) GetClearedMemory(numbots * maxlevelitems * sizeof(int));
+	//the same random areas with reachabilities every run
+	seed = 12345;
+	for (i = 0; i < numbots; i++)
+	{
+		for (j = 0; j < 1000; j++)
+		{
+			seed = seed * 1103515245 + 12345;
+			areas[i] = 1 + ((seed >> 8) & 0x7fffff) % (numareas - 1);
+			if (AAS_AreaReachability(areas[i])) break;
+		} //end for
+		AAS_AreaInfo(areas[i], &info);
+		VectorCopy(info.center, origins[i]);
+	} //end for
+	//
+	BotFreeItemTravelTables();
+	numitems = 0;
+	//the first pass only fills the routing caches
+	for (pass = 0; pass < 3; pass++)
+	{
+		table = (pass == 2);
+		start = botimport.Milliseconds();
+		for (j = 0; j < ITEMBENCH_SELECTIONS; j++)
+		{
+			for (i = 0; i < numbots; i++)
+			{
+				numitems = 0;
+				for (li = levelitems; li; li = li->next)
+				{
+					if (!li->goalareanum) continue;
+					if (!li->entitynum && !(li->flags & IFL_ROAM)) continue;
+					if (table) times[table][i * maxlevelitems + numitems] = BotItemTravelTime(areas[i], origins[i], li, TFL_DEFAULT);
+					else times[table][i * maxlevelitems + numitems] = AAS_AreaTravelTimeToGoalArea(areas[i], origins[i], li->goalareanum, TFL_DEFAULT);
+					numitems++;
+				} //end for
+			} //end for
+		} //end for
+		msec[table] = botimport.Milliseconds() - start;
+	} //end for
+	//
+	different = 0;
+	for (i = 0; i < numbots * maxlevelitems; i++)
+	{
+		if (times[0][i] != times[1][i]) different++;
+	} //end for
+	botimport.Print(PRT_MESSAGE, "%d bots, %d items, %d goal selections each\n", numbots, numitems, ITEMBENCH_SELECTIONS);
+	botimport.Print(PRT_MESSAGE, "routing: %d msec, %1.0f selections/sec\n", msec[0],
+					msec[0] ? numbots * ITEMBENCH_SELECTIONS * 1000.0f / msec[0] : 0);
+	botimport.Print(PRT_MESSAGE, "tables:  %d msec, %1.0f selections/sec\n", msec[1],
+					msec[1] ? numbots * ITEMBENCH_SELECTIONS * 1000.0f / msec[1] : 0);
+	botimport.Print(PRT_MESSAGE, "%d travel times differ\n", different);
+	//
+	FreeMemory(areas);
+	FreeMemory(origins);
+	FreeMemory(times[0]);
+	FreeMemory(times[1]);
+} //end of the function BotItemGoalBench
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -1810,8 +2059,13 @@ void BotShutdownGoalAI(void)
 
 	if (itemconfig) FreeMemory(itemconfig);
 	itemconfig = NULL;
+	BotFreeItemTravelTables();
 	if (levelitemheap) FreeMemory(levelitemheap);
 	levelitemheap = NULL;
+	if (candidateitems) FreeMemory(candidateitems);
+	candidateitems = NULL;
+	candidateweightnums = NULL;
+	candidateweights = NULL;
 	freelevelitems = NULL;
 	levelitems = NULL;
 	numlevelitems = 0;
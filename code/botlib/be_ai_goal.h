@@ -79,6 +79,8 @@ int BotChooseLTGItem(int goalstate, vec3_t origin, int *inventory, int travelfla
 //be larger than the travel time towards the long term goal from the current bot position
 int BotChooseNBGItem(int goalstate, vec3_t origin, int *inventory, int travelflags,
 							bot_goal_t *ltg, float maxtime);
+//times the item travel time lookups of the given number of bots choosing goals
+void BotItemGoalBench(int numbots);
 //returns true if the bot touches the goal
 int BotTouchingGoal(vec3_t origin, bot_goal_t *goal);
 //returns true if the goal should be visible but isn't
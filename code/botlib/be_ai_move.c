@@ -69,6 +69,8 @@ typedef struct bot_movestate_s
 	int areanum;								//area the bot is in
 	int lastareanum;							//last area the bot was in
 	int lastgoalareanum;						//last goal area number
+	int routegoalareanum;						//goal area of the last move to goal
+	int routetravelflags;						//travel flags of the last move to goal
 	int lastreachnum;							//last reachability number
 	vec3_t lastorigin;							//origin previous cycle
 	int reachareanum;							//area number of the reachabilty
@@ -3031,6 +3033,9 @@ void BotMoveToGoal(bot_moveresult_t *result, int movestate, bot_goal_t *goal, in
 		result->failure = qtrue;
 		return;
 	} //end if
+	//remember the route so it can be prefetched next frame
+	ms->routegoalareanum = goal->areanum;
+	ms->routetravelflags = travelflags;
 	//botimport.Print(PRT_MESSAGE, "numavoidreach = %d\n", ms->numavoidreach);
 	//remove some of the move flags
 	ms->moveflags &= ~(MFL_SWIMMING|MFL_AGAINSTLADDER);
@@ -3538,6 +3543,32 @@ int BotSetupMoveAI(void)
 	return BLERR_NOERROR;
 } //end of the function BotSetupMoveAI
 //===========================================================================
+// fills the routing caches for the routes the bots moved along last frame
+// on the job threads, the bots mostly keep their goals between frames
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void BotPrefetchMoveRoutes(void)
+{
+	int i, num;
+	int areas[MAX_CLIENTS], goalareas[MAX_CLIENTS], travelflags[MAX_CLIENTS];
+	bot_movestate_t *ms;
+
+	num = 0;
+	for (i = 1; i <= MAX_CLIENTS; i++)
+	{
+		ms = botmovestates[i];
+		if (!ms || !ms->routegoalareanum) continue;
+		areas[num] = ms->areanum;
+		goalareas[num] = ms->routegoalareanum;
+		travelflags[num] = ms->routetravelflags;
+		num++;
+	} //end for
+	if (num) AAS_PrefetchRoutes(areas, goalareas, travelflags, num);
+} //end of the function BotPrefetchMoveRoutes
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
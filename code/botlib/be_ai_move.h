@@ -139,4 +139,6 @@ void BotSetBrushModelTypes(void);
 int BotSetupMoveAI(void);
 //shutdown movement AI
 void BotShutdownMoveAI(void);
+//fills the routing caches for the routes of the bots on the job threads
+void BotPrefetchMoveRoutes(void);
 
@@ -123,6 +123,7 @@ typedef struct bot_weaponstate_s
 {
 	struct weightconfig_s *weaponweightconfig;		//weapon weight configuration
 	int *weaponweightindex;							//weapon weight index
+	float *weaponweights;							//weights of the last weapon choice
 } bot_weaponstate_t;
 
 static bot_weaponstate_t *botweaponstates[MAX_CLIENTS+1];
@@ -221,7 +222,7 @@ weaponconfig_t *LoadWeaponConfig(char *filename)
 	} //end if
 	Q_strncpyz(path, filename, sizeof(path));
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
-	source = LoadSourceFile(path);
+	source = LoadCachedSourceFile(path);
 	if (!source)
 	{
 		botimport.Print(PRT_ERROR, "couldn't load %s\n", path);
@@ -354,6 +355,8 @@ void BotFreeWeaponWeights(int weaponstate)
 	if (!ws) return;
 	if (ws->weaponweightconfig) FreeWeightConfig(ws->weaponweightconfig);
 	if (ws->weaponweightindex) FreeMemory(ws->weaponweightindex);
+	if (ws->weaponweights) FreeMemory(ws->weaponweights);
+	ws->weaponweights = NULL;
 } //end of the function BotFreeWeaponWeights
 //===========================================================================
 //
@@ -377,6 +380,7 @@ int BotLoadWeaponWeights(int weaponstate, char *filename)
 	} //end if
 	if (!weaponconfig) return BLERR_CANNOTLOADWEAPONCONFIG;
 	ws->weaponweightindex = WeaponWeightIndex(ws->weaponweightconfig, weaponconfig);
+	ws->weaponweights = (float *) GetClearedMemory(weaponconfig->numweapons * sizeof(float));
 	return BLERR_NOERROR;
 } //end of the function BotLoadWeaponWeights
 //===========================================================================
@@ -403,8 +407,8 @@ void BotGetWeaponInfo(int weaponstate, int weapon, weaponinfo_t *weaponinfo)
 //===========================================================================
 int BotChooseBestFightWeapon(int weaponstate, int *inventory)
 {
-	int i, index, bestweapon;
-	float weight, bestweight;
+	int i, bestweapon;
+	float bestweight;
 	weaponconfig_t *wc;
 	bot_weaponstate_t *ws;
 
@@ -416,17 +420,16 @@ int BotChooseBestFightWeapon(int weaponstate, int *inventory)
 	//if the bot has no weapon weight configuration
 	if (!ws->weaponweightconfig) return 0;
 
+	//the weights of all the weapons in one pass, weapons without a weight get zero
+	FuzzyWeights(inventory, ws->weaponweightconfig, ws->weaponweightindex, ws->weaponweights, wc->numweapons);
 	bestweight = 0;
 	bestweapon = 0;
 	for (i = 0; i < wc->numweapons; i++)
 	{
 		if (!wc->weaponinfo[i].valid) continue;
-		index = ws->weaponweightindex[i];
-		if (index < 0) continue;
-		weight = FuzzyWeight(inventory, ws->weaponweightconfig, index);
-		if (weight > bestweight)
+		if (ws->weaponweights[i] > bestweight)
 		{
-			bestweight = weight;
+			bestweight = ws->weaponweights[i];
 			bestweapon = i;
 		} //end if
 	} //end for
@@ -47,6 +47,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define MAX_INVENTORYVALUE			999999
 #define EVALUATERECURSIVELY
 
+#if idx64
+#define FUZZY_SSE2
+#include <emmintrin.h>
+#endif
+//the case values of every switch are padded to a whole number of vectors
+#define FUZZY_CASEPAD				4
+
 #define MAX_WEIGHT_FILES			128
 weightconfig_t	*weightFileList[MAX_WEIGHT_FILES];
 
@@ -138,6 +145,7 @@ void FreeWeightConfig2(weightconfig_t *config)
 		FreeFuzzySeperators_r(config->weights[i].firstseperator);
 		if (config->weights[i].name) FreeMemory(config->weights[i].name);
 	} //end for
+	if (config->switches) FreeMemory(config->switches);
 	FreeMemory(config);
 } //end of the function FreeWeightConfig2
 //===========================================================================
@@ -277,6 +285,109 @@ fuzzyseperator_t *ReadFuzzySeperators_r(source_t *source)
 	return firstfs;
 } //end of the function ReadFuzzySeperators_r
 //===========================================================================
+// counts the switches and padded cases in the seperator tree
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void CountFuzzySeperators_r(fuzzyseperator_t *fs, int *numswitches, int *numcases)
+{
+	int n;
+
+	(*numswitches)++;
+	for (n = 0; fs; fs = fs->next, n++)
+	{
+		if (fs->child) CountFuzzySeperators_r(fs->child, numswitches, numcases);
+	} //end for
+	*numcases += (n + FUZZY_CASEPAD - 1) & ~(FUZZY_CASEPAD - 1);
+} //end of the function CountFuzzySeperators_r
+//===========================================================================
+// stores the seperators of one switch next to each other in the case
+// arrays, the child switches are stored after it
+//
+// Parameter:				-
+// Returns:					number of the switch
+// Changes Globals:		-
+//===========================================================================
+int FlattenFuzzySeperators_r(weightconfig_t *config, fuzzyseperator_t *fs)
+{
+	int s, n, numcases;
+	fuzzyswitch_t *sw;
+	fuzzyseperator_t *f;
+	fuzzycase_t *fc;
+
+	for (numcases = 0, f = fs; f; f = f->next) numcases++;
+	s = config->numswitches++;
+	sw = &config->switches[s];
+	sw->index = fs->index;
+	sw->numcases = numcases;
+	sw->firstcase = config->numcases;
+	config->numcases += (numcases + FUZZY_CASEPAD - 1) & ~(FUZZY_CASEPAD - 1);
+	//the padding is never smaller than an inventory value
+	for (n = numcases; n < config->numcases - sw->firstcase; n++)
+	{
+		config->casevalues[sw->firstcase + n] = INT_MAX;
+	} //end for
+	for (n = 0, f = fs; f; f = f->next, n++)
+	{
+		config->casevalues[sw->firstcase + n] = f->value;
+		fc = &config->cases[sw->firstcase + n];
+		fc->weight = f->weight;
+		fc->minweight = f->minweight;
+		fc->maxweight = f->maxweight;
+		if (f->child) fc->child = FlattenFuzzySeperators_r(config, f->child);
+		else fc->child = -1;
+	} //end for
+	return s;
+} //end of the function FlattenFuzzySeperators_r
+//===========================================================================
+// (re)builds the flattened form of the seperator trees, must be called
+// every time the trees change
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void FlattenWeightConfig(weightconfig_t *config)
+{
+	int i, numswitches, numcases;
+	char *ptr;
+
+	if (config->switches) FreeMemory(config->switches);
+	config->switches = NULL;
+	numswitches = 0;
+	numcases = 0;
+	for (i = 0; i < config->numweights; i++)
+	{
+		if (config->weights[i].firstseperator)
+		{
+			CountFuzzySeperators_r(config->weights[i].firstseperator, &numswitches, &numcases);
+		} //end if
+	} //end for
+	if (!numswitches) return;
+	ptr = (char *) GetClearedMemory(numswitches * sizeof(fuzzyswitch_t) +
+						numcases * (sizeof(int) + sizeof(fuzzycase_t)));
+	config->switches = (fuzzyswitch_t *) ptr;
+	ptr += numswitches * sizeof(fuzzyswitch_t);
+	config->casevalues = (int *) ptr;
+	ptr += numcases * sizeof(int);
+	config->cases = (fuzzycase_t *) ptr;
+	config->numswitches = 0;
+	config->numcases = 0;
+	for (i = 0; i < config->numweights; i++)
+	{
+		if (config->weights[i].firstseperator)
+		{
+			config->firstswitch[i] = FlattenFuzzySeperators_r(config, config->weights[i].firstseperator);
+		} //end if
+		else
+		{
+			config->firstswitch[i] = -1;
+		} //end else
+	} //end for
+} //end of the function FlattenWeightConfig
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -324,7 +435,7 @@ weightconfig_t *ReadWeightConfig(char *filename)
 	} //end if
 
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
-	source = LoadSourceFile(filename);
+	source = LoadCachedSourceFile(filename);
 	if (!source)
 	{
 		botimport.Print(PRT_ERROR, "couldn't load %s\n", filename);
@@ -425,6 +536,7 @@ weightconfig_t *ReadWeightConfig(char *filename)
 	} //end while
 	//free the source at the end of a pass
 	FreeSource(source);
+	FlattenWeightConfig(config);
 	//if the file was located in a pak file
 	botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
 #ifdef DEBUG
@@ -648,6 +760,123 @@ float FuzzyWeightUndecided_r(int *inventory, fuzzyseperator_t *fs)
 	return fs->weight;
 } //end of the function FuzzyWeightUndecided_r
 //===========================================================================
+// returns the first case of the switch with a value above the inventory
+// value, or the number of cases if there is none
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE int FuzzyCase(const int *values, int numcases, int value)
+{
+	int i;
+#ifdef FUZZY_SSE2
+	static const char firstcase[16] = {4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
+	__m128i v;
+	int mask;
+
+	v = _mm_set1_epi32(value);
+	for (i = 0; i < numcases; i += FUZZY_CASEPAD)
+	{
+		mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v,
+								_mm_loadu_si128((const __m128i *) &values[i]))));
+		if (mask)
+		{
+			i += firstcase[mask];
+			//a padding case
+			if (i > numcases) return numcases;
+			return i;
+		} //end if
+	} //end for
+	return numcases;
+#else
+	for (i = 0; i < numcases; i++)
+	{
+		if (value < values[i]) break;
+	} //end for
+	return i;
+#endif //FUZZY_SSE2
+} //end of the function FuzzyCase
+//===========================================================================
+// same as FuzzyWeight_r but with the flattened seperators
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+float FuzzySwitchWeight_r(int *inventory, weightconfig_t *wc, int s)
+{
+	fuzzyswitch_t *sw;
+	fuzzycase_t *fc;
+	int *values, value, i;
+	float scale, w1, w2;
+
+	sw = &wc->switches[s];
+	values = &wc->casevalues[sw->firstcase];
+	fc = &wc->cases[sw->firstcase];
+	value = inventory[sw->index];
+	i = FuzzyCase(values, sw->numcases, value);
+	//above the last case
+	if (i >= sw->numcases) return fc[sw->numcases - 1].weight;
+	//below the first case
+	if (i == 0)
+	{
+		if (fc[0].child >= 0) return FuzzySwitchWeight_r(inventory, wc, fc[0].child);
+		else return fc[0].weight;
+	} //end if
+	//second weight
+	if (fc[i].child >= 0) w2 = FuzzySwitchWeight_r(inventory, wc, fc[i].child);
+	else w2 = fc[i].weight;
+	//can't interpolate towards the default case
+	if (values[i] == MAX_INVENTORYVALUE) return w2;
+	//first weight
+	if (fc[i-1].child >= 0) w1 = FuzzySwitchWeight_r(inventory, wc, fc[i-1].child);
+	else w1 = fc[i-1].weight;
+	//scale between the two weights
+	scale = (float) (value - values[i-1]) / (values[i] - values[i-1]);
+	return (1 - scale) * w1 + scale * w2;
+} //end of the function FuzzySwitchWeight_r
+//===========================================================================
+// same as FuzzyWeightUndecided_r but with the flattened seperators, the
+// random numbers are drawn in the same order
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+float FuzzySwitchWeightUndecided_r(int *inventory, weightconfig_t *wc, int s)
+{
+	fuzzyswitch_t *sw;
+	fuzzycase_t *fc;
+	int *values, value, i;
+	float scale, w1, w2;
+
+	sw = &wc->switches[s];
+	values = &wc->casevalues[sw->firstcase];
+	fc = &wc->cases[sw->firstcase];
+	value = inventory[sw->index];
+	i = FuzzyCase(values, sw->numcases, value);
+	//above the last case
+	if (i >= sw->numcases) return fc[sw->numcases - 1].weight;
+	//below the first case
+	if (i == 0)
+	{
+		if (fc[0].child >= 0) return FuzzySwitchWeightUndecided_r(inventory, wc, fc[0].child);
+		else return fc[0].minweight + random() * (fc[0].maxweight - fc[0].minweight);
+	} //end if
+	//first weight
+	if (fc[i-1].child >= 0) w1 = FuzzySwitchWeightUndecided_r(inventory, wc, fc[i-1].child);
+	else w1 = fc[i-1].minweight + random() * (fc[i-1].maxweight - fc[i-1].minweight);
+	//second weight, FuzzyWeightUndecided_r decides the child switch
+	if (fc[i].child >= 0) w2 = FuzzySwitchWeight_r(inventory, wc, fc[i].child);
+	else w2 = fc[i].minweight + random() * (fc[i].maxweight - fc[i].minweight);
+	//can't interpolate towards the default case
+	if (values[i] == MAX_INVENTORYVALUE) return w2;
+	//scale between the two weights
+	scale = (float) (value - values[i-1]) / (values[i] - values[i-1]);
+	return (1 - scale) * w1 + scale * w2;
+} //end of the function FuzzySwitchWeightUndecided_r
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -656,6 +885,11 @@ float FuzzyWeightUndecided_r(int *inventory, fuzzyseperator_t *fs)
 float FuzzyWeight(int *inventory, weightconfig_t *wc, int weightnum)
 {
 #ifdef EVALUATERECURSIVELY
+	if (wc->switches)
+	{
+		if (wc->firstswitch[weightnum] < 0) return 0;
+		return FuzzySwitchWeight_r(inventory, wc, wc->firstswitch[weightnum]);
+	} //end if
 	return FuzzyWeight_r(inventory, wc->weights[weightnum].firstseperator);
 #else
 	fuzzyseperator_t *s;
@@ -687,6 +921,11 @@ float FuzzyWeight(int *inventory, weightconfig_t *wc, int weightnum)
 float FuzzyWeightUndecided(int *inventory, weightconfig_t *wc, int weightnum)
 {
 #ifdef EVALUATERECURSIVELY
+	if (wc->switches)
+	{
+		if (wc->firstswitch[weightnum] < 0) return 0;
+		return FuzzySwitchWeightUndecided_r(inventory, wc, wc->firstswitch[weightnum]);
+	} //end if
 	return FuzzyWeightUndecided_r(inventory, wc->weights[weightnum].firstseperator);
 #else
 	fuzzyseperator_t *s;
@@ -710,6 +949,66 @@ float FuzzyWeightUndecided(int *inventory, weightconfig_t *wc, int weightnum)
 #endif
 } //end of the function FuzzyWeightUndecided
 //===========================================================================
+// evaluates a list of weights for one inventory, negative weight numbers
+// get a zero weight
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void FuzzyWeights(int *inventory, weightconfig_t *wc, int *weightnums, float *weights, int numweights)
+{
+	int i, s;
+
+	for (i = 0; i < numweights; i++)
+	{
+		if (weightnums[i] < 0)
+		{
+			weights[i] = 0;
+			continue;
+		} //end if
+#ifdef EVALUATERECURSIVELY
+		if (wc->switches)
+		{
+			s = wc->firstswitch[weightnums[i]];
+			weights[i] = s >= 0 ? FuzzySwitchWeight_r(inventory, wc, s) : 0;
+			continue;
+		} //end if
+#endif //EVALUATERECURSIVELY
+		weights[i] = FuzzyWeight(inventory, wc, weightnums[i]);
+	} //end for
+} //end of the function FuzzyWeights
+//===========================================================================
+// evaluates a list of weights for one inventory in order, so the random
+// numbers are drawn just like with calls to FuzzyWeightUndecided
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void FuzzyWeightsUndecided(int *inventory, weightconfig_t *wc, int *weightnums, float *weights, int numweights)
+{
+	int i, s;
+
+	for (i = 0; i < numweights; i++)
+	{
+		if (weightnums[i] < 0)
+		{
+			weights[i] = 0;
+			continue;
+		} //end if
+#ifdef EVALUATERECURSIVELY
+		if (wc->switches)
+		{
+			s = wc->firstswitch[weightnums[i]];
+			weights[i] = s >= 0 ? FuzzySwitchWeightUndecided_r(inventory, wc, s) : 0;
+			continue;
+		} //end if
+#endif //EVALUATERECURSIVELY
+		weights[i] = FuzzyWeightUndecided(inventory, wc, weightnums[i]);
+	} //end for
+} //end of the function FuzzyWeightsUndecided
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -746,6 +1045,7 @@ void EvolveWeightConfig(weightconfig_t *config)
 	{
 		EvolveFuzzySeperator_r(config->weights[i].firstseperator);
 	} //end for
+	FlattenWeightConfig(config);
 } //end of the function EvolveWeightConfig
 //===========================================================================
 //
@@ -789,6 +1089,7 @@ void ScaleWeight(weightconfig_t *config, char *name, float scale)
 			break;
 		} //end if
 	} //end for
+	FlattenWeightConfig(config);
 } //end of the function ScaleWeight
 //===========================================================================
 //
@@ -831,6 +1132,7 @@ void ScaleFuzzyBalanceRange(weightconfig_t *config, float scale)
 	{
 		ScaleFuzzySeperatorBalanceRange_r(config->weights[i].firstseperator, scale);
 	} //end for
+	FlattenWeightConfig(config);
 } //end of the function ScaleFuzzyBalanceRange
 //===========================================================================
 //
@@ -902,6 +1204,7 @@ void InterbreedWeightConfigs(weightconfig_t *config1, weightconfig_t *config2,
 									config2->weights[i].firstseperator,
 									configout->weights[i].firstseperator);
 	} //end for
+	FlattenWeightConfig(configout);
 } //end of the function InterbreedWeightConfigs
 //===========================================================================
 //
@@ -922,3 +1225,201 @@ void BotShutdownWeights(void)
 		} //end if
 	} //end for
 } //end of the function BotShutdownWeights
+//===========================================================================
+// marks the inventory indexes tested by the seperators
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+#define WEIGHTBENCH_INVENTORIES		1024
+#define WEIGHTBENCH_INVENTORYSIZE	256
+#define WEIGHTBENCH_PASSES			64
+
+static void BotWeightBenchIndexes(fuzzyseperator_t *fs, qboolean *tested)
+{
+	for (; fs; fs = fs->next)
+	{
+		if (fs->index >= 0 && fs->index < WEIGHTBENCH_INVENTORYSIZE) tested[fs->index] = qtrue;
+		BotWeightBenchIndexes(fs->child, tested);
+	} //end for
+} //end of the function BotWeightBenchIndexes
+//===========================================================================
+// prints the first weight the flattened seperators got wrong
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void BotWeightBenchError(char *type, int *inventories, float *trees, float *flat, int index)
+{
+	int n, i, k;
+	qboolean tested[WEIGHTBENCH_INVENTORYSIZE];
+	weightconfig_t *wc;
+
+	for (n = 0; n < MAX_WEIGHT_FILES; n++)
+	{
+		wc = weightFileList[n];
+		if (!wc) continue;
+		if (index < WEIGHTBENCH_INVENTORIES * wc->numweights) break;
+		index -= WEIGHTBENCH_INVENTORIES * wc->numweights;
+	} //end for
+	if (n >= MAX_WEIGHT_FILES) return;
+	i = index / wc->numweights;
+	k = index % wc->numweights;
+	botimport.Print(PRT_ERROR, "%s weight %s in %s is %f with the trees and %f flattened for inventory %d\n",
+									type, wc->weights[k].name, wc->filename, trees[index], flat[index], i);
+	Com_Memset(tested, 0, sizeof(tested));
+	BotWeightBenchIndexes(wc->weights[k].firstseperator, tested);
+	for (k = 0; k < WEIGHTBENCH_INVENTORYSIZE; k++)
+	{
+		if (!tested[k]) continue;
+		botimport.Print(PRT_MESSAGE, "  inventory[%d] = %d\n", k, inventories[i * WEIGHTBENCH_INVENTORYSIZE + k]);
+	} //end for
+} //end of the function BotWeightBenchError
+//===========================================================================
+// times the weights of every cached weight configuration for a number of
+// random inventories, once with the seperator trees and once with the
+// flattened seperators, the undecided weights draw the same random numbers
+//
+// Parameter:				-
+// Returns:					qfalse if the flattened weights differ
+// Changes Globals:		-
+//===========================================================================
+int BotWeightBench(void)
+{
+	int i, j, n, pass, flat, seed, start, msec[2][2], different[2], first[2];
+	int numconfigs, numweights, maxvalue, *inventories, *inventory, weightnums[MAX_WEIGHTS];
+	float *results[2][2], *w;
+	weightconfig_t *wc;
+	fuzzyswitch_t *switches;
+
+	numconfigs = 0;
+	numweights = 0;
+	maxvalue = 0;
+	for (n = 0; n < MAX_WEIGHT_FILES; n++)
+	{
+		wc = weightFileList[n];
+		if (!wc) continue;
+		numconfigs++;
+		numweights += wc->numweights;
+		//largest case value besides the padding and the default cases
+		for (i = 0; i < wc->numcases; i++)
+		{
+			if (wc->casevalues[i] >= MAX_INVENTORYVALUE) continue;
+			if (wc->casevalues[i] > maxvalue) maxvalue = wc->casevalues[i];
+		} //end for
+	} //end for
+	if (!numweights)
+	{
+		botimport.Print(PRT_MESSAGE, "no weight configs loaded\n");
+		return qtrue;
+	} //end if
+	//random inventories, with a fair number of empty slots, some below
+	//the first case and some above the last case
+	inventories = (int *) GetMemory(WEIGHTBENCH_INVENTORIES * WEIGHTBENCH_INVENTORYSIZE * sizeof(int));
+	seed = 12345;
+	for (i = 0; i < WEIGHTBENCH_INVENTORIES * WEIGHTBENCH_INVENTORYSIZE; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		switch((seed >> 8) & 15)
+		{
+			case 0: case 1: case 2: case 3: inventories[i] = 0; break;
+			case 12: inventories[i] = maxvalue + ((seed >> 12) & 255); break;
+			case 13: inventories[i] = MAX_INVENTORYVALUE + ((seed >> 12) & 255); break;
+			case 14: inventories[i] = -((seed >> 12) & 255); break;
+			default: inventories[i] = (seed >> 12) & 255; break;
+		} //end switch
+	} //end for
+	for (i = 0; i < 2; i++)
+	{
+		for (j = 0; j < 2; j++)
+		{
+			results[i][j] = (float *) GetMemory(WEIGHTBENCH_INVENTORIES * numweights * sizeof(float));
+		} //end for
+	} //end for
+	for (i = 0; i < MAX_WEIGHTS; i++) weightnums[i] = i;
+	//
+	for (pass = 0; pass < 2; pass++)
+	{
+		flat = (pass == 1);
+		//decided weights
+		start = botimport.Milliseconds();
+		for (j = 0; j < WEIGHTBENCH_PASSES; j++)
+		{
+			w = results[0][flat];
+			for (n = 0; n < MAX_WEIGHT_FILES; n++)
+			{
+				wc = weightFileList[n];
+				if (!wc) continue;
+				for (i = 0; i < WEIGHTBENCH_INVENTORIES; i++, w += wc->numweights)
+				{
+					inventory = &inventories[i * WEIGHTBENCH_INVENTORYSIZE];
+					if (flat)
+					{
+						FuzzyWeights(inventory, wc, weightnums, w, wc->numweights);
+						continue;
+					} //end if
+					switches = wc->switches;
+					wc->switches = NULL;
+					FuzzyWeights(inventory, wc, weightnums, w, wc->numweights);
+					wc->switches = switches;
+				} //end for
+			} //end for
+		} //end for
+		msec[0][flat] = botimport.Milliseconds() - start;
+		//undecided weights
+		start = botimport.Milliseconds();
+		for (j = 0; j < WEIGHTBENCH_PASSES; j++)
+		{
+			w = results[1][flat];
+			srand(j);
+			for (n = 0; n < MAX_WEIGHT_FILES; n++)
+			{
+				wc = weightFileList[n];
+				if (!wc) continue;
+				for (i = 0; i < WEIGHTBENCH_INVENTORIES; i++, w += wc->numweights)
+				{
+					inventory = &inventories[i * WEIGHTBENCH_INVENTORYSIZE];
+					if (flat)
+					{
+						FuzzyWeightsUndecided(inventory, wc, weightnums, w, wc->numweights);
+						continue;
+					} //end if
+					switches = wc->switches;
+					wc->switches = NULL;
+					FuzzyWeightsUndecided(inventory, wc, weightnums, w, wc->numweights);
+					wc->switches = switches;
+				} //end for
+			} //end for
+		} //end for
+		msec[1][flat] = botimport.Milliseconds() - start;
+	} //end for
+	//
+	for (i = 0; i < 2; i++)
+	{
+		different[i] = 0;
+		first[i] = -1;
+		for (j = 0; j < WEIGHTBENCH_INVENTORIES * numweights; j++)
+		{
+			if (results[i][0][j] == results[i][1][j]) continue;
+			if (!different[i]) first[i] = j;
+			different[i]++;
+		} //end for
+	} //end for
+	botimport.Print(PRT_MESSAGE, "%d weight configs, %d weights, %d inventories, %d times\n",
+									numconfigs, numweights, WEIGHTBENCH_INVENTORIES, WEIGHTBENCH_PASSES);
+	botimport.Print(PRT_MESSAGE, "decided:   %d msec trees, %d msec flattened, %d results differ\n",
+									msec[0][0], msec[0][1], different[0]);
+	botimport.Print(PRT_MESSAGE, "undecided: %d msec trees, %d msec flattened, %d results differ\n",
+									msec[1][0], msec[1][1], different[1]);
+	if (different[0]) BotWeightBenchError("decided", inventories, results[0][0], results[0][1], first[0]);
+	if (different[1]) BotWeightBenchError("undecided", inventories, results[1][0], results[1][1], first[1]);
+	//
+	FreeMemory(inventories);
+	for (i = 0; i < 2; i++)
+	{
+		for (j = 0; j < 2; j++) FreeMemory(results[i][j]);
+	} //end for
+	return !different[0] && !different[1];
+} //end of the function BotWeightBench
@@ -45,6 +45,23 @@ typedef struct fuzzyseperator_s
 	struct fuzzyseperator_s *next;
 } fuzzyseperator_t;
 
+//a switch of fuzzy seperators flattened into the case arrays
+typedef struct fuzzyswitch_s
+{
+	int index;						//inventory index the cases test
+	int numcases;					//number of cases
+	int firstcase;					//first case in the case arrays
+} fuzzyswitch_t;
+
+//a flattened fuzzy seperator
+typedef struct fuzzycase_s
+{
+	int child;						//child switch or -1
+	float weight;
+	float minweight;
+	float maxweight;
+} fuzzycase_t;
+
 //fuzzy weight
 typedef struct weight_s
 {
@@ -58,6 +75,13 @@ typedef struct weightconfig_s
 	int numweights;
 	weight_t weights[MAX_WEIGHTS];
 	char		filename[MAX_QPATH];
+	//the seperators flattened into arrays
+	int firstswitch[MAX_WEIGHTS];	//first switch of every weight or -1
+	int numswitches;
+	fuzzyswitch_t *switches;
+	int numcases;					//with padding
+	int *casevalues;				//case values, padded per switch
+	fuzzycase_t *cases;
 } weightconfig_t;
 
 //reads a weight configuration
@@ -71,6 +95,9 @@ int FindFuzzyWeight(weightconfig_t *wc, char *name);
 //returns the fuzzy weight for the given inventory and weight
 float FuzzyWeight(int *inventory, weightconfig_t *wc, int weightnum);
 float FuzzyWeightUndecided(int *inventory, weightconfig_t *wc, int weightnum);
+//returns the fuzzy weights for the given inventory and list of weights in one pass
+void FuzzyWeights(int *inventory, weightconfig_t *wc, int *weightnums, float *weights, int numweights);
+void FuzzyWeightsUndecided(int *inventory, weightconfig_t *wc, int *weightnums, float *weights, int numweights);
 //scales the weight with the given name
 void ScaleWeight(weightconfig_t *config, char *name, float scale);
 //scale the balance range
@@ -81,3 +108,5 @@ void EvolveWeightConfig(weightconfig_t *config);
 void InterbreedWeightConfigs(weightconfig_t *config1, weightconfig_t *config2, weightconfig_t *configout);
 //frees cached weight configurations
 void BotShutdownWeights(void);
+//times the flattened fuzzy weights against the seperator trees, returns qfalse if they differ
+int BotWeightBench(void);
@@ -200,6 +200,8 @@ int Export_BotLibShutdown(void)
 
 	//dump all allocated memory
 //	DumpMemory();
+	//give the memory kept around for new allocations back
+	FreeUnusedMemory();
 #ifdef DEBUG
 	PrintMemoryLabels();
 #endif
@@ -246,8 +248,13 @@ int Export_BotLibVarGet(const char *var_name, char *value, int size)
 //===========================================================================
 int Export_BotLibStartFrame(float time)
 {
+	int errnum;
+
 	if (!BotLibSetup("BotStartFrame")) return BLERR_LIBRARYNOTSETUP;
-	return AAS_StartFrame(time);
+	errnum = AAS_StartFrame(time);
+	if (errnum != BLERR_NOERROR) return errnum;
+	BotPrefetchMoveRoutes();	//be_ai_move.h
+	return BLERR_NOERROR;
 } //end of the function Export_BotLibStartFrame
 //===========================================================================
 //
@@ -293,6 +300,58 @@ int Export_BotLibUpdateEntity(int ent, bot_entitystate_t *state)
 	return AAS_UpdateEntity(ent, state);
 } //end of the function Export_BotLibUpdateEntity
 //===========================================================================
+// runs one of the benchmarks
+//
+// Parameter:			name		: name of the benchmark
+//							arg		: argument of the benchmark, 0 for the default
+// Returns:					qfalse if the benchmark is unknown or failed its check
+// Changes Globals:		-
+//===========================================================================
+int Export_BotLibBench(const char *name, int arg)
+{
+	if (!BotLibSetup("BotLibBench")) return qfalse;
+	//
+	if (!Q_stricmp(name, "reach"))
+	{
+		//the reachability calculation with arg threads
+		if (arg <= 0) arg = LibVarValue("reachabilitythreads", "0");
+		if (arg < 2) arg = 4;
+		AAS_ReachabilityBench(arg);
+		return qtrue;
+	} //end if
+	if (!Q_stricmp(name, "route"))
+	{
+		//filling the routing caches
+		AAS_RoutingBench();
+		return qtrue;
+	} //end if
+	if (!Q_stricmp(name, "goal"))
+	{
+		//the item travel times of arg bots choosing goals
+		BotItemGoalBench(arg > 0 ? arg : 32);
+		return qtrue;
+	} //end if
+	if (!Q_stricmp(name, "sample"))
+	{
+		//point area lookups and traces
+		AAS_SampleBench();
+		return qtrue;
+	} //end if
+	if (!Q_stricmp(name, "chat"))
+	{
+		//matching messages against the chat templates
+		BotChatBench();
+		return qtrue;
+	} //end if
+	if (!Q_stricmp(name, "weight"))
+	{
+		//the flattened fuzzy weights against the seperator trees
+		return BotWeightBench();
+	} //end if
+	botimport.Print(PRT_ERROR, "unknown bench %s, use reach, route, goal, sample, chat or weight\n", name);
+	return qfalse;
+} //end of the function Export_BotLibBench
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -878,6 +937,7 @@ botlib_export_t *GetBotLibAPI(int apiVersion, botlib_import_t *import) {
 	be_botlib_export.BotLibStartFrame = Export_BotLibStartFrame;
 	be_botlib_export.BotLibLoadMap = Export_BotLibLoadMap;
 	be_botlib_export.BotLibUpdateEntity = Export_BotLibUpdateEntity;
+	be_botlib_export.Bench = Export_BotLibBench;
 	be_botlib_export.Test = BotExportTest;
 
 	return &be_botlib_export;
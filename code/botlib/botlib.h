@@ -196,6 +196,15 @@ typedef struct botlib_import_s
 	int			(*FS_Write)( const void *buffer, int len, fileHandle_t f );
 	void		(*FS_FCloseFile)( fileHandle_t f );
 	int			(*FS_Seek)( fileHandle_t f, long offset, int origin );
+	//map a plain file read only, NULL if it isn't one
+	void		*(*FS_MapFile)( const char *qpath, int *length );
+	void		(*FS_UnmapFile)( void *data, int length );
+	//replace a file in the home directory, false on failure
+	int			(*FS_Rename)( const char *from, const char *to );
+	//run func for index 0 to count - 1 spread over numThreads threads
+	void		(*RunJobs)(void (*func)(void *data, int index), void *data, int count, int numThreads);
+	//wall clock milliseconds
+	int			(*Milliseconds)(void);
 	//debug visualisation stuff
 	int			(*DebugLineCreate)(void);
 	void		(*DebugLineDelete)(int line);
@@ -426,6 +435,8 @@ typedef struct botlib_export_s
 	int (*BotLibLoadMap)(const char *mapname);
 	//entity updates
 	int (*BotLibUpdateEntity)(int ent, bot_entitystate_t *state);
+	//run the named benchmark, returns qfalse if it is unknown or failed its check
+	int (*Bench)(const char *name, int arg);
 	//just for testing
 	int (*Test)(int parm0, char *parm1, vec3_t parm2, vec3_t parm3);
 } botlib_export_t;
@@ -490,6 +501,8 @@ name:						default:			module(s):			description:
 "aasoptimize"				"0"					be_aas_main.c		enable aas optimization
 "sv_mapChecksum"			"0"					be_aas_main.c		BSP file checksum
 "bot_visualizejumppads"		"0"					be_aas_reach.c		visualize jump pads
+"reachabilitythreads"		"0"					be_aas_reach.c		threads used to calculate reachabilities
+"routingthreads"			"0"					be_aas_route.c		threads used to fill the routing caches of the bots
 
 "bot_reloadcharacters"		"0"					-					reload bot character files
 "ai_gametype"				"0"					be_ai_goal.c		game type
@@ -328,9 +328,258 @@ void DumpMemory(void)
 	totalmemorysize = 0;
 	allocatedmemory = 0;
 } //end of the function DumpMemory
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void FreeUnusedMemory(void)
+{
+} //end of the function FreeUnusedMemory
 
 #else
 
+/*
+small blocks are carved out of 64KB slabs with one slab per size class,
+every slab keeps its own list of free blocks and the size class keeps a
+list of the slabs that still have free blocks.  Slabs that become empty
+go back to the engine zone, except for one spare per size class so a
+routing cache or chat message being freed and allocated again doesn't
+hit the zone every time.  Larger blocks go to the zone directly.
+
+the allocator can be used from the job threads, a spin lock is enough
+because it is never held while calling out to the engine, slabs and zone
+blocks are allocated and freed outside of it
+*/
+
+#define SLAB_ID				0x51ab51abl
+#define SLAB_SIZE			(64 * 1024)
+#define SLAB_MAXBLOCKSIZE	2048
+#define SLAB_GRANULARITY	16
+#define MAX_SIZECLASSES		32
+
+typedef struct memoryheader_s
+{
+	intptr_t info;							//slab for slab blocks, size for zone blocks
+	unsigned long int id;
+} memoryheader_t;
+
+typedef struct memoryslab_s
+{
+	int sizeclass;
+	int numused;							//blocks handed out
+	char *unused;							//blocks never handed out start here
+	char *end;
+	memoryheader_t *freeblocks;				//blocks handed out and freed again
+	struct memoryslab_s *prev, *next;		//slabs of the size class with free blocks
+} memoryslab_t;
+
+typedef struct memorysizeclass_s
+{
+	int blocksize;							//including the memory header
+	int numslabs;
+	int numemptyslabs;
+	int numused;
+	int numallocs;
+	memoryslab_t *slabs;					//slabs with free blocks
+} memorysizeclass_t;
+
+static memorysizeclass_t sizeclasses[MAX_SIZECLASSES];
+static int numsizeclasses;
+static unsigned char sizeclassforsize[SLAB_MAXBLOCKSIZE / SLAB_GRANULARITY + 1];
+
+static int slabfreebytes;
+static int numzoneblocks, zoneblockbytes, numzoneallocs;
+static int hunkmemorysize;
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#if defined(_M_IX86) || defined(_M_X64)
+#define MEMORY_PAUSE()		_mm_pause()
+#else
+#define MEMORY_PAUSE()		__yield()
+#endif
+static volatile long memorylock;
+#define MEMORY_LOCK()		while (_InterlockedExchange(&memorylock, 1)) while (memorylock) MEMORY_PAUSE()
+#define MEMORY_UNLOCK()		_InterlockedExchange(&memorylock, 0)
+#else
+#if defined(__i386__) || defined(__x86_64__)
+#define MEMORY_PAUSE()		__builtin_ia32_pause()
+#elif defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+#define MEMORY_PAUSE()		__asm__ __volatile__("yield")
+#else
+#define MEMORY_PAUSE()
+#endif
+static volatile int memorylock;
+//spin on a plain read so the cache line isn't written while waiting
+#define MEMORY_LOCK()		while (__sync_lock_test_and_set(&memorylock, 1)) while (memorylock) MEMORY_PAUSE()
+#define MEMORY_UNLOCK()		__sync_lock_release(&memorylock)
+#endif
+
+//===========================================================================
+// size classes are spaced a quarter of a power of two apart so
+// no more than a fifth of a block is ever wasted above 64 bytes
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void InitSizeClasses(void)
+{
+	int size, step, i;
+
+	numsizeclasses = 0;
+	for (size = SLAB_GRANULARITY * 2; size <= SLAB_MAXBLOCKSIZE; size += step)
+	{
+		sizeclasses[numsizeclasses].blocksize = size;
+		numsizeclasses++;
+		for (step = SLAB_GRANULARITY; step * 8 <= size; step <<= 1)
+			;
+	} //end for
+	for (i = 0, size = 0; size <= SLAB_MAXBLOCKSIZE; size += SLAB_GRANULARITY)
+	{
+		while (sizeclasses[i].blocksize < size) i++;
+		sizeclassforsize[size / SLAB_GRANULARITY] = i;
+	} //end for
+} //end of the function InitSizeClasses
+//===========================================================================
+// number of bytes in the blocks of a slab
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int SlabCapacity(memorysizeclass_t *sc)
+{
+	int size;
+
+	size = SLAB_SIZE - PAD(sizeof(memoryslab_t), sizeof(memoryheader_t));
+	return size - size % sc->blocksize;
+} //end of the function SlabCapacity
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void LinkSlab(memorysizeclass_t *sc, memoryslab_t *slab)
+{
+	slab->prev = NULL;
+	slab->next = sc->slabs;
+	if (sc->slabs) sc->slabs->prev = slab;
+	sc->slabs = slab;
+} //end of the function LinkSlab
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void UnlinkSlab(memorysizeclass_t *sc, memoryslab_t *slab)
+{
+	if (slab->prev) slab->prev->next = slab->next;
+	else sc->slabs = slab->next;
+	if (slab->next) slab->next->prev = slab->prev;
+	slab->prev = slab->next = NULL;
+} //end of the function UnlinkSlab
+//===========================================================================
+// adds a slab allocated by the caller to the size class
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AddSlab(int sizeclass, memoryslab_t *slab)
+{
+	memorysizeclass_t *sc;
+
+	sc = &sizeclasses[sizeclass];
+	slab->sizeclass = sizeclass;
+	slab->numused = 0;
+	slab->unused = (char *) slab + PAD(sizeof(memoryslab_t), sizeof(memoryheader_t));
+	slab->end = (char *) slab + SLAB_SIZE;
+	slab->freeblocks = NULL;
+	LinkSlab(sc, slab);
+	sc->numslabs++;
+	sc->numemptyslabs++;
+	slabfreebytes += SlabCapacity(sc);
+} //end of the function AddSlab
+//===========================================================================
+// returns NULL when none of the slabs of the size class have room
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static memoryheader_t *GetSlabBlock(int sizeclass)
+{
+	memorysizeclass_t *sc;
+	memoryslab_t *slab;
+	memoryheader_t *block;
+
+	sc = &sizeclasses[sizeclass];
+	slab = sc->slabs;
+	if (!slab) return NULL;
+	if (slab->freeblocks)
+	{
+		block = slab->freeblocks;
+		slab->freeblocks = *(memoryheader_t **) (block + 1);
+	} //end if
+	else
+	{
+		block = (memoryheader_t *) slab->unused;
+		slab->unused += sc->blocksize;
+	} //end else
+	if (!slab->numused++) sc->numemptyslabs--;
+	//the slab is full
+	if (!slab->freeblocks && slab->unused + sc->blocksize > slab->end)
+	{
+		UnlinkSlab(sc, slab);
+	} //end if
+	sc->numused++;
+	sc->numallocs++;
+	slabfreebytes -= sc->blocksize;
+	block->info = (intptr_t) slab;
+	block->id = SLAB_ID;
+	return block;
+} //end of the function GetSlabBlock
+//===========================================================================
+// returns the slab when it became empty and should go back to the zone
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static memoryslab_t *FreeSlabBlock(memoryheader_t *block)
+{
+	memorysizeclass_t *sc;
+	memoryslab_t *slab;
+
+	slab = (memoryslab_t *) block->info;
+	sc = &sizeclasses[slab->sizeclass];
+	//the slab was full
+	if (!slab->freeblocks && slab->unused + sc->blocksize > slab->end)
+	{
+		LinkSlab(sc, slab);
+	} //end if
+	block->id = 0;
+	*(memoryheader_t **) (block + 1) = slab->freeblocks;
+	slab->freeblocks = block;
+	sc->numused--;
+	slabfreebytes += sc->blocksize;
+	if (--slab->numused) return NULL;
+	//keep one empty slab around
+	if (!sc->numemptyslabs)
+	{
+		sc->numemptyslabs++;
+		return NULL;
+	} //end if
+	UnlinkSlab(sc, slab);
+	sc->numslabs--;
+	slabfreebytes -= SlabCapacity(sc);
+	return slab;
+} //end of the function FreeSlabBlock
 //===========================================================================
 //
 // Parameter:			-
@@ -343,14 +592,42 @@ void *GetMemoryDebug(unsigned long size, char *label, char *file, int line)
 void *GetMemory(unsigned long size)
 #endif //MEMDEBUG
 {
-	void *ptr;
-	unsigned long int *memid;
+	memoryheader_t *block;
+	memoryslab_t *slab;
+	unsigned long blocksize;
+	int sizeclass;
 
-	ptr = botimport.GetMemory(size + sizeof(unsigned long int));
-	if (!ptr) return NULL;
-	memid = (unsigned long int *) ptr;
-	*memid = MEM_ID;
-	return (unsigned long int *) ((char *) ptr + sizeof(unsigned long int));
+	blocksize = size + sizeof(memoryheader_t);
+	if (blocksize > SLAB_MAXBLOCKSIZE)
+	{
+		block = (memoryheader_t *) botimport.GetMemory(blocksize);
+		if (!block) return NULL;
+		block->info = blocksize;
+		block->id = MEM_ID;
+		MEMORY_LOCK();
+		numzoneblocks++;
+		numzoneallocs++;
+		zoneblockbytes += blocksize;
+		MEMORY_UNLOCK();
+		return block + 1;
+	} //end if
+	MEMORY_LOCK();
+	if (!numsizeclasses) InitSizeClasses();
+	sizeclass = sizeclassforsize[(blocksize + SLAB_GRANULARITY - 1) / SLAB_GRANULARITY];
+	block = GetSlabBlock(sizeclass);
+	if (!block)
+	{
+		//get a new slab without holding the lock, if another thread added
+		//one in the mean time this one is simply kept as an empty slab
+		MEMORY_UNLOCK();
+		slab = (memoryslab_t *) botimport.GetMemory(SLAB_SIZE);
+		if (!slab) return NULL;
+		MEMORY_LOCK();
+		AddSlab(sizeclass, slab);
+		block = GetSlabBlock(sizeclass);
+	} //end if
+	MEMORY_UNLOCK();
+	return block + 1;
 } //end of the function GetMemory
 //===========================================================================
 //
@@ -385,14 +662,16 @@ void *GetHunkMemoryDebug(unsigned long size, char *label, char *file, int line)
 void *GetHunkMemory(unsigned long size)
 #endif //MEMDEBUG
 {
-	void *ptr;
-	unsigned long int *memid;
+	memoryheader_t *block;
 
-	ptr = botimport.HunkAlloc(size + sizeof(unsigned long int));
-	if (!ptr) return NULL;
-	memid = (unsigned long int *) ptr;
-	*memid = HUNK_ID;
-	return (unsigned long int *) ((char *) ptr + sizeof(unsigned long int));
+	block = (memoryheader_t *) botimport.HunkAlloc(size + sizeof(memoryheader_t));
+	if (!block) return NULL;
+	block->info = size + sizeof(memoryheader_t);
+	block->id = HUNK_ID;
+	MEMORY_LOCK();
+	hunkmemorysize += block->info;
+	MEMORY_UNLOCK();
+	return block + 1;
 } //end of the function GetHunkMemory
 //===========================================================================
 //
@@ -423,14 +702,26 @@ void *GetClearedHunkMemory(unsigned long size)
 //===========================================================================
 void FreeMemory(void *ptr)
 {
-	unsigned long int *memid;
+	memoryheader_t *block;
+	memoryslab_t *slab;
 
-	memid = (unsigned long int *) ((char *) ptr - sizeof(unsigned long int));
+	block = (memoryheader_t *) ptr - 1;
 
-	if (*memid == MEM_ID)
+	if (block->id == SLAB_ID)
 	{
-		botimport.FreeMemory(memid);
+		MEMORY_LOCK();
+		slab = FreeSlabBlock(block);
+		MEMORY_UNLOCK();
+		if (slab) botimport.FreeMemory(slab);
 	} //end if
+	else if (block->id == MEM_ID)
+	{
+		MEMORY_LOCK();
+		numzoneblocks--;
+		zoneblockbytes -= block->info;
+		MEMORY_UNLOCK();
+		botimport.FreeMemory(block);
+	} //end else if
 } //end of the function FreeMemory
 //===========================================================================
 //
@@ -440,7 +731,14 @@ void FreeMemory(void *ptr)
 //===========================================================================
 int AvailableMemory(void)
 {
-	return botimport.AvailableMemory();
+	int freebytes;
+
+	//free slab blocks count as well, otherwise freeing the oldest routing
+	//caches to make room would go on until whole slabs become empty
+	MEMORY_LOCK();
+	freebytes = slabfreebytes;
+	MEMORY_UNLOCK();
+	return botimport.AvailableMemory() + freebytes;
 } //end of the function AvailableMemory
 //===========================================================================
 //
@@ -448,8 +746,59 @@ int AvailableMemory(void)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+int MemoryByteSize(void *ptr)
+{
+	memoryheader_t *block;
+
+	block = (memoryheader_t *) ptr - 1;
+	if (block->id == SLAB_ID)
+	{
+		return sizeclasses[((memoryslab_t *) block->info)->sizeclass].blocksize - sizeof(memoryheader_t);
+	} //end if
+	return block->info - sizeof(memoryheader_t);
+} //end of the function MemoryByteSize
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void PrintUsedMemorySize(void)
 {
+	int i, numslabs, slabbytes, usedbytes, numallocs, numclasses, freebytes;
+	int zoneblocks, zonebytes, zoneallocs, hunkbytes;
+	memorysizeclass_t classes[MAX_SIZECLASSES], *sc;
+
+	//take a snapshot, the lock mustn't be held while printing
+	MEMORY_LOCK();
+	numclasses = numsizeclasses;
+	Com_Memcpy(classes, sizeclasses, sizeof(classes));
+	freebytes = slabfreebytes;
+	zoneblocks = numzoneblocks;
+	zonebytes = zoneblockbytes;
+	zoneallocs = numzoneallocs;
+	hunkbytes = hunkmemorysize;
+	MEMORY_UNLOCK();
+
+	numslabs = slabbytes = usedbytes = numallocs = 0;
+	botimport.Print(PRT_MESSAGE, "block size   slabs  empty     used   allocs\n");
+	for (i = 0; i < numclasses; i++)
+	{
+		sc = &classes[i];
+		if (!sc->numslabs && !sc->numallocs) continue;
+		botimport.Print(PRT_MESSAGE, "%10d %7d %6d %8d %8d\n", sc->blocksize,
+						sc->numslabs, sc->numemptyslabs, sc->numused, sc->numallocs);
+		numslabs += sc->numslabs;
+		usedbytes += sc->numused * sc->blocksize;
+		numallocs += sc->numallocs;
+	} //end for
+	slabbytes = numslabs * SLAB_SIZE;
+	botimport.Print(PRT_MESSAGE, "slab memory: %d KB in %d slabs, %d KB used, %d KB free, %d allocations\n",
+					slabbytes >> 10, numslabs, usedbytes >> 10, freebytes >> 10, numallocs);
+	botimport.Print(PRT_MESSAGE, "zone memory: %d KB in %d blocks, %d allocations\n",
+					zonebytes >> 10, zoneblocks, zoneallocs);
+	botimport.Print(PRT_MESSAGE, "hunk memory: %d KB\n", hunkbytes >> 10);
+	botimport.Print(PRT_MESSAGE, "total botlib memory: %d KB\n", (slabbytes + zonebytes + hunkbytes) >> 10);
 } //end of the function PrintUsedMemorySize
 //===========================================================================
 //
@@ -460,5 +809,46 @@ void PrintUsedMemorySize(void)
 void PrintMemoryLabels(void)
 {
 } //end of the function PrintMemoryLabels
+//===========================================================================
+// gives the spare empty slabs back to the zone
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void FreeUnusedMemory(void)
+{
+	int i;
+	memorysizeclass_t *sc;
+	memoryslab_t *slab, *next, *emptyslabs;
+
+	emptyslabs = NULL;
+	MEMORY_LOCK();
+	for (i = 0; i < numsizeclasses; i++)
+	{
+		sc = &sizeclasses[i];
+		for (slab = sc->slabs; slab; slab = next)
+		{
+			next = slab->next;
+			if (slab->numused) continue;
+			UnlinkSlab(sc, slab);
+			sc->numslabs--;
+			sc->numemptyslabs--;
+			slabfreebytes -= SlabCapacity(sc);
+			slab->next = emptyslabs;
+			emptyslabs = slab;
+		} //end for
+		sc->numallocs = 0;
+	} //end for
+	numzoneallocs = 0;
+	hunkmemorysize = 0;
+	MEMORY_UNLOCK();
+	//give them back after releasing the lock
+	for (slab = emptyslabs; slab; slab = next)
+	{
+		next = slab->next;
+		botimport.FreeMemory(slab);
+	} //end for
+} //end of the function FreeUnusedMemory
 
 #endif
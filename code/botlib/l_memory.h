@@ -74,3 +74,5 @@ void PrintMemoryLabels(void);
 int MemoryByteSize(void *ptr);
 //free all allocated memory
 void DumpMemory(void);
+//give memory kept around for new allocations back
+void FreeUnusedMemory(void);
@@ -60,6 +60,7 @@ typedef enum {qfalse, qtrue}	qboolean;
 #include "l_script.h"
 #include "l_precomp.h"
 #include "l_log.h"
+#include "l_crc.h"
 #endif //BOTLIB
 
 #ifdef MEQCC
@@ -119,6 +120,57 @@ token_t *freetokens;					//free tokens from the heap
 //list with global defines added to every source loaded
 define_t *globaldefines;
 
+#ifdef BOTLIB
+//the bot files are pre-processed once, the tokens are kept around between
+//bot spawns and map changes and replayed as long as none of the files the
+//tokens came from changed
+
+#define MAX_CACHEDSCRIPTS		8
+#define SOURCECACHE_SIZE		(2 * 1024 * 1024)
+
+//script a cached source was read from
+typedef struct cachedscript_s
+{
+	char filename[MAX_QPATH];
+	int length;
+	unsigned short crc;
+} cachedscript_t;
+
+//pre-processed token
+typedef struct cachedtoken_s
+{
+	int type;
+	int subtype;
+	unsigned long int intvalue;
+	float floatvalue;
+	int line;
+	int string;							//offset in the string buffer
+} cachedtoken_t;
+
+typedef struct cachedsource_s
+{
+	char filename[MAX_QPATH];			//base folder and file name
+	unsigned short globaldefines;		//checksum of the global defines
+	int numscripts;
+	cachedscript_t scripts[MAX_CACHEDSCRIPTS];
+	int numtokens;
+	cachedtoken_t *tokens;
+	char *strings;
+	int size;							//allocated size
+	int refs;							//sources reading the tokens
+	int lastused;
+	struct cachedsource_s *next;
+} cachedsource_t;
+
+cachedsource_t *sourcecache;
+int sourcecachesize;
+int sourcecacheframe;
+//source being pre-processed for the cache
+source_t *cachingsource;
+cachedsource_t *cachingentry;
+char cachebasefolder[MAX_QPATH];
+#endif //BOTLIB
+
 //============================================================================
 //
 // Parameter:				-
@@ -134,6 +186,12 @@ void QDECL SourceError(source_t *source, char *str, ...)
 	Q_vsnprintf(text, sizeof(text), str, ap);
 	va_end(ap);
 #ifdef BOTLIB
+	//sources replaying cached tokens only know the line of the last token
+	if (!source->scriptstack)
+	{
+		botimport.Print(PRT_ERROR, "file %s, line %d: %s\n", source->filename, source->token.line, text);
+		return;
+	} //end if
 	botimport.Print(PRT_ERROR, "file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
 #endif	//BOTLIB
 #ifdef MEQCC
@@ -158,6 +216,11 @@ void QDECL SourceWarning(source_t *source, char *str, ...)
 	Q_vsnprintf(text, sizeof(text), str, ap);
 	va_end(ap);
 #ifdef BOTLIB
+	if (!source->scriptstack)
+	{
+		botimport.Print(PRT_WARNING, "file %s, line %d: %s\n", source->filename, source->token.line, text);
+		return;
+	} //end if
 	botimport.Print(PRT_WARNING, "file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
 #endif //BOTLIB
 #ifdef MEQCC
@@ -210,6 +273,29 @@ void PC_PopIndent(source_t *source, int *type, int *skip)
 	source->skip -= indent->skip;
 	FreeMemory(indent);
 } //end of the function PC_PopIndent
+#ifdef BOTLIB
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+void PC_CacheScript(cachedsource_t *cs, script_t *script)
+{
+	cachedscript_t *s;
+
+	//too many includes to validate, the tokens won't be cached
+	if (cs->numscripts >= MAX_CACHEDSCRIPTS)
+	{
+		cs->numscripts++;
+		return;
+	} //end if
+	s = &cs->scripts[cs->numscripts++];
+	Q_strncpyz(s->filename, script->filename, sizeof(s->filename));
+	s->length = script->length;
+	s->crc = CRC_ProcessString((unsigned char *) script->buffer, script->length);
+} //end of the function PC_CacheScript
+#endif //BOTLIB
 //============================================================================
 //
 // Parameter:				-
@@ -231,6 +317,10 @@ void PC_PushScript(source_t *source, script_t *script)
 	//push the script on the script stack
 	script->next = source->scriptstack;
 	source->scriptstack = script;
+#ifdef BOTLIB
+	//remember the included file to validate the cached tokens with
+	if (source == cachingsource) PC_CacheScript(cachingentry, script);
+#endif //BOTLIB
 } //end of the function PC_PushScript
 //============================================================================
 //
@@ -2698,6 +2788,49 @@ int QuakeCMacro(source_t *source)
 	return qtrue;
 } //end of the function QuakeCMacro
 #endif //QUAKEC
+#ifdef BOTLIB
+//============================================================================
+// reads the next token of a source replaying cached tokens, the
+// directives and defines were handled when the tokens were cached
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+int PC_ReadCachedToken(source_t *source, token_t *token)
+{
+	cachedtoken_t *ct;
+	token_t *t;
+
+	//unread tokens first
+	if (source->tokens)
+	{
+		Com_Memcpy(token, source->tokens, sizeof(token_t));
+		t = source->tokens;
+		source->tokens = source->tokens->next;
+		PC_FreeToken(t);
+	} //end if
+	else
+	{
+		if (source->cachetoken >= source->cache->numtokens) return qfalse;
+		ct = &source->cache->tokens[source->cachetoken++];
+		strcpy(token->string, source->cache->strings + ct->string);
+		token->type = ct->type;
+		token->subtype = ct->subtype;
+		token->intvalue = ct->intvalue;
+		token->floatvalue = ct->floatvalue;
+		token->whitespace_p = NULL;
+		token->endwhitespace_p = NULL;
+		token->line = ct->line;
+		token->linescrossed = 0;
+		token->next = NULL;
+	} //end else
+	//copy token for unreading, without the unused part of the string
+	strcpy(source->token.string, token->string);
+	Com_Memcpy(&source->token.type, &token->type, sizeof(token_t) - offsetof(token_t, type));
+	return qtrue;
+} //end of the function PC_ReadCachedToken
+#endif //BOTLIB
 //============================================================================
 //
 // Parameter:				-
@@ -2708,6 +2841,9 @@ int PC_ReadToken(source_t *source, token_t *token)
 {
 	define_t *define;
 
+#ifdef BOTLIB
+	if (source->cache) return PC_ReadCachedToken(source, token);
+#endif //BOTLIB
 	while(1)
 	{
 		if (!PC_ReadSourceToken(source, token)) return qfalse;
@@ -3078,7 +3214,7 @@ void FreeSource(source_t *source)
 		PC_FreeToken(token);
 	} //end for
 #if DEFINEHASHING
-	for (i = 0; i < DEFINEHASHSIZE; i++)
+	for (i = 0; i < DEFINEHASHSIZE && source->definehash; i++)
 	{
 		while(source->definehash[i])
 		{
@@ -3107,9 +3243,216 @@ void FreeSource(source_t *source)
 	//
 	if (source->definehash) FreeMemory(source->definehash);
 #endif //DEFINEHASHING
+#ifdef BOTLIB
+	if (source->cache) source->cache->refs--;
+#endif //BOTLIB
 	//free the source itself
 	FreeMemory(source);
 } //end of the function FreeSource
+#ifdef BOTLIB
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+unsigned short PC_GlobalDefinesChecksum(void)
+{
+	unsigned short crc;
+	define_t *define;
+	token_t *token;
+
+	CRC_Init(&crc);
+	for (define = globaldefines; define; define = define->next)
+	{
+		CRC_ContinueProcessString(&crc, define->name, strlen(define->name));
+		for (token = define->tokens; token; token = token->next)
+		{
+			CRC_ContinueProcessString(&crc, token->string, strlen(token->string));
+		} //end for
+	} //end for
+	return crc;
+} //end of the function PC_GlobalDefinesChecksum
+//============================================================================
+// returns true when none of the files the tokens were read from changed
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+int PC_CachedSourceValid(cachedsource_t *cs)
+{
+	int i, valid;
+	script_t *script;
+	cachedscript_t *s;
+
+	if (cs->globaldefines != PC_GlobalDefinesChecksum()) return qfalse;
+	for (i = 0; i < cs->numscripts; i++)
+	{
+		s = &cs->scripts[i];
+		script = LoadScriptFile(s->filename);
+		if (!script) return qfalse;
+		valid = (script->length == s->length &&
+				CRC_ProcessString((unsigned char *) script->buffer, script->length) == s->crc);
+		FreeScript(script);
+		if (!valid) return qfalse;
+	} //end for
+	return qtrue;
+} //end of the function PC_CachedSourceValid
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+void PC_FreeCachedSource(cachedsource_t *cs)
+{
+	cachedsource_t **prev;
+
+	for (prev = &sourcecache; *prev; prev = &(*prev)->next)
+	{
+		if (*prev == cs)
+		{
+			*prev = cs->next;
+			break;
+		} //end if
+	} //end for
+	sourcecachesize -= cs->size;
+	FreeMemory(cs);
+} //end of the function PC_FreeCachedSource
+//============================================================================
+// pre-processes the whole source and stores the resulting tokens
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+cachedsource_t *PC_CacheSource(source_t *source, cachedsource_t *entry)
+{
+	int numcached, maxtokens, stringsize, maxstrings, len, size;
+	cachedtoken_t *tokens, *ct;
+	char *strings, *ptr;
+	cachedsource_t *cs;
+	token_t token;
+
+	numcached = stringsize = 0;
+	maxtokens = 1024;
+	maxstrings = 8192;
+	tokens = (cachedtoken_t *) GetMemory(maxtokens * sizeof(cachedtoken_t));
+	strings = (char *) GetMemory(maxstrings);
+	//
+	cachingsource = source;
+	cachingentry = entry;
+	PC_CacheScript(entry, source->scriptstack);
+	while(PC_ReadToken(source, &token))
+	{
+		len = strlen(token.string) + 1;
+		if (numcached >= maxtokens)
+		{
+			ct = (cachedtoken_t *) GetMemory(maxtokens * 2 * sizeof(cachedtoken_t));
+			Com_Memcpy(ct, tokens, numcached * sizeof(cachedtoken_t));
+			FreeMemory(tokens);
+			tokens = ct;
+			maxtokens *= 2;
+		} //end if
+		if (stringsize + len > maxstrings)
+		{
+			while(stringsize + len > maxstrings) maxstrings *= 2;
+			ptr = (char *) GetMemory(maxstrings);
+			Com_Memcpy(ptr, strings, stringsize);
+			FreeMemory(strings);
+			strings = ptr;
+		} //end if
+		ct = &tokens[numcached++];
+		ct->type = token.type;
+		ct->subtype = token.subtype;
+		ct->intvalue = token.intvalue;
+		ct->floatvalue = token.floatvalue;
+		ct->line = token.line;
+		ct->string = stringsize;
+		Com_Memcpy(strings + stringsize, token.string, len);
+		stringsize += len;
+	} //end while
+	cachingsource = NULL;
+	cachingentry = NULL;
+	//
+	cs = NULL;
+	size = sizeof(cachedsource_t) + numcached * sizeof(cachedtoken_t) + stringsize;
+	if (entry->numscripts <= MAX_CACHEDSCRIPTS && size <= SOURCECACHE_SIZE)
+	{
+		cs = (cachedsource_t *) GetMemory(size);
+		Com_Memcpy(cs, entry, sizeof(cachedsource_t));
+		cs->numtokens = numcached;
+		cs->tokens = (cachedtoken_t *) (cs + 1);
+		Com_Memcpy(cs->tokens, tokens, numcached * sizeof(cachedtoken_t));
+		cs->strings = (char *) (cs->tokens + numcached);
+		Com_Memcpy(cs->strings, strings, stringsize);
+		cs->size = size;
+	} //end if
+	FreeMemory(tokens);
+	FreeMemory(strings);
+	return cs;
+} //end of the function PC_CacheSource
+//============================================================================
+// loads a source from the cache, the file is pre-processed and the
+// tokens are cached when it wasn't cached yet or one of its files changed
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+source_t *LoadCachedSourceFile(const char *filename)
+{
+	char name[MAX_QPATH];
+	cachedsource_t *cs, *oldest, *last, entry;
+	source_t *source;
+
+	Com_sprintf(name, sizeof(name), "%s/%s", cachebasefolder, filename);
+	for (cs = sourcecache; cs; cs = cs->next)
+	{
+		if (!Q_stricmp(cs->filename, name)) break;
+	} //end for
+	if (cs && !cs->refs && !PC_CachedSourceValid(cs))
+	{
+		PC_FreeCachedSource(cs);
+		cs = NULL;
+	} //end if
+	if (!cs)
+	{
+		source = LoadSourceFile(filename);
+		if (!source) return NULL;
+		Com_Memset(&entry, 0, sizeof(cachedsource_t));
+		Q_strncpyz(entry.filename, name, sizeof(entry.filename));
+		entry.globaldefines = PC_GlobalDefinesChecksum();
+		cs = PC_CacheSource(source, &entry);
+		FreeSource(source);
+		if (!cs) return LoadSourceFile(filename);
+		//make room for the new tokens by dropping the least recently used
+		while(sourcecachesize + cs->size > SOURCECACHE_SIZE)
+		{
+			oldest = NULL;
+			for (last = sourcecache; last; last = last->next)
+			{
+				if (last->refs) continue;
+				if (!oldest || last->lastused < oldest->lastused) oldest = last;
+			} //end for
+			if (!oldest) break;
+			PC_FreeCachedSource(oldest);
+		} //end while
+		cs->next = sourcecache;
+		sourcecache = cs;
+		sourcecachesize += cs->size;
+	} //end if
+	cs->refs++;
+	cs->lastused = ++sourcecacheframe;
+	//
+	source = (source_t *) GetClearedMemory(sizeof(source_t));
+	Q_strncpyz(source->filename, filename, sizeof(source->filename));
+	source->cache = cs;
+	source->cachetoken = 0;
+	return source;
+} //end of the function LoadCachedSourceFile
+#endif //BOTLIB
 //============================================================================
 //
 // Parameter:			-
@@ -3212,6 +3555,9 @@ int PC_SourceFileAndLine(int handle, char *filename, int *line)
 void PC_SetBaseFolder(char *path)
 {
 	PS_SetBaseFolder(path);
+#ifdef BOTLIB
+	Q_strncpyz(cachebasefolder, path, sizeof(cachebasefolder));
+#endif //BOTLIB
 } //end of the function PC_SetBaseFolder
 //============================================================================
 //
@@ -100,6 +100,8 @@ typedef struct source_s
 	indent_t *indentstack;					//stack with indents
 	int skip;								// > 0 if skipping conditional code
 	token_t token;							//last read token
+	struct cachedsource_s *cache;			//pre-processed tokens read instead of the scripts
+	int cachetoken;							//next cached token to read
 } source_t;
 
 
@@ -145,6 +147,8 @@ void PC_SetBaseFolder(char *path);
 source_t *LoadSourceFile(const char *filename);
 //load a source from memory
 source_t *LoadSourceMemory(char *ptr, int length, char *name);
+//load a source from the pre-processed tokens cached for the file
+source_t *LoadCachedSourceFile(const char *filename);
 //free the given source
 void FreeSource(source_t *source);
 //print a source error
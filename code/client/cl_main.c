@@ -3336,6 +3336,11 @@ void CL_InitRef( void ) {
 	ri.Sys_GLimpInit = Sys_GLimpInit;
 	ri.Sys_LowPhysicalMemory = Sys_LowPhysicalMemory;
 
+	ri.profiling = &com_profiling;
+	ri.ProfileBegin = Com_ProfileBegin;
+	ri.ProfileEnd = Com_ProfileEnd;
+	ri.RunJobs = Com_RunJobs;
+
 	ret = GetRefAPI( REF_API_VERSION, &ri );
 
 #if defined __USEA3D && defined __A3D_GEOM
@@ -858,6 +858,8 @@ CL_ParseServerMessage
 void CL_ParseServerMessage( msg_t *msg ) {
 	int			cmd;
 
+	PROFILE_BEGIN( PROFILE_CL_PARSESERVERMESSAGE );
+
 	if ( cl_shownet->integer == 1 ) {
 		Com_Printf ("%i ",msg->cursize);
 	} else if ( cl_shownet->integer >= 2 ) {
@@ -928,6 +930,8 @@ void CL_ParseServerMessage( msg_t *msg ) {
 			break;
 		}
 	}
+
+	PROFILE_END( PROFILE_CL_PARSESERVERMESSAGE );
 }
 
 
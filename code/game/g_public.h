@@ -101,6 +101,8 @@ typedef struct {
 
 //===============================================================
 
+#define	MAX_TRACE_BATCH		1024		// requests in one G_TRACE_BATCH
+
 //
 // system traps provided by the main engine
 //
@@ -230,6 +232,10 @@ typedef enum {
 	// 1.32
 	G_FS_SEEK,
 
+	G_TRACE_BATCH,	// ( trace_t *results, const traceRequest_t *reqs, int count );
+	// the same as a G_TRACE for each request, faster for many independent traces,
+	// at most MAX_TRACE_BATCH at a time
+
 	BOTLIB_SETUP = 200,				// ( void );
 	BOTLIB_SHUTDOWN,				// ( void );
 	BOTLIB_LIBVAR_SET,
@@ -24,6 +24,16 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "qcommon.h"
 #include "cm_polylib.h"
 
+// the vector brush tests in cm_simd.c must give the same results as the
+// scalar ones, so don't let multiplies and adds be fused on cpus with fma
+#if defined( __FP_FAST_FMAF )
+#if defined( __clang__ )
+#pragma STDC FP_CONTRACT OFF
+#elif defined( __GNUC__ )
+#pragma GCC optimize ( "fp-contract=off" )
+#endif
+#endif
+
 #define	MAX_SUBMODELS			256
 #define	BOX_MODEL_HANDLE		255
 #define CAPSULE_MODEL_HANDLE	254
@@ -63,6 +73,8 @@ typedef struct {
 	int			numsides;
 	cbrushside_t	*sides;
 	int			checkcount;		// to avoid repeated testings
+	float		*sidePlanes;	// normal x, y, z and dist runs for cm_simd.c, NULL on the box brush
+	int			sidePlaneStride;	// floats in each run
 } cbrush_t;
 
 
@@ -139,6 +151,8 @@ extern	int			c_traces, c_brush_traces, c_patch_traces;
 extern	cvar_t		*cm_noAreas;
 extern	cvar_t		*cm_noCurves;
 extern	cvar_t		*cm_playerCurveClip;
+extern	cvar_t		*cm_traceThreads;
+extern	cvar_t		*cm_simd;
 
 // cm_test.c
 
@@ -164,8 +178,18 @@ typedef struct {
 	qboolean	isPoint;	// optimized case
 	trace_t		trace;		// returned from trace call
 	sphere_t	sphere;		// sphere for oriendted capsule collision
+	struct traceChecks_s *checks;	// stamps of a batch worker, NULL for the ones in cm
+	int			checkcount;	// stamp of this trace
 } traceWork_t;
 
+// brushes and patches are stamped when a trace tests them so they aren't
+// tested again through another leaf, batch workers each keep their own
+typedef struct traceChecks_s {
+	int			checkcount;
+	int			*brushes;	// [cm.numBrushes + 1], the box brush is last
+	int			*surfaces;	// [cm.numSurfaces]
+} traceChecks_t;
+
 typedef struct leafList_s {
 	int		count;
 	int		maxcount;
@@ -188,6 +212,35 @@ cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle );
 qboolean CM_BoundsIntersect( const vec3_t mins, const vec3_t maxs, const vec3_t mins2, const vec3_t maxs2 );
 qboolean CM_BoundsIntersectPoint( const vec3_t mins, const vec3_t maxs, const vec3_t point );
 
+// cm_trace.c
+
+void CM_FreeTraceChecks( void );
+
+// cm_simd.c
+
+// a trace clipped against all sides of a brush
+typedef struct {
+	qboolean	startout;
+	qboolean	getout;
+	float		enterFrac;
+	float		leaveFrac;
+	int			leadSide;		// side giving enterFrac, -1 if none
+} brushClip_t;
+
+typedef struct {
+	const char	*name;
+	// returns qfalse if the trace is completely in front of a side
+	qboolean	(*clipBrush)( const traceWork_t *tw, const cbrush_t *brush, brushClip_t *clip );
+	// returns qtrue if the start is in front of one of the non axial sides
+	qboolean	(*outsideBrush)( const traceWork_t *tw, const cbrush_t *brush );
+} brushTests_t;
+
+extern const brushTests_t	*cm_brushTests;	// NULL if the cpu has no vector kernel
+
+void CM_BuildBrushPlanes( void );
+const brushTests_t **CM_BrushTestList( void );
+void CM_InitBrushTests( void );
+
 // cm_patch.c
 
 struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points );
@@ -45,6 +45,9 @@ void		CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 						  vec3_t mins, vec3_t maxs,
 						  clipHandle_t model, int brushmask,
 						  const vec3_t origin, const vec3_t angles, int capsule );
+// results[i] gets the trace of reqs[i], uses cm_traceThreads worker threads
+void		CM_BoxTraceBatch( trace_t *results, const traceRequest_t *reqs, int count, clipHandle_t model );
+void		CM_TraceBench_f( void );
 
 byte		*CM_ClusterPVS (int cluster);
 
@@ -0,0 +1,824 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// cm_simd.c -- vector versions of the brush side tests in cm_trace.c
+//
+// CM_TraceThroughBrush and CM_TestBoxInBrush walk the sides of a brush one
+// plane at a time.  Here the sides of every brush are copied into separate
+// normal x, y, z and dist arrays at load time, so that several sides can be
+// tested per instruction.  The kernels must give exactly the same results as
+// the scalar loops: the same float operations are done in the same order,
+// the clip fractions are divided in double precision just like the
+// SURFACE_CLIP_EPSILON expressions in C, and of the sides giving the same
+// enter fraction the first one is kept.
+
+#include "cm_local.h"
+
+#ifndef BSPC
+
+#if idx64
+#define CM_SSE2
+#include <emmintrin.h>
+#if defined( __GNUC__ )
+#define CM_AVX2
+#include <immintrin.h>
+#endif
+#elif defined( __aarch64__ ) && defined( __ARM_NEON )
+#define CM_NEON
+#include <arm_neon.h>
+#endif
+
+// padding sides have a zero normal and a huge distance, so that both ends
+// of every trace are behind them and they never change the result
+#define	PAD_PLANE_DIST		1e30f
+
+const brushTests_t	*cm_brushTests;
+
+/*
+==================
+CM_SidePlaneStride
+
+Every run of the side arrays is padded to a whole number of 8 wide vectors,
+plus one more vector for CM_TestBoxInBrush, which starts at side 6
+==================
+*/
+static int CM_SidePlaneStride( int numsides ) {
+	return ( ( numsides + 7 ) & ~7 ) + 8;
+}
+
+/*
+==================
+CM_BuildBrushPlanes
+
+Called after the brushes are loaded.  The box brush doesn't get a copy,
+its planes change with every CM_TempBoxModel.
+==================
+*/
+void CM_BuildBrushPlanes( void ) {
+	cbrush_t	*brush;
+	cplane_t	*plane;
+	float		*planes;
+	int			i, j, stride, total;
+
+	total = 0;
+	for ( i = 0 ; i < cm.numBrushes ; i++ ) {
+		total += 4 * CM_SidePlaneStride( cm.brushes[i].numsides );
+	}
+
+	planes = Hunk_Alloc( total * sizeof( *planes ), h_high );
+
+	for ( i = 0 ; i < cm.numBrushes ; i++ ) {
+		brush = &cm.brushes[i];
+		stride = CM_SidePlaneStride( brush->numsides );
+
+		brush->sidePlanes = planes;
+		brush->sidePlaneStride = stride;
+
+		for ( j = 0 ; j < stride ; j++ ) {
+			if ( j < brush->numsides ) {
+				plane = brush->sides[j].plane;
+				planes[j] = plane->normal[0];
+				planes[j + stride] = plane->normal[1];
+				planes[j + stride * 2] = plane->normal[2];
+				planes[j + stride * 3] = plane->dist;
+			} else {
+				planes[j] = 0;
+				planes[j + stride] = 0;
+				planes[j + stride * 2] = 0;
+				planes[j + stride * 3] = PAD_PLANE_DIST;
+			}
+		}
+
+		planes += 4 * stride;
+	}
+}
+
+/*
+==================
+CM_PickEnterSide
+
+Each lane kept its largest enter fraction and the first side giving it,
+pick the first side of the largest fraction over all lanes
+==================
+*/
+static void CM_PickEnterSide( const float *enter, const float *side, int lanes, brushClip_t *clip ) {
+	int		i;
+
+	clip->enterFrac = -1;
+	clip->leadSide = -1;
+
+	for ( i = 0 ; i < lanes ; i++ ) {
+		if ( side[i] < 0 ) {
+			continue;
+		}
+		if ( clip->leadSide < 0 || enter[i] > clip->enterFrac
+			|| ( enter[i] == clip->enterFrac && side[i] < clip->leadSide ) ) {
+			clip->enterFrac = enter[i];
+			clip->leadSide = side[i];
+		}
+	}
+}
+
+/*
+===============================================================================
+
+SSE2
+
+===============================================================================
+*/
+
+#ifdef CM_SSE2
+
+typedef struct {
+	qboolean	sphere;
+	__m128		start[3];
+	__m128		end[3];
+	__m128		size[2][3];		// size[1] is used where the normal is negative
+	__m128		offset[3];		// capsule
+	__m128		radius;
+} sseTrace_t;
+
+/*
+==================
+CM_SetupSSE2
+==================
+*/
+static void CM_SetupSSE2( const traceWork_t *tw, sseTrace_t *st ) {
+	int		i;
+
+	st->sphere = tw->sphere.use;
+	for ( i = 0 ; i < 3 ; i++ ) {
+		st->start[i] = _mm_set1_ps( tw->start[i] );
+		st->end[i] = _mm_set1_ps( tw->end[i] );
+		st->size[0][i] = _mm_set1_ps( tw->size[0][i] );
+		st->size[1][i] = _mm_set1_ps( tw->size[1][i] );
+		st->offset[i] = _mm_set1_ps( tw->sphere.offset[i] );
+	}
+	st->radius = _mm_set1_ps( tw->sphere.radius );
+}
+
+static ID_INLINE __m128 CM_SelectSSE2( __m128 mask, __m128 a, __m128 b ) {
+	return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+
+static ID_INLINE __m128 CM_DotSSE2( const __m128 *v, __m128 n0, __m128 n1, __m128 n2 ) {
+	return _mm_add_ps( _mm_add_ps( _mm_mul_ps( v[0], n0 ), _mm_mul_ps( v[1], n1 ) ), _mm_mul_ps( v[2], n2 ) );
+}
+
+/*
+==================
+CM_SideDistsSSE2
+
+Distances of the trace start and end in front of four sides,
+see CM_TraceThroughBrush
+==================
+*/
+static ID_INLINE void CM_SideDistsSSE2( const sseTrace_t *st, const float *planes, int stride,
+		int side, qboolean wantEnd, __m128 *d1, __m128 *d2 ) {
+	__m128	n0, n1, n2, dist, mask;
+	__m128	p[3];
+	int		i;
+
+	n0 = _mm_loadu_ps( planes + side );
+	n1 = _mm_loadu_ps( planes + stride + side );
+	n2 = _mm_loadu_ps( planes + stride * 2 + side );
+	dist = _mm_loadu_ps( planes + stride * 3 + side );
+
+	if ( st->sphere ) {
+		// adjust the plane distance appropriately for radius
+		dist = _mm_add_ps( dist, st->radius );
+
+		// find the closest point on the capsule to the plane
+		mask = _mm_cmpgt_ps( CM_DotSSE2( st->offset, n0, n1, n2 ), _mm_setzero_ps() );
+		for ( i = 0 ; i < 3 ; i++ ) {
+			p[i] = CM_SelectSSE2( mask, _mm_sub_ps( st->start[i], st->offset[i] ), _mm_add_ps( st->start[i], st->offset[i] ) );
+		}
+		*d1 = _mm_sub_ps( CM_DotSSE2( p, n0, n1, n2 ), dist );
+
+		if ( wantEnd ) {
+			for ( i = 0 ; i < 3 ; i++ ) {
+				p[i] = CM_SelectSSE2( mask, _mm_sub_ps( st->end[i], st->offset[i] ), _mm_add_ps( st->end[i], st->offset[i] ) );
+			}
+			*d2 = _mm_sub_ps( CM_DotSSE2( p, n0, n1, n2 ), dist );
+		}
+		return;
+	}
+
+	// adjust the plane distance appropriately for mins/maxs
+	p[0] = CM_SelectSSE2( _mm_cmplt_ps( n0, _mm_setzero_ps() ), st->size[1][0], st->size[0][0] );
+	p[1] = CM_SelectSSE2( _mm_cmplt_ps( n1, _mm_setzero_ps() ), st->size[1][1], st->size[0][1] );
+	p[2] = CM_SelectSSE2( _mm_cmplt_ps( n2, _mm_setzero_ps() ), st->size[1][2], st->size[0][2] );
+	dist = _mm_sub_ps( dist, CM_DotSSE2( p, n0, n1, n2 ) );
+
+	*d1 = _mm_sub_ps( CM_DotSSE2( st->start, n0, n1, n2 ), dist );
+	if ( wantEnd ) {
+		*d2 = _mm_sub_ps( CM_DotSSE2( st->end, n0, n1, n2 ), dist );
+	}
+}
+
+/*
+==================
+CM_ClipFractionsSSE2
+
+( d1 + epsilon ) / den in double precision, like the C expressions
+==================
+*/
+static ID_INLINE __m128 CM_ClipFractionsSSE2( __m128 d1, __m128 den, __m128d epsilon ) {
+	__m128d	lo, hi;
+
+	lo = _mm_div_pd( _mm_add_pd( _mm_cvtps_pd( d1 ), epsilon ), _mm_cvtps_pd( den ) );
+	hi = _mm_div_pd( _mm_add_pd( _mm_cvtps_pd( _mm_movehl_ps( d1, d1 ) ), epsilon ),
+		_mm_cvtps_pd( _mm_movehl_ps( den, den ) ) );
+
+	return _mm_movelh_ps( _mm_cvtpd_ps( lo ), _mm_cvtpd_ps( hi ) );
+}
+
+/*
+==================
+CM_ClipBrushSSE2
+==================
+*/
+static qboolean CM_ClipBrushSSE2( const traceWork_t *tw, const cbrush_t *brush, brushClip_t *clip ) {
+	sseTrace_t	st;
+	__m128		zero, one, epsilon, index, four;
+	__m128		d1, d2, out, cross, entering, f, update;
+	__m128		startout, getout, enter, enterSide, leave;
+	__m128d		enterEpsilon, leaveEpsilon;
+	float		enters[4], sides[4], leaves[4];
+	int			i;
+
+	CM_SetupSSE2( tw, &st );
+
+	zero = _mm_setzero_ps();
+	one = _mm_set1_ps( 1.0f );
+	epsilon = _mm_set1_ps( SURFACE_CLIP_EPSILON );
+	enterEpsilon = _mm_set1_pd( -SURFACE_CLIP_EPSILON );
+	leaveEpsilon = _mm_set1_pd( SURFACE_CLIP_EPSILON );
+	index = _mm_setr_ps( 0, 1, 2, 3 );
+	four = _mm_set1_ps( 4.0f );
+
+	startout = getout = zero;
+	enter = enterSide = _mm_set1_ps( -1.0f );
+	leave = one;
+
+	for ( i = 0 ; i < brush->numsides ; i += 4 ) {
+		CM_SideDistsSSE2( &st, brush->sidePlanes, brush->sidePlaneStride, i, qtrue, &d1, &d2 );
+
+		getout = _mm_or_ps( getout, _mm_cmpgt_ps( d2, zero ) );
+		startout = _mm_or_ps( startout, _mm_cmpgt_ps( d1, zero ) );
+
+		// if completely in front of face, no intersection with the entire brush
+		out = _mm_and_ps( _mm_cmpgt_ps( d1, zero ), _mm_or_ps( _mm_cmpge_ps( d2, epsilon ), _mm_cmpge_ps( d2, d1 ) ) );
+		if ( _mm_movemask_ps( out ) ) {
+			return qfalse;
+		}
+
+		// if it doesn't cross the plane, the plane isn't relevant
+		cross = _mm_or_ps( _mm_cmpgt_ps( d1, zero ), _mm_cmpgt_ps( d2, zero ) );
+		if ( _mm_movemask_ps( cross ) ) {
+			entering = _mm_cmpgt_ps( d1, d2 );
+
+			f = CM_ClipFractionsSSE2( d1, _mm_sub_ps( d1, d2 ), enterEpsilon );
+			f = CM_SelectSSE2( _mm_cmplt_ps( f, zero ), zero, f );
+			update = _mm_and_ps( _mm_and_ps( cross, entering ), _mm_cmpgt_ps( f, enter ) );
+			enter = CM_SelectSSE2( update, f, enter );
+			enterSide = CM_SelectSSE2( update, index, enterSide );
+
+			f = CM_ClipFractionsSSE2( d1, _mm_sub_ps( d1, d2 ), leaveEpsilon );
+			f = CM_SelectSSE2( _mm_cmpgt_ps( f, one ), one, f );
+			update = _mm_and_ps( _mm_andnot_ps( entering, cross ), _mm_cmplt_ps( f, leave ) );
+			leave = CM_SelectSSE2( update, f, leave );
+		}
+
+		index = _mm_add_ps( index, four );
+	}
+
+	clip->startout = _mm_movemask_ps( startout ) != 0;
+	clip->getout = _mm_movemask_ps( getout ) != 0;
+
+	_mm_storeu_ps( enters, enter );
+	_mm_storeu_ps( sides, enterSide );
+	_mm_storeu_ps( leaves, leave );
+
+	CM_PickEnterSide( enters, sides, 4, clip );
+
+	clip->leaveFrac = leaves[0];
+	for ( i = 1 ; i < 4 ; i++ ) {
+		if ( leaves[i] < clip->leaveFrac ) {
+			clip->leaveFrac = leaves[i];
+		}
+	}
+
+	return qtrue;
+}
+
+/*
+==================
+CM_OutsideBrushSSE2
+==================
+*/
+static qboolean CM_OutsideBrushSSE2( const traceWork_t *tw, const cbrush_t *brush ) {
+	sseTrace_t	st;
+	__m128		d1, out;
+	int			i;
+
+	CM_SetupSSE2( tw, &st );
+
+	// the first six planes are the axial planes, so we only
+	// need to test the remainder
+	out = _mm_setzero_ps();
+	for ( i = 6 ; i < brush->numsides ; i += 4 ) {
+		CM_SideDistsSSE2( &st, brush->sidePlanes, brush->sidePlaneStride, i, qfalse, &d1, NULL );
+		out = _mm_or_ps( out, _mm_cmpgt_ps( d1, _mm_setzero_ps() ) );
+	}
+
+	return _mm_movemask_ps( out ) != 0;
+}
+
+static const brushTests_t	cm_brushTestsSSE2 = { "SSE2", CM_ClipBrushSSE2, CM_OutsideBrushSSE2 };
+
+#endif	// CM_SSE2
+
+/*
+===============================================================================
+
+AVX2
+
+The same as the SSE2 kernels, eight sides at a time.  Only avx2 is enabled
+for these functions and not fma, so the multiplies and adds stay separate.
+
+===============================================================================
+*/
+
+#ifdef CM_AVX2
+
+#define	CM_AVX2_FUNC	__attribute__(( target( "avx2" ) ))
+
+typedef struct {
+	qboolean	sphere;
+	__m256		start[3];
+	__m256		end[3];
+	__m256		size[2][3];
+	__m256		offset[3];
+	__m256		radius;
+} avxTrace_t;
+
+/*
+==================
+CM_SetupAVX2
+==================
+*/
+static CM_AVX2_FUNC void CM_SetupAVX2( const traceWork_t *tw, avxTrace_t *at ) {
+	int		i;
+
+	at->sphere = tw->sphere.use;
+	for ( i = 0 ; i < 3 ; i++ ) {
+		at->start[i] = _mm256_set1_ps( tw->start[i] );
+		at->end[i] = _mm256_set1_ps( tw->end[i] );
+		at->size[0][i] = _mm256_set1_ps( tw->size[0][i] );
+		at->size[1][i] = _mm256_set1_ps( tw->size[1][i] );
+		at->offset[i] = _mm256_set1_ps( tw->sphere.offset[i] );
+	}
+	at->radius = _mm256_set1_ps( tw->sphere.radius );
+}
+
+static CM_AVX2_FUNC ID_INLINE __m256 CM_DotAVX2( const __m256 *v, __m256 n0, __m256 n1, __m256 n2 ) {
+	return _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( v[0], n0 ), _mm256_mul_ps( v[1], n1 ) ), _mm256_mul_ps( v[2], n2 ) );
+}
+
+/*
+==================
+CM_SideDistsAVX2
+==================
+*/
+static CM_AVX2_FUNC ID_INLINE void CM_SideDistsAVX2( const avxTrace_t *at, const float *planes, int stride,
+		int side, qboolean wantEnd, __m256 *d1, __m256 *d2 ) {
+	__m256	n0, n1, n2, dist, mask, zero;
+	__m256	p[3];
+	int		i;
+
+	zero = _mm256_setzero_ps();
+	n0 = _mm256_loadu_ps( planes + side );
+	n1 = _mm256_loadu_ps( planes + stride + side );
+	n2 = _mm256_loadu_ps( planes + stride * 2 + side );
+	dist = _mm256_loadu_ps( planes + stride * 3 + side );
+
+	if ( at->sphere ) {
+		dist = _mm256_add_ps( dist, at->radius );
+
+		mask = _mm256_cmp_ps( CM_DotAVX2( at->offset, n0, n1, n2 ), zero, _CMP_GT_OQ );
+		for ( i = 0 ; i < 3 ; i++ ) {
+			p[i] = _mm256_blendv_ps( _mm256_add_ps( at->start[i], at->offset[i] ), _mm256_sub_ps( at->start[i], at->offset[i] ), mask );
+		}
+		*d1 = _mm256_sub_ps( CM_DotAVX2( p, n0, n1, n2 ), dist );
+
+		if ( wantEnd ) {
+			for ( i = 0 ; i < 3 ; i++ ) {
+				p[i] = _mm256_blendv_ps( _mm256_add_ps( at->end[i], at->offset[i] ), _mm256_sub_ps( at->end[i], at->offset[i] ), mask );
+			}
+			*d2 = _mm256_sub_ps( CM_DotAVX2( p, n0, n1, n2 ), dist );
+		}
+		return;
+	}
+
+	p[0] = _mm256_blendv_ps( at->size[0][0], at->size[1][0], _mm256_cmp_ps( n0, zero, _CMP_LT_OQ ) );
+	p[1] = _mm256_blendv_ps( at->size[0][1], at->size[1][1], _mm256_cmp_ps( n1, zero, _CMP_LT_OQ ) );
+	p[2] = _mm256_blendv_ps( at->size[0][2], at->size[1][2], _mm256_cmp_ps( n2, zero, _CMP_LT_OQ ) );
+	dist = _mm256_sub_ps( dist, CM_DotAVX2( p, n0, n1, n2 ) );
+
+	*d1 = _mm256_sub_ps( CM_DotAVX2( at->start, n0, n1, n2 ), dist );
+	if ( wantEnd ) {
+		*d2 = _mm256_sub_ps( CM_DotAVX2( at->end, n0, n1, n2 ), dist );
+	}
+}
+
+/*
+==================
+CM_ClipFractionsAVX2
+==================
+*/
+static CM_AVX2_FUNC ID_INLINE __m256 CM_ClipFractionsAVX2( __m256 d1, __m256 den, __m256d epsilon ) {
+	__m256d	lo, hi;
+
+	lo = _mm256_div_pd( _mm256_add_pd( _mm256_cvtps_pd( _mm256_castps256_ps128( d1 ) ), epsilon ),
+		_mm256_cvtps_pd( _mm256_castps256_ps128( den ) ) );
+	hi = _mm256_div_pd( _mm256_add_pd( _mm256_cvtps_pd( _mm256_extractf128_ps( d1, 1 ) ), epsilon ),
+		_mm256_cvtps_pd( _mm256_extractf128_ps( den, 1 ) ) );
+
+	return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm256_cvtpd_ps( lo ) ), _mm256_cvtpd_ps( hi ), 1 );
+}
+
+/*
+==================
+CM_ClipBrushAVX2
+==================
+*/
+static CM_AVX2_FUNC qboolean CM_ClipBrushAVX2( const traceWork_t *tw, const cbrush_t *brush, brushClip_t *clip ) {
+	avxTrace_t	at;
+	__m256		zero, one, epsilon, index, eight;
+	__m256		d1, d2, out, cross, entering, f, update;
+	__m256		startout, getout, enter, enterSide, leave;
+	__m256d		enterEpsilon, leaveEpsilon;
+	float		enters[8], sides[8], leaves[8];
+	int			i;
+
+	CM_SetupAVX2( tw, &at );
+
+	zero = _mm256_setzero_ps();
+	one = _mm256_set1_ps( 1.0f );
+	epsilon = _mm256_set1_ps( SURFACE_CLIP_EPSILON );
+	enterEpsilon = _mm256_set1_pd( -SURFACE_CLIP_EPSILON );
+	leaveEpsilon = _mm256_set1_pd( SURFACE_CLIP_EPSILON );
+	index = _mm256_setr_ps( 0, 1, 2, 3, 4, 5, 6, 7 );
+	eight = _mm256_set1_ps( 8.0f );
+
+	startout = getout = zero;
+	enter = enterSide = _mm256_set1_ps( -1.0f );
+	leave = one;
+
+	for ( i = 0 ; i < brush->numsides ; i += 8 ) {
+		CM_SideDistsAVX2( &at, brush->sidePlanes, brush->sidePlaneStride, i, qtrue, &d1, &d2 );
+
+		getout = _mm256_or_ps( getout, _mm256_cmp_ps( d2, zero, _CMP_GT_OQ ) );
+		startout = _mm256_or_ps( startout, _mm256_cmp_ps( d1, zero, _CMP_GT_OQ ) );
+
+		out = _mm256_and_ps( _mm256_cmp_ps( d1, zero, _CMP_GT_OQ ),
+			_mm256_or_ps( _mm256_cmp_ps( d2, epsilon, _CMP_GE_OQ ), _mm256_cmp_ps( d2, d1, _CMP_GE_OQ ) ) );
+		if ( _mm256_movemask_ps( out ) ) {
+			return qfalse;
+		}
+
+		cross = _mm256_or_ps( _mm256_cmp_ps( d1, zero, _CMP_GT_OQ ), _mm256_cmp_ps( d2, zero, _CMP_GT_OQ ) );
+		if ( _mm256_movemask_ps( cross ) ) {
+			entering = _mm256_cmp_ps( d1, d2, _CMP_GT_OQ );
+
+			f = CM_ClipFractionsAVX2( d1, _mm256_sub_ps( d1, d2 ), enterEpsilon );
+			f = _mm256_blendv_ps( f, zero, _mm256_cmp_ps( f, zero, _CMP_LT_OQ ) );
+			update = _mm256_and_ps( _mm256_and_ps( cross, entering ), _mm256_cmp_ps( f, enter, _CMP_GT_OQ ) );
+			enter = _mm256_blendv_ps( enter, f, update );
+			enterSide = _mm256_blendv_ps( enterSide, index, update );
+
+			f = CM_ClipFractionsAVX2( d1, _mm256_sub_ps( d1, d2 ), leaveEpsilon );
+			f = _mm256_blendv_ps( f, one, _mm256_cmp_ps( f, one, _CMP_GT_OQ ) );
+			update = _mm256_and_ps( _mm256_andnot_ps( entering, cross ), _mm256_cmp_ps( f, leave, _CMP_LT_OQ ) );
+			leave = _mm256_blendv_ps( leave, f, update );
+		}
+
+		index = _mm256_add_ps( index, eight );
+	}
+
+	clip->startout = _mm256_movemask_ps( startout ) != 0;
+	clip->getout = _mm256_movemask_ps( getout ) != 0;
+
+	_mm256_storeu_ps( enters, enter );
+	_mm256_storeu_ps( sides, enterSide );
+	_mm256_storeu_ps( leaves, leave );
+
+	CM_PickEnterSide( enters, sides, 8, clip );
+
+	clip->leaveFrac = leaves[0];
+	for ( i = 1 ; i < 8 ; i++ ) {
+		if ( leaves[i] < clip->leaveFrac ) {
+			clip->leaveFrac = leaves[i];
+		}
+	}
+
+	return qtrue;
+}
+
+/*
+==================
+CM_OutsideBrushAVX2
+==================
+*/
+static CM_AVX2_FUNC qboolean CM_OutsideBrushAVX2( const traceWork_t *tw, const cbrush_t *brush ) {
+	avxTrace_t	at;
+	__m256		d1, out;
+	int			i;
+
+	CM_SetupAVX2( tw, &at );
+
+	out = _mm256_setzero_ps();
+	for ( i = 6 ; i < brush->numsides ; i += 8 ) {
+		CM_SideDistsAVX2( &at, brush->sidePlanes, brush->sidePlaneStride, i, qfalse, &d1, NULL );
+		out = _mm256_or_ps( out, _mm256_cmp_ps( d1, _mm256_setzero_ps(), _CMP_GT_OQ ) );
+	}
+
+	return _mm256_movemask_ps( out ) != 0;
+}
+
+static const brushTests_t	cm_brushTestsAVX2 = { "AVX2", CM_ClipBrushAVX2, CM_OutsideBrushAVX2 };
+
+#endif	// CM_AVX2
+
+/*
+===============================================================================
+
+NEON
+
+===============================================================================
+*/
+
+#ifdef CM_NEON
+
+typedef struct {
+	qboolean	sphere;
+	float32x4_t	start[3];
+	float32x4_t	end[3];
+	float32x4_t	size[2][3];
+	float32x4_t	offset[3];
+	float32x4_t	radius;
+} neonTrace_t;
+
+/*
+==================
+CM_SetupNEON
+==================
+*/
+static void CM_SetupNEON( const traceWork_t *tw, neonTrace_t *nt ) {
+	int		i;
+
+	nt->sphere = tw->sphere.use;
+	for ( i = 0 ; i < 3 ; i++ ) {
+		nt->start[i] = vdupq_n_f32( tw->start[i] );
+		nt->end[i] = vdupq_n_f32( tw->end[i] );
+		nt->size[0][i] = vdupq_n_f32( tw->size[0][i] );
+		nt->size[1][i] = vdupq_n_f32( tw->size[1][i] );
+		nt->offset[i] = vdupq_n_f32( tw->sphere.offset[i] );
+	}
+	nt->radius = vdupq_n_f32( tw->sphere.radius );
+}
+
+// separate multiplies and adds, vmlaq_f32 may be fused
+static ID_INLINE float32x4_t CM_DotNEON( const float32x4_t *v, float32x4_t n0, float32x4_t n1, float32x4_t n2 ) {
+	return vaddq_f32( vaddq_f32( vmulq_f32( v[0], n0 ), vmulq_f32( v[1], n1 ) ), vmulq_f32( v[2], n2 ) );
+}
+
+static ID_INLINE qboolean CM_AnyNEON( uint32x4_t mask ) {
+	return vmaxvq_u32( mask ) != 0;
+}
+
+/*
+==================
+CM_SideDistsNEON
+==================
+*/
+static ID_INLINE void CM_SideDistsNEON( const neonTrace_t *nt, const float *planes, int stride,
+		int side, qboolean wantEnd, float32x4_t *d1, float32x4_t *d2 ) {
+	float32x4_t	n0, n1, n2, dist, zero;
+	float32x4_t	p[3];
+	uint32x4_t	mask;
+	int			i;
+
+	zero = vdupq_n_f32( 0 );
+	n0 = vld1q_f32( planes + side );
+	n1 = vld1q_f32( planes + stride + side );
+	n2 = vld1q_f32( planes + stride * 2 + side );
+	dist = vld1q_f32( planes + stride * 3 + side );
+
+	if ( nt->sphere ) {
+		dist = vaddq_f32( dist, nt->radius );
+
+		mask = vcgtq_f32( CM_DotNEON( nt->offset, n0, n1, n2 ), zero );
+		for ( i = 0 ; i < 3 ; i++ ) {
+			p[i] = vbslq_f32( mask, vsubq_f32( nt->start[i], nt->offset[i] ), vaddq_f32( nt->start[i], nt->offset[i] ) );
+		}
+		*d1 = vsubq_f32( CM_DotNEON( p, n0, n1, n2 ), dist );
+
+		if ( wantEnd ) {
+			for ( i = 0 ; i < 3 ; i++ ) {
+				p[i] = vbslq_f32( mask, vsubq_f32( nt->end[i], nt->offset[i] ), vaddq_f32( nt->end[i], nt->offset[i] ) );
+			}
+			*d2 = vsubq_f32( CM_DotNEON( p, n0, n1, n2 ), dist );
+		}
+		return;
+	}
+
+	p[0] = vbslq_f32( vcltq_f32( n0, zero ), nt->size[1][0], nt->size[0][0] );
+	p[1] = vbslq_f32( vcltq_f32( n1, zero ), nt->size[1][1], nt->size[0][1] );
+	p[2] = vbslq_f32( vcltq_f32( n2, zero ), nt->size[1][2], nt->size[0][2] );
+	dist = vsubq_f32( dist, CM_DotNEON( p, n0, n1, n2 ) );
+
+	*d1 = vsubq_f32( CM_DotNEON( nt->start, n0, n1, n2 ), dist );
+	if ( wantEnd ) {
+		*d2 = vsubq_f32( CM_DotNEON( nt->end, n0, n1, n2 ), dist );
+	}
+}
+
+/*
+==================
+CM_ClipFractionsNEON
+==================
+*/
+static ID_INLINE float32x4_t CM_ClipFractionsNEON( float32x4_t d1, float32x4_t den, float64x2_t epsilon ) {
+	float64x2_t	lo, hi;
+
+	lo = vdivq_f64( vaddq_f64( vcvt_f64_f32( vget_low_f32( d1 ) ), epsilon ), vcvt_f64_f32( vget_low_f32( den ) ) );
+	hi = vdivq_f64( vaddq_f64( vcvt_high_f64_f32( d1 ), epsilon ), vcvt_high_f64_f32( den ) );
+
+	return vcvt_high_f32_f64( vcvt_f32_f64( lo ), hi );
+}
+
+/*
+==================
+CM_ClipBrushNEON
+==================
+*/
+static qboolean CM_ClipBrushNEON( const traceWork_t *tw, const cbrush_t *brush, brushClip_t *clip ) {
+	static const float	lanes[4] = { 0, 1, 2, 3 };
+	neonTrace_t	nt;
+	float32x4_t	zero, one, epsilon, index, four;
+	float32x4_t	d1, d2, f, enter, enterSide, leave;
+	uint32x4_t	out, cross, entering, update, startout, getout;
+	float64x2_t	enterEpsilon, leaveEpsilon;
+	float		enters[4], sides[4], leaves[4];
+	int			i;
+
+	CM_SetupNEON( tw, &nt );
+
+	zero = vdupq_n_f32( 0 );
+	one = vdupq_n_f32( 1.0f );
+	epsilon = vdupq_n_f32( SURFACE_CLIP_EPSILON );
+	enterEpsilon = vdupq_n_f64( -SURFACE_CLIP_EPSILON );
+	leaveEpsilon = vdupq_n_f64( SURFACE_CLIP_EPSILON );
+	index = vld1q_f32( lanes );
+	four = vdupq_n_f32( 4.0f );
+
+	startout = getout = vdupq_n_u32( 0 );
+	enter = enterSide = vdupq_n_f32( -1.0f );
+	leave = one;
+
+	for ( i = 0 ; i < brush->numsides ; i += 4 ) {
+		CM_SideDistsNEON( &nt, brush->sidePlanes, brush->sidePlaneStride, i, qtrue, &d1, &d2 );
+
+		getout = vorrq_u32( getout, vcgtq_f32( d2, zero ) );
+		startout = vorrq_u32( startout, vcgtq_f32( d1, zero ) );
+
+		out = vandq_u32( vcgtq_f32( d1, zero ), vorrq_u32( vcgeq_f32( d2, epsilon ), vcgeq_f32( d2, d1 ) ) );
+		if ( CM_AnyNEON( out ) ) {
+			return qfalse;
+		}
+
+		cross = vorrq_u32( vcgtq_f32( d1, zero ), vcgtq_f32( d2, zero ) );
+		if ( CM_AnyNEON( cross ) ) {
+			entering = vcgtq_f32( d1, d2 );
+
+			f = CM_ClipFractionsNEON( d1, vsubq_f32( d1, d2 ), enterEpsilon );
+			f = vbslq_f32( vcltq_f32( f, zero ), zero, f );
+			update = vandq_u32( vandq_u32( cross, entering ), vcgtq_f32( f, enter ) );
+			enter = vbslq_f32( update, f, enter );
+			enterSide = vbslq_f32( update, index, enterSide );
+
+			f = CM_ClipFractionsNEON( d1, vsubq_f32( d1, d2 ), leaveEpsilon );
+			f = vbslq_f32( vcgtq_f32( f, one ), one, f );
+			update = vandq_u32( vbicq_u32( cross, entering ), vcltq_f32( f, leave ) );
+			leave = vbslq_f32( update, f, leave );
+		}
+
+		index = vaddq_f32( index, four );
+	}
+
+	clip->startout = CM_AnyNEON( startout );
+	clip->getout = CM_AnyNEON( getout );
+
+	vst1q_f32( enters, enter );
+	vst1q_f32( sides, enterSide );
+	vst1q_f32( leaves, leave );
+
+	CM_PickEnterSide( enters, sides, 4, clip );
+
+	clip->leaveFrac = leaves[0];
+	for ( i = 1 ; i < 4 ; i++ ) {
+		if ( leaves[i] < clip->leaveFrac ) {
+			clip->leaveFrac = leaves[i];
+		}
+	}
+
+	return qtrue;
+}
+
+/*
+==================
+CM_OutsideBrushNEON
+==================
+*/
+static qboolean CM_OutsideBrushNEON( const traceWork_t *tw, const cbrush_t *brush ) {
+	neonTrace_t	nt;
+	float32x4_t	d1;
+	uint32x4_t	out;
+	int			i;
+
+	CM_SetupNEON( tw, &nt );
+
+	out = vdupq_n_u32( 0 );
+	for ( i = 6 ; i < brush->numsides ; i += 4 ) {
+		CM_SideDistsNEON( &nt, brush->sidePlanes, brush->sidePlaneStride, i, qfalse, &d1, NULL );
+		out = vorrq_u32( out, vcgtq_f32( d1, vdupq_n_f32( 0 ) ) );
+	}
+
+	return CM_AnyNEON( out );
+}
+
+static const brushTests_t	cm_brushTestsNEON = { "NEON", CM_ClipBrushNEON, CM_OutsideBrushNEON };
+
+#endif	// CM_NEON
+
+/*
+==================
+CM_BrushTestList
+
+The kernels this cpu can run, best first, NULL terminated
+==================
+*/
+const brushTests_t **CM_BrushTestList( void ) {
+	static const brushTests_t	*list[4];
+	int		count = 0;
+
+	if ( list[0] ) {
+		return list;
+	}
+
+#ifdef CM_AVX2
+	if ( __builtin_cpu_supports( "avx2" ) ) {
+		list[count++] = &cm_brushTestsAVX2;
+	}
+#endif
+#ifdef CM_SSE2
+	list[count++] = &cm_brushTestsSSE2;
+#endif
+#ifdef CM_NEON
+	list[count++] = &cm_brushTestsNEON;
+#endif
+	list[count] = NULL;
+
+	return list;
+}
+
+/*
+==================
+CM_InitBrushTests
+==================
+*/
+void CM_InitBrushTests( void ) {
+	cm_brushTests = CM_BrushTestList()[0];
+}
+
+#endif	// !BSPC
@@ -153,6 +153,19 @@ POSITION TESTING
 ===============================================================================
 */
 
+#ifndef BSPC
+/*
+================
+CM_UseBrushTests
+
+The vector kernels in cm_simd.c give the same results as the loops below
+================
+*/
+static ID_INLINE qboolean CM_UseBrushTests( const cbrush_t *brush ) {
+	return cm_brushTests && brush->sidePlanes && cm_simd->integer;
+}
+#endif
+
 /*
 ================
 CM_TestBoxInBrush
@@ -182,6 +195,14 @@ void CM_TestBoxInBrush( traceWork_t *tw, cbrush_t *brush ) {
 		return;
 	}
 
+#ifndef BSPC
+	if ( CM_UseBrushTests( brush ) ) {
+		if ( cm_brushTests->outsideBrush( tw, brush ) ) {
+			return;
+		}
+	}
+	else
+#endif
    if ( tw->sphere.use ) {
 		// the first six planes are the axial planes, so we only
 		// need to test the remainder
@@ -234,6 +255,55 @@ void CM_TestBoxInBrush( traceWork_t *tw, cbrush_t *brush ) {
 
 
 
+/*
+================
+CM_NewCheckCount
+================
+*/
+static void CM_NewCheckCount( traceWork_t *tw ) {
+	if ( tw->checks ) {
+		tw->checkcount = ++tw->checks->checkcount;
+	} else {
+		tw->checkcount = ++cm.checkcount;
+	}
+}
+
+/*
+================
+CM_CheckBrush
+
+Returns qfalse if the trace already tested the brush
+================
+*/
+static ID_INLINE qboolean CM_CheckBrush( traceWork_t *tw, int brushnum ) {
+	int		*check;
+
+	check = tw->checks ? &tw->checks->brushes[brushnum] : &cm.brushes[brushnum].checkcount;
+	if ( *check == tw->checkcount ) {
+		return qfalse;
+	}
+	*check = tw->checkcount;
+	return qtrue;
+}
+
+/*
+================
+CM_CheckPatch
+
+Returns qfalse if the trace already tested the patch
+================
+*/
+static ID_INLINE qboolean CM_CheckPatch( traceWork_t *tw, int surfnum ) {
+	int		*check;
+
+	check = tw->checks ? &tw->checks->surfaces[surfnum] : &cm.surfaces[surfnum]->checkcount;
+	if ( *check == tw->checkcount ) {
+		return qfalse;
+	}
+	*check = tw->checkcount;
+	return qtrue;
+}
+
 /*
 ================
 CM_TestInLeaf
@@ -241,18 +311,17 @@ CM_TestInLeaf
 */
 void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	int			k;
-	int			brushnum;
+	int			brushnum, surfnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
 	// test box position against all brushes in the leaf
 	for (k=0 ; k<leaf->numLeafBrushes ; k++) {
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush+k];
-		b = &cm.brushes[brushnum];
-		if (b->checkcount == cm.checkcount) {
+		if ( !CM_CheckBrush( tw, brushnum ) ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = cm.checkcount;
+		b = &cm.brushes[brushnum];
 
 		if ( !(b->contents & tw->contents)) {
 			continue;
@@ -271,14 +340,14 @@ void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	if ( !cm_noCurves->integer ) {
 #endif //BSPC
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			surfnum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = cm.surfaces[ surfnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == cm.checkcount ) {
+			if ( !CM_CheckPatch( tw, surfnum ) ) {
 				continue;	// already checked this brush in another leaf
 			}
-			patch->checkcount = cm.checkcount;
 
 			if ( !(patch->contents & tw->contents)) {
 				continue;
@@ -428,12 +497,12 @@ void CM_PositionTest( traceWork_t *tw ) {
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
 
-	cm.checkcount++;
+	CM_NewCheckCount( tw );
 
 	CM_BoxLeafnums_r( &ll, 0 );
 
 
-	cm.checkcount++;
+	CM_NewCheckCount( tw );
 
 	// test the contents of the leafs
 	for (i=0 ; i < ll.count ; i++) {
@@ -507,6 +576,25 @@ void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush ) {
 
 	leadside = NULL;
 
+#ifndef BSPC
+	if ( CM_UseBrushTests( brush ) ) {
+		brushClip_t	clip;
+
+		if ( !cm_brushTests->clipBrush( tw, brush, &clip ) ) {
+			return;
+		}
+
+		getout = clip.getout;
+		startout = clip.startout;
+		enterFrac = clip.enterFrac;
+		leaveFrac = clip.leaveFrac;
+		if ( clip.leadSide >= 0 ) {
+			leadside = brush->sides + clip.leadSide;
+			clipplane = leadside->plane;
+		}
+	}
+	else
+#endif
 	if ( tw->sphere.use ) {
 		//
 		// compare the trace against all planes of the brush
@@ -668,7 +756,7 @@ CM_TraceThroughLeaf
 */
 void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	int			k;
-	int			brushnum;
+	int			brushnum, surfnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
@@ -676,11 +764,10 @@ void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	for ( k = 0 ; k < leaf->numLeafBrushes ; k++ ) {
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush+k];
 
-		b = &cm.brushes[brushnum];
-		if ( b->checkcount == cm.checkcount ) {
+		if ( !CM_CheckBrush( tw, brushnum ) ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = cm.checkcount;
+		b = &cm.brushes[brushnum];
 
 		if ( !(b->contents & tw->contents) ) {
 			continue;
@@ -704,14 +791,14 @@ void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	if ( !cm_noCurves->integer ) {
 #endif
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			surfnum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = cm.surfaces[ surfnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == cm.checkcount ) {
+			if ( !CM_CheckPatch( tw, surfnum ) ) {
 				continue;	// already checked this patch in another leaf
 			}
-			patch->checkcount = cm.checkcount;
 
 			if ( !(patch->contents & tw->contents) ) {
 				continue;
@@ -1146,7 +1233,8 @@ CM_Trace
 ==================
 */
 void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, vec3_t mins, vec3_t maxs,
-						  clipHandle_t model, const vec3_t origin, int brushmask, int capsule, sphere_t *sphere ) {
+						  clipHandle_t model, const vec3_t origin, int brushmask, int capsule, sphere_t *sphere,
+						  traceChecks_t *checks ) {
 	int			i;
 	traceWork_t	tw;
 	vec3_t		offset;
@@ -1154,13 +1242,14 @@ void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, vec3_t mi
 
 	cmod = CM_ClipHandleToModel( model );
 
-	cm.checkcount++;		// for multi-check avoidance
-
 	c_traces++;				// for statistics, may be zeroed
 
 	// fill in a default trace
 	Com_Memset( &tw, 0, sizeof(tw) );
 	tw.trace.fraction = 1;	// assume it goes the entire distance until shown otherwise
+
+	tw.checks = checks;
+	CM_NewCheckCount( &tw );	// for multi-check avoidance
 	VectorCopy(origin, tw.modelOrigin);
 
 	if (!cm.numNodes) {
@@ -1169,6 +1258,8 @@ void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, vec3_t mi
 		return;	// map not loaded, shouldn't happen
 	}
 
+	PROFILE_BEGIN( PROFILE_CM_TRACE );
+
 	// allow NULL to be passed in for 0,0,0
 	if ( !mins ) {
 		mins = vec3_origin;
@@ -1356,6 +1447,8 @@ void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, vec3_t mi
                tw.trace.fraction == 1.0 ||
                VectorLengthSquared(tw.trace.plane.normal) > 0.9999);
 	*results = tw.trace;
+
+	PROFILE_END( PROFILE_CM_TRACE );
 }
 
 /*
@@ -1366,7 +1459,7 @@ CM_BoxTrace
 void CM_BoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
 						  vec3_t mins, vec3_t maxs,
 						  clipHandle_t model, int brushmask, int capsule ) {
-	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
+	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL, NULL );
 }
 
 /*
@@ -1451,7 +1544,7 @@ void CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 	}
 
 	// sweep the box through the model
-	CM_Trace( &trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere );
+	CM_Trace( &trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere, NULL );
 
 	// if the bmodel was rotated and there was a collision
 	if ( rotated && trace.fraction != 1.0 ) {
@@ -1468,3 +1561,480 @@ void CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 
 	*results = trace;
 }
+
+
+#ifndef BSPC
+/*
+===============================================================================
+
+BATCHED TRACES
+
+CM_BoxTraceBatch runs a set of independent traces through one model.
+The requests are sorted along a space filling curve, so traces that walk
+the same nodes and brushes run back to back and find them in the cache,
+and identical requests end up next to each other and are traced once.
+With cm_traceThreads above 1 the sorted set is split into runs for the
+job pool.  Every run stamps brushes and patches in its own traceChecks_t,
+everything else a trace reads is left untouched.
+
+===============================================================================
+*/
+
+#define	TRACEBATCH_MIN_RUN		16		// fewer traces than this aren't worth a thread
+
+typedef struct {
+	unsigned	key;
+	int			index;
+} traceOrder_t;
+
+typedef struct {
+	trace_t					*results;
+	const traceRequest_t	*reqs;
+	const traceOrder_t		*order;
+	int						count;
+	int						runLength;
+	clipHandle_t			model;
+	traceChecks_t			*checks;	// one per run, NULL when run inline
+} traceBatch_t;
+
+static traceChecks_t		cm_traceChecks[MAX_JOB_THREADS];
+static traceOrder_t			*cm_traceOrder;
+static int					cm_traceOrderSize;
+static const traceRequest_t	*cm_sortRequests;
+
+/*
+==================
+CM_FreeTraceChecks
+
+The stamp arrays are sized for the loaded map
+==================
+*/
+void CM_FreeTraceChecks( void ) {
+	int		i;
+
+	for ( i = 0 ; i < MAX_JOB_THREADS ; i++ ) {
+		if ( cm_traceChecks[i].brushes ) {
+			Z_Free( cm_traceChecks[i].brushes );
+		}
+	}
+	Com_Memset( cm_traceChecks, 0, sizeof( cm_traceChecks ) );
+}
+
+/*
+==================
+CM_AllocTraceChecks
+==================
+*/
+static void CM_AllocTraceChecks( int numRuns ) {
+	traceChecks_t	*checks;
+	int				i;
+
+	for ( i = 0 ; i < numRuns ; i++ ) {
+		checks = &cm_traceChecks[i];
+		if ( checks->brushes ) {
+			continue;
+		}
+		checks->checkcount = 0;
+		checks->brushes = Z_Malloc( ( cm.numBrushes + 1 + cm.numSurfaces ) * sizeof( int ) );
+		checks->surfaces = checks->brushes + cm.numBrushes + 1;
+	}
+}
+
+/*
+==================
+CM_SpreadBits
+
+Moves the low 10 bits of v three bits apart
+==================
+*/
+static unsigned CM_SpreadBits( unsigned v ) {
+	v &= 0x3ff;
+	v = ( v | ( v << 16 ) ) & 0x030000ff;
+	v = ( v | ( v << 8 ) ) & 0x0300f00f;
+	v = ( v | ( v << 4 ) ) & 0x030c30c3;
+	v = ( v | ( v << 2 ) ) & 0x09249249;
+	return v;
+}
+
+/*
+==================
+CM_CompareTraceOrder
+==================
+*/
+static int CM_CompareTraceOrder( const void *a, const void *b ) {
+	const traceOrder_t	*oa = a;
+	const traceOrder_t	*ob = b;
+	int					c;
+
+	if ( oa->key != ob->key ) {
+		return oa->key < ob->key ? -1 : 1;
+	}
+
+	// keep identical requests together
+	c = memcmp( &cm_sortRequests[oa->index], &cm_sortRequests[ob->index],
+		offsetof( traceRequest_t, passEntityNum ) );
+	if ( c ) {
+		return c;
+	}
+
+	return oa->index - ob->index;
+}
+
+/*
+==================
+CM_TraceBatchRun
+==================
+*/
+static void CM_TraceBatchRun( void *data, int run ) {
+	traceBatch_t			*batch = data;
+	traceChecks_t			*checks;
+	const traceRequest_t	*req, *prev;
+	trace_t					*prevResult;
+	int						i, first, last;
+
+	checks = batch->checks ? &batch->checks[run] : NULL;
+
+	first = run * batch->runLength;
+	last = first + batch->runLength;
+	if ( last > batch->count ) {
+		last = batch->count;
+	}
+
+	prev = NULL;
+	prevResult = NULL;
+	for ( i = first ; i < last ; i++ ) {
+		req = &batch->reqs[batch->order[i].index];
+
+		if ( prev && !memcmp( req, prev, offsetof( traceRequest_t, passEntityNum ) ) ) {
+			batch->results[batch->order[i].index] = *prevResult;
+			continue;
+		}
+
+		prev = req;
+		prevResult = &batch->results[batch->order[i].index];
+		CM_Trace( prevResult, req->start, req->end, (float *)req->mins, (float *)req->maxs,
+			batch->model, vec3_origin, req->contentmask, req->capsule, NULL, checks );
+	}
+}
+
+/*
+==================
+CM_TraceBatch
+==================
+*/
+static void CM_TraceBatch( trace_t *results, const traceRequest_t *reqs, int count,
+						   clipHandle_t model, int numThreads ) {
+	traceBatch_t	batch;
+	vec3_t			mins, maxs, scale;
+	int				i, j, numRuns;
+	float			f;
+
+	if ( count <= 0 ) {
+		return;
+	}
+
+	// a bad handle errors out here rather than on a worker
+	CM_ClipHandleToModel( model );
+
+	if ( count > cm_traceOrderSize ) {
+		if ( cm_traceOrder ) {
+			Z_Free( cm_traceOrder );
+		}
+		cm_traceOrderSize = count + 256;
+		cm_traceOrder = Z_Malloc( cm_traceOrderSize * sizeof( *cm_traceOrder ) );
+	}
+
+	// order the traces by where they start in the model
+	CM_ModelBounds( model, mins, maxs );
+	for ( j = 0 ; j < 3 ; j++ ) {
+		scale[j] = maxs[j] > mins[j] ? 1023.0f / ( maxs[j] - mins[j] ) : 0;
+	}
+
+	for ( i = 0 ; i < count ; i++ ) {
+		unsigned	key = 0;
+
+		for ( j = 0 ; j < 3 ; j++ ) {
+			f = ( reqs[i].start[j] - mins[j] ) * scale[j];
+			if ( f < 0 ) {
+				f = 0;
+			} else if ( f > 1023 ) {
+				f = 1023;
+			}
+			key |= CM_SpreadBits( (unsigned)f ) << j;
+		}
+		cm_traceOrder[i].key = key;
+		cm_traceOrder[i].index = i;
+	}
+
+	cm_sortRequests = reqs;
+	qsort( cm_traceOrder, count, sizeof( *cm_traceOrder ), CM_CompareTraceOrder );
+	cm_sortRequests = NULL;
+
+	// the capsule model builds a temp box while tracing, so it stays inline
+	numRuns = numThreads;
+	if ( numRuns > count / TRACEBATCH_MIN_RUN ) {
+		numRuns = count / TRACEBATCH_MIN_RUN;
+	}
+	if ( numRuns < 1 || model == CAPSULE_MODEL_HANDLE ) {
+		numRuns = 1;
+	}
+
+	batch.results = results;
+	batch.reqs = reqs;
+	batch.order = cm_traceOrder;
+	batch.count = count;
+	batch.runLength = ( count + numRuns - 1 ) / numRuns;
+	batch.model = model;
+	batch.checks = NULL;
+
+	if ( numRuns > 1 ) {
+		CM_AllocTraceChecks( numRuns );
+		batch.checks = cm_traceChecks;
+	}
+
+	Com_RunJobs( CM_TraceBatchRun, &batch, numRuns, numRuns );
+}
+
+/*
+==================
+CM_BoxTraceBatch
+==================
+*/
+void CM_BoxTraceBatch( trace_t *results, const traceRequest_t *reqs, int count, clipHandle_t model ) {
+	CM_TraceBatch( results, reqs, count, model, cm_traceThreads ? cm_traceThreads->integer : 0 );
+}
+
+/*
+===============================================================================
+
+TRACE BENCHMARK
+
+tracebench fires a reproducible set of random traces through the world
+model, first one CM_BoxTrace at a time with the scalar brush tests and with
+each vector kernel of cm_simd.c, and then as batches with a growing number
+of threads, and checks that every run gives the same results as the scalar
+one.  Without a running server it loads the map itself with CM_LoadMap.
+
+===============================================================================
+*/
+
+#define	TRACEBENCH_DEFAULT		20000
+#define	TRACEBENCH_MAX			262144
+
+/*
+==================
+CM_BenchPoint
+
+A random point in the world that isn't in solid
+==================
+*/
+static void CM_BenchPoint( vec3_t p, const vec3_t mins, const vec3_t maxs, int *seed ) {
+	int		i, tries;
+
+	for ( tries = 0 ; tries < 64 ; tries++ ) {
+		for ( i = 0 ; i < 3 ; i++ ) {
+			p[i] = mins[i] + Q_random( seed ) * ( maxs[i] - mins[i] );
+		}
+		if ( !( CM_PointContents( p, 0 ) & CONTENTS_SOLID ) ) {
+			return;
+		}
+	}
+}
+
+/*
+==================
+CM_BenchRequests
+
+A mix of shots, player moves, position tests and long box traces
+==================
+*/
+static void CM_BenchRequests( traceRequest_t *reqs, int count ) {
+	static const vec3_t	playerMins = { -15, -15, -24 };
+	static const vec3_t	playerMaxs = { 15, 15, 32 };
+	vec3_t			mins, maxs, dir;
+	traceRequest_t	*req;
+	float			length;
+	int				i, j, seed = 0x5eed;
+
+	CM_ModelBounds( 0, mins, maxs );
+
+	for ( i = 0 ; i < count ; i++ ) {
+		req = &reqs[i];
+		Com_Memset( req, 0, sizeof( *req ) );
+		req->passEntityNum = ENTITYNUM_NONE;
+
+		CM_BenchPoint( req->start, mins, maxs, &seed );
+		for ( j = 0 ; j < 3 ; j++ ) {
+			dir[j] = Q_crandom( &seed );
+		}
+		VectorNormalize( dir );
+
+		switch ( i % 6 ) {
+		case 0:
+		case 1:
+			length = 512 + Q_random( &seed ) * 4096;
+			req->contentmask = CONTENTS_SOLID | CONTENTS_BODY;
+			break;
+		case 2:
+		case 3:
+			length = Q_random( &seed ) * 64;
+			VectorCopy( playerMins, req->mins );
+			VectorCopy( playerMaxs, req->maxs );
+			req->contentmask = CONTENTS_SOLID | CONTENTS_PLAYERCLIP | CONTENTS_BODY;
+			req->capsule = ( i % 6 ) == 3;
+			break;
+		case 4:
+			length = 0;
+			VectorCopy( playerMins, req->mins );
+			VectorCopy( playerMaxs, req->maxs );
+			req->contentmask = CONTENTS_SOLID | CONTENTS_PLAYERCLIP | CONTENTS_BODY;
+			break;
+		default:
+			length = 256 + Q_random( &seed ) * 1024;
+			VectorSet( req->mins, -8, -8, -8 );
+			VectorSet( req->maxs, 8, 8, 8 );
+			req->contentmask = CONTENTS_SOLID;
+			break;
+		}
+
+		VectorMA( req->start, length, dir, req->end );
+	}
+}
+
+/*
+==================
+CM_BenchSerial
+
+Returns the time of the second of two passes, the first warms the caches
+==================
+*/
+static int64_t CM_BenchSerial( trace_t *results, traceRequest_t *reqs, int count ) {
+	int64_t	start, time;
+	int		i, pass;
+
+	time = 0;
+	for ( pass = 0 ; pass < 2 ; pass++ ) {
+		start = Sys_Microseconds();
+		for ( i = 0 ; i < count ; i++ ) {
+			CM_BoxTrace( &results[i], reqs[i].start, reqs[i].end, reqs[i].mins, reqs[i].maxs,
+				0, reqs[i].contentmask, reqs[i].capsule );
+		}
+		time = Sys_Microseconds() - start;
+	}
+
+	return time;
+}
+
+/*
+==================
+CM_BenchMismatches
+==================
+*/
+static int CM_BenchMismatches( const trace_t *a, const trace_t *b, int count ) {
+	int		i, mismatches;
+
+	mismatches = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( memcmp( &a[i], &b[i], sizeof( trace_t ) ) ) {
+			mismatches++;
+		}
+	}
+
+	return mismatches;
+}
+
+/*
+==================
+CM_TraceBench_f
+
+tracebench [map] [traces]
+==================
+*/
+void CM_TraceBench_f( void ) {
+	traceRequest_t	*reqs;
+	trace_t			*serial, *batched;
+	const brushTests_t	**kernels, *brushTests;
+	int64_t			start, serialTime, time;
+	int				count, threads, checksum, mismatches;
+	qboolean		loaded = qfalse;
+	const char		*mapname;
+
+	mapname = Cmd_Argv( 1 );
+	count = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : TRACEBENCH_DEFAULT;
+	if ( count < 1 || count > TRACEBENCH_MAX ) {
+		Com_Printf( "tracebench: traces must be between 1 and %i\n", TRACEBENCH_MAX );
+		return;
+	}
+
+	if ( com_sv_running->integer ) {
+		if ( mapname[0] ) {
+			Com_Printf( "tracebench: server is running, using the current map\n" );
+		}
+	} else if ( mapname[0] ) {
+		CM_LoadMap( va( "maps/%s.bsp", mapname ), qfalse, &checksum );
+		loaded = qtrue;
+	}
+
+	if ( !cm.numNodes ) {
+		Com_Printf( "usage: tracebench [map] [traces]\n" );
+		return;
+	}
+
+	reqs = Z_Malloc( count * sizeof( *reqs ) );
+	serial = Z_Malloc( count * sizeof( *serial ) );
+	batched = Z_Malloc( count * sizeof( *batched ) );
+
+	CM_BenchRequests( reqs, count );
+
+	brushTests = cm_brushTests;
+
+	cm_brushTests = NULL;
+	serialTime = CM_BenchSerial( serial, reqs, count );
+
+	Com_Printf( "%s: %i traces, %i brushes, %i nodes\n", cm.name, count, cm.numBrushes, cm.numNodes );
+	Com_Printf( "CM_BoxTrace          %8lld usec\n", (long long)serialTime );
+
+	// cm_simd 0 would make every kernel fall back to the scalar tests
+	for ( kernels = CM_BrushTestList() ; cm_simd->integer && *kernels ; kernels++ ) {
+		Com_Memset( batched, 0, count * sizeof( *batched ) );
+
+		cm_brushTests = *kernels;
+		time = CM_BenchSerial( batched, reqs, count );
+		mismatches = CM_BenchMismatches( serial, batched, count );
+
+		Com_Printf( "CM_BoxTrace, %-7s %8lld usec  %5.2fx", cm_brushTests->name,
+			(long long)time, time ? (double)serialTime / time : 0.0 );
+		if ( mismatches ) {
+			Com_Printf( S_COLOR_YELLOW "  %i results differ", mismatches );
+		}
+		Com_Printf( "\n" );
+	}
+
+	cm_brushTests = brushTests;
+
+	for ( threads = 1 ; threads <= MAX_JOB_THREADS ; threads *= 2 ) {
+		Com_Memset( batched, 0, count * sizeof( *batched ) );
+
+		start = Sys_Microseconds();
+		CM_TraceBatch( batched, reqs, count, 0, threads );
+		time = Sys_Microseconds() - start;
+
+		mismatches = CM_BenchMismatches( serial, batched, count );
+
+		Com_Printf( "batch, %2i thread%s  %8lld usec  %5.2fx", threads, threads == 1 ? " " : "s",
+			(long long)time, time ? (double)serialTime / time : 0.0 );
+		if ( mismatches ) {
+			Com_Printf( S_COLOR_YELLOW "  %i results differ", mismatches );
+		}
+		Com_Printf( "\n" );
+	}
+
+	Z_Free( batched );
+	Z_Free( serial );
+	Z_Free( reqs );
+
+	if ( loaded ) {
+		CM_ClearMap();
+	}
+}
+#endif
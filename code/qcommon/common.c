@@ -2722,10 +2722,14 @@ void Com_Init( char *commandLine ) {
 	}
 	Cmd_AddCommand ("quit", Com_Quit_f);
 	Cmd_AddCommand ("changeVectors", MSG_ReportChangeVectors_f );
+	Cmd_AddCommand ("huffbench", MSG_HuffBench_f );
+	Cmd_AddCommand ("tracebench", CM_TraceBench_f );
 	Cmd_AddCommand ("writeconfig", Com_WriteConfig_f );
 	Cmd_SetCommandCompletionFunc( "writeconfig", Cmd_CompleteCfgName );
 	Cmd_AddCommand("game_restart", Com_GameRestart_f);
 
+	Com_InitProfile();
+
 	Com_ExecuteCfg();
 
 	// override anything from the config files with command line args
@@ -3160,11 +3164,20 @@ void Com_Frame( void ) {
 		else
 			timeVal = Com_TimeVal(minMsec);
 		
+		// the last millisecond is waited out in short slices, which
+		// only Linux can sleep for, elsewhere they poll like before
 		if(com_busyWait->integer || timeVal < 1)
 			NET_Sleep(0);
+		else if(timeVal > 1)
+			NET_Sleep((timeVal - 1) * 1000);
 		else
-			NET_Sleep(timeVal - 1);
+			NET_Sleep(NET_SLEEP_SLICE);
 	} while(Com_TimeVal(minMsec));
+
+	Com_ProfileFrame();
+	PROFILE_BEGIN( PROFILE_COM_FRAME );
+
+	NET_BenchFrame();
 	
 	IN_Frame();
 
@@ -3191,7 +3204,9 @@ void Com_Frame( void ) {
 		timeBeforeServer = Sys_Milliseconds ();
 	}
 
+	PROFILE_BEGIN( PROFILE_SV_FRAME );
 	SV_Frame( msec );
+	PROFILE_END( PROFILE_SV_FRAME );
 
 	// if "dedicated" has been modified, start up
 	// or shut down the client system.
@@ -3229,7 +3244,9 @@ void Com_Frame( void ) {
 		timeBeforeClient = Sys_Milliseconds ();
 	}
 
+	PROFILE_BEGIN( PROFILE_CL_FRAME );
 	CL_Frame( msec );
+	PROFILE_END( PROFILE_CL_FRAME );
 
 	if ( com_speeds->integer ) {
 		timeAfter = Sys_Milliseconds ();
@@ -3245,6 +3262,8 @@ void Com_Frame( void ) {
 
 	NET_FlushPacketQueue();
 
+	PROFILE_END( PROFILE_COM_FRAME );
+
 	//
 	// report timing information
 	//
@@ -3289,6 +3308,8 @@ Com_Shutdown
 =================
 */
 void Com_Shutdown (void) {
+	Com_ShutdownJobs();
+
 	if (logfile) {
 		FS_FCloseFile (logfile);
 		logfile = 0;
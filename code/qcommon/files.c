@@ -1894,6 +1894,88 @@ void FS_FreeFile( void *buffer ) {
 	}
 }
 
+/*
+============
+FS_MapFile
+
+Maps a file read only when the first match in the search path is a
+plain file in a directory.  Returns NULL if it isn't, or the file is
+inside a pk3, in which case it has to be read as usual.
+============
+*/
+void *FS_MapFile( const char *qpath, long *length ) {
+	searchpath_t	*search;
+	void			*data;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	if ( !qpath || !qpath[0] ) {
+		Com_Error( ERR_FATAL, "FS_MapFile with empty name" );
+	}
+
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( FS_FOpenFileReadDir( qpath, search, NULL, qfalse, qfalse ) <= 0 ) {
+			continue;
+		}
+		if ( !search->dir ) {
+			return NULL;
+		}
+
+		data = Sys_MapFile( FS_BuildOSPath( search->dir->path, search->dir->gamedir, qpath ), length );
+		if ( data && fs_debug->integer ) {
+			Com_Printf( "FS_MapFile: %s (mapped from '%s%c%s')\n", qpath,
+				search->dir->path, PATH_SEP, search->dir->gamedir );
+		}
+		return data;
+	}
+
+	return NULL;
+}
+
+/*
+============
+FS_UnmapFile
+============
+*/
+void FS_UnmapFile( void *data, long length ) {
+	Sys_UnmapFile( data, length );
+}
+
+/*
+===========
+FS_HomeRename
+
+Replaces to with from in the home directory of the current game.
+Processes that still have the old file open or mapped keep seeing it.
+If to can't be replaced it is left alone and from is removed.
+===========
+*/
+qboolean FS_HomeRename( const char *from, const char *to ) {
+	char	*from_ospath, *to_ospath;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	FS_CheckFilenameIsMutable( to, __func__ );
+
+	from_ospath = FS_BuildOSPath( fs_homepath->string, fs_gamedir, from );
+	to_ospath = FS_BuildOSPath( fs_homepath->string, fs_gamedir, to );
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "FS_HomeRename: %s --> %s\n", from_ospath, to_ospath );
+	}
+
+	if ( !Sys_Rename( from_ospath, to_ospath ) ) {
+		Com_Printf( "FS_HomeRename: couldn't replace %s\n", to_ospath );
+		remove( from_ospath );
+		return qfalse;
+	}
+	return qtrue;
+}
+
 /*
 ============
 FS_WriteFile
@@ -27,16 +27,18 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "q_shared.h"
 #include "qcommon.h"
 
+// bit cursor for Huff_Compress / Huff_Decompress, the offset functions
+// used by msg_t bitstreams keep their cursor in the message instead so
+// several messages can be written at once from different threads
 static int			bloc = 0;
 
 void	Huff_putBit( int bit, byte *fout, int *offset) {
-	bloc = *offset;
-	if ((bloc&7) == 0) {
-		fout[(bloc>>3)] = 0;
+	int pos = *offset;
+	if ((pos&7) == 0) {
+		fout[(pos>>3)] = 0;
 	}
-	fout[(bloc>>3)] |= bit << (bloc&7);
-	bloc++;
-	*offset = bloc;
+	fout[(pos>>3)] |= bit << (pos&7);
+	*offset = pos + 1;
 }
 
 int		Huff_getBloc(void)
@@ -51,27 +53,26 @@ void	Huff_setBloc(int _bloc)
 
 int		Huff_getBit( byte *fin, int *offset) {
 	int t;
-	bloc = *offset;
-	t = (fin[(bloc>>3)] >> (bloc&7)) & 0x1;
-	bloc++;
-	*offset = bloc;
+	int pos = *offset;
+	t = (fin[(pos>>3)] >> (pos&7)) & 0x1;
+	*offset = pos + 1;
 	return t;
 }
 
 /* Add a bit to the output file (buffered) */
-static void add_bit (char bit, byte *fout) {
-	if ((bloc&7) == 0) {
-		fout[(bloc>>3)] = 0;
+static void add_bit (char bit, byte *fout, int *pos) {
+	if ((*pos&7) == 0) {
+		fout[(*pos>>3)] = 0;
 	}
-	fout[(bloc>>3)] |= bit << (bloc&7);
-	bloc++;
+	fout[(*pos>>3)] |= bit << (*pos&7);
+	(*pos)++;
 }
 
 /* Receive one bit from the input file (buffered) */
-static int get_bit (byte *fin) {
+static int get_bit (byte *fin, int *pos) {
 	int t;
-	t = (fin[(bloc>>3)] >> (bloc&7)) & 0x1;
-	bloc++;
+	t = (fin[(*pos>>3)] >> (*pos&7)) & 0x1;
+	(*pos)++;
 	return t;
 }
 
@@ -265,7 +266,7 @@ void Huff_addRef(huff_t* huff, byte ch) {
 /* Get a symbol */
 int Huff_Receive (node_t *node, int *ch, byte *fin) {
 	while (node && node->symbol == INTERNAL_NODE) {
-		if (get_bit(fin)) {
+		if (get_bit(fin, &bloc)) {
 			node = node->right;
 		} else {
 			node = node->left;
@@ -280,14 +281,14 @@ int Huff_Receive (node_t *node, int *ch, byte *fin) {
 
 /* Get a symbol */
 void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxoffset) {
-	bloc = *offset;
+	int pos = *offset;
 	while (node && node->symbol == INTERNAL_NODE) {
-		if (bloc >= maxoffset) {
+		if (pos >= maxoffset) {
 			*ch = 0;
 			*offset = maxoffset + 1;
 			return;
 		}
-		if (get_bit(fin)) {
+		if (get_bit(fin, &pos)) {
 			node = node->right;
 		} else {
 			node = node->left;
@@ -299,23 +300,23 @@ void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxo
 //		Com_Error(ERR_DROP, "Illegal tree!");
 	}
 	*ch = node->symbol;
-	*offset = bloc;
+	*offset = pos;
 }
 
 /* Send the prefix code for this node */
-static void send(node_t *node, node_t *child, byte *fout, int maxoffset) {
+static void send(node_t *node, node_t *child, byte *fout, int *pos, int maxoffset) {
 	if (node->parent) {
-		send(node->parent, node, fout, maxoffset);
+		send(node->parent, node, fout, pos, maxoffset);
 	}
 	if (child) {
-		if (bloc >= maxoffset) {
-			bloc = maxoffset + 1;
+		if (*pos >= maxoffset) {
+			*pos = maxoffset + 1;
 			return;
 		}
 		if (node->right == child) {
-			add_bit(1, fout);
+			add_bit(1, fout, pos);
 		} else {
-			add_bit(0, fout);
+			add_bit(0, fout, pos);
 		}
 	}
 }
@@ -327,17 +328,161 @@ void Huff_transmit (huff_t *huff, int ch, byte *fout, int maxoffset) {
 		/* node_t hasn't been transmitted, send a NYT, then the symbol */
 		Huff_transmit(huff, NYT, fout, maxoffset);
 		for (i = 7; i >= 0; i--) {
-			add_bit((char)((ch >> i) & 0x1), fout);
+			add_bit((char)((ch >> i) & 0x1), fout, &bloc);
 		}
 	} else {
-		send(huff->loc[ch], NULL, fout, maxoffset);
+		send(huff->loc[ch], NULL, fout, &bloc, maxoffset);
 	}
 }
 
 void Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset, int maxoffset) {
-	bloc = *offset;
-	send(huff->loc[ch], NULL, fout, maxoffset);
-	*offset = bloc;
+	send(huff->loc[ch], NULL, fout, offset, maxoffset);
+}
+
+/*
+=============================================================================
+
+Static tree lookup tables
+
+The msg_t trees are trained once by MSG_initHuffman and never updated
+afterwards, so their codes can be looked up instead of walking the tree
+a bit at a time.  Whatever the tables can't answer, such as a code that
+would run past maxoffset, goes through the tree walk, so the bits read
+and written are always the same.
+
+=============================================================================
+*/
+
+/*
+============
+Huff_BuildTable
+
+The trees must not be changed with Huff_addRef after this
+============
+*/
+void Huff_BuildTable( huffTable_t *table, huff_t *compressor, huff_t *decompressor ) {
+	node_t			*node;
+	unsigned int	code;
+	int				i, length;
+
+	Com_Memset( table, 0, sizeof( *table ) );
+	table->compressor = compressor;
+	table->decompressor = decompressor;
+
+	// codes are sent from the root down, so walking up from the
+	// leaf the first bit sent ends up lowest
+	for ( i = 0 ; i < HMAX+1 ; i++ ) {
+		code = 0;
+		length = 0;
+		for ( node = compressor->loc[i] ; node && node->parent ; node = node->parent ) {
+			code = ( code << 1 ) | ( node->parent->right == node );
+			length++;
+		}
+		if ( length <= 32 ) {
+			table->code[i] = code;
+			table->codeLength[i] = length;
+		}
+	}
+
+	for ( i = 0 ; i < HUFF_LOOKUP_SIZE ; i++ ) {
+		huffLookup_t *entry = &table->lookup[i];
+
+		node = decompressor->tree;
+		for ( length = 0 ; node && node->symbol == INTERNAL_NODE && length < HUFF_LOOKUP_BITS ; length++ ) {
+			node = ( ( i >> length ) & 1 ) ? node->right : node->left;
+		}
+
+		if ( !node || !length ) {
+			// broken or empty tree, always walk it from the root
+			entry->value = -1;
+			entry->length = 0;
+		} else if ( node->symbol == INTERNAL_NODE ) {
+			entry->value = node - decompressor->nodeList;
+			entry->length = 0;
+		} else {
+			entry->value = node->symbol;
+			entry->length = length;
+		}
+	}
+}
+
+/*
+============
+Huff_tableReceive
+
+Huff_offsetReceive from the root of table->decompressor
+============
+*/
+void Huff_tableReceive( const huffTable_t *table, int *ch, byte *fin, int *offset, int maxoffset ) {
+	const huffLookup_t	*entry;
+	const byte			*in;
+	unsigned int		bits;
+	int					pos = *offset;
+	int					shift = pos & 7;
+
+	// only peek at bits that are known to be there
+	if ( pos + HUFF_LOOKUP_BITS > maxoffset ) {
+		Huff_offsetReceive( table->decompressor->tree, ch, fin, offset, maxoffset );
+		return;
+	}
+
+	in = fin + ( pos >> 3 );
+	bits = in[0] | ( in[1] << 8 );
+	if ( shift + HUFF_LOOKUP_BITS > 16 ) {
+		bits |= in[2] << 16;
+	}
+
+	entry = &table->lookup[( bits >> shift ) & ( HUFF_LOOKUP_SIZE - 1 )];
+
+	if ( entry->length ) {
+		*ch = entry->value;
+		*offset = pos + entry->length;
+	} else if ( entry->value >= 0 ) {
+		// a long code, carry on from the node the lookup got to
+		*offset = pos + HUFF_LOOKUP_BITS;
+		Huff_offsetReceive( &table->decompressor->nodeList[entry->value], ch, fin, offset, maxoffset );
+	} else {
+		Huff_offsetReceive( table->decompressor->tree, ch, fin, offset, maxoffset );
+	}
+}
+
+/*
+============
+Huff_tableTransmit
+
+Huff_offsetTransmit with table->compressor
+============
+*/
+void Huff_tableTransmit( const huffTable_t *table, int ch, byte *fout, int *offset, int maxoffset ) {
+	unsigned int	code;
+	int				length, pos, n;
+
+	length = table->codeLength[ch];
+	pos = *offset;
+
+	// the tree walk decides where a code that doesn't fit gets cut off
+	if ( !length || pos + length > maxoffset ) {
+		Huff_offsetTransmit( table->compressor, ch, fout, offset, maxoffset );
+		return;
+	}
+
+	code = table->code[ch];
+	while ( length ) {
+		n = 8 - ( pos & 7 );
+		if ( n > length ) {
+			n = length;
+		}
+		if ( !( pos & 7 ) ) {
+			fout[pos >> 3] = 0;
+		}
+		fout[pos >> 3] |= ( code & ( ( 1 << n ) - 1 ) ) << ( pos & 7 );
+
+		code >>= n;
+		pos += n;
+		length -= n;
+	}
+
+	*offset = pos;
 }
 
 void Huff_Decompress(msg_t *mbuf, int offset) {
@@ -380,7 +525,7 @@ void Huff_Decompress(msg_t *mbuf, int offset) {
 		if ( ch == NYT ) {								/* We got a NYT, get the symbol associated with it */
 			ch = 0;
 			for ( i = 0; i < 8; i++ ) {
-				ch = (ch<<1) + get_bit(buffer);
+				ch = (ch<<1) + get_bit(buffer, &bloc);
 			}
 		}
     
@@ -392,8 +537,6 @@ void Huff_Decompress(msg_t *mbuf, int offset) {
 	Com_Memcpy(mbuf->data + offset, seq, cch);
 }
 
-extern 	int oldsize;
-
 void Huff_Compress(msg_t *mbuf, int offset) {
 	int			i, ch, size;
 	byte		seq[65536];
@@ -0,0 +1,244 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// jobs.c -- worker thread pool for splitting independent work items
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+typedef struct {
+	jobFunc_t	func;
+	void		*data;
+	int			count;
+	int			next;			// next index to hand out
+	int			pending;		// indices handed out but not yet finished
+	int			maxWorkers;		// workers allowed to join this batch
+	int			numWorkers;		// workers that have joined
+} jobBatch_t;
+
+typedef struct {
+	qboolean	initialized;
+	qboolean	failed;			// no thread support, always run inline
+	qboolean	shutdown;
+
+	sysMutex_t	*lock;
+	sysCond_t	*wake;			// signalled when a batch is posted
+	sysCond_t	*done;			// signalled when the last index finishes
+
+	sysThread_t	*threads[MAX_JOB_THREADS];
+	int			numThreads;
+
+	jobBatch_t	*batch;			// NULL when idle
+	int			batchNum;		// bumped for every posted batch
+} jobPool_t;
+
+static jobPool_t	jobs;
+
+/*
+=================
+Com_RunBatch
+
+Pulls indices from the batch until there are none left.
+Called with jobs.lock held, returns with it held.
+=================
+*/
+static void Com_RunBatch( jobBatch_t *batch ) {
+	int		index;
+
+	while ( batch->next < batch->count ) {
+		index = batch->next++;
+
+		Sys_UnlockMutex( jobs.lock );
+		batch->func( batch->data, index );
+		Sys_LockMutex( jobs.lock );
+
+		if ( --batch->pending == 0 ) {
+			Sys_SignalCond( jobs.done );
+		}
+	}
+}
+
+/*
+=================
+Com_JobThread
+=================
+*/
+static void Com_JobThread( void *arg ) {
+	int		lastBatch = 0;
+
+	Com_ProfileThreadName( "job worker" );
+
+	Sys_LockMutex( jobs.lock );
+
+	while ( !jobs.shutdown ) {
+		jobBatch_t *batch = jobs.batch;
+
+		if ( !batch || jobs.batchNum == lastBatch || batch->numWorkers >= batch->maxWorkers ) {
+			Sys_WaitCond( jobs.wake, jobs.lock );
+			continue;
+		}
+
+		lastBatch = jobs.batchNum;
+		batch->numWorkers++;
+		Com_RunBatch( batch );
+	}
+
+	Sys_UnlockMutex( jobs.lock );
+}
+
+/*
+=================
+Com_InitJobs
+=================
+*/
+static qboolean Com_InitJobs( void ) {
+	if ( jobs.initialized ) {
+		return !jobs.failed;
+	}
+	jobs.initialized = qtrue;
+
+	jobs.lock = Sys_CreateMutex();
+	jobs.wake = Sys_CreateCond();
+	jobs.done = Sys_CreateCond();
+
+	if ( !jobs.lock || !jobs.wake || !jobs.done ) {
+		Com_Printf( "WARNING: job pool unavailable, running jobs inline\n" );
+		jobs.failed = qtrue;
+	}
+
+	return !jobs.failed;
+}
+
+/*
+=================
+Com_StartJobThreads
+
+Grows the pool to numThreads workers, returns how many are running
+=================
+*/
+static int Com_StartJobThreads( int numThreads ) {
+	if ( numThreads > MAX_JOB_THREADS ) {
+		numThreads = MAX_JOB_THREADS;
+	}
+
+	while ( jobs.numThreads < numThreads ) {
+		sysThread_t *thread = Sys_CreateThread( Com_JobThread, NULL );
+
+		if ( !thread ) {
+			break;
+		}
+		jobs.threads[jobs.numThreads++] = thread;
+	}
+
+	return jobs.numThreads;
+}
+
+/*
+=================
+Com_RunJobs
+=================
+*/
+void Com_RunJobs( jobFunc_t func, void *data, int count, int numThreads ) {
+	jobBatch_t	batch;
+	int			i, workers;
+
+	if ( count <= 0 ) {
+		return;
+	}
+
+	workers = numThreads - 1;
+	if ( workers > count - 1 ) {
+		workers = count - 1;
+	}
+
+	if ( workers <= 0 || !Com_InitJobs() ) {
+		for ( i = 0 ; i < count ; i++ ) {
+			func( data, i );
+		}
+		return;
+	}
+
+	Sys_LockMutex( jobs.lock );
+
+	// a job may itself call Com_RunJobs, there is only one batch at a time
+	if ( jobs.batch ) {
+		Sys_UnlockMutex( jobs.lock );
+		for ( i = 0 ; i < count ; i++ ) {
+			func( data, i );
+		}
+		return;
+	}
+
+	// the pool may already hold more threads than this batch asked for
+	if ( Com_StartJobThreads( workers ) < workers ) {
+		workers = jobs.numThreads;
+	}
+
+	batch.func = func;
+	batch.data = data;
+	batch.count = count;
+	batch.next = 0;
+	batch.pending = count;
+	batch.maxWorkers = workers;
+	batch.numWorkers = 0;
+
+	jobs.batch = &batch;
+	jobs.batchNum++;
+	Sys_BroadcastCond( jobs.wake );
+
+	Com_RunBatch( &batch );
+
+	while ( batch.pending ) {
+		Sys_WaitCond( jobs.done, jobs.lock );
+	}
+
+	jobs.batch = NULL;
+
+	Sys_UnlockMutex( jobs.lock );
+}
+
+/*
+=================
+Com_ShutdownJobs
+=================
+*/
+void Com_ShutdownJobs( void ) {
+	int		i;
+
+	if ( !jobs.initialized || jobs.failed ) {
+		return;
+	}
+
+	Sys_LockMutex( jobs.lock );
+	jobs.shutdown = qtrue;
+	Sys_BroadcastCond( jobs.wake );
+	Sys_UnlockMutex( jobs.lock );
+
+	for ( i = 0 ; i < jobs.numThreads ; i++ ) {
+		Sys_JoinThread( jobs.threads[i] );
+	}
+
+	Sys_DestroyCond( jobs.done );
+	Sys_DestroyCond( jobs.wake );
+	Sys_DestroyMutex( jobs.lock );
+
+	Com_Memset( &jobs, 0, sizeof( jobs ) );
+}
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "qcommon.h"
 
 static huffman_t		msgHuff;
+static huffTable_t		msgHuffTable;
 
 static qboolean			msgInit = qfalse;
 
@@ -37,8 +38,6 @@ Handles byte ordering and avoids alignment errors
 ==============================================================================
 */
 
-int oldsize = 0;
-
 void MSG_initHuffman( void );
 
 void MSG_Init( msg_t *buf, byte *data, int length ) {
@@ -105,8 +104,6 @@ bit functions
 void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 	int	i;
 
-	oldsize += bits;
-
 	if ( msg->overflowed ) {
 		return;
 	}
@@ -159,7 +156,7 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 		}
 		if ( bits ) {
 			for( i = 0; i < bits; i += 8 ) {
-				Huff_offsetTransmit( &msgHuff.compressor, (value & 0xff), msg->data, &msg->bit, msg->maxsize << 3 );
+				Huff_tableTransmit( &msgHuffTable, (value & 0xff), msg->data, &msg->bit, msg->maxsize << 3 );
 				value = (value >> 8);
 
 				if ( msg->bit > msg->maxsize << 3 ) {
@@ -172,6 +169,53 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 	}
 }
 
+/*
+============
+MSG_WriteBitstream
+
+Appends numBits of an already encoded bitstream that was written from
+bit 0 of another message.  Huffman codes don't depend on where in the
+stream they start, so this is the same as repeating the original writes.
+============
+*/
+void MSG_WriteBitstream( msg_t *msg, const byte *data, int numBits ) {
+	byte	*out, *last;
+	int		i, shift, bytes;
+
+	if ( msg->overflowed || numBits <= 0 ) {
+		return;
+	}
+
+	if ( msg->oob ) {
+		Com_Error( ERR_DROP, "MSG_WriteBitstream: oob message" );
+	}
+
+	if ( msg->bit + numBits > msg->maxsize << 3 ) {
+		msg->overflowed = qtrue;
+		return;
+	}
+
+	out = msg->data + ( msg->bit >> 3 );
+	last = msg->data + ( ( msg->bit + numBits - 1 ) >> 3 );
+	shift = msg->bit & 7;
+	bytes = ( numBits + 7 ) >> 3;
+
+	if ( !shift ) {
+		Com_Memcpy( out, data, bytes );
+	} else {
+		// bits above the cursor in the current byte are always clear
+		for ( i = 0 ; i < bytes ; i++ ) {
+			out[i] |= data[i] << shift;
+			if ( out + i + 1 <= last ) {
+				out[i + 1] = data[i] >> ( 8 - shift );
+			}
+		}
+	}
+
+	msg->bit += numBits;
+	msg->cursize = (msg->bit >> 3) + 1;
+}
+
 int MSG_ReadBits( msg_t *msg, int bits ) {
 	int			value;
 	int			get;
@@ -237,7 +281,7 @@ int MSG_ReadBits( msg_t *msg, int bits ) {
 		if (bits) {
 //			fp = fopen("c:\\netchan.bin", "a");
 			for(i=0;i<bits;i+=8) {
-				Huff_offsetReceive (msgHuff.decompressor.tree, &get, msg->data, &msg->bit, msg->cursize<<3);
+				Huff_tableReceive (&msgHuffTable, &get, msg->data, &msg->bit, msg->cursize<<3);
 //				fwrite(&get, 1, 1, fp);
 				value = (unsigned int)value | ((unsigned int)get<<(i+nbits));
 
@@ -401,11 +445,9 @@ int MSG_ReadByte( msg_t *msg ) {
 }
 
 int MSG_LookaheadByte( msg_t *msg ) {
-	const int bloc = Huff_getBloc();
 	const int readcount = msg->readcount;
 	const int bit = msg->bit;
 	int c = MSG_ReadByte(msg);
-	Huff_setBloc(bloc);
 	msg->readcount = readcount;
 	msg->bit = bit;
 	return c;
@@ -653,7 +695,6 @@ void MSG_WriteDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *
 		from->buttons == to->buttons &&
 		from->weapon == to->weapon) {
 			MSG_WriteBits( msg, 0, 1 );				// no change
-			oldsize += 7;
 			return;
 	}
 	key ^= to->serverTime;
@@ -872,8 +913,6 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 
 	MSG_WriteByte( msg, lc );	// # of changes
 
-	oldsize += numFields;
-
 	for ( i = 0, field = entityStateFields ; i < lc ; i++, field++ ) {
 		fromF = (int *)( (byte *)from + field->offset );
 		toF = (int *)( (byte *)to + field->offset );
@@ -892,7 +931,6 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 
 			if (fullFloat == 0.0f) {
 					MSG_WriteBits( msg, 0, 1 );
-					oldsize += FLOAT_INT_BITS;
 			} else {
 				MSG_WriteBits( msg, 1, 1 );
 				if ( trunc == fullFloat && trunc + FLOAT_INT_BIAS >= 0 && 
@@ -1147,8 +1185,6 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 
 	MSG_WriteByte( msg, lc );	// # of changes
 
-	oldsize += numFields - lc;
-
 	for ( i = 0, field = playerStateFields ; i < lc ; i++, field++ ) {
 		fromF = (int *)( (byte *)from + field->offset );
 		toF = (int *)( (byte *)to + field->offset );
@@ -1213,7 +1249,6 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 
 	if (!statsbits && !persistantbits && !ammobits && !powerupbits) {
 		MSG_WriteBits( msg, 0, 1 );	// no change
-		oldsize += 4;
 		return;
 	}
 	MSG_WriteBits( msg, 1, 1 );	// changed
@@ -1677,6 +1712,308 @@ void MSG_initHuffman( void ) {
 			Huff_addRef(&msgHuff.decompressor,	(byte)i);			// Do update
 		}
 	}
+	Huff_BuildTable(&msgHuffTable, &msgHuff.compressor, &msgHuff.decompressor);
+}
+
+/*
+=============================================================================
+
+huffbench
+
+Checks the lookup tables against the tree walk and times both, over the
+messages of a recorded demo or, without one, over messages encoded from
+symbols drawn with the msg_hData frequencies.
+
+Any bit string parses into symbols of the static tree, so each message
+is decoded with both readers and the symbols are encoded again with both
+writers.  The two have to agree everywhere and the encoded symbols have
+to give back the bits they were read from.
+
+=============================================================================
+*/
+
+#define	HUFFBENCH_SYNTHETIC		0x100000	// bytes of made up messages
+#define	HUFFBENCH_MSGLEN		1400
+#define	HUFFBENCH_MIN_BYTES		0x2000000	// run passes until this much was timed
+#define	HUFFBENCH_OUTLEN		(MAX_MSGLEN * 3)
+
+typedef struct {
+	byte	*data;			// each message is an int length followed by its bytes
+	int		size;
+	int		maxSize;
+	int		numMessages;
+	int		numBytes;
+
+	int		*symbols;
+	byte	*out[2];
+} huffBench_t;
+
+/*
+=================
+MSG_HuffBenchAdd
+=================
+*/
+static void MSG_HuffBenchAdd( huffBench_t *bench, const byte *msg, int len ) {
+	Com_Memcpy( bench->data + bench->size, &len, 4 );
+	Com_Memcpy( bench->data + bench->size + 4, msg, len );
+	bench->size += 4 + len;
+	bench->numMessages++;
+	bench->numBytes += len;
+}
+
+/*
+=================
+MSG_HuffBenchLoadDemo
+=================
+*/
+static qboolean MSG_HuffBenchLoadDemo( huffBench_t *bench, const char *name ) {
+	fileHandle_t	f;
+	byte			msg[MAX_MSGLEN];
+	int				seq, len;
+
+	bench->maxSize = FS_FOpenFileRead( name, &f, qtrue );
+	if ( !f ) {
+		Com_Printf( "huffbench: couldn't open %s\n", name );
+		return qfalse;
+	}
+
+	bench->data = Z_Malloc( bench->maxSize );
+
+	// the demo stores each message after its sequence and length
+	while ( FS_Read( &seq, 4, f ) == 4 && FS_Read( &len, 4, f ) == 4 ) {
+		len = LittleLong( len );
+		if ( len <= 0 || len > MAX_MSGLEN || bench->size + 4 + len > bench->maxSize ) {
+			break;
+		}
+		if ( FS_Read( msg, len, f ) != len ) {
+			break;
+		}
+		MSG_HuffBenchAdd( bench, msg, len );
+	}
+
+	FS_FCloseFile( f );
+	return qtrue;
+}
+
+/*
+=================
+MSG_HuffBenchSynthesize
+=================
+*/
+static void MSG_HuffBenchSynthesize( huffBench_t *bench ) {
+	byte	msg[HUFFBENCH_MSGLEN];
+	int		total, i, r, pos;
+
+	bench->maxSize = HUFFBENCH_SYNTHETIC;
+	bench->data = Z_Malloc( bench->maxSize );
+
+	for ( total = 0, i = 0 ; i < 256 ; i++ ) {
+		total += msg_hData[i];
+	}
+
+	while ( bench->size + 4 + HUFFBENCH_MSGLEN <= bench->maxSize ) {
+		for ( pos = 0 ; pos + 32 < HUFFBENCH_MSGLEN << 3 ; ) {
+			r = ( ( rand() << 15 ) ^ rand() ) % total;
+			for ( i = 0 ; r >= msg_hData[i] ; i++ ) {
+				r -= msg_hData[i];
+			}
+			Huff_offsetTransmit( &msgHuff.compressor, i, msg, &pos, HUFFBENCH_MSGLEN << 3 );
+		}
+		MSG_HuffBenchAdd( bench, msg, ( pos + 7 ) >> 3 );
+	}
+}
+
+/*
+=================
+MSG_HuffBenchEncode
+
+Encodes count symbols from bit start with either writer,
+returns the bit offset it ended at
+=================
+*/
+static int MSG_HuffBenchEncode( huffBench_t *bench, int writer, int start, int count, int maxoffset ) {
+	int		i, pos = start;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( writer ) {
+			Huff_tableTransmit( &msgHuffTable, bench->symbols[i], bench->out[writer], &pos, maxoffset );
+		} else {
+			Huff_offsetTransmit( &msgHuff.compressor, bench->symbols[i], bench->out[writer], &pos, maxoffset );
+		}
+	}
+
+	return pos;
+}
+
+/*
+=================
+MSG_HuffBenchCheck
+=================
+*/
+static qboolean MSG_HuffBenchCheck( huffBench_t *bench, byte *msg, int len ) {
+	int		maxoffset = len << 3;
+	int		pos[2] = { 0, 0 };
+	int		ch[2];
+	int		num, end, start, cut, i;
+
+	// decode
+	for ( num = 0, end = 0 ; pos[0] < maxoffset ; num++, end = pos[0] ) {
+		Huff_offsetReceive( msgHuff.decompressor.tree, &ch[0], msg, &pos[0], maxoffset );
+		Huff_tableReceive( &msgHuffTable, &ch[1], msg, &pos[1], maxoffset );
+
+		if ( ch[0] != ch[1] || pos[0] != pos[1] ) {
+			return qfalse;
+		}
+		if ( pos[0] > maxoffset ) {
+			break;		// the last code was cut off
+		}
+		bench->symbols[num] = ch[0];
+	}
+
+	// encode again, not byte aligned so the table writer has to shift
+	start = len & 7;
+	for ( i = 0 ; i < 2 ; i++ ) {
+		bench->out[i][0] = 0;
+		pos[i] = MSG_HuffBenchEncode( bench, i, start, num, HUFFBENCH_OUTLEN << 3 );
+	}
+	if ( pos[0] != pos[1] || pos[0] != start + end ) {
+		return qfalse;
+	}
+	for ( i = 0 ; i < end ; i++ ) {
+		int p = start + i;
+		int a = ( bench->out[1][p >> 3] >> ( p & 7 ) ) & 1;
+
+		if ( a != ( ( bench->out[0][p >> 3] >> ( p & 7 ) ) & 1 ) || a != ( ( msg[i >> 3] >> ( i & 7 ) ) & 1 ) ) {
+			return qfalse;
+		}
+	}
+
+	// and once more with too little room, both have to stop at the same bit
+	cut = start + end / 2;
+	for ( i = 0 ; i < 2 ; i++ ) {
+		Com_Memset( bench->out[i], 0, ( cut >> 3 ) + 1 );
+		pos[i] = MSG_HuffBenchEncode( bench, i, start, num, cut );
+	}
+	if ( pos[0] != pos[1] || memcmp( bench->out[0], bench->out[1], ( cut + 7 ) >> 3 ) ) {
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+/*
+=================
+MSG_HuffBenchTime
+
+Returns usec for passes over every message, decoding the bits or
+encoding the bytes as symbols
+=================
+*/
+static int64_t MSG_HuffBenchTime( huffBench_t *bench, int passes, qboolean table, qboolean encode ) {
+	int64_t	start;
+	int		pass, offset, len, pos, ch, i;
+	byte	*msg;
+
+	start = Sys_Microseconds();
+
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		for ( offset = 0 ; offset < bench->size ; offset += 4 + len ) {
+			Com_Memcpy( &len, bench->data + offset, 4 );
+			msg = bench->data + offset + 4;
+			pos = 0;
+
+			if ( encode ) {
+				for ( i = 0 ; i < len ; i++ ) {
+					if ( table ) {
+						Huff_tableTransmit( &msgHuffTable, msg[i], bench->out[0], &pos, HUFFBENCH_OUTLEN << 3 );
+					} else {
+						Huff_offsetTransmit( &msgHuff.compressor, msg[i], bench->out[0], &pos, HUFFBENCH_OUTLEN << 3 );
+					}
+				}
+			} else {
+				while ( pos < len << 3 ) {
+					if ( table ) {
+						Huff_tableReceive( &msgHuffTable, &ch, msg, &pos, len << 3 );
+					} else {
+						Huff_offsetReceive( msgHuff.decompressor.tree, &ch, msg, &pos, len << 3 );
+					}
+				}
+			}
+		}
+	}
+
+	return Sys_Microseconds() - start;
+}
+
+/*
+=================
+MSG_HuffBench_f
+=================
+*/
+void MSG_HuffBench_f( void ) {
+	huffBench_t	bench;
+	int			offset, len, passes, failed;
+	int64_t		usec[2][2];
+	int			i, j;
+
+	if ( !msgInit ) {
+		MSG_initHuffman();
+	}
+
+	Com_Memset( &bench, 0, sizeof( bench ) );
+
+	if ( Cmd_Argc() > 1 ) {
+		if ( !MSG_HuffBenchLoadDemo( &bench, Cmd_Argv( 1 ) ) ) {
+			return;
+		}
+	} else {
+		MSG_HuffBenchSynthesize( &bench );
+	}
+
+	if ( !bench.numBytes ) {
+		Com_Printf( "huffbench: no messages\n" );
+		Z_Free( bench.data );
+		return;
+	}
+
+	bench.symbols = Z_Malloc( MAX_MSGLEN * 8 * sizeof( int ) );
+	bench.out[0] = Z_Malloc( HUFFBENCH_OUTLEN );
+	bench.out[1] = Z_Malloc( HUFFBENCH_OUTLEN );
+
+	failed = 0;
+	for ( offset = 0 ; offset < bench.size ; offset += 4 + len ) {
+		Com_Memcpy( &len, bench.data + offset, 4 );
+		if ( !MSG_HuffBenchCheck( &bench, bench.data + offset + 4, len ) ) {
+			failed++;
+		}
+	}
+
+	passes = HUFFBENCH_MIN_BYTES / bench.numBytes + 1;
+	for ( i = 0 ; i < 2 ; i++ ) {
+		for ( j = 0 ; j < 2 ; j++ ) {
+			usec[i][j] = MSG_HuffBenchTime( &bench, passes, i, j );
+			if ( usec[i][j] < 1 ) {
+				usec[i][j] = 1;
+			}
+		}
+	}
+
+	Com_Printf( "huffbench: %i messages, %i bytes, %i passes\n", bench.numMessages, bench.numBytes, passes );
+	if ( failed ) {
+		Com_Printf( "^1%i messages did NOT round trip identically\n", failed );
+	} else {
+		Com_Printf( "all messages round trip bit-exact\n" );
+	}
+	Com_Printf( "        decode MB/s  encode MB/s\n" );
+	for ( i = 0 ; i < 2 ; i++ ) {
+		Com_Printf( "%-6s %11.1f  %11.1f\n", i ? "table" : "tree",
+			(double)bench.numBytes * passes / usec[i][0], (double)bench.numBytes * passes / usec[i][1] );
+	}
+
+	Z_Free( bench.out[1] );
+	Z_Free( bench.out[0] );
+	Z_Free( bench.symbols );
+	Z_Free( bench.data );
 }
 
 /*
@@ -516,22 +516,38 @@ static void NET_QueuePacket( int length, const void *data, netadr_t to,
 	}
 }
 
+#define	MAX_FLUSH_PACKETS	64
+
 void NET_FlushPacketQueue(void)
 {
-	packetQueue_t *last;
-	int now;
-
-	while(packetQueue) {
+	packetQueue_t *flushed[MAX_FLUSH_PACKETS];
+	int lengths[MAX_FLUSH_PACKETS];
+	const void *data[MAX_FLUSH_PACKETS];
+	netadr_t to[MAX_FLUSH_PACKETS];
+	int i, count, now;
+
+	// hand everything that is due to the system in one go,
+	// Sys_SendPackets can batch the sends
+	do {
 		now = Sys_Milliseconds();
-		if(packetQueue->release >= now)
-			break;
-		Sys_SendPacket(packetQueue->length, packetQueue->data,
-			packetQueue->to);
-		last = packetQueue;
-		packetQueue = packetQueue->next;
-		Z_Free(last->data);
-		Z_Free(last);
-	}
+
+		for(count = 0; packetQueue && count < MAX_FLUSH_PACKETS; count++) {
+			if(packetQueue->release >= now)
+				break;
+			flushed[count] = packetQueue;
+			lengths[count] = packetQueue->length;
+			data[count] = packetQueue->data;
+			to[count] = packetQueue->to;
+			packetQueue = packetQueue->next;
+		}
+
+		Sys_SendPackets(count, lengths, data, to);
+
+		for(i = 0; i < count; i++) {
+			Z_Free(flushed[i]->data);
+			Z_Free(flushed[i]);
+		}
+	} while(count == MAX_FLUSH_PACKETS);
 }
 
 void NET_SendPacket( netsrc_t sock, int length, const void *data, netadr_t to ) {
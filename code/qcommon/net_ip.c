@@ -20,6 +20,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ===========================================================================
 */
 
+#ifdef __linux__
+#	define _GNU_SOURCE		// recvmmsg and sendmmsg
+#endif
+
 #include "../qcommon/q_shared.h"
 #include "../qcommon/qcommon.h"
 
@@ -88,6 +92,12 @@ static qboolean	winsockInitialized = qfalse;
 #		include <sys/filio.h>
 #	endif
 
+#	ifdef __linux__
+#		include <sys/epoll.h>
+#		include <sys/timerfd.h>
+#		define USE_EPOLL
+#	endif
+
 typedef int SOCKET;
 #	define INVALID_SOCKET		-1
 #	define SOCKET_ERROR			-1
@@ -152,6 +162,23 @@ typedef struct
 static nip_localaddr_t localIP[MAX_IPS];
 static int numIP;
 
+typedef struct {
+	int		packets;			// passed on to the client or server
+	int		receiveCalls;
+} netStats_t;
+
+static netStats_t	netStats;
+
+#ifdef USE_EPOLL
+// packets moved per recvmmsg / sendmmsg call
+#define	NET_MMSG_BATCH	16
+
+static int	epoll_fd = -1;
+static int	timer_fd = -1;
+
+static void NET_WatchMulticast6( qboolean watch );
+#endif
+
 
 //=============================================================================
 
@@ -520,6 +547,50 @@ qboolean	NET_IsLocalAddress( netadr_t adr ) {
 
 //=============================================================================
 
+/*
+==================
+NET_AcceptPacket
+
+Fills in where a packet that was just read from sock came from,
+returns qfalse if it has to be dropped
+==================
+*/
+static qboolean NET_AcceptPacket( SOCKET sock, struct sockaddr_storage *from, socklen_t fromlen, int ret, netadr_t *net_from, msg_t *net_message )
+{
+	if ( sock == ip_socket ) {
+		memset( ((struct sockaddr_in *)from)->sin_zero, 0, 8 );
+
+		if ( usingSocks && memcmp( from, &socksRelayAddr, fromlen ) == 0 ) {
+			if ( ret < 10 || net_message->data[0] != 0 || net_message->data[1] != 0 || net_message->data[2] != 0 || net_message->data[3] != 1 ) {
+				return qfalse;
+			}
+			net_from->type = NA_IP;
+			net_from->ip[0] = net_message->data[4];
+			net_from->ip[1] = net_message->data[5];
+			net_from->ip[2] = net_message->data[6];
+			net_from->ip[3] = net_message->data[7];
+			net_from->port = *(short *)&net_message->data[8];
+			net_message->readcount = 10;
+		}
+		else {
+			SockadrToNetadr( (struct sockaddr *) from, net_from );
+			net_message->readcount = 0;
+		}
+	}
+	else {
+		SockadrToNetadr( (struct sockaddr *) from, net_from );
+		net_message->readcount = 0;
+	}
+
+	if( ret >= net_message->maxsize ) {
+		Com_Printf( "Oversize packet from %s\n", NET_AdrToString (*net_from) );
+		return qfalse;
+	}
+
+	net_message->cursize = ret;
+	return qtrue;
+}
+
 /*
 ==================
 NET_GetPacket
@@ -547,35 +618,7 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
 		}
 		else
-		{
-
-			memset( ((struct sockaddr_in *)&from)->sin_zero, 0, 8 );
-		
-			if ( usingSocks && memcmp( &from, &socksRelayAddr, fromlen ) == 0 ) {
-				if ( ret < 10 || net_message->data[0] != 0 || net_message->data[1] != 0 || net_message->data[2] != 0 || net_message->data[3] != 1 ) {
-					return qfalse;
-				}
-				net_from->type = NA_IP;
-				net_from->ip[0] = net_message->data[4];
-				net_from->ip[1] = net_message->data[5];
-				net_from->ip[2] = net_message->data[6];
-				net_from->ip[3] = net_message->data[7];
-				net_from->port = *(short *)&net_message->data[8];
-				net_message->readcount = 10;
-			}
-			else {
-				SockadrToNetadr( (struct sockaddr *) &from, net_from );
-				net_message->readcount = 0;
-			}
-		
-			if( ret >= net_message->maxsize ) {
-				Com_Printf( "Oversize packet from %s\n", NET_AdrToString (*net_from) );
-				return qfalse;
-			}
-			
-			net_message->cursize = ret;
-			return qtrue;
-		}
+			return NET_AcceptPacket( ip_socket, &from, fromlen, ret, net_from, net_message );
 	}
 	
 	if(ip6_socket != INVALID_SOCKET && FD_ISSET(ip6_socket, fdr))
@@ -591,19 +634,7 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
 		}
 		else
-		{
-			SockadrToNetadr((struct sockaddr *) &from, net_from);
-			net_message->readcount = 0;
-		
-			if(ret >= net_message->maxsize)
-			{
-				Com_Printf( "Oversize packet from %s\n", NET_AdrToString (*net_from) );
-				return qfalse;
-			}
-			
-			net_message->cursize = ret;
-			return qtrue;
-		}
+			return NET_AcceptPacket( ip6_socket, &from, fromlen, ret, net_from, net_message );
 	}
 
 	if(multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket && FD_ISSET(multicast6_socket, fdr))
@@ -619,19 +650,7 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
 		}
 		else
-		{
-			SockadrToNetadr((struct sockaddr *) &from, net_from);
-			net_message->readcount = 0;
-		
-			if(ret >= net_message->maxsize)
-			{
-				Com_Printf( "Oversize packet from %s\n", NET_AdrToString (*net_from) );
-				return qfalse;
-			}
-			
-			net_message->cursize = ret;
-			return qtrue;
-		}
+			return NET_AcceptPacket( multicast6_socket, &from, fromlen, ret, net_from, net_message );
 	}
 	
 	
@@ -642,6 +661,27 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 
 static char socksBuf[4096];
 
+/*
+==================
+NET_SendError
+==================
+*/
+static void NET_SendError( netadr_t to ) {
+	int err = socketError;
+
+	// wouldblock is silent
+	if( err == EAGAIN ) {
+		return;
+	}
+
+	// some PPP links do not allow broadcasts and return an error
+	if( ( err == EADDRNOTAVAIL ) && ( ( to.type == NA_BROADCAST ) ) ) {
+		return;
+	}
+
+	Com_Printf( "Sys_SendPacket: %s\n", NET_ErrorString() );
+}
+
 /*
 ==================
 Sys_SendPacket
@@ -686,20 +726,100 @@ void Sys_SendPacket( int length, const void *data, netadr_t to ) {
 			ret = sendto( ip6_socket, data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in6) );
 	}
 	if( ret == SOCKET_ERROR ) {
-		int err = socketError;
+		NET_SendError( to );
+	}
+}
 
-		// wouldblock is silent
-		if( err == EAGAIN ) {
-			return;
+
+#ifdef USE_EPOLL
+/*
+==================
+NET_SendBatch
+==================
+*/
+static void NET_SendBatch( SOCKET sock, struct mmsghdr *hdr, const netadr_t **to, int count ) {
+	int		sent, ret;
+
+	for( sent = 0 ; sent < count ; ) {
+		ret = sendmmsg( sock, hdr + sent, count - sent, 0 );
+
+		if( ret == SOCKET_ERROR ) {
+			// skip the packet that failed and carry on with the rest
+			NET_SendError( *to[sent] );
+			sent++;
+		}
+		else {
+			sent += ret;
 		}
+	}
+}
+#endif
 
-		// some PPP links do not allow broadcasts and return an error
-		if( ( err == EADDRNOTAVAIL ) && ( ( to.type == NA_BROADCAST ) ) ) {
-			return;
+/*
+==================
+Sys_SendPackets
+
+Sends a list of packets in order.  On Linux runs of plain unicast
+packets for the same socket go out in as few sendmmsg calls as possible.
+==================
+*/
+void Sys_SendPackets( int count, const int *lengths, const void **data, const netadr_t *to ) {
+#ifdef USE_EPOLL
+	struct sockaddr_storage	addr[NET_MMSG_BATCH];
+	struct iovec			iov[NET_MMSG_BATCH];
+	struct mmsghdr			hdr[NET_MMSG_BATCH];
+	const netadr_t			*batchTo[NET_MMSG_BATCH];
+	SOCKET					sock, batchSock;
+	int						i, numBatch;
+
+	batchSock = INVALID_SOCKET;
+	numBatch = 0;
+
+	for( i = 0 ; i < count ; i++ ) {
+		// socks relaying, broadcasts and multicast go the long way
+		if( to[i].type == NA_IP && !usingSocks )
+			sock = ip_socket;
+		else if( to[i].type == NA_IP6 )
+			sock = ip6_socket;
+		else
+			sock = INVALID_SOCKET;
+
+		if( sock != batchSock || numBatch == NET_MMSG_BATCH ) {
+			if( numBatch )
+				NET_SendBatch( batchSock, hdr, batchTo, numBatch );
+			numBatch = 0;
+			batchSock = sock;
+		}
+
+		if( sock == INVALID_SOCKET ) {
+			Sys_SendPacket( lengths[i], data[i], to[i] );
+			continue;
 		}
 
-		Com_Printf( "Sys_SendPacket: %s\n", NET_ErrorString() );
+		memset( &addr[numBatch], 0, sizeof( addr[numBatch] ) );
+		NetadrToSockadr( (netadr_t *)&to[i], (struct sockaddr *) &addr[numBatch] );
+
+		iov[numBatch].iov_base = (void *)data[i];
+		iov[numBatch].iov_len = lengths[i];
+
+		memset( &hdr[numBatch], 0, sizeof( hdr[numBatch] ) );
+		hdr[numBatch].msg_hdr.msg_name = &addr[numBatch];
+		hdr[numBatch].msg_hdr.msg_namelen = ( to[i].type == NA_IP ) ? sizeof( struct sockaddr_in ) : sizeof( struct sockaddr_in6 );
+		hdr[numBatch].msg_hdr.msg_iov = &iov[numBatch];
+		hdr[numBatch].msg_hdr.msg_iovlen = 1;
+
+		batchTo[numBatch++] = &to[i];
+	}
+
+	if( numBatch )
+		NET_SendBatch( batchSock, hdr, batchTo, numBatch );
+#else
+	int		i;
+
+	for( i = 0 ; i < count ; i++ ) {
+		Sys_SendPacket( lengths[i], data[i], to[i] );
 	}
+#endif
 }
 
 
@@ -1051,12 +1171,20 @@ void NET_JoinMulticast6(void)
 			return;
 		}
 	}
+
+#ifdef USE_EPOLL
+	NET_WatchMulticast6(qtrue);
+#endif
 }
 
 void NET_LeaveMulticast6(void)
 {
 	if(multicast6_socket != INVALID_SOCKET)
 	{
+#ifdef USE_EPOLL
+		NET_WatchMulticast6(qfalse);
+#endif
+
 		if(multicast6_socket != ip6_socket)
 			closesocket(multicast6_socket);
 		else
@@ -1414,6 +1542,439 @@ void NET_OpenIP( void ) {
 }
 
 
+/*
+====================
+NET_DispatchPacket
+====================
+*/
+static void NET_DispatchPacket( netadr_t *from, msg_t *netmsg )
+{
+	if(net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f)
+	{
+		// com_dropsim->value percent of incoming packets get dropped.
+		if(rand() < (int) (((double) RAND_MAX) / 100.0 * (double) net_dropsim->value))
+			return;          // drop this packet
+	}
+
+	netStats.packets++;
+
+	if(com_sv_running->integer)
+		Com_RunAndTimeServerPacket(from, netmsg);
+	else
+		CL_PacketEvent(*from, netmsg);
+}
+
+#ifdef USE_EPOLL
+/*
+=============================================================================
+
+Linux event loop
+
+NET_Sleep waits on an epoll set holding the game sockets and a timerfd,
+so timeouts are not rounded to whole milliseconds.  Ready sockets are
+drained NET_MMSG_BATCH packets per recvmmsg call.
+
+=============================================================================
+*/
+
+static byte						mmsgData[NET_MMSG_BATCH][MAX_MSGLEN + 1];
+static struct sockaddr_storage	mmsgFrom[NET_MMSG_BATCH];
+static struct iovec				mmsgIov[NET_MMSG_BATCH];
+static struct mmsghdr			mmsgHdr[NET_MMSG_BATCH];
+
+/*
+====================
+NET_CloseEventLoop
+====================
+*/
+static void NET_CloseEventLoop( void )
+{
+	if( epoll_fd != -1 )
+	{
+		close( epoll_fd );
+		epoll_fd = -1;
+	}
+
+	if( timer_fd != -1 )
+	{
+		close( timer_fd );
+		timer_fd = -1;
+	}
+}
+
+/*
+====================
+NET_WatchFd
+====================
+*/
+static qboolean NET_WatchFd( int fd )
+{
+	struct epoll_event ev;
+
+	memset( &ev, 0, sizeof( ev ) );
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+
+	return epoll_ctl( epoll_fd, EPOLL_CTL_ADD, fd, &ev ) == 0;
+}
+
+/*
+====================
+NET_WatchMulticast6
+
+The multicast socket is usually joined after the loop is opened, and
+only needs watching when it isn't ip6_socket
+====================
+*/
+static void NET_WatchMulticast6( qboolean watch )
+{
+	if( epoll_fd == -1 || multicast6_socket == INVALID_SOCKET || multicast6_socket == ip6_socket )
+		return;
+
+	if( !watch )
+	{
+		epoll_ctl( epoll_fd, EPOLL_CTL_DEL, multicast6_socket, NULL );
+		return;
+	}
+
+	if( !NET_WatchFd( multicast6_socket ) && errno != EEXIST )
+	{
+		Com_Printf( "WARNING: NET_WatchMulticast6: %s, using select()\n", NET_ErrorString() );
+		NET_CloseEventLoop();
+	}
+}
+
+/*
+====================
+NET_OpenEventLoop
+
+Called after the sockets are (re)opened, leaves epoll_fd at -1 and
+NET_Sleep on select() if anything fails
+====================
+*/
+static void NET_OpenEventLoop( void )
+{
+	NET_CloseEventLoop();
+
+	epoll_fd = epoll_create1( EPOLL_CLOEXEC );
+	timer_fd = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+
+	if( epoll_fd == -1 || timer_fd == -1 || !NET_WatchFd( timer_fd ) ||
+		( ip_socket != INVALID_SOCKET && !NET_WatchFd( ip_socket ) ) ||
+		( ip6_socket != INVALID_SOCKET && !NET_WatchFd( ip6_socket ) ) ||
+		( multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket && !NET_WatchFd( multicast6_socket ) ) )
+	{
+		Com_Printf( "WARNING: NET_OpenEventLoop: %s, using select()\n", NET_ErrorString() );
+		NET_CloseEventLoop();
+	}
+}
+
+/*
+====================
+NET_ReceivePackets
+
+Reads everything that is waiting on *sock
+====================
+*/
+static void NET_ReceivePackets( SOCKET *sock )
+{
+	SOCKET		s = *sock;
+	netadr_t	from = {0};
+	msg_t		netmsg;
+	int			i, count;
+
+	do
+	{
+		for( i = 0 ; i < NET_MMSG_BATCH ; i++ )
+		{
+			mmsgIov[i].iov_base = mmsgData[i];
+			mmsgIov[i].iov_len = sizeof( mmsgData[i] );
+
+			memset( &mmsgHdr[i], 0, sizeof( mmsgHdr[i] ) );
+			mmsgHdr[i].msg_hdr.msg_name = &mmsgFrom[i];
+			mmsgHdr[i].msg_hdr.msg_namelen = sizeof( mmsgFrom[i] );
+			mmsgHdr[i].msg_hdr.msg_iov = &mmsgIov[i];
+			mmsgHdr[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		count = recvmmsg( s, mmsgHdr, NET_MMSG_BATCH, MSG_DONTWAIT, NULL );
+		netStats.receiveCalls++;
+
+		if( count == SOCKET_ERROR )
+		{
+			int err = socketError;
+
+			if( err != EAGAIN && err != ECONNRESET )
+				Com_Printf( "NET_ReceivePackets: %s\n", NET_ErrorString() );
+			return;
+		}
+
+		for( i = 0 ; i < count ; i++ )
+		{
+			MSG_Init( &netmsg, mmsgData[i], sizeof( mmsgData[i] ) );
+
+			if( NET_AcceptPacket( s, &mmsgFrom[i], mmsgHdr[i].msg_hdr.msg_namelen, mmsgHdr[i].msg_len, &from, &netmsg ) )
+				NET_DispatchPacket( &from, &netmsg );
+		}
+
+		// an rcon net_restart may have replaced the socket
+	} while( count == NET_MMSG_BATCH && *sock == s );
+}
+
+/*
+====================
+NET_WaitEvents
+====================
+*/
+static void NET_WaitEvents( int usec )
+{
+	struct epoll_event	events[4];
+	struct itimerspec	timeout;
+	qboolean			readIP = qfalse, readIP6 = qfalse, readMulticast6 = qfalse;
+	int					i, count;
+
+	if( usec > 0 )
+	{
+		// re-arming also clears an expiry left over from an earlier wait
+		memset( &timeout, 0, sizeof( timeout ) );
+		timeout.it_value.tv_sec = usec / 1000000;
+		timeout.it_value.tv_nsec = ( usec % 1000000 ) * 1000;
+
+		if( timerfd_settime( timer_fd, 0, &timeout, NULL ) == -1 )
+		{
+			Com_Printf( "Warning: timerfd_settime() syscall failed: %s\n", NET_ErrorString() );
+			return;
+		}
+	}
+
+	count = epoll_wait( epoll_fd, events, ARRAY_LEN( events ), usec > 0 ? -1 : 0 );
+
+	if( count == SOCKET_ERROR )
+	{
+		if( errno != EINTR )
+			Com_Printf( "Warning: epoll_wait() syscall failed: %s\n", NET_ErrorString() );
+		return;
+	}
+
+	for( i = 0 ; i < count ; i++ )
+	{
+		if( ip_socket != INVALID_SOCKET && events[i].data.fd == ip_socket )
+			readIP = qtrue;
+		else if( ip6_socket != INVALID_SOCKET && events[i].data.fd == ip6_socket )
+			readIP6 = qtrue;
+		else if( multicast6_socket != INVALID_SOCKET && events[i].data.fd == multicast6_socket )
+			readMulticast6 = qtrue;
+	}
+
+	if( readIP )
+		NET_ReceivePackets( &ip_socket );
+	if( readIP6 && ip6_socket != INVALID_SOCKET )
+		NET_ReceivePackets( &ip6_socket );
+	if( readMulticast6 && multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket )
+		NET_ReceivePackets( &multicast6_socket );
+}
+#endif
+
+/*
+=============================================================================
+
+Loopback load generator
+
+net_bench starts a thread that floods the game's own IPv4 port with
+small connectionless packets and reports how many the main loop took
+in, how many receive calls that needed and how regular the frames were.
+
+=============================================================================
+*/
+
+#define	NET_BENCH_PACKET	"\xff\xff\xff\xffnetbench"
+
+typedef struct {
+	qboolean	running;
+	SOCKET		socket;
+	sysThread_t	*thread;
+
+	// written by the generator thread only, read after it is joined
+	int			rate;			// packets per second
+	int64_t		start;
+	int64_t		end;
+	int			sent;
+
+	// frame timing, main thread only
+	int64_t		lastFrame;
+	int			frames;
+	double		sum;
+	double		sumSq;
+	int64_t		minInterval;
+	int64_t		maxInterval;
+
+	netStats_t	stats;			// netStats when the run started
+} netBench_t;
+
+static netBench_t	netBench;
+
+/*
+====================
+NET_BenchThread
+====================
+*/
+static void NET_BenchThread( void *arg )
+{
+	int64_t		now;
+	int			due;
+
+	while( ( now = Sys_Microseconds() ) < netBench.end )
+	{
+		due = (int)( ( now - netBench.start ) * netBench.rate / 1000000 );
+
+		while( netBench.sent < due )
+		{
+			if( send( netBench.socket, NET_BENCH_PACKET, sizeof( NET_BENCH_PACKET ) - 1, 0 ) == SOCKET_ERROR )
+				break;
+			netBench.sent++;
+		}
+
+#ifdef _WIN32
+		Sleep( 1 );
+#else
+		usleep( 100 );
+#endif
+	}
+}
+
+/*
+====================
+NET_BenchFrame
+
+Called once a frame after the wait for the next frame
+====================
+*/
+void NET_BenchFrame( void )
+{
+	int64_t		now, interval;
+	netStats_t	stats;
+	double		seconds, mean, var;
+
+	if( !netBench.running )
+		return;
+
+	now = Sys_Microseconds();
+
+	if( netBench.lastFrame )
+	{
+		interval = now - netBench.lastFrame;
+
+		if( !netBench.frames || interval < netBench.minInterval )
+			netBench.minInterval = interval;
+		if( interval > netBench.maxInterval )
+			netBench.maxInterval = interval;
+
+		netBench.frames++;
+		netBench.sum += interval;
+		netBench.sumSq += (double)interval * interval;
+	}
+	netBench.lastFrame = now;
+
+	if( now < netBench.end )
+		return;
+
+	Sys_JoinThread( netBench.thread );
+	closesocket( netBench.socket );
+	netBench.running = qfalse;
+
+	stats.packets = netStats.packets - netBench.stats.packets;
+	stats.receiveCalls = netStats.receiveCalls - netBench.stats.receiveCalls;
+	seconds = ( now - netBench.start ) / 1000000.0;
+
+	Com_Printf( "net_bench: %.1f seconds, %i packets sent, %i received, %.0f packets/s\n",
+		seconds, netBench.sent, stats.packets, stats.packets / seconds );
+	Com_Printf( "  %i receive calls, %.2f packets per call\n",
+		stats.receiveCalls, stats.receiveCalls ? (float)stats.packets / stats.receiveCalls : 0.0f );
+
+	if( netBench.frames )
+	{
+		mean = netBench.sum / netBench.frames;
+		var = netBench.sumSq / netBench.frames - mean * mean;
+
+		Com_Printf( "  %i frames, interval %.3f avg %.3f min %.3f max ms, jitter %.3f ms stddev\n",
+			netBench.frames, mean / 1000.0, netBench.minInterval / 1000.0, netBench.maxInterval / 1000.0,
+			sqrt( var > 0 ? var : 0 ) / 1000.0 );
+	}
+}
+
+/*
+====================
+NET_Bench_f
+====================
+*/
+static void NET_Bench_f( void )
+{
+	struct sockaddr_in	addr;
+	socklen_t			addrlen = sizeof( addr );
+	int					seconds;
+
+	if( netBench.running )
+	{
+		Com_Printf( "net_bench is already running\n" );
+		return;
+	}
+
+	if( ip_socket == INVALID_SOCKET || usingSocks )
+	{
+		Com_Printf( "net_bench needs an open IPv4 socket without SOCKS\n" );
+		return;
+	}
+
+	seconds = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 10;
+	Com_Memset( &netBench, 0, sizeof( netBench ) );
+	netBench.rate = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 20000;
+
+	if( seconds <= 0 || netBench.rate <= 0 )
+	{
+		Com_Printf( "usage: net_bench [seconds] [packets per second]\n" );
+		return;
+	}
+
+	if( getsockname( ip_socket, (struct sockaddr *) &addr, &addrlen ) == SOCKET_ERROR )
+	{
+		Com_Printf( "net_bench: getsockname: %s\n", NET_ErrorString() );
+		return;
+	}
+
+	if( addr.sin_addr.s_addr == htonl( INADDR_ANY ) )
+		addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+	netBench.socket = socket( PF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if( netBench.socket == INVALID_SOCKET )
+	{
+		Com_Printf( "net_bench: socket: %s\n", NET_ErrorString() );
+		return;
+	}
+
+	if( connect( netBench.socket, (struct sockaddr *) &addr, sizeof( addr ) ) == SOCKET_ERROR )
+	{
+		Com_Printf( "net_bench: connect: %s\n", NET_ErrorString() );
+		closesocket( netBench.socket );
+		return;
+	}
+
+	netBench.stats = netStats;
+	netBench.start = Sys_Microseconds();
+	netBench.end = netBench.start + (int64_t)seconds * 1000000;
+
+	netBench.thread = Sys_CreateThread( NET_BenchThread, NULL );
+	if( !netBench.thread )
+	{
+		Com_Printf( "net_bench: couldn't start the generator thread\n" );
+		closesocket( netBench.socket );
+		return;
+	}
+
+	netBench.running = qtrue;
+	Com_Printf( "net_bench: sending %i packets/s to %s for %i seconds\n",
+		netBench.rate, inet_ntoa( addr.sin_addr ), seconds );
+}
+
 //===================================================================
 
 
@@ -1569,6 +2130,13 @@ void NET_Config( qboolean enableNetworking ) {
 			NET_SetMulticast6();
 		}
 	}
+
+#ifdef USE_EPOLL
+	if( start && net_enabled->integer )
+		NET_OpenEventLoop();
+	else if( stop )
+		NET_CloseEventLoop();
+#endif
 }
 
 
@@ -1594,6 +2162,7 @@ void NET_Init( void ) {
 	NET_Config( qtrue );
 	
 	Cmd_AddCommand ("net_restart", NET_Restart_f);
+	Cmd_AddCommand ("net_bench", NET_Bench_f);
 }
 
 
@@ -1633,20 +2202,10 @@ void NET_Event(fd_set *fdr)
 	{
 		MSG_Init(&netmsg, bufData, sizeof(bufData));
 
-		if(NET_GetPacket(&from, &netmsg, fdr))
-		{
-			if(net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f)
-			{
-				// com_dropsim->value percent of incoming packets get dropped.
-				if(rand() < (int) (((double) RAND_MAX) / 100.0 * (double) net_dropsim->value))
-					continue;          // drop this packet
-			}
+		netStats.receiveCalls++;
 
-			if(com_sv_running->integer)
-				Com_RunAndTimeServerPacket(&from, &netmsg);
-			else
-				CL_PacketEvent(from, &netmsg);
-		}
+		if(NET_GetPacket(&from, &netmsg, fdr))
+			NET_DispatchPacket(&from, &netmsg);
 		else
 			break;
 	}
@@ -1656,18 +2215,29 @@ void NET_Event(fd_set *fdr)
 ====================
 NET_Sleep
 
-Sleeps msec or until something happens on the network
+Sleeps usec or until something happens on the network.  Only Linux
+waits for less than a millisecond, elsewhere usec is rounded down.
 ====================
 */
-void NET_Sleep(int msec)
+void NET_Sleep(int usec)
 {
 	struct timeval timeout;
 	fd_set fdr;
-	int retval;
+	int retval, msec;
 	SOCKET highestfd = INVALID_SOCKET;
 
-	if(msec < 0)
-		msec = 0;
+	if(usec < 0)
+		usec = 0;
+
+#ifdef USE_EPOLL
+	if(epoll_fd != -1)
+	{
+		NET_WaitEvents(usec);
+		return;
+	}
+#endif
+
+	msec = usec / 1000;
 
 	FD_ZERO(&fdr);
 
@@ -0,0 +1,457 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// profile.c -- scoped timing zones and a Chrome trace exporter
+
+/*
+Every thread that closes a zone while com_profile is set gets its own
+ring of the most recent events.  Only the owning thread writes to a
+ring, and it publishes an event by bumping the ring's head after the
+event is filled in, so recording never takes a lock.  profile_dump
+copies each ring, throws away anything the owner may have overwritten
+while it was copying, and writes the Chrome trace event format:
+
+	{"traceEvents":[
+	{"name":"SV_Frame","ph":"X","pid":1,"tid":0,"ts":1234,"dur":56},
+	...
+	]}
+
+which chrome://tracing and ui.perfetto.dev both open directly.
+*/
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#define	PROFILE_MAX_THREADS		( MAX_JOB_THREADS + 16 )
+#define	PROFILE_RING_EVENTS		( 1 << 16 )		// per thread, power of two
+#define	PROFILE_MAX_DEPTH		32
+#define	PROFILE_WRITE_BUFFER	65536
+
+#ifdef _MSC_VER
+#define	PROFILE_THREAD_LOCAL	__declspec( thread )
+#else
+#define	PROFILE_THREAD_LOCAL	__thread
+#endif
+
+// volatile stores already have release semantics with MSVC on x86
+#ifdef __GNUC__
+#define	PROFILE_PUBLISH( x, v )	__atomic_store_n( &(x), (v), __ATOMIC_RELEASE )
+#define	PROFILE_LOAD( x )		__atomic_load_n( &(x), __ATOMIC_ACQUIRE )
+#else
+#define	PROFILE_PUBLISH( x, v )	( (x) = (v) )
+#define	PROFILE_LOAD( x )		(x)
+#endif
+
+typedef struct {
+	int64_t		start;			// Sys_Microseconds
+	int			duration;
+	short		zone;
+	short		depth;
+} profileEvent_t;
+
+typedef struct {
+	profileEvent_t	*events;
+	volatile unsigned	head;		// events ever written, only the owner stores it
+
+	char			name[32];
+	qboolean		inUse;		// released when the owner exits, see Com_ProfileThreadExit
+
+	// zones opened but not yet closed
+	int				frame;		// profileFrameNum when depth was last valid
+	int				depth;
+	int				zones[PROFILE_MAX_DEPTH];
+	int64_t			starts[PROFILE_MAX_DEPTH];
+} profileThread_t;
+
+static const char *profileZoneNames[PROFILE_NUM_ZONES] = {
+	"Com_Frame",
+	"SV_Frame",
+	"SV_BotFrame",
+	"G_RunFrame",
+	"SV_SendClientMessages",
+	"CL_Frame",
+	"CL_ParseServerMessage",
+	"CM_Trace",
+	"R_GenerateDrawSurfs",
+	"R_SortDrawSurfs",
+	"RB_ExecuteRenderCommands"
+};
+
+static PROFILE_THREAD_LOCAL profileThread_t	*profileThread;
+static PROFILE_THREAD_LOCAL const char		*profileThreadName;
+
+static profileThread_t	profileThreads[PROFILE_MAX_THREADS];
+static int				profileNumThreads;
+static qboolean			profileOutOfThreads;
+static sysMutex_t		*profileLock;
+static volatile int		profileFrameNum;
+
+static cvar_t			*com_profile;
+qboolean				com_profiling;
+
+/*
+=================
+Com_ProfileThreadName
+
+Names the calling thread in dumps, the string must stay valid
+=================
+*/
+void Com_ProfileThreadName( const char *name ) {
+	profileThreadName = name;
+
+	if ( profileThread ) {
+		Q_strncpyz( profileThread->name, name, sizeof( profileThread->name ) );
+	}
+}
+
+/*
+=================
+Com_ProfileClaimThread
+
+Hands the calling thread a ring the first time it records anything,
+reusing the ring of a thread that has exited if there is one.  A reused
+ring keeps counting from its old head, so a dump copying it meanwhile
+only sees events in order.
+=================
+*/
+static profileThread_t *Com_ProfileClaimThread( void ) {
+	profileThread_t	*t = NULL;
+	int				i;
+
+	if ( profileOutOfThreads ) {
+		return NULL;
+	}
+
+	if ( profileLock ) {
+		Sys_LockMutex( profileLock );
+	}
+
+	for ( i = 0 ; i < profileNumThreads ; i++ ) {
+		if ( !profileThreads[i].inUse ) {
+			t = &profileThreads[i];
+			break;
+		}
+	}
+
+	if ( !t && profileNumThreads < PROFILE_MAX_THREADS ) {
+		t = &profileThreads[profileNumThreads];
+		t->events = malloc( PROFILE_RING_EVENTS * sizeof( *t->events ) );
+		if ( t->events ) {
+			t->head = 0;
+			i = profileNumThreads++;
+		} else {
+			t = NULL;
+		}
+	} else if ( !t ) {
+		profileOutOfThreads = qtrue;
+	}
+
+	if ( t ) {
+		t->inUse = qtrue;
+		t->frame = profileFrameNum;
+		t->depth = 0;
+		if ( profileThreadName ) {
+			Q_strncpyz( t->name, profileThreadName, sizeof( t->name ) );
+		} else {
+			Com_sprintf( t->name, sizeof( t->name ), "thread %i", i );
+		}
+	}
+
+	if ( profileLock ) {
+		Sys_UnlockMutex( profileLock );
+	}
+
+	profileThread = t;
+	return t;
+}
+
+/*
+=================
+Com_ProfileThreadExit
+
+Called by every thread on its way out, its ring goes to the next thread
+that records anything.  The events stay in dumps until then.
+=================
+*/
+void Com_ProfileThreadExit( void ) {
+	profileThread_t	*t = profileThread;
+
+	if ( !t ) {
+		return;
+	}
+
+	if ( profileLock ) {
+		Sys_LockMutex( profileLock );
+	}
+
+	t->inUse = qfalse;
+	profileOutOfThreads = qfalse;
+
+	if ( profileLock ) {
+		Sys_UnlockMutex( profileLock );
+	}
+
+	profileThread = NULL;
+}
+
+/*
+=================
+Com_ProfileBegin
+=================
+*/
+void Com_ProfileBegin( int zone ) {
+	profileThread_t	*t;
+
+	if ( !com_profiling ) {
+		return;
+	}
+
+	t = profileThread;
+	if ( !t ) {
+		t = Com_ProfileClaimThread();
+		if ( !t ) {
+			return;
+		}
+	}
+
+	// zones still open from an earlier frame were left by an error
+	if ( t->frame != profileFrameNum ) {
+		t->frame = profileFrameNum;
+		t->depth = 0;
+	}
+
+	if ( t->depth < PROFILE_MAX_DEPTH ) {
+		t->zones[t->depth] = zone;
+		t->starts[t->depth] = Sys_Microseconds();
+	}
+	t->depth++;
+}
+
+/*
+=================
+Com_ProfileEnd
+
+Closes the innermost open zone with a matching id.  Zones left open
+by a Com_Error longjmp are dropped on the way.
+=================
+*/
+void Com_ProfileEnd( int zone ) {
+	profileThread_t	*t;
+	profileEvent_t	*ev;
+	int64_t			start;
+	unsigned		head;
+
+	t = profileThread;
+	if ( !com_profiling || !t ) {
+		return;
+	}
+
+	if ( t->frame != profileFrameNum ) {
+		t->frame = profileFrameNum;
+		t->depth = 0;
+		return;
+	}
+
+	while ( t->depth > 0 ) {
+		t->depth--;
+
+		if ( t->depth >= PROFILE_MAX_DEPTH ) {
+			// too deep to have been recorded
+			return;
+		}
+		if ( t->zones[t->depth] != zone ) {
+			continue;
+		}
+
+		start = t->starts[t->depth];
+		head = t->head;
+
+		ev = &t->events[head & ( PROFILE_RING_EVENTS - 1 )];
+		ev->start = start;
+		ev->duration = (int)( Sys_Microseconds() - start );
+		ev->zone = zone;
+		ev->depth = t->depth;
+
+		PROFILE_PUBLISH( t->head, head + 1 );
+		return;
+	}
+}
+
+/*
+=================
+Com_ProfileFrame
+
+Picks up com_profile changes and forgets zones an ERR_DROP left
+open.  Other threads only run zones inside a frame, they drop theirs
+the next time they open or close one.
+=================
+*/
+void Com_ProfileFrame( void ) {
+	com_profiling = com_profile->integer ? qtrue : qfalse;
+
+	profileFrameNum++;
+
+	if ( profileThread ) {
+		profileThread->frame = profileFrameNum;
+		profileThread->depth = 0;
+	}
+}
+
+/*
+=================
+Com_ProfileWrite
+
+Buffers formatted output so a dump isn't one FS_Write per event
+=================
+*/
+static void QDECL Com_ProfileWrite( fileHandle_t f, char *buffer, int *used, const char *fmt, ... ) Q_PRINTF_FUNC(4, 5);
+static void QDECL Com_ProfileWrite( fileHandle_t f, char *buffer, int *used, const char *fmt, ... ) {
+	va_list	argptr;
+	int		len;
+
+	if ( *used > PROFILE_WRITE_BUFFER - 256 ) {
+		FS_Write( buffer, *used, f );
+		*used = 0;
+	}
+
+	va_start( argptr, fmt );
+	len = Q_vsnprintf( buffer + *used, PROFILE_WRITE_BUFFER - *used, fmt, argptr );
+	va_end( argptr );
+
+	if ( len > 0 ) {
+		*used += len;
+	}
+}
+
+/*
+=================
+Com_ProfileDump_f
+
+profile_dump [file]
+=================
+*/
+static void Com_ProfileDump_f( void ) {
+	char			filename[MAX_QPATH];
+	fileHandle_t	f;
+	profileEvent_t	*copy, *ev;
+	char			*buffer;
+	int				used;
+	int				numThreads, numEvents;
+	unsigned		first, head, last, i;
+	const char		*sep;
+	int				t;
+
+	if ( Cmd_Argc() > 1 ) {
+		Q_strncpyz( filename, Cmd_Argv( 1 ), sizeof( filename ) );
+		COM_DefaultExtension( filename, sizeof( filename ), ".json" );
+	} else {
+		Q_strncpyz( filename, "profile.json", sizeof( filename ) );
+	}
+
+	if ( profileLock ) {
+		Sys_LockMutex( profileLock );
+	}
+	numThreads = profileNumThreads;
+	if ( profileLock ) {
+		Sys_UnlockMutex( profileLock );
+	}
+
+	if ( !numThreads ) {
+		Com_Printf( "profile_dump: nothing recorded, set com_profile 1 first\n" );
+		return;
+	}
+
+	f = FS_FOpenFileWrite( filename );
+	if ( !f ) {
+		Com_Printf( "profile_dump: couldn't open %s\n", filename );
+		return;
+	}
+
+	copy = malloc( PROFILE_RING_EVENTS * sizeof( *copy ) );
+	buffer = malloc( PROFILE_WRITE_BUFFER );
+	if ( !copy || !buffer ) {
+		free( copy );
+		free( buffer );
+		FS_FCloseFile( f );
+		Com_Printf( "profile_dump: out of memory\n" );
+		return;
+	}
+
+	used = 0;
+	numEvents = 0;
+	sep = "";
+
+	Com_ProfileWrite( f, buffer, &used, "{\"traceEvents\":[\n" );
+
+	for ( t = 0 ; t < numThreads ; t++ ) {
+		profileThread_t	*thread = &profileThreads[t];
+
+		Com_ProfileWrite( f, buffer, &used,
+			"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+			sep, t, thread->name );
+		sep = ",\n";
+
+		// copy first, then drop whatever the owner may have lapped meanwhile
+		head = PROFILE_LOAD( thread->head );
+		first = head > PROFILE_RING_EVENTS ? head - PROFILE_RING_EVENTS : 0;
+		for ( i = first ; i != head ; i++ ) {
+			copy[i & ( PROFILE_RING_EVENTS - 1 )] = thread->events[i & ( PROFILE_RING_EVENTS - 1 )];
+		}
+
+		last = PROFILE_LOAD( thread->head );
+		if ( last - first >= PROFILE_RING_EVENTS ) {
+			first = last - PROFILE_RING_EVENTS + 1;
+		}
+
+		for ( i = first ; (int)( head - i ) > 0 ; i++ ) {
+			ev = &copy[i & ( PROFILE_RING_EVENTS - 1 )];
+			Com_ProfileWrite( f, buffer, &used,
+				",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%lld,\"dur\":%i}",
+				profileZoneNames[ev->zone], t, (long long)ev->start, ev->duration );
+			numEvents++;
+		}
+	}
+
+	Com_ProfileWrite( f, buffer, &used, "\n]}\n" );
+	FS_Write( buffer, used, f );
+	FS_FCloseFile( f );
+
+	free( copy );
+	free( buffer );
+
+	Com_Printf( "profile_dump: %i events from %i threads written to %s\n", numEvents, numThreads, filename );
+}
+
+/*
+=================
+Com_InitProfile
+=================
+*/
+void Com_InitProfile( void ) {
+	com_profile = Cvar_Get( "com_profile", "0", 0 );
+	Cvar_SetDescription( com_profile, "Record timing zones for profile_dump" );
+
+	profileLock = Sys_CreateMutex();
+
+	Com_ProfileThreadName( "main" );
+
+	Cmd_AddCommand( "profile_dump", Com_ProfileDump_f );
+}
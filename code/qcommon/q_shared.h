@@ -1038,6 +1038,18 @@ typedef struct {
 	int			entityNum;	// entity the contacted sirface is a part of
 } trace_t;
 
+// one trace of a batch, the fields up to passEntityNum decide the result
+// against the world, so identical requests are only traced once
+typedef struct {
+	vec3_t		start;
+	vec3_t		end;
+	vec3_t		mins;
+	vec3_t		maxs;
+	int			contentmask;
+	int			capsule;
+	int			passEntityNum;	// not used by the collision model
+} traceRequest_t;
+
 // trace->entityNum can also be 0 to (MAX_GENTITIES-1)
 // or ENTITYNUM_NONE, ENTITYNUM_WORLD
 
@@ -60,6 +60,7 @@ struct entityState_s;
 struct playerState_s;
 
 void MSG_WriteBits( msg_t *msg, int value, int bits );
+void MSG_WriteBitstream( msg_t *msg, const byte *data, int numBits );
 
 void MSG_WriteChar (msg_t *sb, int c);
 void MSG_WriteByte (msg_t *sb, int c);
@@ -101,6 +102,7 @@ void MSG_ReadDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct pl
 
 
 void MSG_ReportChangeVectors_f( void );
+void MSG_HuffBench_f( void );
 
 //============================================================================
 
@@ -178,7 +180,9 @@ int		NET_StringToAdr ( const char *s, netadr_t *a, netadrtype_t family);
 qboolean	NET_GetLoopPacket (netsrc_t sock, netadr_t *net_from, msg_t *net_message);
 void		NET_JoinMulticast6(void);
 void		NET_LeaveMulticast6(void);
-void		NET_Sleep(int msec);
+#define	NET_SLEEP_SLICE		100		// usec
+void		NET_Sleep(int usec);
+void		NET_BenchFrame(void);
 
 
 #define	MAX_MSGLEN				16384		// max length of a message, which may
@@ -327,7 +331,8 @@ typedef struct vm_s vm_t;
 typedef enum {
 	VMI_NATIVE,
 	VMI_BYTECODE,
-	VMI_COMPILED
+	VMI_COMPILED,
+	VMI_OPTIMIZED		// second tier compiler, falls back to VMI_COMPILED
 } vmInterpret_t;
 
 typedef enum {
@@ -367,6 +372,7 @@ void	VM_Debug( int level );
 
 void	*VM_ArgPtr( intptr_t intValue );
 void	*VM_ExplicitArgPtr( vm_t *vm, intptr_t intValue );
+void	VM_CheckBlock( intptr_t intValue, size_t size, const char *name );
 
 #define	VMA(x) VM_ArgPtr(args[x])
 static ID_INLINE float _vmf(intptr_t x)
@@ -726,6 +732,11 @@ qboolean FS_ComparePaks( char *neededpaks, int len, qboolean dlstring );
 
 void FS_Remove( const char *osPath );
 void FS_HomeRemove( const char *homePath );
+qboolean FS_HomeRename( const char *from, const char *to );
+
+// maps a plain file from the search path read only, NULL if it isn't one
+void	*FS_MapFile( const char *qpath, long *length );
+void	FS_UnmapFile( void *data, long length );
 
 void	FS_FilenameCompletion( const char *dir, const char *ext,
 		qboolean stripExt, void(*callback)(const char *s), qboolean allowNonPureFilesOnDisk );
@@ -957,6 +968,75 @@ void Com_Init( char *commandLine );
 void Com_Frame( void );
 void Com_Shutdown( void );
 
+/*
+==============================================================
+
+JOB POOL
+
+Worker threads for splitting independent work items across cores.
+Com_RunJobs calls func( data, index ) once for every index in
+[0, count) and returns when all of them have finished.  The calling
+thread takes part in the work, so at most numThreads - 1 workers are
+used; numThreads <= 1, a nested call from inside a job, or a platform
+without threads simply runs the loop inline.
+
+Jobs run concurrently, so they must not call Com_Error, Com_Printf,
+the zone/hunk allocators or anything else that touches shared engine
+state without its own locking.
+
+==============================================================
+*/
+
+#define	MAX_JOB_THREADS		32
+
+typedef void (*jobFunc_t)( void *data, int index );
+
+void	Com_RunJobs( jobFunc_t func, void *data, int count, int numThreads );
+void	Com_ShutdownJobs( void );
+
+
+/*
+==============================================================
+
+TIMING ZONES
+
+PROFILE_BEGIN / PROFILE_END bracket a piece of work on any thread;
+with com_profile set the closed zones go into a per-thread ring that
+profile_dump writes out as Chrome trace JSON.  With com_profile 0 a
+zone costs one test of com_profiling.  An END closes the innermost
+open zone with the same id, so zones skipped by an error are dropped.
+
+==============================================================
+*/
+
+typedef enum {
+	PROFILE_COM_FRAME,
+	PROFILE_SV_FRAME,
+	PROFILE_SV_BOTFRAME,
+	PROFILE_SV_GAMEFRAME,
+	PROFILE_SV_SENDCLIENTMESSAGES,
+	PROFILE_CL_FRAME,
+	PROFILE_CL_PARSESERVERMESSAGE,
+	PROFILE_CM_TRACE,
+	PROFILE_R_GENERATEDRAWSURFS,
+	PROFILE_R_SORTDRAWSURFS,
+	PROFILE_RB_EXECUTERENDERCOMMANDS,
+
+	PROFILE_NUM_ZONES
+} profileZone_t;
+
+extern	qboolean	com_profiling;
+
+#define	PROFILE_BEGIN( zone )	do { if ( com_profiling ) Com_ProfileBegin( zone ); } while ( 0 )
+#define	PROFILE_END( zone )		do { if ( com_profiling ) Com_ProfileEnd( zone ); } while ( 0 )
+
+void	Com_InitProfile( void );
+void	Com_ProfileFrame( void );
+void	Com_ProfileBegin( int zone );
+void	Com_ProfileEnd( int zone );
+void	Com_ProfileThreadName( const char *name );
+void	Com_ProfileThreadExit( void );
+
 
 /*
 ==============================================================
@@ -1091,6 +1171,7 @@ void	Sys_Print( const char *msg );
 // Sys_Milliseconds should only be used for profiling purposes,
 // any game related timing information should come from event timestamps
 int		Sys_Milliseconds (void);
+int64_t	Sys_Microseconds( void );
 
 qboolean Sys_RandomBytes( byte *string, int len );
 
@@ -1102,6 +1183,7 @@ cpuFeatures_t Sys_GetProcessorFeatures( void );
 void	Sys_SetErrorText( const char *text );
 
 void	Sys_SendPacket( int length, const void *data, netadr_t to );
+void	Sys_SendPackets( int count, const int *lengths, const void **data, const netadr_t *to );
 
 qboolean	Sys_StringToAdr( const char *s, netadr_t *a, netadrtype_t family );
 //Does NOT parse port numbers, only base addresses.
@@ -1112,6 +1194,9 @@ void		Sys_ShowIP(void);
 FILE	*Sys_FOpen( const char *ospath, const char *mode );
 qboolean Sys_Mkdir( const char *path );
 FILE	*Sys_Mkfifo( const char *ospath );
+void	*Sys_MapFile( const char *ospath, long *length );
+void	Sys_UnmapFile( void *data, long length );
+qboolean Sys_Rename( const char *from, const char *to );
 char	*Sys_Cwd( void );
 void	Sys_SetDefaultInstallPath(const char *path);
 char	*Sys_DefaultInstallPath(void);
@@ -1136,6 +1221,34 @@ qboolean Sys_LowPhysicalMemory( void );
 
 void Sys_SetEnv(const char *name, const char *value);
 
+// threads, mutexes and condition variables for the job pool; the create
+// functions return NULL on platforms without thread support
+typedef struct sysThread_s	sysThread_t;
+typedef struct sysMutex_s	sysMutex_t;
+typedef struct sysCond_s	sysCond_t;
+
+sysThread_t	*Sys_CreateThread( void (*func)( void *arg ), void *arg );
+void		Sys_JoinThread( sysThread_t *thread );
+sysMutex_t	*Sys_CreateMutex( void );
+void		Sys_DestroyMutex( sysMutex_t *mutex );
+void		Sys_LockMutex( sysMutex_t *mutex );
+void		Sys_UnlockMutex( sysMutex_t *mutex );
+sysCond_t	*Sys_CreateCond( void );
+void		Sys_DestroyCond( sysCond_t *cond );
+void		Sys_WaitCond( sysCond_t *cond, sysMutex_t *mutex );
+void		Sys_SignalCond( sysCond_t *cond );
+void		Sys_BroadcastCond( sysCond_t *cond );
+int			Sys_NumProcessors( void );
+
+// profiling timer for vmprof; func runs in a signal handler with the
+// interrupted pc and stack pointer and the native return addresses the
+// system could unwind, leaf first, or none
+typedef void (*sysProfileFunc_t)( void *pc, void *sp, void **frames, int numFrames );
+
+qboolean	Sys_StartProfiler( int hz, sysProfileFunc_t func );
+void		Sys_StopProfiler( void );
+qboolean	Sys_AddressToSymbol( const void *address, char *buf, int size );
+
 typedef enum
 {
 	DR_YES = 0,
@@ -1205,6 +1318,28 @@ void	Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset, int max
 void	Huff_putBit( int bit, byte *fout, int *offset);
 int		Huff_getBit( byte *fout, int *offset);
 
+// lookup tables for a tree that is no longer updated, see Huff_BuildTable
+#define	HUFF_LOOKUP_BITS	11
+#define	HUFF_LOOKUP_SIZE	(1<<HUFF_LOOKUP_BITS)
+
+typedef struct {
+	short	value;			// symbol, or nodeList index to walk on from if length is 0
+	byte	length;
+} huffLookup_t;
+
+typedef struct {
+	huff_t			*compressor;
+	huff_t			*decompressor;
+
+	huffLookup_t	lookup[HUFF_LOOKUP_SIZE];	// indexed by the next bits of input
+	unsigned int	code[HMAX+1];				// first bit sent is bit 0
+	byte			codeLength[HMAX+1];			// 0 if the tree has to be walked
+} huffTable_t;
+
+void	Huff_BuildTable( huffTable_t *table, huff_t *compressor, huff_t *decompressor );
+void	Huff_tableReceive( const huffTable_t *table, int *ch, byte *fin, int *offset, int maxoffset );
+void	Huff_tableTransmit( const huffTable_t *table, int ch, byte *fout, int *offset, int maxoffset );
+
 // don't use if you don't know what you're doing.
 int		Huff_getBloc(void);
 void	Huff_setBloc(int _bloc);
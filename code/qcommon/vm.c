@@ -43,7 +43,6 @@ int		vm_debugLevel;
 // used by Com_Error to get rid of running vm's before longjmp
 static int forced_unload;
 
-#define	MAX_VM		3
 vm_t	vmTable[MAX_VM];
 
 
@@ -70,12 +69,14 @@ VM_Init
 ==============
 */
 void VM_Init( void ) {
+	// 0 native, 1 interpreted, 2 compiled, 3 compiled with the optimizing tier
 	Cvar_Get( "vm_cgame", "2", CVAR_ARCHIVE );	// !@# SHIP WITH SET TO 2
 	Cvar_Get( "vm_game", "2", CVAR_ARCHIVE );	// !@# SHIP WITH SET TO 2
 	Cvar_Get( "vm_ui", "2", CVAR_ARCHIVE );		// !@# SHIP WITH SET TO 2
 
 	Cmd_AddCommand ("vmprofile", VM_VmProfile_f );
 	Cmd_AddCommand ("vminfo", VM_VmInfo_f );
+	Cmd_AddCommand ("vmprof", VM_Prof_f );
 
 	Com_Memset( vmTable, 0, sizeof( vmTable ) );
 }
@@ -155,31 +156,48 @@ int VM_SymbolToValue( vm_t *vm, const char *symbol ) {
 /*
 =====================
 VM_SymbolForCompiledPointer
+
+Name of the function the compiled code at this address belongs to,
+symbols of compiled vms hold instruction numbers
 =====================
 */
-#if 0 // 64bit!
-const char *VM_SymbolForCompiledPointer( vm_t *vm, void *code ) {
-	int			i;
+const char *VM_SymbolForCompiledPointer( vm_t *vm, const void *code ) {
+	int			low, high, mid, probe;
+	const byte	*entry;
 
-	if ( code < (void *)vm->codeBase ) {
+	if ( (const byte *)code < vm->codeBase ) {
 		return "Before code block";
 	}
-	if ( code >= (void *)(vm->codeBase + vm->codeLength) ) {
+	if ( (const byte *)code >= vm->codeBase + vm->codeLength ) {
 		return "After code block";
 	}
+	if ( !vm->symbols ) {
+		return "NO SYMBOLS";
+	}
 
-	// find which original instruction it is after
-	for ( i = 0 ; i < vm->codeLength ; i++ ) {
-		if ( (void *)vm->instructionPointers[i] > code ) {
-			break;
+	// find which original instruction it is after, instructions the
+	// compiler merged into the one before them have no code of their own
+	entry = vm->codeBase + vm->entryOfs;
+	low = 0;
+	high = vm->instructionCount - 1;
+	while ( low < high ) {
+		mid = ( low + high + 1 ) / 2;
+
+		probe = mid;
+		while ( probe > low && (const byte *)vm->instructionPointers[probe] < entry ) {
+			probe--;
+		}
+
+		if ( probe > low && (const byte *)vm->instructionPointers[probe] > (const byte *)code ) {
+			high = probe - 1;
+		} else {
+			low = mid;
 		}
 	}
-	i--;
 
 	// now look up the bytecode instruction pointer
-	return VM_ValueToSymbol( vm, i );
+	return VM_ValueToFunctionSymbol( vm, low )->symName;
 }
-#endif
 
 
 
@@ -281,8 +299,9 @@ void VM_LoadSymbols( vm_t *vm ) {
 		prev = &sym->next;
 		sym->next = NULL;
 
-		// convert value from an instruction number to a code offset
-		if ( value >= 0 && value < numInstructions ) {
+		// convert value from an instruction number to a code offset,
+		// compiled code is looked up by instruction number
+		if ( !vm->compiled && value >= 0 && value < numInstructions ) {
 			value = vm->instructionPointers[value];
 		}
 
@@ -652,6 +671,7 @@ vm_t *VM_Create( const char *module, intptr_t (*systemCalls)(intptr_t *),
 	vm->codeLength = header->codeLength;
 
 	vm->compiled = qfalse;
+	vm->optimized = qfalse;
 
 #ifndef HAVE_VM_COMPILED
 	if(interpret >= VMI_COMPILED) {
@@ -662,6 +682,9 @@ vm_t *VM_Create( const char *module, intptr_t (*systemCalls)(intptr_t *),
 	if(interpret != VMI_BYTECODE)
 	{
 		vm->compiled = qtrue;
+#if idx64
+		vm->optimized = (interpret == VMI_OPTIMIZED);
+#endif
 		VM_Compile( vm, header );
 	}
 #endif
@@ -706,6 +729,9 @@ void VM_Free( vm_t *vm ) {
 		}
 	}
 
+	// vmprof names its samples while the code is still there
+	VM_ProfileResolve();
+
 	if(vm->destroy)
 		vm->destroy(vm);
 
@@ -809,6 +835,8 @@ intptr_t QDECL VM_Call( vm_t *vm, int callnum, ... )
 	vm_t	*oldVM;
 	intptr_t r;
 	int i;
+	int64_t	startTime;
+	void	*oldCallFrame;
 
 	if(!vm || !vm->name[0])
 		Com_Error(ERR_FATAL, "VM_Call with NULL vm");
@@ -821,6 +849,17 @@ intptr_t QDECL VM_Call( vm_t *vm, int callnum, ... )
 	  Com_Printf( "VM_Call( %d )\n", callnum );
 	}
 
+	// only the outermost call is timed, syscalls may enter again
+	startTime = vm->callLevel ? 0 : Sys_Microseconds();
+
+	// vmprof walks the machine stack of compiled code up to here, a
+	// syscall left by longjmp may not have reset its frame
+	oldCallFrame = vm->callFrame;
+	vm->callFrame = &oldCallFrame;
+	if ( !vm->callLevel ) {
+		vm->syscallFrame = NULL;
+	}
+
 	++vm->callLevel;
 	// if we have a dll loaded, call it directly
 	if ( vm->entryPoint ) {
@@ -866,6 +905,12 @@ intptr_t QDECL VM_Call( vm_t *vm, int callnum, ... )
 #endif
 	}
 	--vm->callLevel;
+	vm->callFrame = oldCallFrame;
+
+	if ( !vm->callLevel ) {
+		vm->callTime += Sys_Microseconds() - startTime;
+		vm->callCount++;
+	}
 
 	if ( oldVM != NULL )
 	  currentVM = oldVM;
@@ -893,6 +938,8 @@ static int QDECL VM_ProfileSort( const void *a, const void *b ) {
 ==============
 VM_VmProfile_f
 
+Prints the time spent in the vm since the last vmprofile, and the
+instruction counts of interpreted vms built with DEBUG_VM
 ==============
 */
 void VM_VmProfile_f( void ) {
@@ -901,11 +948,30 @@ void VM_VmProfile_f( void ) {
 	int			i;
 	double		total;
 
-	if ( !lastVM ) {
+	vm = lastVM;
+
+	if ( Cmd_Argc() > 1 ) {
+		vm = NULL;
+		for ( i = 0 ; i < MAX_VM ; i++ ) {
+			if ( vmTable[i].name[0] && !Q_stricmp( vmTable[i].name, Cmd_Argv( 1 ) ) ) {
+				vm = &vmTable[i];
+				break;
+			}
+		}
+		if ( !vm ) {
+			Com_Printf( "vmprofile: no vm named %s\n", Cmd_Argv( 1 ) );
+			return;
+		}
+	}
+
+	if ( !vm ) {
 		return;
 	}
 
-	vm = lastVM;
+	Com_Printf( "%s: %i calls, %.3f msec, %.3f msec per call\n", vm->name, vm->callCount,
+		vm->callTime / 1000.0, vm->callCount ? vm->callTime / 1000.0 / vm->callCount : 0.0 );
+	vm->callTime = 0;
+	vm->callCount = 0;
 
 	if ( !vm->numSymbols ) {
 		return;
@@ -957,7 +1023,9 @@ void VM_VmInfo_f( void ) {
 			Com_Printf( "native\n" );
 			continue;
 		}
-		if ( vm->compiled ) {
+		if ( vm->optimized ) {
+			Com_Printf( "compiled on load, optimized\n" );
+		} else if ( vm->compiled ) {
 			Com_Printf( "compiled on load\n" );
 		} else {
 			Com_Printf( "interpreted\n" );
@@ -987,6 +1055,32 @@ void VM_LogSyscalls( int *args ) {
 		args[0], args[1], args[2], args[3], args[4] );
 }
 
+/*
+=================
+VM_CheckBlock
+
+Drops if a block a syscall was handed doesn't lie entirely within
+the current VM's data segment.  Native modules aren't sandboxed.
+=================
+*/
+void VM_CheckBlock( intptr_t intValue, size_t size, const char *name )
+{
+	unsigned int dataMask;
+
+	if ( !currentVM || currentVM->entryPoint || !size ) {
+		return;
+	}
+
+	dataMask = currentVM->dataMask;
+
+	if ( !intValue
+	|| (uintptr_t)intValue > dataMask
+	|| size > (size_t)dataMask + 1 - (uintptr_t)intValue )
+	{
+		Com_Error( ERR_DROP, "%s: block out of range!", name );
+	}
+}
+
 /*
 =================
 VM_BlockCopy
@@ -161,6 +161,7 @@ struct vm_s {
 	qboolean	currentlyInterpreting;
 
 	qboolean	compiled;
+	qboolean	optimized;			// compiled with the second tier
 	byte		*codeBase;
 	int			entryOfs;
 	int			codeLength;
@@ -178,6 +179,10 @@ struct vm_s {
 	struct vmSymbol_s	*symbols;
 
 	int			callLevel;		// counts recursive VM_Call
+	void		*callFrame;		// machine stack of the innermost VM_Call
+	void		*syscallFrame;	// and of the innermost syscall from compiled code
+	int64_t		callTime;		// usec spent in outermost VM_Calls, for vmprofile
+	int			callCount;
 	int			breakFunction;		// increment breakCount on function entry to this
 	int			breakCount;
 
@@ -195,9 +200,15 @@ int	VM_CallCompiled( vm_t *vm, int *args );
 void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header );
 int	VM_CallInterpreted( vm_t *vm, int *args );
 
+#define	MAX_VM		3
+extern	vm_t	vmTable[MAX_VM];
+
 vmSymbol_t *VM_ValueToFunctionSymbol( vm_t *vm, int value );
 int VM_SymbolToValue( vm_t *vm, const char *symbol );
 const char *VM_ValueToSymbol( vm_t *vm, int value );
+const char *VM_SymbolForCompiledPointer( vm_t *vm, const void *code );
+void VM_Prof_f( void );
+void VM_ProfileResolve( void );
 void VM_LogSyscalls( int *args );
 
 void VM_BlockCopy(unsigned int dest, unsigned int src, size_t n);
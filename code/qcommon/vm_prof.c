@@ -0,0 +1,574 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// vm_prof.c -- sampling profiler for compiled and native modules
+
+/*
+
+vmprof samples the interrupted program counter on a profiling timer.
+Compiled QVM code only keeps return addresses on the machine stack, so a
+sample that lands in it, or in a syscall made from it, is walked back to
+the VM_Call that entered the vm and named with the QVM symbols.  Native
+modules and the engine are named by the system.
+
+vmprof dump writes the samples as folded stacks, root first, which
+flame graph tools read directly:
+
+qagame;vmMain;G_RunFrame;G_RunThink 42
+
+The sample buffer is filled from a signal handler, so nothing is
+resolved or allocated until the dump, or until a vm is freed.
+
+*/
+
+#include "vm_local.h"
+
+#define	PROF_DEFAULT_HZ		1000
+#define	PROF_MAX_HZ			10000
+#define	PROF_MAX_FRAMES		64
+#define	PROF_BUFFER_WORDS	(1 << 18)		// frame counts and frames of all samples
+#define	PROF_MAX_STACK		(1 << 20)		// bytes between a sample and its VM_Call
+
+#define	PROF_ADDRESS_HASH	(1 << 16)
+#define	PROF_MAX_NAMES		8192
+#define	PROF_NAME_HASH		(PROF_MAX_NAMES * 2)
+
+#ifdef __GNUC__
+#define	PROF_ADD(x, n)		__sync_fetch_and_add( &(x), (n) )
+#else
+#define	PROF_ADD(x, n)		( ( (x) += (n) ) - (n) )	// Sys_StartProfiler fails there
+#endif
+
+typedef struct {
+	qboolean		running;
+	int				hz;
+
+	void			**buffer;		// per sample the frame count, then the frames leaf first
+	volatile int	used;			// words reserved, may run past the buffer
+	volatile int	dropped;
+	int				resolved;		// words of samples whose frames are names
+
+	char			**names;
+	int				numNames;
+	int				*nameHash;
+
+	int64_t			startTime;
+	int64_t			time;			// usec sampled
+} vmProf_t;
+
+typedef struct {
+	const void		*address;
+	int				name;
+} profAddress_t;
+
+typedef struct {
+	int				sample;			// buffer offset of the first sample with this stack
+	int				count;
+} profStack_t;
+
+static vmProf_t	prof;
+
+/*
+=================
+VM_ProfileIsCompiled
+=================
+*/
+static qboolean VM_ProfileIsCompiled( const vm_t *vm, const void *address ) {
+	const byte	*p = address;
+
+	return vm->compiled && !vm->dllHandle &&
+		p >= vm->codeBase + vm->entryOfs && p < vm->codeBase + vm->codeLength;
+}
+
+/*
+=================
+VM_ProfileIsVM
+
+Samples of compiled code have their vm as the root frame
+=================
+*/
+static qboolean VM_ProfileIsVM( const void *address ) {
+	return (const vm_t *)address >= vmTable && (const vm_t *)address < vmTable + MAX_VM;
+}
+
+/*
+=================
+VM_ProfileActiveVM
+
+The compiled vm running innermost on the stack of sp, if any
+=================
+*/
+static vm_t *VM_ProfileActiveVM( const byte *sp ) {
+	vm_t		*vm, *best;
+	const byte	*frame;
+	int			i;
+
+	best = NULL;
+	for ( i = 0 ; i < MAX_VM ; i++ ) {
+		vm = &vmTable[i];
+		frame = vm->callFrame;
+
+		if ( !vm->compiled || vm->dllHandle || !vm->callLevel || !frame ) {
+			continue;
+		}
+		// other threads sample on other stacks
+		if ( sp >= frame || frame - sp > PROF_MAX_STACK ) {
+			continue;
+		}
+		if ( !best || frame < (const byte *)best->callFrame ) {
+			best = vm;
+		}
+	}
+
+	return best;
+}
+
+/*
+=================
+VM_ProfileSample
+
+Called from the signal handler of the profiling timer, frames are the
+native return addresses the system could unwind, leaf first
+=================
+*/
+static void VM_ProfileSample( void *pc, void *sp, void **frames, int numFrames ) {
+	void	*sample[PROF_MAX_FRAMES];
+	void	**p, **top;
+	vm_t	*vm;
+	int		count, start, i;
+
+	if ( !numFrames ) {
+		frames = &pc;
+		numFrames = 1;
+	}
+
+	vm = VM_ProfileActiveVM( sp );
+	count = 0;
+
+	// the unwinder stops at the first frame in generated code
+	for ( i = 0 ; i < numFrames && count < PROF_MAX_FRAMES - 1 ; i++ ) {
+		if ( vm && (byte *)frames[i] >= vm->codeBase && (byte *)frames[i] < vm->codeBase + vm->codeLength ) {
+			break;
+		}
+		sample[count++] = frames[i];
+	}
+
+	if ( vm ) {
+		if ( VM_ProfileIsCompiled( vm, pc ) ) {
+			sample[count++] = pc;
+		}
+
+		// in a syscall, the frames below it may hold stale addresses
+		p = sp;
+		top = vm->callFrame;
+		if ( vm->syscallFrame && (void **)vm->syscallFrame > p && (void **)vm->syscallFrame < top ) {
+			p = vm->syscallFrame;
+		}
+
+		// anything on the stack pointing into the code is a return address,
+		// except the entry point VM_CallCompiled keeps in its frame
+		for ( ; p < top && count < PROF_MAX_FRAMES - 1 ; p++ ) {
+			if ( VM_ProfileIsCompiled( vm, *p ) && *p != vm->codeBase + vm->entryOfs ) {
+				sample[count++] = *p;
+			}
+		}
+
+		// the vm itself is the root
+		sample[count++] = vm;
+	}
+
+	start = PROF_ADD( prof.used, count + 1 );
+	if ( start + count + 1 > PROF_BUFFER_WORDS ) {
+		PROF_ADD( prof.dropped, 1 );
+		return;
+	}
+
+	for ( i = 0 ; i < count ; i++ ) {
+		prof.buffer[start + 1 + i] = sample[i];
+	}
+	// written last, the dump stops at a sample still being written
+	prof.buffer[start] = (void *)(intptr_t)count;
+}
+
+/*
+=================
+VM_ProfileFrameName
+=================
+*/
+static void VM_ProfileFrameName( const void *address, char *buf, int size ) {
+	vm_t	*vm;
+	int		i;
+
+	if ( VM_ProfileIsVM( address ) ) {
+		Q_strncpyz( buf, ( (const vm_t *)address )->name, size );
+		return;
+	}
+
+	for ( i = 0 ; i < MAX_VM ; i++ ) {
+		vm = &vmTable[i];
+
+		if ( vm->name[0] && VM_ProfileIsCompiled( vm, address ) ) {
+			Q_strncpyz( buf, VM_SymbolForCompiledPointer( vm, address ), size );
+			return;
+		}
+	}
+
+	if ( !Sys_AddressToSymbol( address, buf, size ) ) {
+		Com_sprintf( buf, size, "%p", address );
+	}
+}
+
+/*
+=================
+VM_ProfileHashString
+=================
+*/
+static unsigned VM_ProfileHashString( const char *s ) {
+	unsigned	hash = 0;
+
+	while ( *s ) {
+		hash = hash * 31 + (byte)*s++;
+	}
+
+	return hash;
+}
+
+/*
+=================
+VM_ProfileComplete
+
+End of the samples the handler has finished writing
+=================
+*/
+static int VM_ProfileComplete( int pos ) {
+	int		used, count;
+
+	used = prof.used < PROF_BUFFER_WORDS ? prof.used : PROF_BUFFER_WORDS;
+	for ( ; pos < used ; pos += count + 1 ) {
+		count = (intptr_t)prof.buffer[pos];
+		if ( count <= 0 || pos + 1 + count > used ) {
+			break;
+		}
+	}
+
+	return pos;
+}
+
+/*
+=================
+VM_ProfileName
+=================
+*/
+static int VM_ProfileName( const char *name ) {
+	int		n;
+
+	// different addresses in one function share the name
+	n = VM_ProfileHashString( name ) & ( PROF_NAME_HASH - 1 );
+	while ( prof.nameHash[n] >= 0 && strcmp( prof.names[prof.nameHash[n]], name ) ) {
+		n = ( n + 1 ) & ( PROF_NAME_HASH - 1 );
+	}
+
+	if ( prof.nameHash[n] < 0 ) {
+		if ( prof.numNames == PROF_MAX_NAMES ) {
+			return 0;
+		}
+		prof.names[prof.numNames] = CopyString( name );
+		prof.nameHash[n] = prof.numNames++;
+	}
+
+	return prof.nameHash[n];
+}
+
+/*
+=================
+VM_ProfileResolve
+
+Replaces the frames of the samples taken so far with indices into the
+names.  Compiled code goes away with its vm, so this is done before a
+vm is freed and before a dump.
+=================
+*/
+void VM_ProfileResolve( void ) {
+	profAddress_t	*addresses;
+	int				numAddresses, end, pos, count, i, h, name;
+	const void		*address;
+	char			buf[MAX_STRING_CHARS];
+
+	if ( !prof.buffer ) {
+		return;
+	}
+
+	end = VM_ProfileComplete( prof.resolved );
+	if ( end == prof.resolved ) {
+		return;
+	}
+
+	addresses = Z_Malloc( PROF_ADDRESS_HASH * sizeof( *addresses ) );
+	numAddresses = 0;
+
+	for ( pos = prof.resolved ; pos < end ; pos += count + 1 ) {
+		count = (intptr_t)prof.buffer[pos];
+
+		for ( i = 0 ; i < count ; i++ ) {
+			address = prof.buffer[pos + 1 + i];
+
+			// return addresses point behind the call
+			if ( i && !VM_ProfileIsVM( address ) ) {
+				address = (const byte *)address - 1;
+			}
+
+			h = ( (uintptr_t)address >> 2 ) & ( PROF_ADDRESS_HASH - 1 );
+			while ( addresses[h].address && addresses[h].address != address ) {
+				h = ( h + 1 ) & ( PROF_ADDRESS_HASH - 1 );
+			}
+
+			if ( addresses[h].address ) {
+				name = addresses[h].name;
+			} else {
+				VM_ProfileFrameName( address, buf, sizeof( buf ) );
+				name = VM_ProfileName( buf );
+
+				// keep the cache half empty so lookups end
+				if ( numAddresses < PROF_ADDRESS_HASH / 2 ) {
+					addresses[h].address = address;
+					addresses[h].name = name;
+					numAddresses++;
+				}
+			}
+
+			prof.buffer[pos + 1 + i] = (void *)(intptr_t)name;
+		}
+	}
+
+	prof.resolved = end;
+
+	Z_Free( addresses );
+}
+
+/*
+=================
+VM_ProfileSameStack
+=================
+*/
+static qboolean VM_ProfileSameStack( int a, int b ) {
+	int		i, count;
+
+	count = (intptr_t)prof.buffer[a];
+	if ( count != (intptr_t)prof.buffer[b] ) {
+		return qfalse;
+	}
+
+	for ( i = 1 ; i <= count ; i++ ) {
+		if ( prof.buffer[a + i] != prof.buffer[b + i] ) {
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+/*
+=================
+VM_ProfileDump
+=================
+*/
+static void VM_ProfileDump( const char *filename ) {
+	fileHandle_t	f;
+	profStack_t		*stacks;
+	char			*line;
+	int				pos, count, numSamples, numStacks;
+	int				tableSize, i, h;
+	unsigned		hash;
+
+	VM_ProfileResolve();
+
+	numSamples = 0;
+	for ( pos = 0 ; pos < prof.resolved ; pos += (intptr_t)prof.buffer[pos] + 1 ) {
+		numSamples++;
+	}
+
+	if ( !numSamples ) {
+		Com_Printf( "vmprof: no samples\n" );
+		return;
+	}
+
+	f = FS_FOpenFileWrite( filename );
+	if ( !f ) {
+		Com_Printf( "vmprof: couldn't open %s\n", filename );
+		return;
+	}
+
+	// merge the samples with identical stacks
+	for ( tableSize = 1 ; tableSize < numSamples * 2 ; tableSize <<= 1 ) {
+	}
+	stacks = Z_Malloc( tableSize * sizeof( *stacks ) );
+	numStacks = 0;
+
+	for ( pos = 0 ; pos < prof.resolved ; pos += count + 1 ) {
+		count = (intptr_t)prof.buffer[pos];
+
+		hash = count;
+		for ( i = 1 ; i <= count ; i++ ) {
+			hash = hash * 31 + (intptr_t)prof.buffer[pos + i];
+		}
+
+		h = hash & ( tableSize - 1 );
+		while ( stacks[h].count && !VM_ProfileSameStack( stacks[h].sample, pos ) ) {
+			h = ( h + 1 ) & ( tableSize - 1 );
+		}
+		if ( !stacks[h].count ) {
+			stacks[h].sample = pos;
+			numStacks++;
+		}
+		stacks[h].count++;
+	}
+
+	line = Z_Malloc( PROF_MAX_FRAMES * MAX_STRING_CHARS );
+
+	for ( h = 0 ; h < tableSize ; h++ ) {
+		if ( !stacks[h].count ) {
+			continue;
+		}
+
+		pos = stacks[h].sample;
+		count = (intptr_t)prof.buffer[pos];
+
+		line[0] = '\0';
+		for ( i = count ; i >= 1 ; i-- ) {
+			Q_strcat( line, PROF_MAX_FRAMES * MAX_STRING_CHARS, prof.names[(intptr_t)prof.buffer[pos + i]] );
+			Q_strcat( line, PROF_MAX_FRAMES * MAX_STRING_CHARS, i > 1 ? ";" : " " );
+		}
+		Q_strcat( line, PROF_MAX_FRAMES * MAX_STRING_CHARS, va( "%i\n", stacks[h].count ) );
+
+		FS_Write( line, strlen( line ), f );
+	}
+
+	FS_FCloseFile( f );
+
+	Com_Printf( "vmprof: %i samples, %i stacks, %i functions written to %s\n",
+		numSamples, numStacks, prof.numNames, filename );
+
+	Z_Free( line );
+	Z_Free( stacks );
+}
+
+/*
+=================
+VM_ProfileStart
+=================
+*/
+static void VM_ProfileStart( int hz ) {
+	int		i;
+
+	if ( prof.running ) {
+		Com_Printf( "vmprof: already running\n" );
+		return;
+	}
+
+	// samples of the last run are dropped
+	if ( !prof.buffer ) {
+		prof.buffer = Z_Malloc( PROF_BUFFER_WORDS * sizeof( *prof.buffer ) );
+		prof.names = Z_Malloc( PROF_MAX_NAMES * sizeof( *prof.names ) );
+		prof.nameHash = Z_Malloc( PROF_NAME_HASH * sizeof( *prof.nameHash ) );
+	} else {
+		Com_Memset( prof.buffer, 0, PROF_BUFFER_WORDS * sizeof( *prof.buffer ) );
+		for ( i = 0 ; i < prof.numNames ; i++ ) {
+			Z_Free( prof.names[i] );
+		}
+	}
+
+	for ( i = 0 ; i < PROF_NAME_HASH ; i++ ) {
+		prof.nameHash[i] = -1;
+	}
+	prof.numNames = 0;
+	VM_ProfileName( "[unnamed]" );
+
+	prof.used = 0;
+	prof.resolved = 0;
+	prof.dropped = 0;
+	prof.time = 0;
+	prof.hz = hz;
+
+	for ( i = 0 ; i < MAX_VM ; i++ ) {
+		if ( vmTable[i].name[0] && vmTable[i].compiled && !vmTable[i].symbols ) {
+			Com_Printf( "vmprof: no symbols for %s, load it with developer 1 to name its functions\n",
+				vmTable[i].name );
+		}
+	}
+
+	if ( !Sys_StartProfiler( hz, VM_ProfileSample ) ) {
+		Com_Printf( "vmprof: no profiling timer on this platform\n" );
+		return;
+	}
+
+	prof.running = qtrue;
+	prof.startTime = Sys_Microseconds();
+
+	Com_Printf( "vmprof: sampling at %i Hz\n", hz );
+}
+
+/*
+=================
+VM_ProfileStop
+=================
+*/
+static void VM_ProfileStop( void ) {
+	if ( !prof.running ) {
+		return;
+	}
+
+	Sys_StopProfiler();
+
+	prof.running = qfalse;
+	prof.time += Sys_Microseconds() - prof.startTime;
+
+	Com_Printf( "vmprof: stopped after %.1f seconds, %i samples dropped\n",
+		prof.time / 1000000.0, prof.dropped );
+}
+
+/*
+=================
+VM_Prof_f
+=================
+*/
+void VM_Prof_f( void ) {
+	const char	*cmd;
+	int			hz;
+
+	cmd = Cmd_Argv( 1 );
+
+	if ( !Q_stricmp( cmd, "start" ) ) {
+		hz = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : PROF_DEFAULT_HZ;
+		if ( hz <= 0 ) {
+			hz = PROF_DEFAULT_HZ;
+		} else if ( hz > PROF_MAX_HZ ) {
+			hz = PROF_MAX_HZ;
+		}
+		VM_ProfileStart( hz );
+	} else if ( !Q_stricmp( cmd, "stop" ) ) {
+		VM_ProfileStop();
+	} else if ( !Q_stricmp( cmd, "dump" ) ) {
+		VM_ProfileStop();
+		VM_ProfileDump( Cmd_Argc() > 2 ? Cmd_Argv( 2 ) : "vmprof.folded" );
+	} else {
+		Com_Printf( "usage: vmprof <start [hz] | stop | dump [file]>\n" );
+	}
+}
@@ -408,16 +408,22 @@ int vm_programStack;
 int *vm_opStackBase;
 uint8_t vm_opStackOfs;
 intptr_t vm_arg;
+void *vm_machineStack;		// stack pointer of the generated code, for vmprof
 
 static void DoSyscall(void)
 {
 	vm_t *savedVM;
+	void *oldSyscallFrame;
 
 	// save currentVM so as to allow for recursive VM entry
 	savedVM = currentVM;
 	// modify VM stack pointer for recursive VM entry
 	currentVM->programStack = vm_programStack - 4;
 
+	// vmprof walks the generated code from here
+	oldSyscallFrame = savedVM->syscallFrame;
+	savedVM->syscallFrame = vm_machineStack;
+
 	if(vm_syscallNum < 0)
 	{
 		int *data, *ret;
@@ -459,6 +465,7 @@ static void DoSyscall(void)
 		}
 	}
 
+	savedVM->syscallFrame = oldSyscallFrame;
 	currentVM = savedVM;
 }
 
@@ -518,6 +525,10 @@ int EmitCallDoSyscall(vm_t *vm)
 	EmitString("89 C8");			// mov eax, ecx
 	EmitString("A3");			// mov [0x12345678], eax
 	EmitPtr(&vm_arg);
+	// vm_machineStack
+	EmitRexString(0x48, "89 E0");		// mov eax, esp
+	EmitRexString(0x48, "A3");		// mov [0x12345678], eax
+	EmitPtr(&vm_machineStack);
 	
 	// align the stack pointer to a 16-byte-boundary
 	EmitString("55");			// push ebp
@@ -1064,6 +1075,1018 @@ qboolean ConstOptimize(vm_t *vm, int callProcOfsSyscall)
 	return qfalse;
 }
 
+#if idx64
+/*
+===============================================================================
+
+OPTIMIZING COMPILER
+
+vm_game 3 compiles with this second tier instead.  It walks the same
+instructions, but the values they push are kept on a compile time stack
+of registers and constants for as long as the code stays inside a basic
+block, so most values never go through the opStack in memory.  At jump
+targets, function entries, calls and jumps the compile time stack is
+flushed, so the code there sees the same state as the first tier: the
+values in the opStack, bl at the top.
+
+Calls to constant syscall numbers call DoSyscallDirect straight from the
+generated code, and sqrt is done inline.
+
+  r10d-r15d		opStack values kept in registers
+  eax, ecx, edx		scratch
+  xmm0, xmm1		scratch for floats
+
+===============================================================================
+*/
+
+#define	REG_EAX		0
+#define	REG_ECX		1
+#define	REG_EDX		2
+#define	REG_ESI		6
+#define	REG_R9		9
+#define	REG_FIRST	10		// r10d
+#define	REG_COUNT	6
+
+#define	VS_MAX		16		// deeper values are stored to the opStack
+
+typedef enum {
+	VS_CONST,
+	VS_REG
+} vsKind_t;
+
+typedef struct {
+	vsKind_t	kind;
+	int			value;		// constant or register number
+} vsEntry_t;
+
+static	vsEntry_t	vs[VS_MAX];		// compile time top of the opStack, vs[0] lowest
+static	int			vsDepth;
+static	int			vsRegsUsed;		// bit per register of the pool
+static	int			vsPushed;		// values pushed in the last pass
+static	int			vsStored;		// values of those that went through memory
+
+/*
+=================
+DoSyscallDirect
+
+Called straight from the code of the optimizing compiler, like DoSyscall
+for a negative vm_syscallNum
+=================
+*/
+static int DoSyscallDirect( int syscallNum, int programStack )
+{
+	vm_t *savedVM;
+	intptr_t args[MAX_VMSYSCALL_ARGS];
+	int *data, index, ret;
+	void *oldSyscallFrame;
+
+	savedVM = currentVM;
+	currentVM->programStack = programStack - 4;
+
+	oldSyscallFrame = savedVM->syscallFrame;
+	savedVM->syscallFrame = vm_machineStack;
+
+	data = (int *) (savedVM->dataBase + programStack + 4);
+
+	args[0] = ~syscallNum;
+	for(index = 1; index < ARRAY_LEN(args); index++)
+		args[index] = data[index];
+
+	ret = savedVM->systemCall(args);
+
+	savedVM->syscallFrame = oldSyscallFrame;
+	currentVM = savedVM;
+
+	return ret;
+}
+
+static void EmitRex(int w, int reg, int index, int base)
+{
+	int rex = 0x40 | (w << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+
+	if(rex != 0x40)
+		Emit1(rex);
+}
+
+static void EmitOpcode(int prefix, int opcode, int reg, int index, int base)
+{
+	if(prefix)
+		Emit1(prefix);
+	EmitRex(0, reg, index, base);
+	if(opcode > 0xFF)
+		Emit1(opcode >> 8);
+	Emit1(opcode & 0xFF);
+}
+
+// op reg, rm
+static void EmitRegOp(int prefix, int opcode, int reg, int rm)
+{
+	EmitOpcode(prefix, opcode, reg, 0, rm);
+	Emit1(0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+// op reg, dword ptr [edi + ebx * 4]
+static void EmitStackOp(int opcode, int reg)
+{
+	EmitOpcode(0, opcode, reg, 0, 0);
+	Emit1(0x04 | ((reg & 7) << 3));
+	Emit1(0x9F);
+}
+
+// op reg, [r9 + index]
+static void EmitDataOp(int prefix, int opcode, int reg, int index)
+{
+	EmitOpcode(prefix, opcode, reg, index, REG_R9);
+	Emit1(0x04 | ((reg & 7) << 3));
+	Emit1(((index & 7) << 3) | (REG_R9 & 7));
+}
+
+// op reg, [r9 + 0x12345678]
+static void EmitDataConstOp(int prefix, int opcode, int reg, int ofs)
+{
+	EmitOpcode(prefix, opcode, reg, 0, REG_R9);
+	Emit1(0x81 | ((reg & 7) << 3));
+	Emit4(ofs);
+}
+
+// op reg, 0x12345678 for the 81 / 83 group, ext is the operation
+static void EmitRegImm(int ext, int reg, int v)
+{
+	if(iss8(v))
+	{
+		EmitRegOp(0, 0x83, ext, reg);
+		Emit1(v);
+	}
+	else
+	{
+		EmitRegOp(0, 0x81, ext, reg);
+		Emit4(v);
+	}
+}
+
+// mov reg, 0x12345678
+static void EmitMovRegImm(int reg, int v)
+{
+	EmitRex(0, 0, 0, reg);
+	Emit1(0xB8 + (reg & 7));
+	Emit4(v);
+}
+
+// lea reg, [esi + 0x12345678]
+static void EmitLeaLocal(int reg, int v)
+{
+	EmitOpcode(0, 0x8D, reg, 0, REG_ESI);
+	Emit1(0x80 | ((reg & 7) << 3) | REG_ESI);
+	Emit4(v);
+}
+
+static void VsFreeReg(int reg)
+{
+	vsRegsUsed &= ~(1 << (reg - REG_FIRST));
+}
+
+/*
+=================
+VsStoreEntry
+
+Pushes an entry to the opStack in memory.  bl is bumped for every value
+so it wraps within the opStack like the first tier.
+=================
+*/
+static void VsStoreEntry(const vsEntry_t *e)
+{
+	STACK_PUSH(1);					// add bl, 1
+	if(e->kind == VS_CONST)
+	{
+		EmitString("C7 04 9F");			// mov dword ptr [edi + ebx * 4], 0x12345678
+		Emit4(e->value);
+	}
+	else
+	{
+		EmitStackOp(0x89, e->value);		// mov dword ptr [edi + ebx * 4], reg
+		VsFreeReg(e->value);
+	}
+	vsStored++;
+}
+
+/*
+=================
+VsSpill
+
+Stores the lowest entry to make room
+=================
+*/
+static void VsSpill(void)
+{
+	if(!vsDepth)
+	{
+		VMFREE_BUFFERS();
+		Com_Error(ERR_DROP, "VM_CompileX86: out of registers at offset %d", pc);
+	}
+
+	VsStoreEntry(&vs[0]);
+	memmove(vs, vs + 1, (vsDepth - 1) * sizeof(vs[0]));
+	vsDepth--;
+}
+
+/*
+=================
+VsFlush
+
+Stores all entries, the opStack in memory is complete afterwards
+=================
+*/
+static void VsFlush(void)
+{
+	int i;
+
+	for(i = 0; i < vsDepth; i++)
+		VsStoreEntry(&vs[i]);
+
+	vsDepth = 0;
+}
+
+static int VsAllocReg(void)
+{
+	int i;
+
+	while(1)
+	{
+		for(i = 0; i < REG_COUNT; i++)
+		{
+			if(!(vsRegsUsed & (1 << i)))
+			{
+				vsRegsUsed |= 1 << i;
+				return REG_FIRST + i;
+			}
+		}
+		VsSpill();
+	}
+}
+
+static void VsPush(vsKind_t kind, int value)
+{
+	if(vsDepth == VS_MAX)
+		VsSpill();
+
+	vs[vsDepth].kind = kind;
+	vs[vsDepth].value = value;
+	vsDepth++;
+	vsPushed++;
+}
+
+/*
+=================
+VsPop
+
+Pops the top entry, loading it from the opStack in memory when the
+compile time stack is empty
+=================
+*/
+static vsEntry_t VsPop(void)
+{
+	vsEntry_t e;
+
+	if(vsDepth)
+		return vs[--vsDepth];
+
+	e.kind = VS_REG;
+	e.value = VsAllocReg();
+	EmitStackOp(0x8B, e.value);			// mov reg, dword ptr [edi + ebx * 4]
+	STACK_POP(1);					// sub bl, 1
+
+	return e;
+}
+
+static int VsToReg(vsEntry_t e)
+{
+	int reg;
+
+	if(e.kind == VS_REG)
+		return e.value;
+
+	reg = VsAllocReg();
+	EmitMovRegImm(reg, e.value);
+
+	return reg;
+}
+
+static void VsRelease(vsEntry_t e)
+{
+	if(e.kind == VS_REG)
+		VsFreeReg(e.value);
+}
+
+static int VsFold(int op, int a, int b)
+{
+	switch(op)
+	{
+	case OP_ADD:
+		return (unsigned)a + (unsigned)b;
+	case OP_SUB:
+		return (unsigned)a - (unsigned)b;
+	case OP_MULI:
+	case OP_MULU:
+		return (unsigned)a * (unsigned)b;
+	case OP_BAND:
+		return a & b;
+	case OP_BOR:
+		return a | b;
+	case OP_BXOR:
+		return a ^ b;
+	case OP_LSH:
+		return (unsigned)a << (b & 31);
+	case OP_RSHI:
+		return a >> (b & 31);
+	case OP_RSHU:
+		return (unsigned)a >> (b & 31);
+	}
+
+	return 0;
+}
+
+/*
+=================
+VsIntegerOp
+
+add, sub, and, or, xor and mul, opcode is the reg to reg form and ext
+the group 1 operation for immediates, or -1 for imul
+=================
+*/
+static void VsIntegerOp(int op, int opcode, int ext)
+{
+	vsEntry_t a, b, t;
+	int ra;
+
+	b = VsPop();
+	a = VsPop();
+
+	if(a.kind == VS_CONST && b.kind == VS_CONST)
+	{
+		VsPush(VS_CONST, VsFold(op, a.value, b.value));
+		return;
+	}
+
+	if(a.kind == VS_CONST && op != OP_SUB)
+	{
+		t = a;
+		a = b;
+		b = t;
+	}
+
+	ra = VsToReg(a);
+	if(b.kind == VS_CONST)
+	{
+		if(ext >= 0)
+			EmitRegImm(ext, ra, b.value);
+		else if(iss8(b.value))
+		{
+			EmitRegOp(0, 0x6B, ra, ra);		// imul reg, reg, 0x12
+			Emit1(b.value);
+		}
+		else
+		{
+			EmitRegOp(0, 0x69, ra, ra);		// imul reg, reg, 0x12345678
+			Emit4(b.value);
+		}
+	}
+	else
+	{
+		if(ext >= 0)
+			EmitRegOp(0, opcode, b.value, ra);	// op ra, rb
+		else
+			EmitRegOp(0, 0x0FAF, ra, b.value);	// imul ra, rb
+		VsFreeReg(b.value);
+	}
+	VsPush(VS_REG, ra);
+}
+
+/*
+=================
+VsShiftOp
+
+ext is the group 2 operation
+=================
+*/
+static void VsShiftOp(int op, int ext)
+{
+	vsEntry_t a, b;
+	int ra;
+
+	b = VsPop();
+	a = VsPop();
+
+	if(a.kind == VS_CONST && b.kind == VS_CONST)
+	{
+		VsPush(VS_CONST, VsFold(op, a.value, b.value));
+		return;
+	}
+
+	ra = VsToReg(a);
+	if(b.kind == VS_CONST)
+	{
+		EmitRegOp(0, 0xC1, ext, ra);			// shift reg, 0x12
+		Emit1(b.value & 31);
+	}
+	else
+	{
+		EmitRegOp(0, 0x89, b.value, REG_ECX);		// mov ecx, rb
+		EmitRegOp(0, 0xD3, ext, ra);			// shift reg, cl
+		VsFreeReg(b.value);
+	}
+	VsPush(VS_REG, ra);
+}
+
+/*
+=================
+VsDivOp
+=================
+*/
+static void VsDivOp(int op)
+{
+	vsEntry_t a, b;
+	int rb, result;
+
+	b = VsPop();
+	a = VsPop();
+
+	if(a.kind == VS_CONST)
+		EmitMovRegImm(REG_EAX, a.value);		// mov eax, 0x12345678
+	else
+		EmitRegOp(0, 0x89, a.value, REG_EAX);		// mov eax, ra
+
+	if(b.kind == VS_CONST)
+	{
+		rb = REG_ECX;
+		EmitMovRegImm(REG_ECX, b.value);		// mov ecx, 0x12345678
+	}
+	else
+		rb = b.value;
+
+	if(op == OP_DIVI || op == OP_MODI)
+	{
+		EmitString("99");				// cdq
+		EmitRegOp(0, 0xF7, 7, rb);			// idiv rb
+	}
+	else
+	{
+		EmitString("31 D2");				// xor edx, edx
+		EmitRegOp(0, 0xF7, 6, rb);			// div rb
+	}
+
+	VsRelease(a);
+	VsRelease(b);
+
+	result = VsAllocReg();
+	if(op == OP_DIVI || op == OP_DIVU)
+		EmitRegOp(0, 0x89, REG_EAX, result);		// mov reg, eax
+	else
+		EmitRegOp(0, 0x89, REG_EDX, result);		// mov reg, edx
+	VsPush(VS_REG, result);
+}
+
+/*
+=================
+VsFloatOp
+
+opcode is the F3 0F xx operation
+=================
+*/
+static void VsFloatOp(int opcode)
+{
+	vsEntry_t a, b;
+	int ra, rb;
+
+	b = VsPop();
+	a = VsPop();
+
+	ra = VsToReg(a);
+	rb = VsToReg(b);
+
+	EmitRegOp(0x66, 0x0F6E, 0, ra);			// movd xmm0, ra
+	EmitRegOp(0x66, 0x0F6E, 1, rb);			// movd xmm1, rb
+	EmitRegOp(0xF3, opcode, 0, 1);			// op xmm0, xmm1
+	EmitRegOp(0x66, 0x0F7E, 0, ra);			// movd ra, xmm0
+
+	VsFreeReg(rb);
+	VsPush(VS_REG, ra);
+}
+
+/*
+=================
+VsLoad
+
+opcode loads reg from memory: mov, movzx word, movzx byte
+=================
+*/
+static void VsLoad(vm_t *vm, int opcode)
+{
+	vsEntry_t a;
+	int reg;
+
+	a = VsPop();
+
+	if(a.kind == VS_CONST)
+	{
+		reg = VsAllocReg();
+		EmitDataConstOp(0, opcode, reg, a.value & vm->dataMask);
+	}
+	else
+	{
+		reg = a.value;
+		EmitRegImm(4, reg, vm->dataMask);		// and reg, dataMask
+		EmitDataOp(0, opcode, reg, reg);
+	}
+	VsPush(VS_REG, reg);
+}
+
+/*
+=================
+VsStoreValue
+
+Stores v to [r9 + index], or to [r9 + ofs] when index is -1
+=================
+*/
+static void VsStoreValue(vsEntry_t v, int size, int index, int ofs)
+{
+	int prefix, opcode;
+
+	prefix = size == 2 ? 0x66 : 0;
+
+	if(v.kind == VS_CONST)
+		opcode = size == 1 ? 0xC6 : 0xC7;		// mov [mem], 0x12345678
+	else
+		opcode = size == 1 ? 0x88 : 0x89;		// mov [mem], reg
+
+	if(index < 0)
+		EmitDataConstOp(prefix, opcode, v.kind == VS_CONST ? 0 : v.value, ofs);
+	else
+		EmitDataOp(prefix, opcode, v.kind == VS_CONST ? 0 : v.value, index);
+
+	if(v.kind == VS_CONST)
+	{
+		if(size == 4)
+			Emit4(v.value);
+		else if(size == 2)
+			Emit2(v.value);
+		else
+			Emit1(v.value);
+	}
+}
+
+static void VsStore(vm_t *vm, int size)
+{
+	vsEntry_t a, v;
+
+	v = VsPop();
+	a = VsPop();
+
+	if(a.kind == VS_CONST)
+		VsStoreValue(v, size, -1, a.value & vm->dataMask);
+	else
+	{
+		EmitRegImm(4, a.value, vm->dataMask);		// and reg, dataMask
+		VsStoreValue(v, size, a.value, 0);
+	}
+
+	VsRelease(a);
+	VsRelease(v);
+}
+
+/*
+=================
+VsBranch
+
+Compares the two top values and jumps, the opStack is flushed in between
+=================
+*/
+static void VsBranch(vm_t *vm, int op)
+{
+	vsEntry_t a, b;
+	int ra, rb;
+
+	b = VsPop();
+	a = VsPop();
+	ra = VsToReg(a);
+
+	if(op >= OP_EQF)
+	{
+		if((op == OP_EQF || op == OP_NEF) && b.kind == VS_CONST && b.value == 0)
+		{
+			// floating point hack as in ConstOptimize
+			VsFlush();
+			EmitRegOp(0, 0xF7, 0, ra);		// test reg, 0x7FFFFFFF
+			Emit4(0x7FFFFFFF);
+			VsFreeReg(ra);
+			if(op == OP_EQF)
+				EmitJumpIns(vm, "0F 84", Constant4());	// je 0x12345678
+			else
+				EmitJumpIns(vm, "0F 85", Constant4());	// jne 0x12345678
+			return;
+		}
+
+		rb = VsToReg(b);
+		VsFlush();
+		EmitRegOp(0x66, 0x0F6E, 0, ra);			// movd xmm0, ra
+		EmitRegOp(0x66, 0x0F6E, 1, rb);			// movd xmm1, rb
+		EmitRegOp(0, 0x0F2E, 0, 1);			// ucomiss xmm0, xmm1
+		VsFreeReg(ra);
+		VsFreeReg(rb);
+
+		// unordered compares like the x87 code of the first tier
+		switch(op)
+		{
+		case OP_EQF:
+			EmitJumpIns(vm, "0F 84", Constant4());	// je 0x12345678
+		break;
+		case OP_NEF:
+			EmitJumpIns(vm, "0F 85", Constant4());	// jne 0x12345678
+		break;
+		case OP_LTF:
+			EmitJumpIns(vm, "0F 82", Constant4());	// jb 0x12345678
+		break;
+		case OP_LEF:
+			EmitJumpIns(vm, "0F 86", Constant4());	// jbe 0x12345678
+		break;
+		case OP_GTF:
+			EmitJumpIns(vm, "0F 87", Constant4());	// ja 0x12345678
+		break;
+		case OP_GEF:
+			EmitJumpIns(vm, "0F 83", Constant4());	// jae 0x12345678
+		break;
+		}
+		return;
+	}
+
+	VsFlush();
+	if(b.kind == VS_CONST)
+		EmitRegImm(7, ra, b.value);			// cmp reg, 0x12345678
+	else
+		EmitRegOp(0, 0x39, b.value, ra);		// cmp ra, rb
+	VsFreeReg(ra);
+	VsRelease(b);
+
+	EmitBranchConditions(vm, op);
+}
+
+/*
+=================
+EmitSyscallDirect
+
+Calls DoSyscallDirect with the C calling convention, the result is in eax
+=================
+*/
+static void EmitSyscallDirect(int syscallNum)
+{
+	EmitString("56");				// push rsi
+	EmitString("57");				// push rdi
+	EmitRexString(0x41, "50");			// push r8
+	EmitRexString(0x41, "51");			// push r9
+
+	EmitRexString(0x48, "89 E0");			// mov rax, rsp
+	EmitRexString(0x48, "A3");			// mov [0x12345678], rax
+	EmitPtr(&vm_machineStack);
+
+	// align the stack pointer to a 16-byte-boundary
+	EmitString("55");				// push rbp
+	EmitRexString(0x48, "89 E5");			// mov rbp, rsp
+	EmitRexString(0x48, "83 E4 F0");		// and rsp, 0xFFFFFFF0
+
+#ifdef _WIN32
+	EmitRexString(0x48, "83 EC 20");		// sub rsp, 32
+	EmitString("89 F2");				// mov edx, esi
+	EmitString("B9");				// mov ecx, syscallNum
+	Emit4(syscallNum);
+#else
+	EmitString("BF");				// mov edi, syscallNum
+	Emit4(syscallNum);
+#endif
+
+	EmitRexString(0x48, "B8");			// mov rax, DoSyscallDirect
+	EmitPtr(DoSyscallDirect);
+	EmitString("FF D0");				// call rax
+
+	EmitRexString(0x48, "89 EC");			// mov rsp, rbp
+	EmitString("5D");				// pop rbp
+
+	EmitRexString(0x41, "59");			// pop r9
+	EmitRexString(0x41, "58");			// pop r8
+	EmitString("5F");				// pop rdi
+	EmitString("5E");				// pop rsi
+}
+
+/*
+=================
+VsCall
+=================
+*/
+static void VsCall(vm_t *vm, int callProcOfs)
+{
+	vsEntry_t a;
+	int reg;
+
+	if(!vsDepth || vs[vsDepth - 1].kind != VS_CONST)
+	{
+		VsFlush();
+		EmitCallRel(vm, callProcOfs);
+		return;
+	}
+
+	a = VsPop();
+	VsFlush();
+
+	if(a.value >= 0)
+	{
+		EmitCallIns(vm, a.value);
+		return;
+	}
+
+	reg = VsAllocReg();
+
+	if(a.value == ~TRAP_SQRT)
+	{
+		EmitString("8D 46 08");				// lea eax, [esi + 8]
+		EmitRegImm(4, REG_EAX, vm->dataMask);		// and eax, dataMask
+		EmitDataOp(0x66, 0x0F6E, 0, REG_EAX);		// movd xmm0, [r9 + eax]
+		EmitRegOp(0xF3, 0x0F51, 0, 0);			// sqrtss xmm0, xmm0
+		EmitRegOp(0x66, 0x0F7E, 0, reg);		// movd reg, xmm0
+	}
+	else
+	{
+		EmitSyscallDirect(a.value);
+		EmitRegOp(0, 0x89, REG_EAX, reg);		// mov reg, eax
+	}
+
+	VsPush(VS_REG, reg);
+}
+
+/*
+=================
+VM_CompileOptimized
+=================
+*/
+static void VM_CompileOptimized(vm_t *vm, vmHeader_t *header, int maxLength, int callProcOfs, int callDoSyscallOfs)
+{
+	vsEntry_t a;
+	int op, v, reg;
+
+	for(pass = 0; pass < 3; pass++)
+	{
+		pc = 0;
+		instruction = 0;
+		compiledOfs = vm->entryOfs;
+
+		vsDepth = 0;
+		vsRegsUsed = 0;
+		vsPushed = 0;
+		vsStored = 0;
+
+		while(instruction < header->instructionCount)
+		{
+			if(compiledOfs > maxLength - 256)
+			{
+				VMFREE_BUFFERS();
+				Com_Error(ERR_DROP, "VM_CompileX86: maxLength exceeded");
+			}
+
+			if(pc > header->codeLength)
+			{
+				VMFREE_BUFFERS();
+				Com_Error(ERR_DROP, "VM_CompileX86: pc > header->codeLength");
+			}
+
+			op = code[pc];
+			pc++;
+
+			// jumps and calls land with everything in the opStack
+			if(jused[instruction] || op == OP_ENTER)
+				VsFlush();
+
+			vm->instructionPointers[instruction] = compiledOfs;
+			instruction++;
+
+			switch(op)
+			{
+			case 0:
+				break;
+			case OP_BREAK:
+				VsFlush();
+				EmitString("CC");				// int 3
+				break;
+			case OP_ENTER:
+				EmitString("81 EE");				// sub esi, 0x12345678
+				Emit4(Constant4());
+				break;
+			case OP_LEAVE:
+				v = Constant4();
+				VsFlush();
+				EmitString("81 C6");				// add esi, 0x12345678
+				Emit4(v);
+				EmitString("C3");				// ret
+				break;
+			case OP_CALL:
+				VsCall(vm, callProcOfs);
+				break;
+			case OP_PUSH:
+				VsPush(VS_CONST, 0);
+				break;
+			case OP_POP:
+				if(vsDepth)
+					VsRelease(vs[--vsDepth]);
+				else
+					STACK_POP(1);				// sub bl, 1
+				break;
+			case OP_CONST:
+				VsPush(VS_CONST, Constant4());
+				break;
+			case OP_LOCAL:
+				reg = VsAllocReg();
+				EmitLeaLocal(reg, Constant4());			// lea reg, [esi + 0x12345678]
+				VsPush(VS_REG, reg);
+				break;
+			case OP_JUMP:
+				a = VsPop();
+				VsFlush();
+				if(a.kind == VS_CONST)
+				{
+					EmitJumpIns(vm, "E9", a.value);		// jmp 0x12345678
+					break;
+				}
+				EmitRegOp(0, 0x89, a.value, REG_EAX);		// mov eax, reg
+				VsFreeReg(a.value);
+				EmitString("3D");				// cmp eax, vm->instructionCount
+				Emit4(vm->instructionCount);
+				EmitString("73 04");				// jae +4
+				EmitRexString(0x49, "FF 24 C0");		// jmp qword ptr [r8 + eax * 8]
+				EmitCallErrJump(vm, callDoSyscallOfs);
+				break;
+
+			case OP_EQ:
+			case OP_NE:
+			case OP_LTI:
+			case OP_LEI:
+			case OP_GTI:
+			case OP_GEI:
+			case OP_LTU:
+			case OP_LEU:
+			case OP_GTU:
+			case OP_GEU:
+			case OP_EQF:
+			case OP_NEF:
+			case OP_LTF:
+			case OP_LEF:
+			case OP_GTF:
+			case OP_GEF:
+				VsBranch(vm, op);
+				break;
+
+			case OP_LOAD1:
+				VsLoad(vm, 0x0FB6);				// movzx reg, byte ptr [r9 + reg]
+				break;
+			case OP_LOAD2:
+				VsLoad(vm, 0x0FB7);				// movzx reg, word ptr [r9 + reg]
+				break;
+			case OP_LOAD4:
+				VsLoad(vm, 0x8B);				// mov reg, dword ptr [r9 + reg]
+				break;
+			case OP_STORE1:
+				VsStore(vm, 1);
+				break;
+			case OP_STORE2:
+				VsStore(vm, 2);
+				break;
+			case OP_STORE4:
+				VsStore(vm, 4);
+				break;
+			case OP_ARG:
+				v = Constant1() & 0xFF;
+				a = VsPop();
+				EmitString("8D 86");				// lea eax, [esi + 0x12345678]
+				Emit4(v);
+				EmitRegImm(4, REG_EAX, vm->dataMask);		// and eax, dataMask
+				VsStoreValue(a, 4, REG_EAX, 0);			// mov dword ptr [r9 + eax], a
+				VsRelease(a);
+				break;
+			case OP_BLOCK_COPY:
+				VsFlush();
+				EmitString("B8");				// mov eax, 0x12345678
+				Emit4(VM_BLOCK_COPY);
+				EmitString("B9");				// mov ecx, 0x12345678
+				Emit4(Constant4());
+				EmitCallRel(vm, callDoSyscallOfs);
+				STACK_POP(2);					// sub bl, 2
+				break;
+
+			case OP_SEX8:
+			case OP_SEX16:
+				a = VsPop();
+				if(a.kind == VS_CONST)
+				{
+					VsPush(VS_CONST, op == OP_SEX8 ? (signed char) a.value : (short) a.value);
+					break;
+				}
+				// movsx reg, byte / word
+				EmitRegOp(0, op == OP_SEX8 ? 0x0FBE : 0x0FBF, a.value, a.value);
+				VsPush(VS_REG, a.value);
+				break;
+			case OP_NEGI:
+			case OP_BCOM:
+			case OP_NEGF:
+				a = VsPop();
+				if(a.kind == VS_CONST)
+				{
+					if(op == OP_NEGI)
+						v = -(unsigned) a.value;
+					else if(op == OP_BCOM)
+						v = ~a.value;
+					else
+						v = a.value ^ 0x80000000;
+					VsPush(VS_CONST, v);
+					break;
+				}
+				if(op == OP_NEGI)
+					EmitRegOp(0, 0xF7, 3, a.value);		// neg reg
+				else if(op == OP_BCOM)
+					EmitRegOp(0, 0xF7, 2, a.value);		// not reg
+				else
+				{
+					EmitRegOp(0, 0x81, 6, a.value);		// xor reg, 0x80000000
+					Emit4(0x80000000);
+				}
+				VsPush(VS_REG, a.value);
+				break;
+
+			case OP_ADD:
+				VsIntegerOp(op, 0x01, 0);
+				break;
+			case OP_SUB:
+				VsIntegerOp(op, 0x29, 5);
+				break;
+			case OP_MULI:
+			case OP_MULU:
+				VsIntegerOp(op, 0, -1);
+				break;
+			case OP_BAND:
+				VsIntegerOp(op, 0x21, 4);
+				break;
+			case OP_BOR:
+				VsIntegerOp(op, 0x09, 1);
+				break;
+			case OP_BXOR:
+				VsIntegerOp(op, 0x31, 6);
+				break;
+			case OP_DIVI:
+			case OP_DIVU:
+			case OP_MODI:
+			case OP_MODU:
+				VsDivOp(op);
+				break;
+			case OP_LSH:
+				VsShiftOp(op, 4);
+				break;
+			case OP_RSHI:
+				VsShiftOp(op, 7);
+				break;
+			case OP_RSHU:
+				VsShiftOp(op, 5);
+				break;
+
+			case OP_ADDF:
+				VsFloatOp(0x0F58);				// addss
+				break;
+			case OP_SUBF:
+				VsFloatOp(0x0F5C);				// subss
+				break;
+			case OP_MULF:
+				VsFloatOp(0x0F59);				// mulss
+				break;
+			case OP_DIVF:
+				VsFloatOp(0x0F5E);				// divss
+				break;
+			case OP_CVIF:
+				reg = VsToReg(VsPop());
+				EmitRegOp(0xF3, 0x0F2A, 0, reg);		// cvtsi2ss xmm0, reg
+				EmitRegOp(0x66, 0x0F7E, 0, reg);		// movd reg, xmm0
+				VsPush(VS_REG, reg);
+				break;
+			case OP_CVFI:
+				reg = VsToReg(VsPop());
+				EmitRegOp(0x66, 0x0F6E, 0, reg);		// movd xmm0, reg
+				EmitRegOp(0xF3, 0x0F2C, reg, 0);		// cvttss2si reg, xmm0
+				VsPush(VS_REG, reg);
+				break;
+
+			default:
+				VMFREE_BUFFERS();
+				Com_Error(ERR_DROP, "VM_CompileX86: bad opcode %i at offset %i", op, pc);
+			}
+		}
+
+		VsFlush();
+	}
+}
+#endif
+
 /*
 =================
 VM_Compile
@@ -1079,8 +2102,20 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 
 	jusedSize = header->instructionCount + 2;
 
+#if idx64
+	// the optimizing compiler needs indirect jumps to land on known targets
+	if(vm->optimized && !vm->jumpTableTargets)
+	{
+		Com_Printf("VM file %s has no jump table targets, not optimizing\n", vm->name);
+		vm->optimized = qfalse;
+	}
+#endif
+
 	// allocate a very large temp buffer, we will shrink it later
-	maxLength = header->codeLength * 8 + 64;
+	if(vm->optimized)
+		maxLength = header->codeLength * 24 + 512;
+	else
+		maxLength = header->codeLength * 8 + 64;
 	buf = Z_Malloc(maxLength);
 	jused = Z_Malloc(jusedSize);
 	code = Z_Malloc(header->codeLength+32);
@@ -1109,6 +2144,11 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 	callProcOfsSyscall = EmitCallProcedure(vm, callDoSyscallOfs);
 	vm->entryOfs = compiledOfs;
 
+#if idx64
+	if(vm->optimized)
+		VM_CompileOptimized(vm, header, maxLength, callProcOfs, callDoSyscallOfs);
+	else
+#endif
 	for(pass=0; pass < 3; pass++) {
 	oc0 = -23423;
 	oc1 = -234354;
@@ -1682,6 +2722,14 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 	Z_Free( code );
 	Z_Free( buf );
 	Z_Free( jused );
+#if idx64
+	if(vm->optimized)
+	{
+		Com_Printf("VM file %s compiled to %i bytes of code, optimized, %i%% of opStack values kept in registers\n",
+			vm->name, compiledOfs, vsPushed ? 100 - vsStored * 100 / vsPushed : 0);
+	}
+	else
+#endif
 	Com_Printf( "VM file %s compiled to %i bytes of code\n", vm->name, compiledOfs );
 
 	vm->destroy = VM_Destroy_Compiled;
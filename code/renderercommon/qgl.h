@@ -105,6 +105,7 @@ extern void (APIENTRYP qglUnlockArraysEXT) (void);
 	GLE(void, ClearDepth, GLclampd depth) \
 	GLE(void, DepthRange, GLclampd near_val, GLclampd far_val) \
 	GLE(void, DrawBuffer, GLenum mode) \
+	GLE(void, GetTexImage, GLenum target, GLint level, GLenum format, GLenum type, GLvoid *pixels) \
 	GLE(void, PolygonMode, GLenum face, GLenum mode) \
 
 // OpenGL 1.0/1.1 but not OpenGL 3.2 core profile or OpenGL ES 1.x
@@ -140,6 +141,10 @@ extern void (APIENTRYP qglUnlockArraysEXT) (void);
 	GLE(void, CompressedTexImage2D, GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data) \
 	GLE(void, CompressedTexSubImage2D, GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data) \
 
+// OpenGL 1.3 but not OpenGL ES 2.0
+#define QGL_DESKTOP_1_3_PROCS \
+	GLE(void, GetCompressedTexImage, GLenum target, GLint level, void *img) \
+
 // GL_ARB_occlusion_query, built-in to OpenGL 1.5 but not OpenGL ES 2.0
 #define QGL_ARB_occlusion_query_PROCS \
 	GLE(void, GenQueries, GLsizei n, GLuint *ids) \
@@ -260,6 +265,7 @@ extern void (APIENTRYP qglUnlockArraysEXT) (void);
 	GLE(void, GenerateMipmap, GLenum target) \
 	GLE(void, BlitFramebuffer, GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) \
 	GLE(void, RenderbufferStorageMultisample, GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) \
+	GLE(void, GetFramebufferAttachmentParameteriv, GLenum target, GLenum attachment, GLenum pname, GLint *params) \
 
 // GL_ARB_vertex_array_object, built-in to OpenGL 3.0
 #define QGL_ARB_vertex_array_object_PROCS \
@@ -343,6 +349,7 @@ QGL_DESKTOP_1_1_FIXED_FUNCTION_PROCS;
 QGL_ES_1_1_PROCS;
 QGL_ES_1_1_FIXED_FUNCTION_PROCS;
 QGL_1_3_PROCS;
+QGL_DESKTOP_1_3_PROCS;
 QGL_1_5_PROCS;
 QGL_2_0_PROCS;
 QGL_3_0_PROCS;
@@ -71,6 +71,11 @@ typedef struct image_s {
 #define LIGHTMAP_NONE       -1
 
 extern	refimport_t		ri;
+
+// the engine's PROFILE_BEGIN / PROFILE_END through the refimport
+#define	R_PROFILE_BEGIN( zone )	do { if ( *ri.profiling ) ri.ProfileBegin( zone ); } while ( 0 )
+#define	R_PROFILE_END( zone )	do { if ( *ri.profiling ) ri.ProfileEnd( zone ); } while ( 0 )
+
 extern glconfig_t	glConfig;		// outside of TR since it shouldn't be cleared during ref re-init
 
 // These variables should live inside glConfig but can't because of
@@ -148,6 +153,30 @@ void R_LoadPCX( const char *name, byte **pic, int *width, int *height );
 void R_LoadPNG( const char *name, byte **pic, int *width, int *height );
 void R_LoadTGA( const char *name, byte **pic, int *width, int *height );
 
+/*
+The decoders behind R_LoadJPG and R_LoadTGA work on a file that was
+already read into memory, and touch nothing but the buffer and the
+allocator they are given, so they can run on job threads.  They
+return qfalse for a file the loader would drop the game over, with
+the reason in message.  A file that merely fails to decode leaves
+pic NULL, and a warning may be left in message either way.
+*/
+typedef struct {
+	const char	*name;
+	const byte	*buffer;
+	int			length;
+
+	void		*(*alloc)( int size );
+	void		(*free)( void *ptr );
+
+	byte		*pic;
+	int			width, height;
+	char		message[256];
+} imageDecode_t;
+
+qboolean R_DecodeJPG( imageDecode_t *d );
+qboolean R_DecodeTGA( imageDecode_t *d );
+
 /*
 ====================================================================
 
@@ -167,5 +196,16 @@ void		GLimp_SetGamma( unsigned char red[256],
 		unsigned char green[256],
 		unsigned char blue[256] );
 
+void		GLimp_CheckFullscreen( void );
+
+// r_smp: the back end runs on a thread of its own, the GL context
+// stays with it unless the front end asks for it back
+qboolean	GLimp_SpawnRenderThread( void (*function)( void ) );
+void		GLimp_ShutdownRenderThread( void );
+void		*GLimp_RendererSleep( void );
+void		GLimp_FrontEndSleep( void );
+void		GLimp_WakeRenderer( void *data );
+void		GLimp_AcquireContext( void );
+
 
 #endif
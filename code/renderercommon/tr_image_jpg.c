@@ -50,6 +50,8 @@ typedef struct q_jpeg_error_mgr_s
   struct jpeg_error_mgr pub;  /* "public" fields */
 
   jmp_buf setjmp_buffer;  /* for return to caller */
+
+  imageDecode_t *decode;  /* messages go to decode->message */
 } q_jpeg_error_mgr_t;
 
 static void R_JPGErrorExit(j_common_ptr cinfo)
@@ -61,7 +63,9 @@ static void R_JPGErrorExit(j_common_ptr cinfo)
   
   (*cinfo->err->format_message) (cinfo, buffer);
 
-  ri.Printf(PRINT_ALL, "Error: %s", buffer);
+  /* Append the filename to the error for easier debugging */
+  Com_sprintf(jerr->decode->message, sizeof(jerr->decode->message), "Error: %s, loading file %s",
+    buffer, jerr->decode->name);
 
   /* Return control to the setjmp point */
   longjmp(jerr->setjmp_buffer, 1);
@@ -70,15 +74,22 @@ static void R_JPGErrorExit(j_common_ptr cinfo)
 static void R_JPGOutputMessage(j_common_ptr cinfo)
 {
   char buffer[JMSG_LENGTH_MAX];
+  q_jpeg_error_mgr_t *jerr = (q_jpeg_error_mgr_t *)cinfo->err;
   
   /* Create the message */
   (*cinfo->err->format_message) (cinfo, buffer);
   
-  /* Send it to stderr, adding a newline */
-  ri.Printf(PRINT_ALL, "%s\n", buffer);
+  /* Keep the first one, the caller prints it */
+  if (!jerr->decode->message[0])
+    Q_strncpyz(jerr->decode->message, buffer, sizeof(jerr->decode->message));
 }
 
-void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *height)
+/*
+=============
+R_DecodeJPG
+=============
+*/
+qboolean R_DecodeJPG(imageDecode_t *d)
 {
   /* This struct contains the JPEG decompression parameters and pointers to
    * working space (which is allocated as needed by the JPEG library).
@@ -103,23 +114,11 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
   unsigned int pixelcount, memcount;
   unsigned int sindex, dindex;
   byte *out;
-  int len;
-	union {
-		byte *b;
-		void *v;
-	} fbuffer;
   byte  *buf;
 
-  /* In this example we want to open the input file before doing anything else,
-   * so that the setjmp() error recovery below can assume the file is open.
-   * VERY IMPORTANT: use "b" option to fopen() if you are on a machine that
-   * requires it in order to read binary files.
-   */
-
-  len = ri.FS_ReadFile ( ( char * ) filename, &fbuffer.v);
-  if (!fbuffer.b || len < 0) {
-	return;
-  }
+  d->pic = NULL;
+  d->width = 0;
+  d->height = 0;
 
   /* Step 1: allocate and initialize JPEG decompression object */
 
@@ -131,6 +130,7 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
   cinfo.err = jpeg_std_error(&jerr.pub);
   cinfo.err->error_exit = R_JPGErrorExit;
   cinfo.err->output_message = R_JPGOutputMessage;
+  jerr.decode = d;
 
   /* Establish the setjmp return context for R_JPGErrorExit to use. */
   if (setjmp(jerr.setjmp_buffer))
@@ -139,11 +139,15 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
      * We need to clean up the JPEG object, close the input file, and return.
      */
     jpeg_destroy_decompress(&cinfo);
-    ri.FS_FreeFile(fbuffer.v);
 
-    /* Append the filename to the error for easier debugging */
-    ri.Printf(PRINT_ALL, ", loading file %s\n", filename);
-    return;
+    /* d->pic is set as soon as the output buffer exists */
+    if (d->pic) {
+      d->free(d->pic);
+      d->pic = NULL;
+    }
+    d->width = 0;
+    d->height = 0;
+    return qtrue;
   }
 
   /* Now we can initialize the JPEG decompression object. */
@@ -151,7 +155,7 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
 
   /* Step 2: specify data source (eg, a file) */
 
-  jpeg_mem_src(&cinfo, fbuffer.b, len);
+  jpeg_mem_src(&cinfo, (unsigned char *)d->buffer, d->length);
 
   /* Step 3: read file parameters with jpeg_read_header() */
 
@@ -192,21 +196,28 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
       || pixelcount > 0x1FFFFFFF || cinfo.output_components != 3
     )
   {
+    Com_sprintf(d->message, sizeof(d->message), "LoadJPG: %s has an invalid image format: %dx%d*4=%d, components: %d", d->name,
+		    cinfo.output_width, cinfo.output_height, pixelcount * 4, cinfo.output_components);
+
     // Free the memory to make sure we don't leak memory
-    ri.FS_FreeFile (fbuffer.v);
     jpeg_destroy_decompress(&cinfo);
-  
-    ri.Error(ERR_DROP, "LoadJPG: %s has an invalid image format: %dx%d*4=%d, components: %d", filename,
-		    cinfo.output_width, cinfo.output_height, pixelcount * 4, cinfo.output_components);
+    return qfalse;
   }
 
   memcount = pixelcount * 4;
   row_stride = cinfo.output_width * cinfo.output_components;
 
-  out = ri.Malloc(memcount);
+  out = d->alloc(memcount);
+  if (!out)
+  {
+    Com_sprintf(d->message, sizeof(d->message), "LoadJPG: out of memory for %s", d->name);
+    jpeg_destroy_decompress(&cinfo);
+    return qfalse;
+  }
+  d->pic = out;
 
-  *width = cinfo.output_width;
-  *height = cinfo.output_height;
+  d->width = cinfo.output_width;
+  d->height = cinfo.output_height;
 
   /* Step 6: while (scan lines remain to be read) */
   /*           jpeg_read_scanlines(...); */
@@ -238,8 +249,6 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
     buf[--dindex] = buf[--sindex];
   } while(sindex);
 
-  *pic = out;
-
   /* Step 7: Finish decompression */
 
   jpeg_finish_decompress(&cinfo);
@@ -252,18 +261,54 @@ void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *heigh
   /* This is an important step since it will release a good deal of memory. */
   jpeg_destroy_decompress(&cinfo);
 
-  /* After finish_decompress, we can close the input file.
-   * Here we postpone it until after no more JPEG errors are possible,
-   * so as to simplify the setjmp error logic above.  (Actually, I don't
-   * think that jpeg_destroy can do an error exit, but why assume anything...)
-   */
-  ri.FS_FreeFile (fbuffer.v);
-
   /* At this point you may want to check to see whether any corrupt-data
    * warnings occurred (test whether jerr.pub.num_warnings is nonzero).
    */
 
   /* And we're done! */
+  return qtrue;
+}
+
+/*
+=============
+R_LoadJPG
+=============
+*/
+void R_LoadJPG(const char *filename, unsigned char **pic, int *width, int *height)
+{
+  imageDecode_t d;
+	union {
+		byte *b;
+		void *v;
+	} fbuffer;
+  qboolean ok;
+
+  *pic = NULL;
+  *width = 0;
+  *height = 0;
+
+  Com_Memset(&d, 0, sizeof(d));
+  d.length = ri.FS_ReadFile ( ( char * ) filename, &fbuffer.v);
+  if (!fbuffer.b || d.length < 0) {
+	return;
+  }
+
+  d.name = filename;
+  d.buffer = fbuffer.b;
+  d.alloc = ri.Malloc;
+  d.free = ri.Free;
+
+  ok = R_DecodeJPG(&d);
+  ri.FS_FreeFile (fbuffer.v);
+
+  if (!ok)
+    ri.Error(ERR_DROP, "%s", d.message);
+  if (d.message[0])
+    ri.Printf(PRINT_ALL, "%s\n", d.message);
+
+  *pic = d.pic;
+  *width = d.width;
+  *height = d.height;
 }
 
 
@@ -38,43 +38,35 @@ typedef struct _TargaHeader {
 	unsigned char	pixel_size, attributes;
 } TargaHeader;
 
-void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
+/*
+=============
+R_DecodeTGA
+=============
+*/
+qboolean R_DecodeTGA( imageDecode_t *d )
 {
 	unsigned	columns, rows, numPixels;
 	byte	*pixbuf;
 	int	row, column;
-	byte	*buf_p;
-	byte	*end;
-	union {
-		byte *b;
-		void *v;
-	} buffer;
+	const byte	*buf_p;
+	const byte	*end;
+	const char	*name = d->name;
 	TargaHeader	targa_header;
-	byte		*targa_rgba;
-	int length;
+	byte		*targa_rgba = NULL;
+	int length = d->length;
 
-	*pic = NULL;
-
-	if(width)
-		*width = 0;
-	if(height)
-		*height = 0;
-
-	//
-	// load the file
-	//
-	length = ri.FS_ReadFile ( ( char * ) name, &buffer.v);
-	if (!buffer.b || length < 0) {
-		return;
-	}
+	d->pic = NULL;
+	d->width = 0;
+	d->height = 0;
 
 	if(length < 18)
 	{
-		ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
+		Com_sprintf( d->message, sizeof( d->message ), "LoadTGA: header too short (%s)", name );
+		return qfalse;
 	}
 
-	buf_p = buffer.b;
-	end = buffer.b + length;
+	buf_p = d->buffer;
+	end = d->buffer + length;
 
 	targa_header.id_length = buf_p[0];
 	targa_header.colormap_type = buf_p[1];
@@ -103,17 +95,20 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 		&& targa_header.image_type!=10
 		&& targa_header.image_type != 3 ) 
 	{
-		ri.Error (ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported");
+		Com_sprintf( d->message, sizeof( d->message ), "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported" );
+		return qfalse;
 	}
 
 	if ( targa_header.colormap_type != 0 )
 	{
-		ri.Error( ERR_DROP, "LoadTGA: colormaps not supported" );
+		Com_sprintf( d->message, sizeof( d->message ), "LoadTGA: colormaps not supported" );
+		return qfalse;
 	}
 
 	if ( ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 ) && targa_header.image_type != 3 )
 	{
-		ri.Error (ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)");
+		Com_sprintf( d->message, sizeof( d->message ), "LoadTGA: Only 32 or 24 bit images supported (no colormaps)" );
+		return qfalse;
 	}
 
 	columns = targa_header.width;
@@ -122,16 +117,25 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 
 	if(!columns || !rows || numPixels > 0x7FFFFFFF || numPixels / columns / 4 != rows)
 	{
-		ri.Error (ERR_DROP, "LoadTGA: %s has an invalid image size", name);
+		Com_sprintf( d->message, sizeof( d->message ), "LoadTGA: %s has an invalid image size", name );
+		return qfalse;
 	}
 
 
-	targa_rgba = ri.Malloc (numPixels);
+	targa_rgba = d->alloc (numPixels);
+	if (!targa_rgba)
+	{
+		Com_sprintf( d->message, sizeof( d->message ), "LoadTGA: out of memory for %s", name );
+		return qfalse;
+	}
 
 	if (targa_header.id_length != 0)
 	{
 		if (buf_p + targa_header.id_length > end)
-			ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
+		{
+			Com_sprintf( d->message, sizeof( d->message ), "LoadTGA: header too short (%s)", name );
+			goto fail;
+		}
 
 		buf_p += targa_header.id_length;  // skip TARGA image comment
 	}
@@ -139,9 +143,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 	if ( targa_header.image_type==2 || targa_header.image_type == 3 )
 	{ 
 		if(buf_p + columns*rows*targa_header.pixel_size/8 > end)
-		{
-			ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
-		}
+			goto truncated;
 
 		// Uncompressed RGB or gray scale image
 		for(row=rows-1; row>=0; row--) 
@@ -183,7 +185,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 					*pixbuf++ = alphabyte;
 					break;
 				default:
-					ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+					goto badPixelSize;
 					break;
 				}
 			}
@@ -197,12 +199,12 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 			pixbuf = targa_rgba + row*columns*4;
 			for(column=0; column<columns; ) {
 				if(buf_p + 1 > end)
-					ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+					goto truncated;
 				packetHeader= *buf_p++;
 				packetSize = 1 + (packetHeader & 0x7f);
 				if (packetHeader & 0x80) {        // run-length packet
 					if(buf_p + targa_header.pixel_size/8 > end)
-						ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+						goto truncated;
 					switch (targa_header.pixel_size) {
 						case 24:
 								blue = *buf_p++;
@@ -217,7 +219,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 								alphabyte = *buf_p++;
 								break;
 						default:
-							ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+							goto badPixelSize;
 							break;
 					}
 	
@@ -240,7 +242,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 				else {                            // non run-length packet
 
 					if(buf_p + targa_header.pixel_size/8*packetSize > end)
-						ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+						goto truncated;
 					for(j=0;j<packetSize;j++) {
 						switch (targa_header.pixel_size) {
 							case 24:
@@ -263,7 +265,7 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 									*pixbuf++ = alphabyte;
 									break;
 							default:
-								ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+								goto badPixelSize;
 								break;
 						}
 						column++;
@@ -302,15 +304,76 @@ void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
 #endif
   // instead we just print a warning
   if (targa_header.attributes & 0x20) {
-    ri.Printf( PRINT_WARNING, "WARNING: '%s' TGA file header declares top-down image, ignoring\n", name);
+    Com_sprintf( d->message, sizeof( d->message ), "WARNING: '%s' TGA file header declares top-down image, ignoring", name);
   }
 
-  if (width)
-	  *width = columns;
-  if (height)
-	  *height = rows;
+  d->width = columns;
+  d->height = rows;
+  d->pic = targa_rgba;
+
+  return qtrue;
+
+truncated:
+	Com_sprintf( d->message, sizeof( d->message ), "LoadTGA: file truncated (%s)", name );
+	goto fail;
+
+badPixelSize:
+	Com_sprintf( d->message, sizeof( d->message ), "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+
+fail:
+	d->free( targa_rgba );
+	return qfalse;
+}
+
+/*
+=============
+R_LoadTGA
+=============
+*/
+void R_LoadTGA ( const char *name, byte **pic, int *width, int *height)
+{
+	imageDecode_t	d;
+	union {
+		byte *b;
+		void *v;
+	} buffer;
+	qboolean	ok;
+
+	*pic = NULL;
+
+	if(width)
+		*width = 0;
+	if(height)
+		*height = 0;
+
+	//
+	// load the file
+	//
+	Com_Memset( &d, 0, sizeof( d ) );
+	d.length = ri.FS_ReadFile ( ( char * ) name, &buffer.v);
+	if (!buffer.b || d.length < 0) {
+		return;
+	}
+
+	d.name = name;
+	d.buffer = buffer.b;
+	d.alloc = ri.Malloc;
+	d.free = ri.Free;
+
+	ok = R_DecodeTGA( &d );
+	ri.FS_FreeFile (buffer.v);
+
+	if ( !ok ) {
+		ri.Error( ERR_DROP, "%s", d.message );
+	}
+	if ( d.message[0] ) {
+		ri.Printf( PRINT_WARNING, "%s\n", d.message );
+	}
 
-  *pic = targa_rgba;
+	if (width)
+		*width = d.width;
+	if (height)
+		*height = d.height;
 
-  ri.FS_FreeFile (buffer.v);
+	*pic = d.pic;
 }
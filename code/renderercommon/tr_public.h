@@ -86,6 +86,16 @@ typedef struct {
 
 	void	(*SetVRHeadsetParms)( const float projectionMatrix[16], const float nonVRProjectionMatrix[16], int renderBuffer );
 
+	// [OpenXR] swapchain work that opens and closes a VR frame.  With r_smp
+	// it runs on the render thread in order with the frame's commands, and
+	// EndVRFrame returns qtrue while that thread may still be drawing it;
+	// otherwise both run right away.  The begin function returns the
+	// framebuffer to render into.
+	void	(*BeginVRFrame)( int (*func)( void *data ), void *data );
+	qboolean (*EndVRFrame)( int (*func)( void *data ), void *data );
+	// waits until the render thread is done with every frame handed to it
+	void	(*SyncRenderThread)( void );
+
 	int		(*MarkFragments)( int numPoints, const vec3_t *points, const vec3_t projection,
 				   int maxPoints, vec3_t pointBuffer, int maxFragments, markFragment_t *fragmentBuffer );
 
@@ -183,6 +193,14 @@ typedef struct {
 	void	(*Sys_GLimpSafeInit)( void );
 	void	(*Sys_GLimpInit)( void );
 	qboolean (*Sys_LowPhysicalMemory)( void );
+
+	// timing zones for profile_dump, only call them while *profiling is set
+	qboolean	*profiling;
+	void	(*ProfileBegin)( int zone );
+	void	(*ProfileEnd)( int zone );
+
+	// Com_RunJobs, the jobs may only use what the job pool allows
+	void	(*RunJobs)( void (*func)( void *data, int index ), void *data, int count, int numThreads );
 } refimport_t;
 
 
@@ -217,7 +217,7 @@ typedef struct {
 	// used CDS.
 	qboolean				isFullscreen;
 	qboolean				stereoEnabled;
-	qboolean				smpActive;		// UNUSED, present for compatibility
+	qboolean				smpActive;		// dual processor acceleration, r_smp
 } glconfig_t;
 
 #endif	// __TR_TYPES_H
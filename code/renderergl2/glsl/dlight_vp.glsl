@@ -91,7 +91,7 @@ void main()
 	position = DeformPosition(position, normal, attr_TexCoord0.st);
 #endif
 
-	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[gl_ViewID_OVR] * (u_ModelMatrix * vec4(position, 1.0)));
+	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[VIEW_ID] * (u_ModelMatrix * vec4(position, 1.0)));
 		
 	vec3 dist = u_DlightInfo.xyz - position;
 
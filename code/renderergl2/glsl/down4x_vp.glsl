@@ -18,6 +18,6 @@ varying vec2   var_TexCoords;
 
 void main()
 {
-	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[gl_ViewID_OVR] * (u_ModelMatrix * vec4(attr_Position, 1.0)));
+	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[VIEW_ID] * (u_ModelMatrix * vec4(attr_Position, 1.0)));
 	var_TexCoords = attr_TexCoord0.st;
 }
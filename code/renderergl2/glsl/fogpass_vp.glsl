@@ -136,7 +136,7 @@ void main()
 	position.xyz = DeformPosition(position.xyz, normal, attr_TexCoord0.st);
 #endif
 
-	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[gl_ViewID_OVR] * (u_ModelMatrix * vec4(position, 1.0)));
+	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[VIEW_ID] * (u_ModelMatrix * vec4(position, 1.0)));
 
 	var_Scale = CalcFog(position) * u_Color.a * u_Color.a;
 }
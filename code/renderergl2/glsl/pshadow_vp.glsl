@@ -18,7 +18,7 @@ varying vec3   var_Normal;
 
 void main()
 {
-	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[gl_ViewID_OVR] * (u_ModelMatrix * vec4(attr_Position, 1.0)));
+	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[VIEW_ID] * (u_ModelMatrix * vec4(attr_Position, 1.0)));
 
 	var_Position  = attr_Position;
 	var_Normal    = attr_Normal;
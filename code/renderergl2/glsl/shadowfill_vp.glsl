@@ -110,7 +110,7 @@ void main()
 
 	position = DeformPosition(position, normal, attr_TexCoord0.st);
 
-	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[gl_ViewID_OVR] * (u_ModelMatrix * vec4(position, 1.0)));
+	gl_Position = u_ProjectionMatrix * (u_ViewMatrices[VIEW_ID] * (u_ModelMatrix * vec4(position, 1.0)));
 	
 	var_Position  = (u_ModelMatrix * vec4(position, 1.0)).xyz;
 }
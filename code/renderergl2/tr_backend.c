@@ -23,7 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "tr_fbo.h"
 #include "tr_dsa.h"
 
-backEndData_t	*backEndData;
+backEndData_t	*backEndData[SMP_FRAMES];
 backEndState_t	backEnd;
 
 
@@ -1775,6 +1775,71 @@ const void *RB_ExportCubemaps(const void *data)
 	return (const void *)(cmd + 1);
 }
 
+/*
+====================
+Two pass stereo
+
+Without GL_OVR_multiview2 the swapchain framebuffer has one layer
+of the eye images attached.  Everything from RC_SWITCH_EYE to
+RC_SWAP_BUFFERS is drawn into the left eye's layer, then run again
+for the right eye's.  Lists flushed in the middle of a frame are
+replayed on their own.
+====================
+*/
+static qboolean		stereoFrame;		// RC_SWITCH_EYE seen, RC_SWAP_BUFFERS not yet
+static const void	*stereoPassStart;	// where the right eye's pass starts over
+static uniformBuffersCommand_t	stereoUniforms;	// matrices to reload on eye changes
+
+/*
+====================
+RB_SetStereoEye
+
+Attaches the eye's layers and loads its view matrices
+====================
+*/
+static void RB_SetStereoEye( int eye ) {
+	GLint	drawFramebuffer, color, depth;
+
+	backEnd.stereoEye = eye;
+
+	qglGetIntegerv( GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer );
+	qglBindFramebuffer( GL_DRAW_FRAMEBUFFER, tr.renderFbo->frameBuffer );
+
+	qglGetFramebufferAttachmentParameteriv( GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &color );
+	qglGetFramebufferAttachmentParameteriv( GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &depth );
+	qglFramebufferTextureLayer( GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, color, 0, eye );
+	qglFramebufferTextureLayer( GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depth, 0, eye );
+
+	qglBindFramebuffer( GL_DRAW_FRAMEBUFFER, drawFramebuffer );
+
+	if ( stereoUniforms.commandId ) {
+		GLSL_PrepareUniformBuffers( &stereoUniforms );
+	}
+}
+
+/*
+====================
+RB_EndStereoPass
+
+Called where a stereo frame or list ends, returns where to carry on
+====================
+*/
+static const void *RB_EndStereoPass( const void *data ) {
+	// finish any 2D drawing if needed
+	if(tess.numIndexes)
+		RB_EndSurface();
+
+	if ( backEnd.stereoEye == 0 ) {
+		RB_SetStereoEye( 1 );
+		return stereoPassStart;
+	}
+
+	// the rest of the frame, if any, starts over with the left eye
+	stereoPassStart = NULL;
+	RB_SetStereoEye( 0 );
+	return data;
+}
+
 /*
 ====================
 RB_SwitchEye
@@ -1783,7 +1848,7 @@ RB_SwitchEye
 const void* RB_SwitchEye( const void* data ) {
 	const switchEyeCommand_t *cmd = data;
 
-	tr.renderFbo->frameBuffer = cmd->eye;
+	tr.renderFbo->frameBuffer = cmd->eye ? cmd->eye : backEnd.vrRenderBuffer;
 
 	// finish any 2D drawing if needed
 	if(tess.numIndexes)
@@ -1803,6 +1868,13 @@ const void* RB_SwitchEye( const void* data ) {
 		glState.currentFBO = tr.renderFbo;
 	}
 
+	if (!glRefConfig.multiview)
+	{
+		stereoFrame = qtrue;
+		stereoPassStart = cmd + 1;
+		RB_SetStereoEye(0);
+	}
+
 	return (const void*)(cmd + 1);
 }
 
@@ -1868,6 +1940,52 @@ const void* RB_HUDBuffer( const void* data ) {
 	return (const void*)(cmd + 1);
 }
 
+/*
+====================
+RB_UniformBuffers
+====================
+*/
+const void *RB_UniformBuffers( const void *data ) {
+	const uniformBuffersCommand_t *cmd = data;
+
+	// finish any 2D drawing if needed
+	if(tess.numIndexes)
+		RB_EndSurface();
+
+	if (!glRefConfig.multiview)
+	{
+		stereoUniforms = *cmd;
+	}
+
+	GLSL_PrepareUniformBuffers(cmd);
+
+	return (const void *)(cmd + 1);
+}
+
+
+/*
+====================
+RB_VRFrame
+====================
+*/
+const void *RB_VRFrame( const void *data ) {
+	const vrFrameCommand_t *cmd = data;
+	int renderBuffer;
+
+	// finish any 2D drawing if needed
+	if(tess.numIndexes)
+		RB_EndSurface();
+
+	renderBuffer = cmd->func(cmd->data);
+	if (renderBuffer)
+	{
+		backEnd.vrRenderBuffer = renderBuffer;
+	}
+
+	return (const void *)(cmd + 1);
+}
+
+
 /*
 ====================
 RB_ExecuteRenderCommands
@@ -1878,6 +1996,13 @@ void RB_ExecuteRenderCommands( const void *data ) {
 
 	t1 = ri.Milliseconds ();
 
+	R_PROFILE_BEGIN( PROFILE_RB_EXECUTERENDERCOMMANDS );
+
+	// a two pass stereo frame carried over from the last list
+	if ( stereoFrame ) {
+		stereoPassStart = data;
+	}
+
 	while ( 1 ) {
 		data = PADP(data, sizeof(void *));
 
@@ -1895,12 +2020,28 @@ void RB_ExecuteRenderCommands( const void *data ) {
 			data = RB_DrawBuffer( data );
 			break;
 		case RC_SWAP_BUFFERS:
+			if ( stereoPassStart ) {
+				data = RB_EndStereoPass( data );
+				if ( stereoPassStart ) {
+					break;
+				}
+				stereoFrame = qfalse;
+			}
 			data = RB_SwapBuffers( data );
 			break;
 		case RC_SCREENSHOT:
+			// captures are taken once, from the left eye
+			if ( backEnd.stereoEye ) {
+				data = (const screenshotCommand_t *)data + 1;
+				break;
+			}
 			data = RB_TakeScreenshotCmd( data );
 			break;
 		case RC_VIDEOFRAME:
+			if ( backEnd.stereoEye ) {
+				data = (const videoFrameCommand_t *)data + 1;
+				break;
+			}
 			data = RB_TakeVideoFrameCmd( data );
 			break;
 		case RC_COLORMASK:
@@ -1916,6 +2057,10 @@ void RB_ExecuteRenderCommands( const void *data ) {
 			data = RB_PostProcess(data);
 			break;
 		case RC_EXPORT_CUBEMAPS:
+			if ( backEnd.stereoEye ) {
+				data = (const exportCubemapsCommand_t *)data + 1;
+				break;
+			}
 			data = RB_ExportCubemaps(data);
 			break;
 		case RC_SWITCH_EYE:
@@ -1924,8 +2069,21 @@ void RB_ExecuteRenderCommands( const void *data ) {
 		case RC_HUD_BUFFER:
 			data = RB_HUDBuffer(data);
 			break;
+		case RC_UNIFORM_BUFFERS:
+			data = RB_UniformBuffers(data);
+			break;
+		case RC_VR_FRAME:
+			data = RB_VRFrame(data);
+			break;
 		case RC_END_OF_LIST:
 		default:
+			if ( stereoPassStart ) {
+				data = RB_EndStereoPass( data );
+				if ( stereoPassStart ) {
+					break;
+				}
+			}
+
 			// finish any 2D drawing if needed
 			if(tess.numIndexes)
 				RB_EndSurface();
@@ -1933,8 +2091,43 @@ void RB_ExecuteRenderCommands( const void *data ) {
 			// stop rendering
 			t2 = ri.Milliseconds ();
 			backEnd.pc.msec = t2 - t1;
+
+			R_PROFILE_END( PROFILE_RB_EXECUTERENDERCOMMANDS );
 			return;
 		}
 	}
 
 }
+
+
+/*
+================
+RB_RenderThread
+================
+*/
+volatile qboolean	renderThreadActive;
+
+void RB_RenderThread( void ) {
+	const void	*data;
+
+	// wait for either a rendering command or a quit command
+	while ( 1 ) {
+		// sleep until we have work to do
+		data = GLimp_RendererSleep();
+
+		if ( !data ) {
+			return;	// all done, renderer is shutting down
+		}
+
+		renderThreadActive = qtrue;
+
+		RB_ExecuteRenderCommands( data );
+
+		if ( r_useFlush->integer ) {
+			//FLush all open gl commands
+			qglFlush();
+		}
+
+		renderThreadActive = qfalse;
+	}
+}
@@ -2737,6 +2737,12 @@ void RE_LoadWorldMap( const char *name ) {
 
 	tr.worldMapLoaded = qtrue;
 
+	// reported by RE_EndRegistration
+	tr.mapLoadStart = ri.Milliseconds();
+	tr.mapLoadImages = 0;
+	tr.mapLoadPooled = 0;
+	tr.mapLoadCached = 0;
+
 	// load it
     ri.FS_ReadFile( name, &buffer.v );
 	if ( !buffer.b ) {
@@ -3008,6 +3014,9 @@ void RE_LoadWorldMap( const char *name ) {
 	if (r_cubeMapping->integer && tr.numCubemaps && glRefConfig.framebufferObject)
 	{
 		R_LoadCubemaps();
+
+		// the world has to be drawable for the missing ones
+		R_FinishImageJobs();
 		R_RenderMissingCubemaps();
 	}
 
@@ -79,13 +79,13 @@ void R_PerformanceCounters( void ) {
 
 /*
 ====================
-R_IssueRenderCommands
+R_TerminateCommandList
 ====================
 */
-void R_IssueRenderCommands( qboolean runPerformanceCounters ) {
+static renderCommandList_t *R_TerminateCommandList( void ) {
 	renderCommandList_t	*cmdList;
 
-	cmdList = &backEndData->commands;
+	cmdList = &backEndData[tr.smpFrame]->commands;
 	assert(cmdList);
 	// add an end-of-list command
 	*(int *)(cmdList->cmds + cmdList->used) = RC_END_OF_LIST;
@@ -93,6 +93,53 @@ void R_IssueRenderCommands( qboolean runPerformanceCounters ) {
 	// clear it out, in case this is a sync and not a buffer flip
 	cmdList->used = 0;
 
+	return cmdList;
+}
+
+
+/*
+====================
+R_IssueRenderCommands
+
+With r_smp this hands the list to the render thread once it is
+done with the previous one, and returns without waiting for it
+====================
+*/
+int	c_blockedOnRender;
+int	c_blockedOnMain;
+
+void R_IssueRenderCommands( qboolean runPerformanceCounters ) {
+	renderCommandList_t	*cmdList;
+
+	// images still waiting on the job pool could be drawn with
+	if ( backEndData[tr.smpFrame]->commands.used ) {
+		R_FinishImageJobs();
+	}
+
+	cmdList = R_TerminateCommandList();
+
+	if ( glConfig.smpActive ) {
+		// if the render thread is not idle, wait for it
+		if ( renderThreadActive ) {
+			c_blockedOnRender++;
+			if ( r_showSmp->integer ) {
+				ri.Printf( PRINT_ALL, "R" );
+			}
+		} else {
+			c_blockedOnMain++;
+			if ( r_showSmp->integer ) {
+				ri.Printf( PRINT_ALL, "." );
+			}
+		}
+
+		// sleep until the renderer has completed
+		GLimp_FrontEndSleep();
+
+		tr.smpBackEndMsec = backEnd.pc.msec;
+	}
+
+	// at this point, the back end thread is idle, so it is ok
+	// to look at its performance counters
 	if ( runPerformanceCounters ) {
 		R_PerformanceCounters();
 	}
@@ -100,23 +147,66 @@ void R_IssueRenderCommands( qboolean runPerformanceCounters ) {
 	// actually start the commands going
 	if ( !r_skipBackEnd->integer ) {
 		// let it start on the new batch
-		RB_ExecuteRenderCommands( cmdList->cmds );
+		if ( !glConfig.smpActive ) {
+			RB_ExecuteRenderCommands( cmdList->cmds );
+		} else {
+			GLimp_WakeRenderer( cmdList );
+		}
 	}
 }
 
 
+/*
+====================
+R_SyncRenderThread
+
+Waits until the render thread is done with everything it was
+handed.  Pending commands stay pending and the GL context stays
+with the render thread.
+====================
+*/
+void R_SyncRenderThread( void ) {
+	if ( !glConfig.smpActive ) {
+		return;
+	}
+	GLimp_FrontEndSleep();
+}
+
+
 /*
 ====================
 R_IssuePendingRenderCommands
 
 Issue any pending commands and wait for them to complete.
+
+With r_smp this also takes the GL context from the render thread,
+so anything outside the back end must come here before calling GL.
+The pending commands then run right here rather than bouncing the
+context over to the render thread and back.
 ====================
 */
 void R_IssuePendingRenderCommands( void ) {
+	renderCommandList_t	*cmdList;
+
 	if ( !tr.registered ) {
 		return;
 	}
-	R_IssueRenderCommands( qfalse );
+
+	if ( !glConfig.smpActive ) {
+		R_IssueRenderCommands( qfalse );
+		return;
+	}
+
+	GLimp_AcquireContext();
+
+	if ( backEndData[tr.smpFrame]->commands.used ) {
+		R_FinishImageJobs();
+	}
+
+	cmdList = R_TerminateCommandList();
+	if ( !r_skipBackEnd->integer ) {
+		RB_ExecuteRenderCommands( cmdList->cmds );
+	}
 }
 
 /*
@@ -129,7 +219,7 @@ make sure there is enough command space
 void *R_GetCommandBufferReserved( int bytes, int reservedBytes ) {
 	renderCommandList_t	*cmdList;
 
-	cmdList = &backEndData->commands;
+	cmdList = &backEndData[tr.smpFrame]->commands;
 	bytes = PAD(bytes, sizeof(void *));
 
 	// always leave room for the end of list command
@@ -150,11 +240,13 @@ void *R_GetCommandBufferReserved( int bytes, int reservedBytes ) {
 =============
 R_GetCommandBuffer
 
-returns NULL if there is not enough space for important commands
+returns NULL if there is not enough space for important commands,
+the swap and the command that closes a queued VR frame always fit
 =============
 */
 void *R_GetCommandBuffer( int bytes ) {
-	return R_GetCommandBufferReserved( bytes, PAD( sizeof( swapBuffersCommand_t ), sizeof(void *) ) );
+	return R_GetCommandBufferReserved( bytes, PAD( sizeof( swapBuffersCommand_t ), sizeof(void *) )
+		+ PAD( sizeof( vrFrameCommand_t ), sizeof(void *) ) );
 }
 
 
@@ -428,14 +520,27 @@ void RE_BeginFrame( stereoFrame_t stereoFrame ) {
 					if (!(sec = R_GetCommandBuffer(sizeof(*sec))))
 						return;
 					sec->commandId = RC_SWITCH_EYE;
+					// 0 when the swapchain image is acquired by a queued
+					// RC_VR_FRAME, the back end then uses that one
 					sec->eye = tr.vrParms.renderBuffer;
 					sec->stereoFrame = stereoFrame;
 				}
 			}
 		}
 	}
-	
-	GLSL_PrepareUniformBuffers();
+
+	{
+		uniformBuffersCommand_t	*ubc;
+
+		if ( !( ubc = R_GetCommandBuffer( sizeof( *ubc ) ) ) )
+			return;
+		ubc->commandId = RC_UNIFORM_BUFFERS;
+		Com_Memcpy( ubc->projection, tr.vrParms.projection, sizeof( ubc->projection ) );
+		Com_Memcpy( ubc->mirrorProjection, tr.vrParms.mirrorProjection, sizeof( ubc->mirrorProjection ) );
+		Com_Memcpy( ubc->monoVRProjection, tr.vrParms.monoVRProjection, sizeof( ubc->monoVRProjection ) );
+		Com_Memcpy( ubc->eyeViewMatrix, tr.viewParms.world.eyeViewMatrix, sizeof( ubc->eyeViewMatrix ) );
+		Com_Memcpy( ubc->modelView, tr.viewParms.world.modelView, sizeof( ubc->modelView ) );
+	}
 }
 
 
@@ -452,30 +557,104 @@ void RE_EndFrame( int *frontEndMsec, int *backEndMsec ) {
 	if ( !tr.registered ) {
 		return;
 	}
-	cmd = R_GetCommandBufferReserved( sizeof( *cmd ), 0 );
+	cmd = R_GetCommandBufferReserved( sizeof( *cmd ),
+		tr.vrFrameQueued ? PAD( sizeof( vrFrameCommand_t ), sizeof(void *) ) : 0 );
 	if ( !cmd ) {
 		return;
 	}
 	cmd->commandId = RC_SWAP_BUFFERS;
 
-	R_IssueRenderCommands( qtrue );
+	// a queued VR frame is handed to the render thread by RE_EndVRFrame,
+	// along with the swapchain work that has to follow these commands
+	if ( !tr.vrFrameQueued ) {
+		R_IssueRenderCommands( qtrue );
 
-	if (r_useFlush->integer)
-	{
-		//FLush all open gl commands
-		qglFlush();
-	}
+		if (r_useFlush->integer && !glConfig.smpActive)
+		{
+			//FLush all open gl commands
+			qglFlush();
+		}
 
-	R_InitNextFrame();
+		R_InitNextFrame();
+	}
 
 	if ( frontEndMsec ) {
 		*frontEndMsec = tr.frontEndMsec;
 	}
 	tr.frontEndMsec = 0;
 	if ( backEndMsec ) {
-		*backEndMsec = backEnd.pc.msec;
+		*backEndMsec = glConfig.smpActive ? tr.smpBackEndMsec : backEnd.pc.msec;
 	}
-	backEnd.pc.msec = 0;
+	if ( !glConfig.smpActive ) {
+		backEnd.pc.msec = 0;
+	}
+}
+
+/*
+=============
+RE_BeginVRFrame
+
+func does the swapchain work that opens a VR frame and returns the
+framebuffer the eyes render into.  With r_smp it is queued, so the
+render thread runs it in order with the frame's commands, otherwise
+it is called right away and the framebuffer comes in through
+RE_SetVRHeadsetParms as before.
+=============
+*/
+void RE_BeginVRFrame( int (*func)( void *data ), void *data ) {
+	vrFrameCommand_t	*cmd;
+
+	if ( !tr.registered || !glConfig.smpActive || tr.vrFrameQueued ) {
+		func( data );
+		return;
+	}
+
+	cmd = R_GetCommandBuffer( sizeof( *cmd ) );
+	if ( !cmd ) {
+		R_IssuePendingRenderCommands();
+		func( data );
+		return;
+	}
+	cmd->commandId = RC_VR_FRAME;
+	cmd->func = func;
+	cmd->data = data;
+
+	tr.vrFrameQueued = qtrue;
+}
+
+/*
+=============
+RE_EndVRFrame
+
+Closes the frame opened by RE_BeginVRFrame.  If that was queued,
+func is queued behind it and the whole frame goes to the render
+thread, which may still be working on it when this returns qtrue.
+=============
+*/
+qboolean RE_EndVRFrame( int (*func)( void *data ), void *data ) {
+	vrFrameCommand_t	*cmd;
+
+	if ( !tr.vrFrameQueued ) {
+		// the render thread may still hold the context
+		if ( glConfig.smpActive ) {
+			R_IssuePendingRenderCommands();
+		}
+		func( data );
+		return qfalse;
+	}
+	tr.vrFrameQueued = qfalse;
+
+	// R_GetCommandBuffer always leaves room for this one
+	cmd = R_GetCommandBufferReserved( sizeof( *cmd ), 0 );
+	cmd->commandId = RC_VR_FRAME;
+	cmd->func = func;
+	cmd->data = data;
+
+	R_IssueRenderCommands( qtrue );
+
+	R_InitNextFrame();
+
+	return qtrue;
 }
 
 void RE_HUDBufferStart( qboolean clear )
@@ -347,6 +347,28 @@ void GLimp_InitExtraExtensions(void)
 		ri.Printf(PRINT_ALL, result[2], extension);
 	}
 
+	// GL_OVR_multiview2, without it both eyes are drawn in two passes.
+	// The VR code checks qglFramebufferTextureMultiviewOVR as well.
+	extension = "GL_OVR_multiview2";
+	glRefConfig.multiview = qfalse;
+	qglFramebufferTextureMultiviewOVR = NULL;
+	if (SDL_GL_ExtensionSupported(extension))
+	{
+		glRefConfig.multiview = !!r_ext_multiview->integer;
+
+		// QGL_*_PROCS becomes several functions, do not remove {}
+		if (glRefConfig.multiview)
+		{
+			QGL_OVR_multiview_PROCS;
+		}
+
+		ri.Printf(PRINT_ALL, result[glRefConfig.multiview], extension);
+	}
+	else
+	{
+		ri.Printf(PRINT_ALL, result[2], extension);
+	}
+
 done:
 
 	// Determine GLSL version
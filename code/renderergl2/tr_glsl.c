@@ -192,6 +192,9 @@ GLSL_ViewMatricesUniformBuffer
 ====================
 */
 static void GLSL_ViewMatricesUniformBuffer(const float eyeView[2][16], const float modelView[32]) {
+	// without multiview only the first slot is read, by the eye being drawn
+	const int firstEye = glRefConfig.multiview ? 0 : backEnd.stereoEye;
+	const int secondEye = glRefConfig.multiview ? 1 : backEnd.stereoEye;
 
 	for (int i = 0; i < PROJECTION_COUNT; ++i)
 	{
@@ -226,18 +229,18 @@ static void GLSL_ViewMatricesUniformBuffer(const float eyeView[2][16], const flo
           //and I've just had enough messing about with this
 				  const int depthOffset = (5-powf(vr_hudDepth->integer, 0.7f)) * 16;
           vec3_t translate;
-          VectorSet(translate, depthOffset, 0, 0);
+          VectorSet(translate, firstEye ? -depthOffset : depthOffset, 0, 0);
           Mat4Translation( translate, viewMatrices );
 
-          VectorSet(translate, -depthOffset, 0, 0);
+          VectorSet(translate, secondEye ? -depthOffset : depthOffset, 0, 0);
           Mat4Translation( translate, viewMatrices + 16 );
         }
         break;
       case MIRROR_VR_PROJECTION:
       case VR_PROJECTION:
         {
-          Mat4Copy(eyeView[0], viewMatrices);
-          Mat4Copy(eyeView[1], viewMatrices+16);
+          Mat4Copy(eyeView[firstEye], viewMatrices);
+          Mat4Copy(eyeView[secondEye], viewMatrices+16);
         }
         break;
       case MONO_VR_PROJECTION:
@@ -365,11 +368,21 @@ static void GLSL_GetShaderHeader( GLenum shaderType, const GLchar *extra, char *
 	{
     if(shaderType == GL_VERTEX_SHADER)
     {
-      //Enable multiview
       Q_strcat(dest, size, "#version 430\n");
+      //Both eyes' matrices are in the view matrices block either way
       Q_strcat(dest, size, "#define NUM_VIEWS 2\n");
-      Q_strcat(dest, size, "#extension GL_OVR_multiview2 : enable\n");
-      Q_strcat(dest, size, "layout(num_views=NUM_VIEWS) in;\n");
+      if (glRefConfig.multiview)
+      {
+        //Enable multiview
+        Q_strcat(dest, size, "#extension GL_OVR_multiview2 : enable\n");
+        Q_strcat(dest, size, "layout(num_views=NUM_VIEWS) in;\n");
+        Q_strcat(dest, size, "#define VIEW_ID gl_ViewID_OVR\n");
+      }
+      else
+      {
+        //Two pass stereo, the eye being drawn is always in the first slot
+        Q_strcat(dest, size, "#define VIEW_ID 0\n");
+      }
     }
 		else if (qglesMajorVersion >= 3 && glRefConfig.glslMajorVersion >= 3)
 			Q_strcat(dest, size, "#version 300 es\n");
@@ -1753,7 +1766,7 @@ void GLSL_ShutdownGPUShaders(void)
 	qglDeleteBuffers(PROJECTION_COUNT, projectionMatricesBuffer);
 }
 
-void GLSL_PrepareUniformBuffers(void)
+void GLSL_PrepareUniformBuffers(const uniformBuffersCommand_t *cmd)
 {
   int width, height;
   if (glState.currentFBO)
@@ -1782,18 +1795,18 @@ void GLSL_PrepareUniformBuffers(void)
 
   //VR projection matrix
   GLSL_ProjectionMatricesUniformBuffer(projectionMatricesBuffer[VR_PROJECTION],
-          tr.vrParms.projection);
+          cmd->projection);
 
   //Mirror VR projection matrix
 	GLSL_ProjectionMatricesUniformBuffer(projectionMatricesBuffer[MIRROR_VR_PROJECTION],
-                                         tr.vrParms.mirrorProjection);
+                                         cmd->mirrorProjection);
 
   //Used for drawing models
   GLSL_ProjectionMatricesUniformBuffer(projectionMatricesBuffer[MONO_VR_PROJECTION],
-                                        tr.vrParms.monoVRProjection);
+                                        cmd->monoVRProjection);
 
   //Set all view matrices
-	GLSL_ViewMatricesUniformBuffer(tr.viewParms.world.eyeViewMatrix, tr.viewParms.world.modelView);
+	GLSL_ViewMatricesUniformBuffer(cmd->eyeViewMatrix, cmd->modelView);
 }
 
 void GLSL_BindProgram(shaderProgram_t * program)
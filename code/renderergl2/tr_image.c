@@ -2201,31 +2201,19 @@ static void Upload32(byte *data, int x, int y, int width, int height, GLenum pic
 
 /*
 ================
-R_CreateImage2
+R_AllocImage
 
-This is the only way any image_t are created
+This is the only way any image_t are created, the texture gets
+its storage from R_UploadImage
 ================
 */
-image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLenum picFormat, int numMips, imgType_t type, imgFlags_t flags, int internalFormat ) {
-	byte       *resampledBuffer = NULL;
+static image_t *R_AllocImage( const char *name, imgType_t type, imgFlags_t flags ) {
 	image_t    *image;
-	qboolean    isLightmap = qfalse, scaled = qfalse;
 	long        hash;
-	int         glWrapClampMode, mipWidth, mipHeight, miplevel;
-	qboolean    rgba8 = picFormat == GL_RGBA8 || picFormat == GL_SRGB8_ALPHA8_EXT;
-	qboolean    mipmap = !!(flags & IMGFLAG_MIPMAP);
-	qboolean    cubemap = !!(flags & IMGFLAG_CUBEMAP);
-	qboolean    picmip = !!(flags & IMGFLAG_PICMIP);
-	qboolean    lastMip;
-	GLenum textureTarget = cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
-	GLenum dataFormat, dataType;
 
 	if (strlen(name) >= MAX_QPATH ) {
 		ri.Error (ERR_DROP, "R_CreateImage: \"%s\" is too long", name);
 	}
-	if ( !strncmp( name, "*lightmap", 9 ) ) {
-		isLightmap = qtrue;
-	}
 
 	if ( tr.numImages == MAX_DRAWIMAGES ) {
 		ri.Error( ERR_DROP, "R_CreateImage: MAX_DRAWIMAGES hit");
@@ -2240,6 +2228,41 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 
 	strcpy (image->imgName, name);
 
+	hash = generateHashValue(name);
+	image->next = hashTable[hash];
+	hashTable[hash] = image;
+
+	return image;
+}
+
+
+/*
+================
+R_UploadImage
+
+Gives an image from R_AllocImage its size, storage and contents.
+A prepared pic is a full mip chain from r_imageCache that only
+needs copying.
+================
+*/
+static void R_UploadImage( image_t *image, byte *pic, int width, int height, GLenum picFormat, int numMips, int internalFormat, qboolean prepared ) {
+	byte       *resampledBuffer = NULL;
+	imgType_t   type = image->type;
+	imgFlags_t  flags = image->flags;
+	qboolean    isLightmap = qfalse, scaled = qfalse;
+	int         glWrapClampMode, mipWidth, mipHeight, miplevel;
+	qboolean    rgba8 = picFormat == GL_RGBA8 || picFormat == GL_SRGB8_ALPHA8_EXT;
+	qboolean    mipmap = !!(flags & IMGFLAG_MIPMAP);
+	qboolean    cubemap = !!(flags & IMGFLAG_CUBEMAP);
+	qboolean    picmip = !!(flags & IMGFLAG_PICMIP);
+	qboolean    lastMip;
+	GLenum textureTarget = cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	GLenum dataFormat, dataType;
+
+	if ( !strncmp( image->imgName, "*lightmap", 9 ) ) {
+		isLightmap = qtrue;
+	}
+
 	image->width = width;
 	image->height = height;
 	if (flags & IMGFLAG_CLAMPTOEDGE)
@@ -2248,7 +2271,7 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 		glWrapClampMode = GL_REPEAT;
 
 	if (!internalFormat)
-		internalFormat = RawImage_GetFormat(pic, width * height, picFormat, isLightmap, image->type, image->flags);
+		internalFormat = RawImage_GetFormat(pic, width * height, picFormat, isLightmap, type, flags);
 
 	dataFormat = PixelDataFormatFromInternalFormat(internalFormat);
 	dataType = picFormat == GL_RGBA16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
@@ -2293,7 +2316,7 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 				dataType = GL_UNSIGNED_SHORT_4_4_4_4;
 				break;
 			default:
-				ri.Error( ERR_DROP, "Missing OpenGL ES support for image '%s' with internal format 0x%X\n", name, internalFormat );
+				ri.Error( ERR_DROP, "Missing OpenGL ES support for image '%s' with internal format 0x%X\n", image->imgName, internalFormat );
 		}
 	}
 
@@ -2301,7 +2324,7 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 
 	// Possibly scale image before uploading.
 	// if not rgba8 and uploading an image, skip picmips.
-	if (!cubemap)
+	if (!cubemap && !prepared)
 	{
 		if (rgba8)
 			scaled = RawImage_ScaleToPower2(&pic, &width, &height, type, flags, &resampledBuffer);
@@ -2346,7 +2369,9 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 	while (!lastMip);
 
 	// Upload data.
-	if (pic)
+	if (pic && prepared)
+		RawImage_UploadTexture(image->texnum, pic, 0, 0, width, height, GL_TEXTURE_2D, picFormat, dataFormat, dataType, numMips, internalFormat, type, flags, qfalse);
+	else if (pic)
 		Upload32(pic, 0, 0, width, height, picFormat, dataFormat, dataType, numMips, image, scaled);
 
 	if (resampledBuffer != NULL)
@@ -2384,10 +2409,19 @@ image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLe
 	}
 
 	GL_CheckErrors();
+}
 
-	hash = generateHashValue(name);
-	image->next = hashTable[hash];
-	hashTable[hash] = image;
+
+/*
+================
+R_CreateImage2
+================
+*/
+image_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLenum picFormat, int numMips, imgType_t type, imgFlags_t flags, int internalFormat ) {
+	image_t    *image;
+
+	image = R_AllocImage( name, type, flags );
+	R_UploadImage( image, pic, width, height, picFormat, numMips, internalFormat, qfalse );
 
 	return image;
 }
@@ -2421,36 +2455,94 @@ void R_UpdateSubImage( image_t *image, byte *pic, int x, int y, int width, int h
 
 // Prototype for dds loader function which isn't common to both renderers
 void R_LoadDDS(const char *filename, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips);
+void R_LoadDDS2(const char *filename, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips, int *size, int *internalFormat);
+void R_SaveDDS2(const char *filename, byte *pic, int picSize, int width, int height, GLenum picFormat, int numMips, int internalFormat);
 
 typedef struct
 {
 	char *ext;
 	void (*ImageLoader)( const char *, unsigned char **, int *, int * );
+	qboolean (*Decode)( imageDecode_t *d );		// safe on the job pool, or NULL
 } imageExtToLoaderMap_t;
 
 // Note that the ordering indicates the order of preference used
 // when there are multiple images of different formats available
 static imageExtToLoaderMap_t imageLoaders[ ] =
 {
-	{ "png",  R_LoadPNG },
-	{ "tga",  R_LoadTGA },
-	{ "jpg",  R_LoadJPG },
-	{ "jpeg", R_LoadJPG },
-	{ "pcx",  R_LoadPCX },
-	{ "bmp",  R_LoadBMP }
+	{ "png",  R_LoadPNG, NULL },
+	{ "tga",  R_LoadTGA, R_DecodeTGA },
+	{ "jpg",  R_LoadJPG, R_DecodeJPG },
+	{ "jpeg", R_LoadJPG, R_DecodeJPG },
+	{ "pcx",  R_LoadPCX, NULL },
+	{ "bmp",  R_LoadBMP, NULL }
 };
 
 static int numImageLoaders = ARRAY_LEN( imageLoaders );
 
+// the file R_FindImageFile is loading
+typedef struct {
+	int		loader;					// from R_FindImageLoader
+	char	filename[MAX_QPATH];
+	void	*buffer;				// NULL unless the loader has a Decode
+	int		length;
+} imageFile_t;
+
+/*
+=================
+R_FreeImageFile
+=================
+*/
+static void R_FreeImageFile( imageFile_t *file )
+{
+	if ( file->buffer ) {
+		ri.FS_FreeFile( file->buffer );
+		file->buffer = NULL;
+	}
+}
+
+/*
+=================
+R_DecodeImageFile
+
+R_LoadJPG or R_LoadTGA on a file that was already read, which it frees
+=================
+*/
+static void R_DecodeImageFile( imageFile_t *file, byte **pic, int *width, int *height )
+{
+	imageDecode_t	d;
+	qboolean		ok;
+
+	Com_Memset( &d, 0, sizeof( d ) );
+	d.name = file->filename;
+	d.buffer = file->buffer;
+	d.length = file->length;
+	d.alloc = ri.Malloc;
+	d.free = ri.Free;
+
+	ok = imageLoaders[file->loader].Decode( &d );
+	R_FreeImageFile( file );
+
+	if ( !ok ) {
+		ri.Error( ERR_DROP, "%s", d.message );
+	}
+	if ( d.message[0] ) {
+		ri.Printf( PRINT_WARNING, "%s\n", d.message );
+	}
+
+	*pic = d.pic;
+	*width = d.width;
+	*height = d.height;
+}
+
 /*
 =================
 R_LoadImage
 
 Loads any of the supported image types into a canonical
-32 bit format.
+32 bit format.  file is from R_ReadImageFile, and is freed.
 =================
 */
-void R_LoadImage( const char *name, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips )
+static void R_LoadImage( const char *name, imageFile_t *file, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips )
 {
 	qboolean orgNameFailed = qfalse;
 	int orgLoader = -1;
@@ -2465,6 +2557,14 @@ void R_LoadImage( const char *name, byte **pic, int *width, int *height, GLenum
 	*picFormat = GL_RGBA8;
 	*numMips = 0;
 
+	// a file that fails to decode falls back to the other formats below
+	if ( file->buffer )
+	{
+		R_DecodeImageFile( file, pic, width, height );
+		if ( *pic )
+			return;
+	}
+
 	Q_strncpyz( localName, name, MAX_QPATH );
 
 	ext = COM_GetExtension( localName );
@@ -2542,6 +2642,822 @@ void R_LoadImage( const char *name, byte **pic, int *width, int *height, GLenum
 }
 
 
+/*
+================
+R_GenerateNormalMap
+
+Builds a normal map from the heights in a colour image, and
+brightens the colours to work with it.  Only touches the two
+pics, so the image jobs can run it.
+================
+*/
+static void R_GenerateNormalMap( byte *pic, byte *normalPic, int width, int height, imgFlags_t flags )
+{
+	int x, y;
+
+	RGBAtoNormal(pic, normalPic, width, height, flags & IMGFLAG_CLAMPTOEDGE);
+
+#if 1
+	// Brighten up the original image to work with the normal map
+	RGBAtoYCoCgA(pic, pic, width, height);
+	for (y = 0; y < height; y++)
+	{
+		byte *picbyte  = pic       + y * width * 4;
+		byte *normbyte = normalPic + y * width * 4;
+		for (x = 0; x < width; x++)
+		{
+			int div = MAX(normbyte[2] - 127, 16);
+			picbyte[0] = CLAMP(picbyte[0] * 128 / div, 0, 255);
+			picbyte  += 4;
+			normbyte += 4;
+		}
+	}
+	YCoCgAtoRGBA(pic, pic, width, height);
+#else
+	// Blur original image's luma to work with the normal map
+	{
+		byte *blurPic;
+
+		RGBAtoYCoCgA(pic, pic, width, height);
+		blurPic = ri.Malloc(width * height);
+
+		for (y = 1; y < height - 1; y++)
+		{
+			byte *picbyte  = pic     + y * width * 4;
+			byte *blurbyte = blurPic + y * width;
+
+			picbyte += 4;
+			blurbyte += 1;
+
+			for (x = 1; x < width - 1; x++)
+			{
+				int result;
+
+				result = *(picbyte - (width + 1) * 4) + *(picbyte - width * 4) + *(picbyte - (width - 1) * 4) +
+				         *(picbyte -          1  * 4) + *(picbyte            ) + *(picbyte +          1  * 4) +
+				         *(picbyte + (width - 1) * 4) + *(picbyte + width * 4) + *(picbyte + (width + 1) * 4);
+
+				result /= 9;
+
+				*blurbyte = result;
+				picbyte += 4;
+				blurbyte += 1;
+			}
+		}
+
+		// FIXME: do borders
+
+		for (y = 1; y < height - 1; y++)
+		{
+			byte *picbyte  = pic     + y * width * 4;
+			byte *blurbyte = blurPic + y * width;
+
+			picbyte += 4;
+			blurbyte += 1;
+
+			for (x = 1; x < width - 1; x++)
+			{
+				picbyte[0] = *blurbyte;
+				picbyte += 4;
+				blurbyte += 1;
+			}
+		}
+
+		ri.Free(blurPic);
+
+		YCoCgAtoRGBA(pic, pic, width, height);
+	}
+#endif
+}
+
+
+/*
+=================
+R_FindImageLoader
+
+Finds the file R_LoadImage would load for name, without reading
+it.  Returns the index into imageLoaders, numImageLoaders for a DDS,
+or -1 if there is no such file.
+=================
+*/
+static int R_FindImageLoader( const char *name, char *filename )
+{
+	char localName[ MAX_QPATH ];
+	const char *ext;
+	int orgLoader = -1;
+	int i;
+
+	if (r_ext_compressed_textures->integer)
+	{
+		COM_StripExtension(name, filename, MAX_QPATH);
+		Q_strcat(filename, MAX_QPATH, ".dds");
+
+		if (ri.FS_ReadFile(filename, NULL) >= 0)
+			return numImageLoaders;
+	}
+
+	Q_strncpyz( localName, name, MAX_QPATH );
+
+	ext = COM_GetExtension( localName );
+
+	if( *ext )
+	{
+		for( i = 0; i < numImageLoaders; i++ )
+		{
+			if( !Q_stricmp( ext, imageLoaders[ i ].ext ) )
+			{
+				if( ri.FS_ReadFile( localName, NULL ) >= 0 )
+				{
+					Q_strncpyz( filename, localName, MAX_QPATH );
+					return i;
+				}
+
+				orgLoader = i;
+				COM_StripExtension( name, localName, MAX_QPATH );
+				break;
+			}
+		}
+	}
+
+	for( i = 0; i < numImageLoaders; i++ )
+	{
+		if (i == orgLoader)
+			continue;
+
+		Com_sprintf( filename, MAX_QPATH, "%s.%s", localName, imageLoaders[ i ].ext );
+
+		if( ri.FS_ReadFile( filename, NULL ) >= 0 )
+		{
+			if( orgLoader >= 0 )
+			{
+				ri.Printf( PRINT_DEVELOPER, "WARNING: %s not present, using %s instead\n",
+						name, filename );
+			}
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+=================
+R_ReadImageFile
+
+Finds the file R_LoadImage would load for name, and reads it if
+it can be decoded from memory, for the image cache, the job pool
+and R_LoadImage to share.  Returns qfalse if there is no such file.
+=================
+*/
+static qboolean R_ReadImageFile( const char *name, imageFile_t *file )
+{
+	Com_Memset( file, 0, sizeof( *file ) );
+
+	file->loader = R_FindImageLoader( name, file->filename );
+	if ( file->loader < 0 ) {
+		return qfalse;
+	}
+	if ( file->loader == numImageLoaders || !imageLoaders[file->loader].Decode ) {
+		return qtrue;
+	}
+
+	file->length = ri.FS_ReadFile( file->filename, &file->buffer );
+	if ( !file->buffer || file->length < 0 ) {
+		file->buffer = NULL;
+		file->length = 0;
+	}
+
+	return qtrue;
+}
+
+/*
+=================
+R_NormalMapForImage
+
+Returns qtrue if a colour image loaded with these parameters gets a
+normal map, either name_n or one generated from it
+=================
+*/
+static qboolean R_NormalMapForImage( const char *name, imgType_t type, imgFlags_t flags, char *normalName, imgFlags_t *normalFlags )
+{
+	imgFlags_t checkFlagsTrue, checkFlagsFalse;
+
+	checkFlagsTrue = IMGFLAG_PICMIP | IMGFLAG_MIPMAP | IMGFLAG_GENNORMALMAP;
+	checkFlagsFalse = IMGFLAG_CUBEMAP;
+	if (!r_normalMapping->integer || (type != IMGTYPE_COLORALPHA) ||
+		((flags & checkFlagsTrue) != checkFlagsTrue) || (flags & checkFlagsFalse))
+	{
+		return qfalse;
+	}
+
+	*normalFlags = (flags & ~IMGFLAG_GENNORMALMAP) | IMGFLAG_NOLIGHTSCALE;
+
+	COM_StripExtension(name, normalName, MAX_QPATH);
+	Q_strcat(normalName, MAX_QPATH, "_n");
+
+	return qtrue;
+}
+
+
+/*
+==============================================================================
+
+IMAGE CACHE
+
+With r_imageCache, an image R_FindImageFile decodes from a TGA or JPG
+file is read back from the GL after it is uploaded and written to
+imagecache/ under the home path, all mips included, still compressed
+if the driver compressed it.  The file is named for a hash of the
+source file, taken from the same read the decoder uses, and everything
+else that went into processing it, so a later load of the same file
+with the same settings copies it straight to the GL without decoding,
+scaling or compressing anything, and any other load just misses.
+Nothing ever removes stale files.
+
+==============================================================================
+*/
+
+#define	IMAGE_CACHE_VERSION		1
+#define	IMAGE_CACHE_HASH_START	0xcbf29ce484222325ULL	// FNV-1a offset basis
+
+// what the cached image is to the file it was loaded from
+typedef enum {
+	IMAGECACHE_PLAIN,
+	IMAGECACHE_BRIGHTENED,			// colours, brightened for a generated normal map
+	IMAGECACHE_GENERATED_NORMAL
+} imageCacheRole_t;
+
+// everything besides the file that changes what ends up on the GL
+typedef struct {
+	int		version;
+	int		role;
+	int		type;
+	int		flags;
+	float	greyscale;
+	int		picmip;
+	int		roundImagesDown;
+	int		imageUpsample;
+	int		imageUpsampleMaxSize;
+	int		imageUpsampleType;
+	int		texturebits;
+	int		parallaxMapping;
+	int		textureCompression;
+	int		textureCompressionRef;
+	int		swizzleNormalmap;
+	int		framebufferObject;		// glGenerateMipmap or R_MipMapsRGB
+	int		maxTextureSize;
+	int		deviceSupportsGamma;
+	byte	gammatable[256];
+	byte	intensitytable[256];
+} imageCacheKey_t;
+
+typedef struct {
+	char	image[MAX_QPATH];		// to write once uploaded, or empty
+	char	normalImage[MAX_QPATH];
+} imageCacheFiles_t;
+
+/*
+================
+R_HashImageCacheBytes
+
+64 bit FNV-1a
+================
+*/
+static uint64_t R_HashImageCacheBytes( uint64_t hash, const void *data, int length ) {
+	const byte	*p = data;
+	int			i;
+
+	for ( i = 0 ; i < length ; i++ ) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+/*
+================
+R_ImageCacheName
+================
+*/
+static void R_ImageCacheName( uint64_t fileHash, imageCacheRole_t role, imgType_t type, imgFlags_t flags, char *cacheName ) {
+	imageCacheKey_t	key;
+	uint64_t		hash;
+
+	Com_Memset( &key, 0, sizeof( key ) );
+
+	key.version = IMAGE_CACHE_VERSION;
+	key.role = role;
+	key.type = type;
+	key.flags = flags;
+	key.greyscale = r_greyscale->value;
+	key.picmip = r_picmip->integer;
+	key.roundImagesDown = r_roundImagesDown->integer;
+	key.imageUpsample = r_imageUpsample->integer;
+	key.imageUpsampleMaxSize = r_imageUpsampleMaxSize->integer;
+	key.imageUpsampleType = r_imageUpsampleType->integer;
+	key.texturebits = r_texturebits->integer;
+	key.parallaxMapping = r_parallaxMapping->integer;
+	key.textureCompression = glConfig.textureCompression;
+	key.textureCompressionRef = glRefConfig.textureCompression;
+	key.swizzleNormalmap = glRefConfig.swizzleNormalmap;
+	key.framebufferObject = glRefConfig.framebufferObject;
+	key.maxTextureSize = glConfig.maxTextureSize;
+	key.deviceSupportsGamma = glConfig.deviceSupportsGamma;
+	Com_Memcpy( key.gammatable, s_gammatable, sizeof( key.gammatable ) );
+	Com_Memcpy( key.intensitytable, s_intensitytable, sizeof( key.intensitytable ) );
+
+	hash = R_HashImageCacheBytes( fileHash, &key, sizeof( key ) );
+
+	Com_sprintf( cacheName, MAX_QPATH, "imagecache/%08x%08x.dds",
+		(unsigned int)( hash >> 32 ), (unsigned int)hash );
+}
+
+/*
+================
+R_ImageCacheUsable
+
+The cache is filled by reading textures back, which OpenGL ES can't do
+================
+*/
+static qboolean R_ImageCacheUsable( imgFlags_t flags ) {
+	if ( !r_imageCache->integer || qglesMajorVersion || !qglGetTexImage || !qglGetCompressedTexImage ) {
+		return qfalse;
+	}
+
+	// tinted mips are a debugging view, not worth keeping
+	if ( ( flags & IMGFLAG_CUBEMAP ) || r_colorMipLevels->integer ) {
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+/*
+================
+R_ImageCacheMips
+
+Cached images always have every mip down to 1x1, or just the one
+================
+*/
+static int R_ImageCacheMips( int width, int height, imgFlags_t flags ) {
+	int		numMips = 1;
+
+	if ( flags & IMGFLAG_MIPMAP ) {
+		while ( width > 1 || height > 1 ) {
+			width = MAX( 1, width >> 1 );
+			height = MAX( 1, height >> 1 );
+			numMips++;
+		}
+	}
+
+	return numMips;
+}
+
+/*
+================
+R_ImageCacheSize
+================
+*/
+static int R_ImageCacheSize( int width, int height, GLenum picFormat, int numMips ) {
+	int		size = 0;
+	int		mipSize;
+
+	for ( ; numMips > 0 ; numMips-- ) {
+		mipSize = CalculateMipSize( width, height, picFormat );
+		if ( !mipSize ) {
+			return 0;
+		}
+
+		size += mipSize;
+		width = MAX( 1, width >> 1 );
+		height = MAX( 1, height >> 1 );
+	}
+
+	return size;
+}
+
+/*
+================
+R_SaveCachedImage
+
+Reads an uploaded image back from the GL into cacheName, needs the
+GL context
+================
+*/
+static void R_SaveCachedImage( image_t *image, const char *cacheName ) {
+	GLenum	picFormat;
+	byte	*pic, *out;
+	int		width, height, numMips, size, level;
+
+	// pure servers hide loose files, don't keep writing one that can't be read
+	if ( ri.FS_ReadFile( cacheName, NULL ) < 0 && ri.FS_FileExists( cacheName ) ) {
+		return;
+	}
+
+	// RawImage_GetFormat's compressed formats come back as they are,
+	// anything else as RGBA8
+	switch ( image->internalFormat ) {
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RG_RGTC2:
+		case GL_COMPRESSED_RGBA_BPTC_UNORM_ARB:
+			picFormat = image->internalFormat;
+			break;
+		default:
+			picFormat = GL_RGBA8;
+			break;
+	}
+
+	width = image->uploadWidth;
+	height = image->uploadHeight;
+	numMips = R_ImageCacheMips( width, height, image->flags );
+	size = R_ImageCacheSize( width, height, picFormat, numMips );
+	if ( !size ) {
+		return;
+	}
+
+	pic = ri.Malloc( size );
+
+	GL_BindToTMU( image, TB_COLORMAP );
+
+	for ( level = 0, out = pic ; level < numMips ; level++ ) {
+		if ( picFormat == GL_RGBA8 ) {
+			qglGetTexImage( GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, out );
+		} else {
+			qglGetCompressedTexImage( GL_TEXTURE_2D, level, out );
+		}
+
+		out += CalculateMipSize( width, height, picFormat );
+		width = MAX( 1, width >> 1 );
+		height = MAX( 1, height >> 1 );
+	}
+
+	if ( qglGetError() == GL_NO_ERROR ) {
+		R_SaveDDS2( cacheName, pic, size, image->uploadWidth, image->uploadHeight, picFormat, numMips, image->internalFormat );
+	} else {
+		ri.Printf( PRINT_DEVELOPER, "WARNING: couldn't read back %s for the image cache\n", image->imgName );
+	}
+
+	ri.Free( pic );
+}
+
+/*
+================
+R_LoadCachedPic
+
+Returns NULL unless cacheName holds a complete mip chain
+================
+*/
+static byte *R_LoadCachedPic( const char *cacheName, imgFlags_t flags, int *width, int *height, GLenum *picFormat, int *numMips, int *internalFormat ) {
+	byte	*pic;
+	int		size;
+
+	R_LoadDDS2( cacheName, &pic, width, height, picFormat, numMips, &size, internalFormat );
+	if ( !pic ) {
+		return NULL;
+	}
+
+	if ( !*internalFormat || *width < 1 || *height < 1
+		|| *width > glConfig.maxTextureSize || *height > glConfig.maxTextureSize
+		|| *numMips != R_ImageCacheMips( *width, *height, flags )
+		|| !R_ImageCacheSize( *width, *height, *picFormat, *numMips )
+		|| R_ImageCacheSize( *width, *height, *picFormat, *numMips ) > size ) {
+		ri.Printf( PRINT_DEVELOPER, "WARNING: ignoring bad image cache file %s\n", cacheName );
+		ri.Free( pic );
+		return NULL;
+	}
+
+	return pic;
+}
+
+/*
+================
+R_LoadCachedImage
+
+Looks for file, from R_ReadImageFile, in the cache.  Returns qtrue
+with image if it was there.  Otherwise files names the cache files
+to write once the image has been loaded the slow way, if any.
+================
+*/
+static qboolean R_LoadCachedImage( const char *name, const imageFile_t *file, imgType_t type, imgFlags_t flags, image_t **image, imageCacheFiles_t *files )
+{
+	char		normalName[MAX_QPATH];
+	imgFlags_t	normalFlags = 0;
+	qboolean	generateNormal = qfalse;
+	image_t		*normalImage;
+	uint64_t	fileHash;
+	byte		*pic, *normalPic = NULL;
+	GLenum		picFormat, normalPicFormat;
+	int			width, height, numMips, internalFormat;
+	int			normalWidth, normalHeight, normalNumMips, normalInternalFormat;
+
+	*image = NULL;
+	Com_Memset( files, 0, sizeof( *files ) );
+
+	// a DDS is as ready as it gets, and PNG, PCX and BMP files
+	// are read by their loaders, so hashing them would read them twice
+	if ( !file->buffer || !R_ImageCacheUsable( flags ) ) {
+		return qfalse;
+	}
+
+	fileHash = R_HashImageCacheBytes( IMAGE_CACHE_HASH_START, file->buffer, file->length );
+
+	// every loader gives RGBA8, so the same check as R_FindImageFile
+	if ( R_NormalMapForImage( name, type, flags, normalName, &normalFlags ) ) {
+		// find normalmap in case it's there, generate it if not
+		generateNormal = R_FindImageFile( normalName, IMGTYPE_NORMAL, normalFlags ) == NULL;
+	}
+
+	if ( generateNormal ) {
+		R_ImageCacheName( fileHash, IMAGECACHE_BRIGHTENED, type, flags, files->image );
+		R_ImageCacheName( fileHash, IMAGECACHE_GENERATED_NORMAL, IMGTYPE_NORMAL, normalFlags, files->normalImage );
+
+		normalPic = R_LoadCachedPic( files->normalImage, normalFlags, &normalWidth, &normalHeight,
+			&normalPicFormat, &normalNumMips, &normalInternalFormat );
+		if ( !normalPic ) {
+			return qfalse;
+		}
+	} else {
+		R_ImageCacheName( fileHash, IMAGECACHE_PLAIN, type, flags, files->image );
+	}
+
+	pic = R_LoadCachedPic( files->image, flags, &width, &height, &picFormat, &numMips, &internalFormat );
+	if ( !pic ) {
+		if ( normalPic ) {
+			ri.Free( normalPic );
+		}
+		return qfalse;
+	}
+
+	// the normal map goes first, like R_FindImageFile does it
+	if ( generateNormal ) {
+		normalImage = R_AllocImage( normalName, IMGTYPE_NORMAL, normalFlags );
+		R_UploadImage( normalImage, normalPic, normalWidth, normalHeight, normalPicFormat, normalNumMips, normalInternalFormat, qtrue );
+		ri.Free( normalPic );
+	}
+
+	*image = R_AllocImage( name, type, flags );
+	R_UploadImage( *image, pic, width, height, picFormat, numMips, internalFormat, qtrue );
+	ri.Free( pic );
+
+	tr.mapLoadImages++;
+	tr.mapLoadCached++;
+
+	Com_Memset( files, 0, sizeof( *files ) );
+	return qtrue;
+}
+
+
+/*
+==============================================================================
+
+IMAGE JOBS
+
+With r_imageThreads above 1, R_FindImageFile only reads a JPG or TGA
+file and hands back an image without storage.  R_FinishImageJobs
+decodes the queued files on the job pool, along with the normal maps
+generated from them, then scales and uploads them here.  It runs
+before any command list that could draw with them, when the queue
+fills up, and at the end of registration.
+
+==============================================================================
+*/
+
+#define	MAX_IMAGE_JOBS			1024
+#define	IMAGE_JOB_FILE_BYTES	( 64 << 20 )	// of files waiting in the queue
+#define	IMAGE_JOB_BATCH			64				// decoded pics held at once
+
+typedef struct {
+	image_t			*image;
+	image_t			*normalImage;	// generated from image, or NULL
+	int				loader;
+	char			filename[MAX_QPATH];
+	byte			*file;
+	imageCacheFiles_t	cache;
+
+	// filled in on the job pool
+	imageDecode_t	decode;
+	qboolean		ok;
+	byte			*normalPic;
+} imageJob_t;
+
+static imageJob_t	imageJobs[MAX_IMAGE_JOBS];
+static int			numImageJobs;
+static int			imageJobFileBytes;
+static qboolean		imageJobsFinishing;
+
+static void *R_ImageJobAlloc( int size ) {
+	return malloc( size );
+}
+
+/*
+================
+R_DecodeImageJob
+================
+*/
+static void R_DecodeImageJob( void *data, int index ) {
+	imageJob_t		*job = (imageJob_t *)data + index;
+	imageDecode_t	*d = &job->decode;
+
+	job->ok = imageLoaders[job->loader].Decode( d );
+	if ( !job->ok || !d->pic || !job->normalImage ) {
+		return;
+	}
+
+	job->normalPic = malloc( d->width * d->height * 4 );
+	if ( job->normalPic ) {
+		R_GenerateNormalMap( d->pic, job->normalPic, d->width, d->height, job->image->flags );
+	}
+}
+
+/*
+================
+R_ClearImageJobs
+
+Drops everything still queued
+================
+*/
+static void R_ClearImageJobs( void ) {
+	imageJob_t	*job;
+	int			i;
+
+	for ( i = 0, job = imageJobs ; i < numImageJobs ; i++, job++ ) {
+		free( job->file );
+		free( job->decode.pic );
+		free( job->normalPic );
+	}
+
+	numImageJobs = 0;
+	imageJobFileBytes = 0;
+	imageJobsFinishing = qfalse;
+}
+
+/*
+================
+R_UploadImageJob
+================
+*/
+static void R_UploadImageJob( imageJob_t *job ) {
+	imageDecode_t	*d = &job->decode;
+	byte			grey[4] = { 128, 128, 128, 255 };
+	byte			flat[4] = { 128, 128, 255, 255 };
+
+	if ( d->message[0] ) {
+		ri.Printf( PRINT_WARNING, "%s\n", d->message );
+	}
+
+	if ( !d->pic ) {
+		// too late to tell whoever asked for it, they get a stand-in
+		ri.Printf( PRINT_WARNING, "WARNING: couldn't decode %s\n", job->filename );
+		if ( job->normalImage ) {
+			R_UploadImage( job->normalImage, flat, 1, 1, GL_RGBA8, 0, 0, qfalse );
+		}
+		R_UploadImage( job->image, grey, 1, 1, GL_RGBA8, 0, 0, qfalse );
+	} else {
+		if ( job->normalImage ) {
+			if ( job->normalPic ) {
+				R_UploadImage( job->normalImage, job->normalPic, d->width, d->height, GL_RGBA8, 0, 0, qfalse );
+				if ( job->cache.normalImage[0] ) {
+					R_SaveCachedImage( job->normalImage, job->cache.normalImage );
+				}
+			} else {
+				R_UploadImage( job->normalImage, flat, 1, 1, GL_RGBA8, 0, 0, qfalse );
+			}
+		}
+		R_UploadImage( job->image, d->pic, d->width, d->height, GL_RGBA8, 0, 0, qfalse );
+		if ( job->cache.image[0] && ( job->normalPic || !job->normalImage ) ) {
+			R_SaveCachedImage( job->image, job->cache.image );
+		}
+	}
+
+	free( job->file );
+	free( d->pic );
+	free( job->normalPic );
+	job->file = NULL;
+	d->pic = NULL;
+	job->normalPic = NULL;
+}
+
+/*
+================
+R_FinishImageJobs
+
+Decodes and uploads everything R_FindImageFile queued, needs the
+GL context
+================
+*/
+void R_FinishImageJobs( void ) {
+	char	error[sizeof( imageJobs[0].decode.message )];
+	int		i, j, count;
+
+	if ( imageJobsFinishing ) {
+		// an error got out of the last call, the images are gone
+		R_ClearImageJobs();
+		return;
+	}
+
+	if ( !numImageJobs ) {
+		return;
+	}
+
+	if ( glConfig.smpActive ) {
+		GLimp_AcquireContext();
+	}
+
+	imageJobsFinishing = qtrue;
+
+	for ( i = 0 ; i < numImageJobs ; i += count ) {
+		count = MIN( IMAGE_JOB_BATCH, numImageJobs - i );
+		ri.RunJobs( R_DecodeImageJob, imageJobs + i, count, r_imageThreads->integer );
+
+		for ( j = i ; j < i + count ; j++ ) {
+			if ( !imageJobs[j].ok ) {
+				Q_strncpyz( error, imageJobs[j].decode.message, sizeof( error ) );
+				R_ClearImageJobs();
+				ri.Error( ERR_DROP, "%s", error );
+			}
+
+			R_UploadImageJob( &imageJobs[j] );
+		}
+	}
+
+	tr.mapLoadPooled += numImageJobs;
+
+	numImageJobs = 0;
+	imageJobFileBytes = 0;
+	imageJobsFinishing = qfalse;
+}
+
+/*
+================
+R_QueueImageFile
+
+Hands file, from R_ReadImageFile, to R_FinishImageJobs to decode.
+Returns qfalse if it has to be loaded right away, otherwise image is
+its placeholder.  cache is from R_LoadCachedImage.
+================
+*/
+static qboolean R_QueueImageFile( const char *name, const imageFile_t *file, imgType_t type, imgFlags_t flags, const imageCacheFiles_t *cache, image_t **image )
+{
+	imageJob_t	*job;
+	char		normalName[MAX_QPATH];
+	imgFlags_t	normalFlags = 0;
+	qboolean	generateNormal = qfalse;
+	byte		*copy;
+
+	*image = NULL;
+
+	if ( !file->buffer ) {
+		return qfalse;
+	}
+
+	// same as R_FindImageFile, JPG and TGA always decode to RGBA8
+	if ( R_NormalMapForImage( name, type, flags, normalName, &normalFlags ) ) {
+		// find normalmap in case it's there, generate it if not
+		generateNormal = R_FindImageFile( normalName, IMGTYPE_NORMAL, normalFlags ) == NULL;
+	}
+
+	if ( numImageJobs == MAX_IMAGE_JOBS || imageJobFileBytes > IMAGE_JOB_FILE_BYTES ) {
+		R_FinishImageJobs();
+	}
+
+	// the temp hunk wants its blocks back in order, so the jobs
+	// get their own copy
+	copy = malloc( file->length + 1 );
+	if ( !copy ) {
+		return qfalse;
+	}
+	Com_Memcpy( copy, file->buffer, file->length );
+
+	job = &imageJobs[numImageJobs++];
+	Com_Memset( job, 0, sizeof( *job ) );
+
+	job->loader = file->loader;
+	Q_strncpyz( job->filename, file->filename, sizeof( job->filename ) );
+	job->file = copy;
+	job->cache = *cache;
+
+	job->decode.name = job->filename;
+	job->decode.buffer = copy;
+	job->decode.length = file->length;
+	job->decode.alloc = R_ImageJobAlloc;
+	job->decode.free = free;
+
+	imageJobFileBytes += file->length;
+	tr.mapLoadImages++;
+
+	// the normal map goes first, like R_FindImageFile does it
+	if ( generateNormal ) {
+		job->normalImage = R_AllocImage( normalName, IMGTYPE_NORMAL, normalFlags );
+	}
+	job->image = R_AllocImage( name, type, flags );
+
+	*image = job->image;
+	return qtrue;
+}
+
+
 /*
 ===============
 R_FindImageFile
@@ -2558,7 +3474,10 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 	GLenum  picFormat;
 	int picNumMips;
 	long	hash;
-	imgFlags_t checkFlagsTrue, checkFlagsFalse;
+	imageFile_t file;
+	imageCacheFiles_t cache;
+	char normalName[MAX_QPATH];
+	imgFlags_t normalFlags;
 
 	if (!name) {
 		return NULL;
@@ -2581,28 +3500,43 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 		}
 	}
 
+	//
+	// JPG and TGA files are read once, for everything below
+	//
+	if ( !R_ReadImageFile( name, &file ) ) {
+		return NULL;
+	}
+
+	//
+	// with r_imageCache, processed images may be on disk already
+	//
+	if ( R_LoadCachedImage( name, &file, type, flags, &image, &cache ) ) {
+		R_FreeImageFile( &file );
+		return image;
+	}
+
+	//
+	// with the job pool, JPG and TGA files are decoded later
+	//
+	if ( r_imageThreads->integer > 1 && R_QueueImageFile( name, &file, type, flags, &cache, &image ) ) {
+		R_FreeImageFile( &file );
+		return image;
+	}
+
 	//
 	// load the pic from disk
 	//
-	R_LoadImage( name, &pic, &width, &height, &picFormat, &picNumMips );
+	R_LoadImage( name, &file, &pic, &width, &height, &picFormat, &picNumMips );
 	if ( pic == NULL ) {
 		return NULL;
 	}
+	tr.mapLoadImages++;
 
-	checkFlagsTrue = IMGFLAG_PICMIP | IMGFLAG_MIPMAP | IMGFLAG_GENNORMALMAP;
-	checkFlagsFalse = IMGFLAG_CUBEMAP;
-	if (r_normalMapping->integer && (picFormat == GL_RGBA8) && (type == IMGTYPE_COLORALPHA) &&
-		((flags & checkFlagsTrue) == checkFlagsTrue) && !(flags & checkFlagsFalse))
+	if ((picFormat == GL_RGBA8) && R_NormalMapForImage(name, type, flags, normalName, &normalFlags))
 	{
-		char normalName[MAX_QPATH];
 		image_t *normalImage;
+		byte *normalPic;
 		int normalWidth, normalHeight;
-		imgFlags_t normalFlags;
-
-		normalFlags = (flags & ~IMGFLAG_GENNORMALMAP) | IMGFLAG_NOLIGHTSCALE;
-
-		COM_StripExtension(name, normalName, MAX_QPATH);
-		Q_strcat(normalName, MAX_QPATH, "_n");
 
 		// find normalmap in case it's there
 		normalImage = R_FindImageFile(normalName, IMGTYPE_NORMAL, normalFlags);
@@ -2610,88 +3544,17 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 		// if not, generate it
 		if (normalImage == NULL)
 		{
-			byte *normalPic;
-			int x, y;
-
 			normalWidth = width;
 			normalHeight = height;
 			normalPic = ri.Malloc(width * height * 4);
-			RGBAtoNormal(pic, normalPic, width, height, flags & IMGFLAG_CLAMPTOEDGE);
+			R_GenerateNormalMap(pic, normalPic, width, height, flags);
 
-#if 1
-			// Brighten up the original image to work with the normal map
-			RGBAtoYCoCgA(pic, pic, width, height);
-			for (y = 0; y < height; y++)
-			{
-				byte *picbyte  = pic       + y * width * 4;
-				byte *normbyte = normalPic + y * width * 4;
-				for (x = 0; x < width; x++)
-				{
-					int div = MAX(normbyte[2] - 127, 16);
-					picbyte[0] = CLAMP(picbyte[0] * 128 / div, 0, 255);
-					picbyte  += 4;
-					normbyte += 4;
-				}
-			}
-			YCoCgAtoRGBA(pic, pic, width, height);
-#else
-			// Blur original image's luma to work with the normal map
-			{
-				byte *blurPic;
-
-				RGBAtoYCoCgA(pic, pic, width, height);
-				blurPic = ri.Malloc(width * height);
-
-				for (y = 1; y < height - 1; y++)
-				{
-					byte *picbyte  = pic     + y * width * 4;
-					byte *blurbyte = blurPic + y * width;
-
-					picbyte += 4;
-					blurbyte += 1;
-
-					for (x = 1; x < width - 1; x++)
-					{
-						int result;
-
-						result = *(picbyte - (width + 1) * 4) + *(picbyte - width * 4) + *(picbyte - (width - 1) * 4) +
-						         *(picbyte -          1  * 4) + *(picbyte            ) + *(picbyte +          1  * 4) +
-						         *(picbyte + (width - 1) * 4) + *(picbyte + width * 4) + *(picbyte + (width + 1) * 4);
-
-						result /= 9;
-
-						*blurbyte = result;
-						picbyte += 4;
-						blurbyte += 1;
-					}
-				}
-
-				// FIXME: do borders
-
-				for (y = 1; y < height - 1; y++)
-				{
-					byte *picbyte  = pic     + y * width * 4;
-					byte *blurbyte = blurPic + y * width;
-
-					picbyte += 4;
-					blurbyte += 1;
-
-					for (x = 1; x < width - 1; x++)
-					{
-						picbyte[0] = *blurbyte;
-						picbyte += 4;
-						blurbyte += 1;
-					}
-				}
-
-				ri.Free(blurPic);
+			normalImage = R_CreateImage( normalName, normalPic, normalWidth, normalHeight, IMGTYPE_NORMAL, normalFlags, 0 );
+			ri.Free( normalPic );	
 
-				YCoCgAtoRGBA(pic, pic, width, height);
+			if ( cache.normalImage[0] ) {
+				R_SaveCachedImage( normalImage, cache.normalImage );
 			}
-#endif
-
-			R_CreateImage( normalName, normalPic, normalWidth, normalHeight, IMGTYPE_NORMAL, normalFlags, 0 );
-			ri.Free( normalPic );	
 		}
 	}
 
@@ -2711,6 +3574,11 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 
 	image = R_CreateImage2( ( char * ) name, pic, width, height, picFormat, picNumMips, type, flags, 0 );
 	ri.Free( pic );
+
+	if ( cache.image[0] ) {
+		R_SaveCachedImage( image, cache.image );
+	}
+
 	return image;
 }
 
@@ -3098,6 +3966,8 @@ void R_DeleteTextures( void ) {
 
 	tr.numImages = 0;
 
+	R_ClearImageJobs();
+
 	GL_BindNullTextures();
 }
 
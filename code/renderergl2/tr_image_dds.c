@@ -213,7 +213,21 @@ typedef enum DXGI_FORMAT {
                          (((ui32_t)((x)[3])) << 24) )
 
 
-void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips )
+// r_imageCache files are tagged so they can carry the exact internal format
+#define DDS_CACHE_TAG      EncodeFourCC("Q3IC")
+#define DDS_CACHE_TAG_SLOT 9
+#define DDS_CACHE_FMT_SLOT 10
+
+
+/*
+===============
+R_LoadDDS2
+
+Like R_LoadDDS, also returns the size of the pixel data and the
+internal format a tagged file was read back from, or 0
+===============
+*/
+void R_LoadDDS2 ( const char *filename, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips, int *size, int *internalFormat )
 {
 	union {
 		byte *b;
@@ -238,6 +252,10 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
 		*picFormat = GL_RGBA8;
 	if (numMips)
 		*numMips = 1;
+	if (size)
+		*size = 0;
+	if (internalFormat)
+		*internalFormat = 0;
 
 	*pic = NULL;
 
@@ -446,12 +464,29 @@ void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLen
 		}
 	}
 
+	if (internalFormat && ddsHeader->reserved1[DDS_CACHE_TAG_SLOT] == DDS_CACHE_TAG)
+	{
+		*internalFormat = ddsHeader->reserved1[DDS_CACHE_FMT_SLOT];
+
+		// the DXGI format doesn't tell DXT1 with and without alpha apart
+		if (*picFormat != GL_RGBA8 && *picFormat != GL_SRGB8_ALPHA8_EXT)
+			*picFormat = *internalFormat;
+	}
+
+	if (size)
+		*size = len;
+
 	*pic = ri.Malloc(len);
 	Com_Memcpy(*pic, data, len);
 
 	ri.FS_FreeFile(buffer.v);
 }
 
+void R_LoadDDS ( const char *filename, byte **pic, int *width, int *height, GLenum *picFormat, int *numMips )
+{
+	R_LoadDDS2(filename, pic, width, height, picFormat, numMips, NULL, NULL);
+}
+
 void R_SaveDDS(const char *filename, byte *pic, int width, int height, int depth)
 {
 	byte *data;
@@ -496,3 +531,132 @@ void R_SaveDDS(const char *filename, byte *pic, int width, int height, int depth
 
 	ri.Free(data);
 }
+
+/*
+===============
+R_SaveDDS2
+
+Writes a full mip chain with a DX10 header, tagged with the internal
+format it was read back from for R_LoadDDS2
+===============
+*/
+void R_SaveDDS2(const char *filename, byte *pic, int picSize, int width, int height, GLenum picFormat, int numMips, int internalFormat)
+{
+	byte *data;
+	ddsHeader_t *ddsHeader;
+	ddsHeaderDxt10_t *ddsHeaderDxt10;
+	ui32_t dxgiFormat;
+	int size;
+
+	switch (picFormat)
+	{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+			dxgiFormat = DXGI_FORMAT_BC1_UNORM;
+			break;
+
+		case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+			dxgiFormat = DXGI_FORMAT_BC1_UNORM_SRGB;
+			break;
+
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+			dxgiFormat = DXGI_FORMAT_BC2_UNORM;
+			break;
+
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+			dxgiFormat = DXGI_FORMAT_BC2_UNORM_SRGB;
+			break;
+
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			dxgiFormat = DXGI_FORMAT_BC3_UNORM;
+			break;
+
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+			dxgiFormat = DXGI_FORMAT_BC3_UNORM_SRGB;
+			break;
+
+		case GL_COMPRESSED_RED_RGTC1:
+			dxgiFormat = DXGI_FORMAT_BC4_UNORM;
+			break;
+
+		case GL_COMPRESSED_SIGNED_RED_RGTC1:
+			dxgiFormat = DXGI_FORMAT_BC4_SNORM;
+			break;
+
+		case GL_COMPRESSED_RG_RGTC2:
+			dxgiFormat = DXGI_FORMAT_BC5_UNORM;
+			break;
+
+		case GL_COMPRESSED_SIGNED_RG_RGTC2:
+			dxgiFormat = DXGI_FORMAT_BC5_SNORM;
+			break;
+
+		case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB:
+			dxgiFormat = DXGI_FORMAT_BC6H_UF16;
+			break;
+
+		case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_ARB:
+			dxgiFormat = DXGI_FORMAT_BC6H_SF16;
+			break;
+
+		case GL_COMPRESSED_RGBA_BPTC_UNORM_ARB:
+			dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+			break;
+
+		case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB:
+			dxgiFormat = DXGI_FORMAT_BC7_UNORM_SRGB;
+			break;
+
+		case GL_SRGB8_ALPHA8_EXT:
+			dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+			break;
+
+		case GL_RGBA8:
+			dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+			break;
+
+		default:
+			ri.Printf(PRINT_DEVELOPER, "R_SaveDDS2: can't write %s with format %08x\n", filename, picFormat);
+			return;
+	}
+
+	size = 4 + sizeof(*ddsHeader) + sizeof(*ddsHeaderDxt10) + picSize;
+	data = ri.Malloc(size);
+
+	data[0] = 'D';
+	data[1] = 'D';
+	data[2] = 'S';
+	data[3] = ' ';
+
+	ddsHeader = (ddsHeader_t *)(data + 4);
+	memset(ddsHeader, 0, sizeof(ddsHeader_t));
+
+	ddsHeader->headerSize = 0x7c;
+	ddsHeader->flags = _DDSFLAGS_REQUIRED | _DDSFLAGS_MIPMAPCOUNT;
+	ddsHeader->height = height;
+	ddsHeader->width = width;
+	ddsHeader->numMips = numMips;
+	ddsHeader->reserved1[DDS_CACHE_TAG_SLOT] = DDS_CACHE_TAG;
+	ddsHeader->reserved1[DDS_CACHE_FMT_SLOT] = internalFormat;
+	ddsHeader->always_0x00000020 = 0x00000020;
+	ddsHeader->pixelFormatFlags = DDSPF_FOURCC;
+	ddsHeader->fourCC = EncodeFourCC("DX10");
+	ddsHeader->caps = DDSCAPS_REQUIRED;
+
+	if (numMips > 1)
+		ddsHeader->caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+	ddsHeaderDxt10 = (ddsHeaderDxt10_t *)(data + 4 + sizeof(*ddsHeader));
+	memset(ddsHeaderDxt10, 0, sizeof(ddsHeaderDxt10_t));
+
+	ddsHeaderDxt10->dxgiFormat = dxgiFormat;
+	ddsHeaderDxt10->dimensions = 3; // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+	ddsHeaderDxt10->arraySize = 1;
+
+	Com_Memcpy(data + 4 + sizeof(*ddsHeader) + sizeof(*ddsHeaderDxt10), pic, picSize);
+
+	ri.FS_WriteFile(filename, data, size);
+
+	ri.Free(data);
+}
@@ -63,6 +63,10 @@ cvar_t	*r_stereoSeparation;
 cvar_t	*r_useFlush;
 
 cvar_t	*r_skipBackEnd;
+cvar_t	*r_smp;
+cvar_t	*r_showSmp;
+cvar_t	*r_imageThreads;
+cvar_t	*r_imageCache;
 
 cvar_t	*r_stereoEnabled;
 cvar_t	*r_anaglyphMode;
@@ -108,6 +112,7 @@ cvar_t  *r_ext_framebuffer_multisample;
 cvar_t  *r_arb_seamless_cube_map;
 cvar_t  *r_arb_vertex_array_object;
 cvar_t  *r_ext_direct_state_access;
+cvar_t  *r_ext_multiview;
 
 cvar_t  *r_cameraExposure;
 
@@ -1109,6 +1114,9 @@ void GfxInfo_f( void )
 		"fullscreen"
 	};
 
+	// the render thread may hold the context
+	R_IssuePendingRenderCommands();
+
 	ri.Printf( PRINT_ALL, "\nGL_VENDOR: %s\n", glConfig.vendor_string );
 	ri.Printf( PRINT_ALL, "GL_RENDERER: %s\n", glConfig.renderer_string );
 	ri.Printf( PRINT_ALL, "GL_VERSION: %s\n", glConfig.version_string );
@@ -1172,6 +1180,9 @@ void GfxInfo_f( void )
 	if ( r_finish->integer ) {
 		ri.Printf( PRINT_ALL, "Forcing glFinish\n" );
 	}
+	if ( glConfig.smpActive ) {
+		ri.Printf( PRINT_ALL, "Using dual processor acceleration\n" );
+	}
 }
 
 /*
@@ -1181,6 +1192,8 @@ GfxMemInfo_f
 */
 void GfxMemInfo_f( void ) 
 {
+	R_IssuePendingRenderCommands();
+
 	switch (glRefConfig.memInfo)
 	{
 		case MI_NONE:
@@ -1252,11 +1265,17 @@ void R_Register( void )
 	r_arb_seamless_cube_map = ri.Cvar_Get( "r_arb_seamless_cube_map", "0", CVAR_ARCHIVE | CVAR_LATCH);
 	r_arb_vertex_array_object = ri.Cvar_Get( "r_arb_vertex_array_object", "1", CVAR_ARCHIVE | CVAR_LATCH);
 	r_ext_direct_state_access = ri.Cvar_Get("r_ext_direct_state_access", "1", CVAR_ARCHIVE | CVAR_LATCH);
+	r_ext_multiview = ri.Cvar_Get("r_ext_multiview", "1", CVAR_ARCHIVE | CVAR_LATCH);
 
 	r_ext_texture_filter_anisotropic = ri.Cvar_Get( "r_ext_texture_filter_anisotropic",
 			"0", CVAR_ARCHIVE | CVAR_LATCH );
 	r_ext_max_anisotropy = ri.Cvar_Get( "r_ext_max_anisotropy", "2", CVAR_ARCHIVE | CVAR_LATCH );
 
+	r_smp = ri.Cvar_Get( "r_smp", "0", CVAR_ARCHIVE | CVAR_LATCH );
+	r_imageThreads = ri.Cvar_Get( "r_imageThreads", "4", CVAR_ARCHIVE );
+	ri.Cvar_CheckRange( r_imageThreads, 0, 32, qtrue );
+	r_imageCache = ri.Cvar_Get( "r_imageCache", "1", CVAR_ARCHIVE );
+
 	r_picmip = ri.Cvar_Get ("r_picmip", "0", CVAR_ARCHIVE | CVAR_LATCH );
 	r_roundImagesDown = ri.Cvar_Get ("r_roundImagesDown", "0", CVAR_ARCHIVE | CVAR_LATCH );
 	r_colorMipLevels = ri.Cvar_Get ("r_colorMipLevels", "0", CVAR_LATCH );
@@ -1416,6 +1435,7 @@ void R_Register( void )
 	r_flareCoeff = ri.Cvar_Get ("r_flareCoeff", FLARE_STDCOEFF, CVAR_CHEAT);
 
 	r_skipBackEnd = ri.Cvar_Get ("r_skipBackEnd", "0", CVAR_CHEAT);
+	r_showSmp = ri.Cvar_Get ("r_showSmp", "0", CVAR_CHEAT);
 
 	r_measureOverdraw = ri.Cvar_Get( "r_measureOverdraw", "0", CVAR_CHEAT );
 	r_lodscale = ri.Cvar_Get( "r_lodscale", "5", CVAR_CHEAT );
@@ -1553,10 +1573,18 @@ void R_Init( void ) {
 	if (max_polyverts < MAX_POLYVERTS)
 		max_polyverts = MAX_POLYVERTS;
 
-	ptr = ri.Hunk_Alloc( sizeof( *backEndData ) + sizeof(srfPoly_t) * max_polys + sizeof(polyVert_t) * max_polyverts, h_low);
-	backEndData = (backEndData_t *) ptr;
-	backEndData->polys = (srfPoly_t *) ((char *) ptr + sizeof( *backEndData ));
-	backEndData->polyVerts = (polyVert_t *) ((char *) ptr + sizeof( *backEndData ) + sizeof(srfPoly_t) * max_polys);
+	ptr = ri.Hunk_Alloc( sizeof( *backEndData[0] ) + sizeof(srfPoly_t) * max_polys + sizeof(polyVert_t) * max_polyverts, h_low);
+	backEndData[0] = (backEndData_t *) ptr;
+	backEndData[0]->polys = (srfPoly_t *) ((char *) ptr + sizeof( *backEndData[0] ));
+	backEndData[0]->polyVerts = (polyVert_t *) ((char *) ptr + sizeof( *backEndData[0] ) + sizeof(srfPoly_t) * max_polys);
+	if ( r_smp->integer ) {
+		ptr = ri.Hunk_Alloc( sizeof( *backEndData[1] ) + sizeof(srfPoly_t) * max_polys + sizeof(polyVert_t) * max_polyverts, h_low);
+		backEndData[1] = (backEndData_t *) ptr;
+		backEndData[1]->polys = (srfPoly_t *) ((char *) ptr + sizeof( *backEndData[1] ));
+		backEndData[1]->polyVerts = (polyVert_t *) ((char *) ptr + sizeof( *backEndData[1] ) + sizeof(srfPoly_t) * max_polys);
+	} else {
+		backEndData[1] = NULL;
+	}
 	R_InitNextFrame();
 
 	InitOpenGL();
@@ -1585,6 +1613,18 @@ void R_Init( void ) {
 	if ( err != GL_NO_ERROR )
 		ri.Printf (PRINT_ALL, "glGetError() = 0x%x\n", err);
 
+	// the render thread starts out idle, the context stays here
+	// until the first frame is handed over
+	if ( r_smp->integer ) {
+		ri.Printf( PRINT_ALL, "Trying SMP acceleration...\n" );
+		if ( GLimp_SpawnRenderThread( RB_RenderThread ) ) {
+			ri.Printf( PRINT_ALL, "...succeeded.\n" );
+			glConfig.smpActive = qtrue;
+		} else {
+			ri.Printf( PRINT_ALL, "...failed.\n" );
+		}
+	}
+
 	// print info
 	GfxInfo_f();
 	ri.Printf( PRINT_ALL, "----- finished R_Init -----\n" );
@@ -1614,6 +1654,16 @@ void RE_Shutdown( qboolean destroyWindow ) {
 
 	if ( tr.registered ) {
 		R_IssuePendingRenderCommands();
+	}
+
+	// the context comes back to this thread as the render thread stops
+	if ( glConfig.smpActive ) {
+		GLimp_ShutdownRenderThread();
+		glConfig.smpActive = qfalse;
+	}
+	tr.vrFrameQueued = qfalse;
+
+	if ( tr.registered ) {
 		R_ShutDownQueries();
 		if (glRefConfig.framebufferObject)
 		{
@@ -1657,6 +1707,19 @@ Touch all images to make sure they are resident
 */
 void RE_EndRegistration( void ) {
 	R_IssuePendingRenderCommands();
+	R_FinishImageJobs();
+
+	if ( tr.mapLoadStart ) {
+		if ( r_imageThreads->integer > 1 ) {
+			ri.Printf( PRINT_ALL, "map loaded in %i msec, %i image files, %i from the cache, %i decoded on %i threads\n",
+				ri.Milliseconds() - tr.mapLoadStart, tr.mapLoadImages, tr.mapLoadCached, tr.mapLoadPooled, r_imageThreads->integer );
+		} else {
+			ri.Printf( PRINT_ALL, "map loaded in %i msec, %i image files, %i from the cache, no image jobs\n",
+				ri.Milliseconds() - tr.mapLoadStart, tr.mapLoadImages, tr.mapLoadCached );
+		}
+		tr.mapLoadStart = 0;
+	}
+
 	if (!ri.Sys_LowPhysicalMemory()) {
 		RB_ShowImages();
 	}
@@ -1718,6 +1781,9 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp ) {
 	re.HUDBufferStart = RE_HUDBufferStart;
 	re.HUDBufferEnd = RE_HUDBufferEnd;
 	re.SetVRHeadsetParms = RE_SetVRHeadsetParms;
+	re.BeginVRFrame = RE_BeginVRFrame;
+	re.EndVRFrame = RE_EndVRFrame;
+	re.SyncRenderThread = R_SyncRenderThread;
 
 	re.SetColor = RE_SetColor;
 	re.DrawStretchPic = RE_StretchPic;
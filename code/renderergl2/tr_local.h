@@ -45,6 +45,7 @@ extern vr_clientinfo_t vr;
 QGL_1_1_PROCS;
 QGL_DESKTOP_1_1_PROCS;
 QGL_1_3_PROCS;
+QGL_DESKTOP_1_3_PROCS;
 QGL_1_5_PROCS;
 QGL_2_0_PROCS;
 QGL_3_0_PROCS;
@@ -1454,6 +1455,7 @@ typedef struct {
 
 	qboolean vertexArrayObject;
 	qboolean directStateAccess;
+	qboolean multiview;
 
 	int maxVertexAttribs;
 	qboolean gpuVertexAnimation;
@@ -1516,6 +1518,9 @@ typedef struct {
 	FBO_t *last2DFBO;
 	qboolean    colorMask[4];
 	qboolean    depthFill;
+
+	int			vrRenderBuffer;	// swapchain framebuffer acquired by the last RC_VR_FRAME
+	int			stereoEye;		// eye being drawn when there is no multiview
 } backEndState_t;
 
 /*
@@ -1529,6 +1534,10 @@ typedef struct {
 typedef struct {
 	qboolean				registered;		// cleared at shutdown, set at beginRegistration
 
+	int						smpFrame;		// which backEndData the front end is filling
+	qboolean				vrFrameQueued;	// the VR frame is issued by RE_EndVRFrame, not RE_EndFrame
+	int						smpBackEndMsec;	// back end time of the last frame the render thread finished
+
 	int						visIndex;
 	int						visClusters[MAX_VISCOUNTS];
 	int						visCounts[MAX_VISCOUNTS];	// incremented every time a new vis cluster is entered
@@ -1671,6 +1680,11 @@ typedef struct {
 	frontEndCounters_t		pc;
 	int						frontEndMsec;		// not in pc due to clearing issue
 
+	int						mapLoadStart;		// ri.Milliseconds() in RE_LoadWorldMap, 0 once reported
+	int						mapLoadImages;		// image files loaded since then
+	int						mapLoadPooled;		// of those, decoded on the job pool
+	int						mapLoadCached;		// of those, uploaded from r_imageCache
+
 	//
 	// put large tables at the end, so most elements will be
 	// within the +/32K indexed range on risc processors
@@ -1768,6 +1782,7 @@ extern  cvar_t  *r_ext_framebuffer_multisample;
 extern  cvar_t  *r_arb_seamless_cube_map;
 extern  cvar_t  *r_arb_vertex_array_object;
 extern  cvar_t  *r_ext_direct_state_access;
+extern  cvar_t  *r_ext_multiview;
 
 extern	cvar_t	*r_nobind;						// turns off binding to appropriate textures
 extern	cvar_t	*r_singleShader;				// make most world faces use default shader
@@ -1803,6 +1818,10 @@ extern	cvar_t	*r_portalOnly;
 extern	cvar_t	*r_subdivisions;
 extern	cvar_t	*r_lodCurveError;
 extern	cvar_t	*r_skipBackEnd;
+extern	cvar_t	*r_smp;
+extern	cvar_t	*r_showSmp;
+extern	cvar_t	*r_imageThreads;
+extern	cvar_t	*r_imageCache;
 
 extern	cvar_t	*r_anaglyphMode;
 
@@ -2034,6 +2053,7 @@ void	R_InitFogTable( void );
 float	R_FogFactor( float s, float t );
 void	R_InitImages( void );
 void	R_DeleteTextures( void );
+void	R_FinishImageJobs( void );
 int		R_SumOfUsedImages( void );
 void	R_InitSkins( void );
 skin_t	*R_GetSkinByHandle( qhandle_t hSkin );
@@ -2283,7 +2303,6 @@ GLSL
 */
 
 void GLSL_InitGPUShaders(void);
-void GLSL_PrepareUniformBuffers(void);
 void GLSL_ShutdownGPUShaders(void);
 void GLSL_VertexAttribPointers(uint32_t attribBits);
 void GLSL_BindProgram(shaderProgram_t * program);
@@ -2507,6 +2526,23 @@ typedef struct {
 	qboolean clear; // Clear the buffer?
 } hudBufferCommand_t;
 
+// the uniform buffers are filled by the back end from a copy of the
+// front end matrices, so the render thread never reads tr.vrParms
+typedef struct {
+	int		commandId;
+	float	projection[16];
+	float	mirrorProjection[16];
+	float	monoVRProjection[16];
+	float	eyeViewMatrix[2][16];
+	float	modelView[16];
+} uniformBuffersCommand_t;
+
+typedef struct {
+	int		commandId;
+	int		(*func)( void *data );
+	void	*data;
+} vrFrameCommand_t;
+
 typedef enum {
 	RC_END_OF_LIST,
 	RC_SET_COLOR,
@@ -2522,7 +2558,9 @@ typedef enum {
 	RC_POSTPROCESS,
 	RC_EXPORT_CUBEMAPS,
 	RC_SWITCH_EYE,
-	RC_HUD_BUFFER
+	RC_HUD_BUFFER,
+	RC_UNIFORM_BUFFERS,
+	RC_VR_FRAME
 } renderCommand_t;
 
 
@@ -2547,18 +2585,26 @@ typedef struct {
 extern	int		max_polys;
 extern	int		max_polyverts;
 
-extern	backEndData_t	*backEndData;	// the second one may not be allocated
+#define	SMP_FRAMES		2
+
+extern	backEndData_t	*backEndData[SMP_FRAMES];	// the second one may not be allocated
+
+extern	volatile qboolean	renderThreadActive;
 
 
 void *R_GetCommandBuffer( int bytes );
 void RB_ExecuteRenderCommands( const void *data );
 
 void R_IssuePendingRenderCommands( void );
+void R_SyncRenderThread( void );
+void RB_RenderThread( void );
 
 void R_AddDrawSurfCmd( drawSurf_t *drawSurfs, int numDrawSurfs );
 void R_AddCapShadowmapCmd( int dlight, int cubeSide );
 void R_AddPostProcessCmd (void);
 
+void GLSL_PrepareUniformBuffers(const uniformBuffersCommand_t *cmd);
+
 void RE_SetColor( const float *rgba );
 void RE_StretchPic ( float x, float y, float w, float h, 
 					  float s1, float t1, float s2, float t2, qhandle_t hShader );
@@ -2569,6 +2615,8 @@ void RE_SetVRHeadsetParms( const float projectionMatrix[16],
 					  int renderBuffer );
 void RE_HUDBufferStart( qboolean clear );
 void RE_HUDBufferEnd( void );
+void RE_BeginVRFrame( int (*func)( void *data ), void *data );
+qboolean RE_EndVRFrame( int (*func)( void *data ), void *data );
 
 void RE_SaveJPG(char * filename, int quality, int image_width, int image_height,
                 unsigned char *image_buffer, int padding);
@@ -560,6 +560,22 @@ void R_RotateForEntity( const trRefEntity_t *ent, const viewParms_t *viewParms,
 	or->viewOrigin[2] = DotProduct( delta, or->axis[2] ) * axisLength;
 }
 
+/*
+=================
+R_StereoEyeOffset
+
+How far each eye sits from the view origin along or.axis[1],
+the left eye on the positive side
+=================
+*/
+static float R_StereoEyeOffset( void ) {
+	if ( VR_Gameplay_ShouldRenderInVirtualScreen() ) {
+		return 0.0f;
+	}
+
+	return ((r_stereoSeparation->value / 1000.0f) / 2.0f) * vr_worldscale->value * vr_worldscaleScaler->value;
+}
+
 /*
 =================
 R_RotateForViewer
@@ -570,6 +586,7 @@ Sets up the modelview matrix for a given viewParm
 void R_RotateForViewer (void) 
 {
 	float	viewerMatrix[16];
+	float	eyeOffset = R_StereoEyeOffset();
 
 	Com_Memset (&tr.or, 0, sizeof(tr.or));
 	tr.or.axis[0][0] = 1;
@@ -583,10 +600,9 @@ void R_RotateForViewer (void)
 		vec3_t	origin;
 		VectorCopy(tr.viewParms.or.origin, origin);
 
-		if ((eye < 2) && !VR_Gameplay_ShouldRenderInVirtualScreen())
+		if (eye < 2)
 		{
-			float scale = ((r_stereoSeparation->value / 1000.0f) / 2.0f) * vr_worldscale->value * vr_worldscaleScaler->value;
-			VectorMA(origin, (eye == 0 ? 1.0f : -1.0f) * scale, tr.viewParms.or.axis[1], origin);
+			VectorMA(origin, (eye == 0 ? 1.0f : -1.0f) * eyeOffset, tr.viewParms.or.axis[1], origin);
 		}
 
 		viewerMatrix[0] = tr.viewParms.or.axis[0][0];
@@ -694,6 +710,63 @@ static void R_SetFarClip( void )
 	tr.viewParms.zFar = sqrt( farthestCornerDistance );
 }
 
+/*
+=================
+R_SetupStereoFrustum
+
+Culling frustum holding what either eye sees, so both eyes share
+one set of draw surfaces.  The side planes come from the headset
+projection, which may be asymmetric, and each passes through the
+eye on its own side.
+=================
+*/
+static void R_SetupStereoFrustum( void ) {
+	const float	*m = tr.viewParms.projectionMatrix;
+	float		tanLeft, tanRight, tanDown, tanUp;
+	float		eyeOffset;
+	vec3_t		leftEye, rightEye;
+	int			i;
+
+	// column-major GL projection, as built by XrMatrix4x4f_CreateProjectionFov
+	tanRight = ( m[8] + 1.0f ) / m[0];
+	tanLeft = ( m[8] - 1.0f ) / m[0];
+	tanUp = ( m[9] + 1.0f ) / m[5];
+	tanDown = ( m[9] - 1.0f ) / m[5];
+
+	eyeOffset = R_StereoEyeOffset();
+	VectorMA( tr.viewParms.or.origin, eyeOffset, tr.viewParms.or.axis[1], leftEye );
+	VectorMA( tr.viewParms.or.origin, -eyeOffset, tr.viewParms.or.axis[1], rightEye );
+
+	// right edge of the right eye
+	VectorScale( tr.viewParms.or.axis[0], tanRight, tr.viewParms.frustum[0].normal );
+	VectorAdd( tr.viewParms.frustum[0].normal, tr.viewParms.or.axis[1], tr.viewParms.frustum[0].normal );
+	tr.viewParms.frustum[0].dist = DotProduct( rightEye, tr.viewParms.frustum[0].normal );
+
+	// left edge of the left eye
+	VectorScale( tr.viewParms.or.axis[0], -tanLeft, tr.viewParms.frustum[1].normal );
+	VectorSubtract( tr.viewParms.frustum[1].normal, tr.viewParms.or.axis[1], tr.viewParms.frustum[1].normal );
+	tr.viewParms.frustum[1].dist = DotProduct( leftEye, tr.viewParms.frustum[1].normal );
+
+	// bottom and top, both eyes are level
+	VectorScale( tr.viewParms.or.axis[0], -tanDown, tr.viewParms.frustum[2].normal );
+	VectorAdd( tr.viewParms.frustum[2].normal, tr.viewParms.or.axis[2], tr.viewParms.frustum[2].normal );
+
+	VectorScale( tr.viewParms.or.axis[0], tanUp, tr.viewParms.frustum[3].normal );
+	VectorSubtract( tr.viewParms.frustum[3].normal, tr.viewParms.or.axis[2], tr.viewParms.frustum[3].normal );
+
+	for ( i = 0 ; i < 4 ; i++ ) {
+		float length = VectorNormalize( tr.viewParms.frustum[i].normal );
+
+		tr.viewParms.frustum[i].type = PLANE_NON_AXIAL;
+		if ( i < 2 ) {
+			tr.viewParms.frustum[i].dist /= length;
+		} else {
+			tr.viewParms.frustum[i].dist = DotProduct( tr.viewParms.or.origin, tr.viewParms.frustum[i].normal );
+		}
+		SetPlaneSignbits( &tr.viewParms.frustum[i] );
+	}
+}
+
 /*
 =================
 R_SetupFrustum
@@ -706,6 +779,12 @@ void R_SetupFrustum( void ) {
 	float xs, xc;
 	float ang;
 
+	// the headset projection is what both eyes are drawn with
+	if ( tr.vrParms.valid ) {
+		R_SetupStereoFrustum();
+		return;
+	}
+
 	ang = tr.viewParms.fovX / 180 * M_PI * 0.5f;
 	xs = sinf( ang );
 	xc = cosf( ang );
@@ -1460,6 +1539,8 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 		return;
 	}
 
+	R_PROFILE_BEGIN( PROFILE_R_SORTDRAWSURFS );
+
 	// sort the drawsurfs by sort type, then orientation, then shader
 	R_RadixSort( drawSurfs, numDrawSurfs );
 
@@ -1467,6 +1548,7 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 	if (tr.viewParms.flags & (VPF_SHADOWMAP | VPF_DEPTHSHADOW))
 	{
 		R_AddDrawSurfCmd( drawSurfs, numDrawSurfs );
+		R_PROFILE_END( PROFILE_R_SORTDRAWSURFS );
 		return;
 	}
 
@@ -1488,6 +1570,7 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 		if ( R_MirrorViewBySurface( (drawSurfs+i), entityNum) ) {
 			// this is a debug option to see exactly what is being mirrored
 			if ( r_portalOnly->integer ) {
+				R_PROFILE_END( PROFILE_R_SORTDRAWSURFS );
 				return;
 			}
 			break;		// only one mirror view at a time
@@ -1495,6 +1578,8 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 	}
 
 	R_AddDrawSurfCmd( drawSurfs, numDrawSurfs );
+
+	R_PROFILE_END( PROFILE_R_SORTDRAWSURFS );
 }
 
 static void R_AddEntitySurface (int entityNum)
@@ -1601,6 +1686,8 @@ R_GenerateDrawSurfs
 ====================
 */
 void R_GenerateDrawSurfs( void ) {
+	R_PROFILE_BEGIN( PROFILE_R_GENERATEDRAWSURFS );
+
 	R_AddWorldSurfaces ();
 
 	R_AddPolygonSurfaces();
@@ -1621,6 +1708,8 @@ void R_GenerateDrawSurfs( void ) {
 	R_SetupProjectionZ (&tr.viewParms);
 
 	R_AddEntitySurfaces ();
+
+	R_PROFILE_END( PROFILE_R_GENERATEDRAWSURFS );
 }
 
 /*
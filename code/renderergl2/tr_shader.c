@@ -2661,7 +2661,7 @@ sortedIndex.
 ==============
 */
 static void FixRenderCommandList( int newShader ) {
-	renderCommandList_t	*cmdList = &backEndData->commands;
+	renderCommandList_t	*cmdList = &backEndData[tr.smpFrame]->commands;
 
 	if( cmdList ) {
 		const void *curCmd = cmdList->cmds;
@@ -3409,6 +3409,12 @@ shader_t *R_FindShaderEx( const char *name, int lightmapIndex, qboolean mipRawIm
 		}
 	}
 
+	// make sure the render thread is stopped, because we are probably
+	// going to have to upload an image and resort tr.sortedShaders
+	if ( glConfig.smpActive ) {
+		R_IssuePendingRenderCommands();
+	}
+
 	InitShaderEx( strippedName, lightmapIndex, realLightmapIndex );
 
 	//
@@ -3544,6 +3550,11 @@ qhandle_t RE_RegisterShaderFromImage(const char *name, int lightmapIndex, image_
 		}
 	}
 
+	// this resorts tr.sortedShaders too, see R_FindShaderEx
+	if ( glConfig.smpActive ) {
+		R_IssuePendingRenderCommands();
+	}
+
 	InitShader( name, lightmapIndex );
 
 	//
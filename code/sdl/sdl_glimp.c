@@ -51,6 +51,7 @@ typedef enum
 
 SDL_Window *SDL_window = NULL;
 static SDL_GLContext SDL_glContext = NULL;
+static SDL_Thread *renderThread = NULL;	// r_smp
 
 cvar_t *r_allowSoftwareGL; // Don't abort out if a hardware visual can't be obtained
 cvar_t *r_allowResize; // make window resizable
@@ -76,6 +77,7 @@ QGL_DESKTOP_1_1_FIXED_FUNCTION_PROCS;
 QGL_ES_1_1_PROCS;
 QGL_ES_1_1_FIXED_FUNCTION_PROCS;
 QGL_1_3_PROCS;
+QGL_DESKTOP_1_3_PROCS;
 QGL_1_5_PROCS;
 QGL_2_0_PROCS;
 QGL_3_0_PROCS;
@@ -341,6 +343,7 @@ static qboolean GLimp_GetProcAddresses( qboolean fixedFunction ) {
 			QGL_1_1_PROCS;
 			QGL_DESKTOP_1_1_PROCS;
 			QGL_1_3_PROCS;
+			QGL_DESKTOP_1_3_PROCS;
 			QGL_1_5_PROCS;
 			QGL_2_0_PROCS;
 		} else if ( QGLES_VERSION_ATLEAST( 2, 0 ) ) {
@@ -374,9 +377,6 @@ static qboolean GLimp_GetProcAddresses( qboolean fixedFunction ) {
 	if ( QGL_VERSION_ATLEAST( 4, 5 ) ) {
 		QGL_4_5_PROCS;
 	}
-	if ( QGL_VERSION_ATLEAST( 4, 5 ) ) {
-		QGL_OVR_multiview_PROCS;
-	}
 
 #undef GLE
 
@@ -405,6 +405,7 @@ static void GLimp_ClearProcAddresses( void ) {
 	QGL_ES_1_1_PROCS;
 	QGL_ES_1_1_FIXED_FUNCTION_PROCS;
 	QGL_1_3_PROCS;
+	QGL_DESKTOP_1_3_PROCS;
 	QGL_1_5_PROCS;
 	QGL_2_0_PROCS;
 	QGL_3_0_PROCS;
@@ -1113,15 +1114,6 @@ static void GLimp_InitExtensions( qboolean fixedFunction )
 	{
 		ri.Printf( PRINT_ALL, "...GL_SGIS_texture_edge_clamp not found\n" );
 	}
-
-	if ( SDL_GL_ExtensionSupported( "GL_OVR_multiview2" ) )
-	{
-		qglFramebufferTextureMultiviewOVR = SDL_GL_GetProcAddress( "glFramebufferTextureMultiviewOVR" );
-	}
-	else
-	{
-		ri.Error( ERR_FATAL, "Failed to initialze GL_OVR_multiview2 OpenGL extension\n" );
-	}
 }
 
 #define R_MODE_FALLBACK 3 // 640 * 480
@@ -1261,12 +1253,35 @@ void GLimp_EndFrame( void )
 		SDL_GL_SwapWindow( SDL_window );
 	}
 
+	// the window is managed from the main thread, with r_smp that
+	// is left to GLimp_CheckFullscreen
+	if ( !renderThread || SDL_ThreadID( ) != SDL_GetThreadID( renderThread ) )
+	{
+		GLimp_CheckFullscreen( );
+	}
+}
+
+/*
+===============
+GLimp_CheckFullscreen
+
+Applies r_fullscreen changes
+===============
+*/
+void GLimp_CheckFullscreen( void )
+{
 	if( r_fullscreen->modified )
 	{
 		int         fullscreen;
 		qboolean    needToToggle;
 		qboolean    sdlToggled = qfalse;
 
+		// don't resize the window under the render thread
+		if ( renderThread )
+		{
+			GLimp_FrontEndSleep( );
+		}
+
 		// Find out the current state
 		fullscreen = !!( SDL_GetWindowFlags( SDL_window ) & SDL_WINDOW_FULLSCREEN );
 
@@ -1294,3 +1309,279 @@ void GLimp_EndFrame( void )
 		r_fullscreen->modified = qfalse;
 	}
 }
+
+/*
+===========================================================
+
+SMP acceleration
+
+The front end hands whole command lists to the render thread,
+which keeps the GL context between lists.  The context only moves
+back to the main thread when GLimp_AcquireContext asks for it, and
+goes along with the next list handed over.
+
+===========================================================
+*/
+
+static SDL_mutex *smpMutex = NULL;
+static SDL_cond *renderCommandsEvent = NULL;
+static SDL_cond *renderCompletedEvent = NULL;
+static void (*glimpRenderThread)( void ) = NULL;
+
+// all guarded by smpMutex
+static void *smpData = NULL;				// NULL asks the render thread to quit
+static qboolean smpDataReady = qfalse;		// smpData was posted and not picked up yet
+static qboolean smpRendererBusy = qfalse;	// the render thread is working on a list
+static qboolean smpRendererHasContext = qfalse;
+static qboolean smpContextWanted = qfalse;	// the front end waits for the context
+
+// only touched by the main thread
+static qboolean smpFrontEndHasContext = qfalse;
+
+/*
+===============
+GLimp_DestroySmpObjects
+===============
+*/
+static void GLimp_DestroySmpObjects( void )
+{
+	if ( smpMutex )
+	{
+		SDL_DestroyMutex( smpMutex );
+		smpMutex = NULL;
+	}
+	if ( renderCommandsEvent )
+	{
+		SDL_DestroyCond( renderCommandsEvent );
+		renderCommandsEvent = NULL;
+	}
+	if ( renderCompletedEvent )
+	{
+		SDL_DestroyCond( renderCompletedEvent );
+		renderCompletedEvent = NULL;
+	}
+}
+
+/*
+===============
+GLimp_RenderThreadWrapper
+===============
+*/
+static int GLimp_RenderThreadWrapper( void *arg )
+{
+	glimpRenderThread( );
+
+	return 0;
+}
+
+/*
+===============
+GLimp_SpawnRenderThread
+
+Called with the context current on the main thread, which keeps
+it until the first list is handed over
+===============
+*/
+qboolean GLimp_SpawnRenderThread( void (*function)( void ) )
+{
+	if ( renderThread )
+	{
+		ri.Printf( PRINT_WARNING, "GLimp_SpawnRenderThread: already running\n" );
+		return qfalse;
+	}
+
+	smpMutex = SDL_CreateMutex( );
+	renderCommandsEvent = SDL_CreateCond( );
+	renderCompletedEvent = SDL_CreateCond( );
+
+	if ( !smpMutex || !renderCommandsEvent || !renderCompletedEvent )
+	{
+		ri.Printf( PRINT_ALL, "GLimp_SpawnRenderThread: %s\n", SDL_GetError( ) );
+		GLimp_DestroySmpObjects( );
+		return qfalse;
+	}
+
+	smpData = NULL;
+	smpDataReady = qfalse;
+	smpRendererBusy = qfalse;
+	smpRendererHasContext = qfalse;
+	smpContextWanted = qfalse;
+	smpFrontEndHasContext = qtrue;
+
+	glimpRenderThread = function;
+	renderThread = SDL_CreateThread( GLimp_RenderThreadWrapper, "render", NULL );
+
+	if ( !renderThread )
+	{
+		ri.Printf( PRINT_ALL, "GLimp_SpawnRenderThread: %s\n", SDL_GetError( ) );
+		GLimp_DestroySmpObjects( );
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+/*
+===============
+GLimp_ShutdownRenderThread
+
+Stops the render thread once it is idle, the context ends up
+current on the main thread again
+===============
+*/
+void GLimp_ShutdownRenderThread( void )
+{
+	if ( !renderThread )
+	{
+		return;
+	}
+
+	SDL_LockMutex( smpMutex );
+	while ( smpDataReady || smpRendererBusy )
+	{
+		SDL_CondWait( renderCompletedEvent, smpMutex );
+	}
+	smpData = NULL;
+	smpDataReady = qtrue;
+	SDL_CondSignal( renderCommandsEvent );
+	SDL_UnlockMutex( smpMutex );
+
+	SDL_WaitThread( renderThread, NULL );
+	renderThread = NULL;
+
+	// the render thread let go of it on the way out
+	if ( !smpFrontEndHasContext )
+	{
+		SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+		smpFrontEndHasContext = qtrue;
+	}
+
+	GLimp_DestroySmpObjects( );
+}
+
+/*
+===============
+GLimp_RendererSleep
+
+Called by the render thread when it is done with a list, returns
+the next one, or NULL when it should quit
+===============
+*/
+void *GLimp_RendererSleep( void )
+{
+	void *data;
+
+	SDL_LockMutex( smpMutex );
+
+	// after this, the front end can exit GLimp_FrontEndSleep
+	if ( smpRendererBusy )
+	{
+		smpRendererBusy = qfalse;
+		SDL_CondBroadcast( renderCompletedEvent );
+	}
+
+	while ( !smpDataReady )
+	{
+		if ( smpContextWanted && smpRendererHasContext )
+		{
+			SDL_GL_MakeCurrent( SDL_window, NULL );
+			smpRendererHasContext = qfalse;
+			SDL_CondBroadcast( renderCompletedEvent );
+		}
+		SDL_CondWait( renderCommandsEvent, smpMutex );
+	}
+
+	data = smpData;
+	smpDataReady = qfalse;
+
+	if ( data )
+	{
+		smpRendererBusy = qtrue;
+
+		// the front end released it before handing the list over
+		if ( !smpRendererHasContext )
+		{
+			SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+			smpRendererHasContext = qtrue;
+		}
+	}
+	else if ( smpRendererHasContext )
+	{
+		SDL_GL_MakeCurrent( SDL_window, NULL );
+		smpRendererHasContext = qfalse;
+	}
+
+	SDL_UnlockMutex( smpMutex );
+
+	return data;
+}
+
+/*
+===============
+GLimp_FrontEndSleep
+
+Waits until the render thread is done with the list it was handed,
+the context stays where it is
+===============
+*/
+void GLimp_FrontEndSleep( void )
+{
+	SDL_LockMutex( smpMutex );
+	while ( smpDataReady || smpRendererBusy )
+	{
+		SDL_CondWait( renderCompletedEvent, smpMutex );
+	}
+	SDL_UnlockMutex( smpMutex );
+}
+
+/*
+===============
+GLimp_WakeRenderer
+
+Hands a list to the idle render thread, the context goes with it
+===============
+*/
+void GLimp_WakeRenderer( void *data )
+{
+	if ( smpFrontEndHasContext )
+	{
+		SDL_GL_MakeCurrent( SDL_window, NULL );
+		smpFrontEndHasContext = qfalse;
+	}
+
+	SDL_LockMutex( smpMutex );
+	assert( !smpDataReady && !smpRendererBusy );
+	smpData = data;
+	smpDataReady = qtrue;
+	SDL_CondSignal( renderCommandsEvent );
+	SDL_UnlockMutex( smpMutex );
+}
+
+/*
+===============
+GLimp_AcquireContext
+
+Waits for the render thread to go idle and makes the context
+current on the main thread
+===============
+*/
+void GLimp_AcquireContext( void )
+{
+	if ( smpFrontEndHasContext )
+	{
+		return;
+	}
+
+	SDL_LockMutex( smpMutex );
+	smpContextWanted = qtrue;
+	SDL_CondSignal( renderCommandsEvent );
+	while ( smpDataReady || smpRendererBusy || smpRendererHasContext )
+	{
+		SDL_CondWait( renderCompletedEvent, smpMutex );
+	}
+	smpContextWanted = qfalse;
+	SDL_UnlockMutex( smpMutex );
+
+	SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+	smpFrontEndHasContext = qtrue;
+}
@@ -38,6 +38,13 @@ int bot_maxdebugpolys;
 extern botlib_export_t	*botlib_export;
 int	bot_enable;
 
+// held around engine calls while botlib work runs on the job threads
+static sysMutex_t *botJobLock;
+static qboolean botJobsActive;
+
+#define BOT_JOB_LOCK()		if ( botJobsActive ) Sys_LockMutex( botJobLock )
+#define BOT_JOB_UNLOCK()	if ( botJobsActive ) Sys_UnlockMutex( botJobLock )
+
 
 /*
 ==================
@@ -142,6 +149,7 @@ static Q_PRINTF_FUNC(2, 3) void QDECL BotImport_Print(int type, char *fmt, ...)
 	Q_vsnprintf(str, sizeof(str), fmt, ap);
 	va_end(ap);
 
+	BOT_JOB_LOCK();
 	switch(type) {
 		case PRT_MESSAGE: {
 			Com_Printf("%s", str);
@@ -168,6 +176,7 @@ static Q_PRINTF_FUNC(2, 3) void QDECL BotImport_Print(int type, char *fmt, ...)
 			break;
 		}
 	}
+	BOT_JOB_UNLOCK();
 }
 
 /*
@@ -178,7 +187,9 @@ BotImport_Trace
 static void BotImport_Trace(bsp_trace_t *bsptrace, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int passent, int contentmask) {
 	trace_t trace;
 
+	BOT_JOB_LOCK();
 	SV_Trace(&trace, start, mins, maxs, end, passent, contentmask, qfalse);
+	BOT_JOB_UNLOCK();
 	//copy the trace information
 	bsptrace->allsolid = trace.allsolid;
 	bsptrace->startsolid = trace.startsolid;
@@ -204,7 +215,9 @@ BotImport_EntityTrace
 static void BotImport_EntityTrace(bsp_trace_t *bsptrace, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int entnum, int contentmask) {
 	trace_t trace;
 
+	BOT_JOB_LOCK();
 	SV_ClipToEntity(&trace, start, mins, maxs, end, entnum, contentmask, qfalse);
+	BOT_JOB_UNLOCK();
 	//copy the trace information
 	bsptrace->allsolid = trace.allsolid;
 	bsptrace->startsolid = trace.startsolid;
@@ -229,7 +242,12 @@ BotImport_PointContents
 ==================
 */
 static int BotImport_PointContents(vec3_t point) {
-	return SV_PointContents(point, -1);
+	int contents;
+
+	BOT_JOB_LOCK();
+	contents = SV_PointContents(point, -1);
+	BOT_JOB_UNLOCK();
+	return contents;
 }
 
 /*
@@ -286,7 +304,9 @@ BotImport_GetMemory
 static void *BotImport_GetMemory(int size) {
 	void *ptr;
 
+	BOT_JOB_LOCK();
 	ptr = Z_TagMalloc( size, TAG_BOTLIB );
+	BOT_JOB_UNLOCK();
 	return ptr;
 }
 
@@ -296,7 +316,73 @@ BotImport_FreeMemory
 ==================
 */
 static void BotImport_FreeMemory(void *ptr) {
+	BOT_JOB_LOCK();
 	Z_Free(ptr);
+	BOT_JOB_UNLOCK();
+}
+
+/*
+==================
+BotImport_MapFile
+==================
+*/
+static void *BotImport_MapFile( const char *qpath, int *length ) {
+	void *data;
+	long len;
+
+	data = FS_MapFile( qpath, &len );
+	if ( data ) {
+		*length = len;
+	}
+	return data;
+}
+
+/*
+==================
+BotImport_UnmapFile
+==================
+*/
+static void BotImport_UnmapFile( void *data, int length ) {
+	FS_UnmapFile( data, length );
+}
+
+/*
+==================
+BotImport_Rename
+==================
+*/
+static int BotImport_Rename( const char *from, const char *to ) {
+	return FS_HomeRename( from, to );
+}
+
+/*
+==================
+BotImport_RunJobs
+
+The collision model, the world sectors and the zone aren't thread safe,
+so the imports above take botJobLock while the jobs are running
+==================
+*/
+static void BotImport_RunJobs(void (*func)(void *data, int index), void *data, int count, int numThreads) {
+	if ( numThreads <= 1 ) {
+		Com_RunJobs( func, data, count, 1 );
+		return;
+	}
+	if ( numThreads > MAX_JOB_THREADS ) {
+		numThreads = MAX_JOB_THREADS;
+	}
+
+	if ( !botJobLock ) {
+		botJobLock = Sys_CreateMutex();
+		if ( !botJobLock ) {
+			Com_RunJobs( func, data, count, 1 );
+			return;
+		}
+	}
+
+	botJobsActive = qtrue;
+	Com_RunJobs( func, data, count, numThreads );
+	botJobsActive = qfalse;
 }
 
 /*
@@ -454,6 +540,8 @@ int SV_BotLibSetup( void ) {
 	}
 
 	botlib_export->BotLibVarSet( "basegame", com_basegame->string );
+	botlib_export->BotLibVarSet( "reachabilitythreads", Cvar_VariableString( "bot_reachabilityThreads" ) );
+	botlib_export->BotLibVarSet( "routingthreads", Cvar_VariableString( "bot_routingThreads" ) );
 
 	return botlib_export->BotLibSetup();
 }
@@ -491,6 +579,8 @@ void SV_BotInitCvars(void) {
 	Cvar_Get("bot_visualizejumppads", "0", CVAR_CHEAT);	//show jumppads
 	Cvar_Get("bot_forceclustering", "0", 0);			//force cluster calculations
 	Cvar_Get("bot_forcereachability", "0", 0);			//force reachability calculations
+	Cvar_Get("bot_reachabilityThreads", "0", CVAR_ARCHIVE);	//threads used for reachability calculations
+	Cvar_Get("bot_routingThreads", "0", CVAR_ARCHIVE);	//threads used to fill the routing caches of the bots
 	Cvar_Get("bot_forcewrite", "0", 0);					//force writing aas file
 	Cvar_Get("bot_aasoptimize", "0", 0);				//no aas file optimisation
 	Cvar_Get("bot_saveroutingcache", "0", 0);			//save routing cache
@@ -514,6 +604,27 @@ void SV_BotInitCvars(void) {
 	Cvar_Get("bot_interbreedwrite", "", CVAR_CHEAT);	//write interbreeded bots to this file
 }
 
+/*
+==================
+SV_BotBench_f
+
+bot_bench <name> [arg]
+==================
+*/
+void SV_BotBench_f( void ) {
+	if ( !botlib_export || !bot_enable ) {
+		Com_Printf( "The bot library isn't loaded.\n" );
+		return;
+	}
+
+	if ( Cmd_Argc() < 2 ) {
+		Com_Printf( "usage: bot_bench <name> [arg]\n" );
+		return;
+	}
+
+	botlib_export->Bench( Cmd_Argv( 1 ), Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 0 );
+}
+
 /*
 ==================
 SV_BotInitBotLib
@@ -547,6 +658,13 @@ void SV_BotInitBotLib(void) {
 	botlib_import.FS_Write = FS_Write;
 	botlib_import.FS_FCloseFile = FS_FCloseFile;
 	botlib_import.FS_Seek = FS_Seek;
+	botlib_import.FS_MapFile = BotImport_MapFile;
+	botlib_import.FS_UnmapFile = BotImport_UnmapFile;
+	botlib_import.FS_Rename = BotImport_Rename;
+
+	// worker threads
+	botlib_import.RunJobs = BotImport_RunJobs;
+	botlib_import.Milliseconds = Sys_Milliseconds;
 
 	//debug lines
 	botlib_import.DebugLineCreate = BotImport_DebugLineCreate;
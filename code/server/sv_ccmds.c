@@ -1539,6 +1539,12 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("dumpuser", SV_DumpUser_f);
 	Cmd_AddCommand ("map_restart", SV_MapRestart_f);
 	Cmd_AddCommand ("sectorlist", SV_SectorList_f);
+#ifdef USE_WORLD_BENCH
+	Cmd_AddCommand ("worldbench", SV_WorldBench_f);
+#endif
+	Cmd_AddCommand ("snapshotstats", SV_SnapshotStats_f);
+	Cmd_AddCommand ("deltacachestats", SV_DeltaCacheStats_f);
+	Cmd_AddCommand ("bot_bench", SV_BotBench_f);
 	Cmd_AddCommand ("map", SV_Map_f);
 	Cmd_SetCommandCompletionFunc( "map", SV_CompleteMapName );
 #ifndef PRE_RELEASE_DEMO
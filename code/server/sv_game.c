@@ -367,6 +367,14 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 	case G_TRACECAPSULE:
 		SV_Trace( VMA(1), VMA(2), VMA(3), VMA(4), VMA(5), args[6], args[7], /*int capsule*/ qtrue );
 		return 0;
+	case G_TRACE_BATCH:
+		if ( args[3] < 0 || args[3] > MAX_TRACE_BATCH ) {
+			Com_Error( ERR_DROP, "G_TRACE_BATCH: bad count %i", (int)args[3] );
+		}
+		VM_CheckBlock( args[1], args[3] * sizeof( trace_t ), "G_TRACE_BATCH" );
+		VM_CheckBlock( args[2], args[3] * sizeof( traceRequest_t ), "G_TRACE_BATCH" );
+		SV_TraceBatch( VMA(1), VMA(2), args[3] );
+		return 0;
 	case G_POINT_CONTENTS:
 		return SV_PointContents( VMA(1), args[2] );
 	case G_SET_BRUSH_MODEL:
@@ -931,6 +939,7 @@ Called on a normal map change, not on a map_restart
 */
 void SV_InitGameProgs( void ) {
 	cvar_t	*var;
+	vmInterpret_t	interpret;
 	//FIXME these are temp while I make bots run in vm
 	extern int	bot_enable;
 
@@ -942,8 +951,14 @@ void SV_InitGameProgs( void ) {
 		bot_enable = 0;
 	}
 
-	// load the dll or bytecode
-	gvm = VM_Create( "qagame", SV_GameSystemCalls, VMI_NATIVE );
+	// load the dll or bytecode, native modules stay preferred unless
+	// vm_game 3 asks for the qvm with the optimizing compiler
+	interpret = VMI_NATIVE;
+	if ( Cvar_VariableIntegerValue( "vm_game" ) == VMI_OPTIMIZED ) {
+		interpret = VMI_OPTIMIZED;
+	}
+
+	gvm = VM_Create( "qagame", SV_GameSystemCalls, interpret );
 	if ( !gvm ) {
 		Com_Error( ERR_FATAL, "VM_Create on game failed" );
 	}
@@ -684,6 +684,10 @@ void SV_Init (void)
 	sv_killserver = Cvar_Get ("sv_killserver", "0", 0);
 	sv_mapChecksum = Cvar_Get ("sv_mapChecksum", "", CVAR_ROM);
 	sv_lanForceRate = Cvar_Get ("sv_lanForceRate", "1", CVAR_ARCHIVE );
+	sv_snapshotThreads = Cvar_Get ("sv_snapshotThreads", "0", CVAR_ARCHIVE );
+	Cvar_CheckRange( sv_snapshotThreads, 0, MAX_JOB_THREADS, qtrue );
+	sv_deltaCache = Cvar_Get ("sv_deltaCache", "1", CVAR_ARCHIVE );
+	sv_worldTree = Cvar_Get ("sv_worldTree", "0", CVAR_ARCHIVE );
 #ifndef STANDALONE
 	sv_strictAuth = Cvar_Get ("sv_strictAuth", "0", CVAR_ARCHIVE );
 #endif
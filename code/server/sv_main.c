@@ -58,6 +58,9 @@ cvar_t	*sv_gametype;
 cvar_t	*sv_pure;
 cvar_t	*sv_floodProtect;
 cvar_t	*sv_lanForceRate; // dedicated 1 (LAN) server forces local client rates to 99999 (bug #491)
+cvar_t	*sv_snapshotThreads;	// build and encode client snapshots on this many threads
+cvar_t	*sv_deltaCache;		// reuse entity deltas shared by several clients in a frame
+cvar_t	*sv_worldTree;		// link entities into a dynamic box tree instead of sectors
 #ifndef STANDALONE
 cvar_t	*sv_strictAuth;
 #endif
@@ -1094,7 +1097,11 @@ void SV_Frame( int msec ) {
 
 	sv.timeResidual += msec;
 
-	if (!com_dedicated->integer) SV_BotFrame (sv.time + sv.timeResidual);
+	if (!com_dedicated->integer) {
+		PROFILE_BEGIN( PROFILE_SV_BOTFRAME );
+		SV_BotFrame (sv.time + sv.timeResidual);
+		PROFILE_END( PROFILE_SV_BOTFRAME );
+	}
 
 	// if time is about to hit the 32nd bit, kick all clients
 	// and clear sv.time, rather
@@ -1137,7 +1144,11 @@ void SV_Frame( int msec ) {
 	// update ping based on the all received frames
 	SV_CalcPings();
 
-	if (com_dedicated->integer) SV_BotFrame (sv.time);
+	if (com_dedicated->integer) {
+		PROFILE_BEGIN( PROFILE_SV_BOTFRAME );
+		SV_BotFrame (sv.time);
+		PROFILE_END( PROFILE_SV_BOTFRAME );
+	}
 
 	// run the game simulation in chunks
 	while ( sv.timeResidual >= frameMsec ) {
@@ -1146,7 +1157,9 @@ void SV_Frame( int msec ) {
 		sv.time += frameMsec;
 
 		// let everything in the world think and move
+		PROFILE_BEGIN( PROFILE_SV_GAMEFRAME );
 		VM_Call (gvm, GAME_RUN_FRAME, sv.time);
+		PROFILE_END( PROFILE_SV_GAMEFRAME );
 	}
 
 	if ( com_speeds->integer ) {
@@ -1157,7 +1170,9 @@ void SV_Frame( int msec ) {
 	SV_CheckTimeouts();
 
 	// send messages back to the clients
+	PROFILE_BEGIN( PROFILE_SV_SENDCLIENTMESSAGES );
 	SV_SendClientMessages();
+	PROFILE_END( PROFILE_SV_SENDCLIENTMESSAGES );
 
 	// send a heartbeat to the master if needed
 	SV_MasterHeartbeat(HEARTBEAT_FOR_MASTER);
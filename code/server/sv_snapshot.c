@@ -45,6 +45,214 @@ A normal server packet will look like:
 =============================================================================
 */
 
+/*
+=============================================================================
+
+Entity delta cache
+
+Clients that acknowledged the same server frame delta each entity from
+the same old state to the same new one, so the bits MSG_WriteDeltaEntity
+produces are kept for the rest of the frame and copied into the other
+clients' messages.  Entries are matched on the full state contents rather
+than on where the states are stored, so a hit always gives exactly the
+bits encoding again would have.
+
+=============================================================================
+*/
+
+#define	DELTACACHE_ENTRIES		4096
+#define	DELTACACHE_BYTES		0x40000
+#define	DELTACACHE_MAX_DELTA	512		// larger than any single entity delta
+
+typedef struct deltaCacheEntry_s {
+	entityState_t				from;
+	qboolean					force;
+	int							offset;		// into deltaCache.bits, in bytes
+	int							numBits;
+	struct deltaCacheEntry_s	*next;		// next entry for the same entity
+} deltaCacheEntry_t;
+
+typedef struct {
+	int					frame;
+
+	// the entity state every entry in the chain was delta compressed to
+	entityState_t		to[MAX_GENTITIES];
+	int					toFrame[MAX_GENTITIES];
+	deltaCacheEntry_t	*chains[MAX_GENTITIES];
+
+	deltaCacheEntry_t	entries[DELTACACHE_ENTRIES];
+	int					numEntries;
+	byte				bits[DELTACACHE_BYTES];
+	int					numBytes;
+
+	// the threaded snapshot path encodes several clients at once
+	sysMutex_t			*lock;
+
+	int64_t				hits;
+	int64_t				misses;
+	int64_t				bitsSaved;
+	int					maxEntries;
+	int					maxBytes;
+} deltaCache_t;
+
+static deltaCache_t		deltaCache;
+
+/*
+=============
+SV_ClearDeltaCache
+
+Called from the main thread before the snapshots of a server frame
+=============
+*/
+static void SV_ClearDeltaCache( void ) {
+	if ( !deltaCache.lock ) {
+		deltaCache.lock = Sys_CreateMutex();
+	}
+
+	if ( deltaCache.numEntries > deltaCache.maxEntries ) {
+		deltaCache.maxEntries = deltaCache.numEntries;
+	}
+	if ( deltaCache.numBytes > deltaCache.maxBytes ) {
+		deltaCache.maxBytes = deltaCache.numBytes;
+	}
+
+	// chains are only valid while toFrame matches
+	deltaCache.frame++;
+	deltaCache.numEntries = 0;
+	deltaCache.numBytes = 0;
+}
+
+/*
+=============
+SV_FindCachedDelta
+
+Returns the entry for the pair or NULL, sets *store when a new entry
+for the pair can be added.  Called with deltaCache.lock held.
+=============
+*/
+static deltaCacheEntry_t *SV_FindCachedDelta( entityState_t *from, entityState_t *to, qboolean force, qboolean *store ) {
+	deltaCacheEntry_t	*entry;
+	int					num = to->number;
+
+	*store = qfalse;
+
+	if ( deltaCache.toFrame[num] != deltaCache.frame ) {
+		deltaCache.toFrame[num] = deltaCache.frame;
+		deltaCache.to[num] = *to;
+		deltaCache.chains[num] = NULL;
+	} else if ( memcmp( &deltaCache.to[num], to, sizeof( *to ) ) ) {
+		// the entity changed since the chain was started
+		return NULL;
+	}
+
+	for ( entry = deltaCache.chains[num] ; entry ; entry = entry->next ) {
+		if ( entry->force == force && !memcmp( &entry->from, from, sizeof( *from ) ) ) {
+			return entry;
+		}
+	}
+
+	*store = qtrue;
+	return NULL;
+}
+
+/*
+=============
+SV_WriteCachedDeltaEntity
+
+MSG_WriteDeltaEntity for SV_EmitPacketEntities, going through the cache
+=============
+*/
+static void SV_WriteCachedDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to, qboolean force ) {
+	deltaCacheEntry_t	*entry;
+	qboolean			store;
+	msg_t				delta;
+	byte				deltaBuf[DELTACACHE_MAX_DELTA];
+	int					bytes;
+
+	if ( !to || !sv_deltaCache->integer || !deltaCache.lock
+		|| to->number < 0 || to->number >= MAX_GENTITIES ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	Sys_LockMutex( deltaCache.lock );
+	entry = SV_FindCachedDelta( from, to, force, &store );
+	if ( entry ) {
+		deltaCache.hits++;
+		deltaCache.bitsSaved += entry->numBits;
+	} else {
+		deltaCache.misses++;
+	}
+	Sys_UnlockMutex( deltaCache.lock );
+
+	// entries are never changed once added, only dropped with the frame
+	if ( entry ) {
+		MSG_WriteBitstream( msg, deltaCache.bits + entry->offset, entry->numBits );
+		return;
+	}
+
+	if ( !store ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	MSG_Init( &delta, deltaBuf, sizeof( deltaBuf ) );
+	MSG_WriteDeltaEntity( &delta, from, to, force );
+	if ( delta.overflowed ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	MSG_WriteBitstream( msg, deltaBuf, delta.bit );
+
+	bytes = ( delta.bit + 7 ) >> 3;
+
+	Sys_LockMutex( deltaCache.lock );
+	// another client may have added the pair meanwhile, the first one wins
+	if ( !SV_FindCachedDelta( from, to, force, &store ) && store
+		&& deltaCache.numEntries < DELTACACHE_ENTRIES
+		&& deltaCache.numBytes + bytes <= DELTACACHE_BYTES ) {
+		entry = &deltaCache.entries[deltaCache.numEntries++];
+		entry->from = *from;
+		entry->force = force;
+		entry->offset = deltaCache.numBytes;
+		entry->numBits = delta.bit;
+		Com_Memcpy( deltaCache.bits + entry->offset, deltaBuf, bytes );
+		deltaCache.numBytes += bytes;
+
+		entry->next = deltaCache.chains[to->number];
+		deltaCache.chains[to->number] = entry;
+	}
+	Sys_UnlockMutex( deltaCache.lock );
+}
+
+/*
+=======================
+SV_DeltaCacheStats_f
+=======================
+*/
+void SV_DeltaCacheStats_f( void ) {
+	int64_t		total = deltaCache.hits + deltaCache.misses;
+
+	Com_Printf( "entity delta cache: %s\n", sv_deltaCache->integer ? "enabled" : "disabled" );
+	Com_Printf( "%12lld hits\n", (long long)deltaCache.hits );
+	Com_Printf( "%12lld misses\n", (long long)deltaCache.misses );
+	if ( total ) {
+		Com_Printf( "%12.1f%% hit rate\n", 100.0 * deltaCache.hits / total );
+	}
+	Com_Printf( "%12lld bytes copied instead of encoded\n", (long long)( deltaCache.bitsSaved >> 3 ) );
+	Com_Printf( "%12i peak entries per frame (of %i)\n", deltaCache.maxEntries, DELTACACHE_ENTRIES );
+	Com_Printf( "%12i peak bytes per frame (of %i)\n", deltaCache.maxBytes, DELTACACHE_BYTES );
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		deltaCache.hits = 0;
+		deltaCache.misses = 0;
+		deltaCache.bitsSaved = 0;
+		deltaCache.maxEntries = 0;
+		deltaCache.maxBytes = 0;
+	}
+}
+
 /*
 =============
 SV_EmitPacketEntities
@@ -88,7 +296,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 			// delta update from old position
 			// because the force parm is qfalse, this will not result
 			// in any bytes being emitted if the entity has not changed at all
-			MSG_WriteDeltaEntity (msg, oldent, newent, qfalse );
+			SV_WriteCachedDeltaEntity (msg, oldent, newent, qfalse );
 			oldindex++;
 			newindex++;
 			continue;
@@ -96,7 +304,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 		if ( newnum < oldnum ) {
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
+			SV_WriteCachedDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
 			newindex++;
 			continue;
 		}
@@ -116,42 +324,55 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 /*
 ==================
-SV_WriteSnapshotToClient
+SV_SnapshotDeltaFrame
+
+Picks the previous frame to delta compress the new snapshot from,
+returns NULL if a full snapshot has to be sent
 ==================
 */
-static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
-	clientSnapshot_t	*frame, *oldframe;
-	int					lastframe;
-	int					i;
-	int					snapFlags;
-
-	// this is the snapshot we are creating
-	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+static clientSnapshot_t *SV_SnapshotDeltaFrame( client_t *client, int *lastframe ) {
+	clientSnapshot_t	*oldframe;
 
 	// try to use a previous frame as the source for delta compressing the snapshot
 	if ( client->deltaMessage <= 0 || client->state != CS_ACTIVE ) {
 		// client is asking for a retransmit
 		oldframe = NULL;
-		lastframe = 0;
+		*lastframe = 0;
 	} else if ( client->netchan.outgoingSequence - client->deltaMessage 
 		>= (PACKET_BACKUP - 3) ) {
 		// client hasn't gotten a good message through in a long time
 		Com_DPrintf ("%s: Delta request from out of date packet.\n", client->name);
 		oldframe = NULL;
-		lastframe = 0;
+		*lastframe = 0;
 	} else {
 		// we have a valid snapshot to delta from
 		oldframe = &client->frames[ client->deltaMessage & PACKET_MASK ];
-		lastframe = client->netchan.outgoingSequence - client->deltaMessage;
+		*lastframe = client->netchan.outgoingSequence - client->deltaMessage;
 
 		// the snapshot's entities may still have rolled off the buffer, though
 		if ( oldframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities ) {
 			Com_DPrintf ("%s: Delta request from out of date entities.\n", client->name);
 			oldframe = NULL;
-			lastframe = 0;
+			*lastframe = 0;
 		}
 	}
 
+	return oldframe;
+}
+
+/*
+==================
+SV_WriteSnapshotToClient
+==================
+*/
+static void SV_WriteSnapshotToClient( client_t *client, clientSnapshot_t *oldframe, int lastframe, msg_t *msg ) {
+	clientSnapshot_t	*frame;
+	int					i;
+	int					snapFlags;
+
+	// this is the snapshot we are creating
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
 	MSG_WriteByte (msg, svc_snapshot);
 
 	// NOTE, MRE: now sent at the start of every message from server to client
@@ -238,11 +459,18 @@ Build a client snapshot structure
 typedef struct {
 	int		numSnapshotEntities;
 	int		snapshotEntities[MAX_SNAPSHOT_ENTITIES];	
+	byte	added[MAX_GENTITIES/8];		// prevents double adding from portal views
+	const char	*error;					// reported by the caller, this may run in a job
 } snapshotEntityNumbers_t;
 
+#define SV_SnapshotHasEntity( eNums, num )	( (eNums)->added[(num) >> 3] & ( 1 << ( (num) & 7 ) ) )
+#define SV_SnapshotMarkEntity( eNums, num )	( (eNums)->added[(num) >> 3] |= ( 1 << ( (num) & 7 ) ) )
+
 /*
 =======================
 SV_QsortEntityNumbers
+
+Duplicates can't happen, SV_AddEntToSnapshot never adds an entity twice
 =======================
 */
 static int QDECL SV_QsortEntityNumbers( const void *a, const void *b ) {
@@ -251,10 +479,6 @@ static int QDECL SV_QsortEntityNumbers( const void *a, const void *b ) {
 	ea = (int *)a;
 	eb = (int *)b;
 
-	if ( *ea == *eb ) {
-		Com_Error( ERR_DROP, "SV_QsortEntityStates: duplicated entity" );
-	}
-
 	if ( *ea < *eb ) {
 		return -1;
 	}
@@ -268,12 +492,12 @@ static int QDECL SV_QsortEntityNumbers( const void *a, const void *b ) {
 SV_AddEntToSnapshot
 ===============
 */
-static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
+static void SV_AddEntToSnapshot( sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
 	// if we have already added this entity to this snapshot, don't add again
-	if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+	if ( SV_SnapshotHasEntity( eNums, gEnt->s.number ) ) {
 		return;
 	}
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	SV_SnapshotMarkEntity( eNums, gEnt->s.number );
 
 	// if we are full, silently discard entities
 	if ( eNums->numSnapshotEntities == MAX_SNAPSHOT_ENTITIES ) {
@@ -348,22 +572,24 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		}
 		// entities can be flagged to be sent to a given mask of clients
 		if ( ent->r.svFlags & SVF_CLIENTMASK ) {
-			if (frame->ps.clientNum >= 32)
-				Com_Error( ERR_DROP, "SVF_CLIENTMASK: clientNum >= 32" );
+			if (frame->ps.clientNum >= 32) {
+				eNums->error = "SVF_CLIENTMASK: clientNum >= 32";
+				return;
+			}
 			if (~ent->r.singleClient & (1 << frame->ps.clientNum))
 				continue;
 		}
 
-		svEnt = SV_SvEntityForGentity( ent );
-
 		// don't double add an entity through portals
-		if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+		if ( SV_SnapshotHasEntity( eNums, e ) ) {
 			continue;
 		}
 
+		svEnt = SV_SvEntityForGentity( ent );
+
 		// broadcast entities are always sent
 		if ( ent->r.svFlags & SVF_BROADCAST ) {
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
+			SV_AddEntToSnapshot( ent, eNums );
 			continue;
 		}
 
@@ -409,7 +635,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		}
 
 		// add it
-		SV_AddEntToSnapshot( svEnt, ent, eNums );
+		SV_AddEntToSnapshot( ent, eNums );
 
 		// if it's a portal entity, add everything visible from its camera position
 		if ( ent->r.svFlags & SVF_PORTAL ) {
@@ -421,6 +647,9 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 				}
 			}
 			SV_AddEntitiesVisibleFromPoint( ent->s.origin2, frame, eNums, qtrue );
+			if ( eNums->error ) {
+				return;
+			}
 		}
 
 	}
@@ -428,7 +657,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 
 /*
 =============
-SV_BuildClientSnapshot
+SV_BuildClientEntityNumbers
 
 Decides which entities are going to be visible to the client, and
 copies off the playerstate and areabits.
@@ -437,28 +666,26 @@ This properly handles multiple recursive portals, but the render
 currently doesn't.
 
 For viewing through other player's eyes, clent can be something other than client->gentity
+
+Only the client's own frame and eNums are written, so this can run
+as a job.  Returns qfalse if the client gets an empty snapshot.
 =============
 */
-static void SV_BuildClientSnapshot( client_t *client ) {
+static qboolean SV_BuildClientEntityNumbers( client_t *client, snapshotEntityNumbers_t *eNums ) {
 	vec3_t						org;
 	clientSnapshot_t			*frame;
-	snapshotEntityNumbers_t		entityNumbers;
 	int							i;
-	sharedEntity_t				*ent;
-	entityState_t				*state;
-	svEntity_t					*svEnt;
 	sharedEntity_t				*clent;
 	int							clientNum;
 	playerState_t				*ps;
 
-	// bump the counter used to prevent double adding
-	sv.snapshotCounter++;
-
 	// this is the frame we are creating
 	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// clear everything in this snapshot
-	entityNumbers.numSnapshotEntities = 0;
+	eNums->numSnapshotEntities = 0;
+	eNums->error = NULL;
+	Com_Memset( eNums->added, 0, sizeof( eNums->added ) );
 	Com_Memset( frame->areabits, 0, sizeof( frame->areabits ) );
 
   // https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=62
@@ -466,7 +693,7 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	
 	clent = client->gentity;
 	if ( !clent || client->state == CS_ZOMBIE ) {
-		return;
+		return qfalse;
 	}
 
 	// grab the current playerState_t
@@ -477,11 +704,10 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	// be regenerated from the playerstate
 	clientNum = frame->ps.clientNum;
 	if ( clientNum < 0 || clientNum >= MAX_GENTITIES ) {
-		Com_Error( ERR_DROP, "SV_SvEntityForGentity: bad gEnt" );
+		eNums->error = "SV_SvEntityForGentity: bad gEnt";
+		return qfalse;
 	}
-	svEnt = &sv.svEntities[ clientNum ];
-
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	SV_SnapshotMarkEntity( eNums, clientNum );
 
 	// find the client's viewpoint
 	VectorCopy( ps->origin, org );
@@ -489,14 +715,16 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 
 	// add all the entities directly visible to the eye, which
 	// may include portal entities that merge other viewpoints
-	SV_AddEntitiesVisibleFromPoint( org, frame, &entityNumbers, qfalse );
+	SV_AddEntitiesVisibleFromPoint( org, frame, eNums, qfalse );
+	if ( eNums->error ) {
+		return qfalse;
+	}
 
 	// if there were portals visible, there may be out of order entities
 	// in the list which will need to be resorted for the delta compression
-	// to work correctly.  This also catches the error condition
-	// of an entity being included twice.
-	qsort( entityNumbers.snapshotEntities, entityNumbers.numSnapshotEntities, 
-		sizeof( entityNumbers.snapshotEntities[0] ), SV_QsortEntityNumbers );
+	// to work correctly.
+	qsort( eNums->snapshotEntities, eNums->numSnapshotEntities, 
+		sizeof( eNums->snapshotEntities[0] ), SV_QsortEntityNumbers );
 
 	// now that all viewpoint's areabits have been OR'd together, invert
 	// all of them to make it a mask vector, which is what the renderer wants
@@ -504,11 +732,30 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 		((int *)frame->areabits)[i] = ((int *)frame->areabits)[i] ^ -1;
 	}
 
-	// copy the entity states out
+	return qtrue;
+}
+
+/*
+=============
+SV_CopySnapshotEntities
+
+Copies the entity states out into svs.snapshotEntities.  Clients must
+go through here one at a time and in slot order so the positions in
+the shared ring don't depend on how the snapshots were built.
+=============
+*/
+static void SV_CopySnapshotEntities( client_t *client, snapshotEntityNumbers_t *eNums ) {
+	clientSnapshot_t			*frame;
+	int							i;
+	sharedEntity_t				*ent;
+	entityState_t				*state;
+
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
 	frame->num_entities = 0;
 	frame->first_entity = svs.nextSnapshotEntities;
-	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ ) {
-		ent = SV_GentityNum(entityNumbers.snapshotEntities[i]);
+	for ( i = 0 ; i < eNums->numSnapshotEntities ; i++ ) {
+		ent = SV_GentityNum(eNums->snapshotEntities[i]);
 		state = &svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
 		*state = ent->s;
 		svs.nextSnapshotEntities++;
@@ -520,6 +767,21 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	}
 }
 
+/*
+=============
+SV_BuildClientSnapshot
+=============
+*/
+static void SV_BuildClientSnapshot( client_t *client ) {
+	snapshotEntityNumbers_t		entityNumbers;
+
+	if ( SV_BuildClientEntityNumbers( client, &entityNumbers ) ) {
+		SV_CopySnapshotEntities( client, &entityNumbers );
+	} else if ( entityNumbers.error ) {
+		Com_Error( ERR_DROP, "%s", entityNumbers.error );
+	}
+}
+
 #ifdef USE_VOIP
 /*
 ==================
@@ -586,6 +848,47 @@ void SV_SendMessageToClient(msg_t *msg, client_t *client)
 }
 
 
+/*
+=======================
+SV_WriteClientMessage
+
+Everything in a snapshot message up to the VoIP data.  Only the
+client's own message and reliable command state are written, so
+this can run as a job.
+=======================
+*/
+static void SV_WriteClientMessage( client_t *client, clientSnapshot_t *oldframe, int lastframe, msg_t *msg ) {
+	// NOTE, MRE: all server->client messages now acknowledge
+	// let the client know which reliable clientCommands we have received
+	MSG_WriteLong( msg, client->lastClientCommand );
+
+	// (re)send any reliable server commands
+	SV_UpdateServerCommandsToClient( client, msg );
+
+	// send over all the relevant entityState_t
+	// and the playerState_t
+	SV_WriteSnapshotToClient( client, oldframe, lastframe, msg );
+}
+
+/*
+=======================
+SV_FinishClientMessage
+=======================
+*/
+static void SV_FinishClientMessage( client_t *client, msg_t *msg ) {
+#ifdef USE_VOIP
+	SV_WriteVoipToClient( client, msg );
+#endif
+
+	// check for overflow
+	if ( msg->overflowed ) {
+		Com_Printf ("WARNING: msg overflowed for %s\n", client->name);
+		MSG_Clear (msg);
+	}
+
+	SV_SendMessageToClient( msg, client );
+}
+
 /*
 =======================
 SV_SendClientSnapshot
@@ -597,6 +900,8 @@ Also called by SV_FinalMessage
 void SV_SendClientSnapshot( client_t *client ) {
 	byte		msg_buf[MAX_MSGLEN];
 	msg_t		msg;
+	clientSnapshot_t	*oldframe;
+	int			lastframe;
 
 	// build the snapshot
 	SV_BuildClientSnapshot( client );
@@ -610,30 +915,186 @@ void SV_SendClientSnapshot( client_t *client ) {
 	MSG_Init (&msg, msg_buf, sizeof(msg_buf));
 	msg.allowoverflow = qtrue;
 
-	// NOTE, MRE: all server->client messages now acknowledge
-	// let the client know which reliable clientCommands we have received
-	MSG_WriteLong( &msg, client->lastClientCommand );
+	oldframe = SV_SnapshotDeltaFrame( client, &lastframe );
+	SV_WriteClientMessage( client, oldframe, lastframe, &msg );
+	SV_FinishClientMessage( client, &msg );
+}
 
-	// (re)send any reliable server commands
-	SV_UpdateServerCommandsToClient( client, &msg );
+/*
+=============================================================================
 
-	// send over all the relevant entityState_t
-	// and the playerState_t
-	SV_WriteSnapshotToClient( client, &msg );
+Threaded snapshots
 
-#ifdef USE_VOIP
-	SV_WriteVoipToClient( client, &msg );
-#endif
+With sv_snapshotThreads > 1 the per-client work is split into passes:
 
-	// check for overflow
-	if ( msg.overflowed ) {
-		Com_Printf ("WARNING: msg overflowed for %s\n", client->name);
-		MSG_Clear (&msg);
+1. entity culling for every client, as jobs
+2. copying entity states into svs.snapshotEntities and picking the
+   delta frame, serially in slot order
+3. delta encoding the messages, as jobs
+4. VoIP, overflow checks and netchan transmit, serially in slot order
+
+Anything that prints, allocates or touches state shared between clients
+stays in the serial passes, so the messages that go out are the same no
+matter how the jobs were scheduled.
+
+=============================================================================
+*/
+
+typedef struct {
+	client_t				*client;
+	qboolean				built;
+	snapshotEntityNumbers_t	entityNumbers;
+	clientSnapshot_t		*oldframe;
+	int						lastframe;
+	msg_t					msg;
+	byte					msgBuf[MAX_MSGLEN];
+} snapshotJob_t;
+
+static snapshotJob_t	snapshotJobs[MAX_CLIENTS];
+
+typedef struct {
+	int			frames;
+	int			clients;
+	int64_t		usec;
+	int64_t		maxUsec;
+	int			threads;
+} snapshotStats_t;
+
+// [0] is the serial path, [1] the threaded one
+static snapshotStats_t	snapshotStats[2];
+
+/*
+=======================
+SV_BuildSnapshotJob
+=======================
+*/
+static void SV_BuildSnapshotJob( void *data, int index ) {
+	snapshotJob_t	*job = ((snapshotJob_t **)data)[index];
+
+	job->built = SV_BuildClientEntityNumbers( job->client, &job->entityNumbers );
+}
+
+/*
+=======================
+SV_WriteSnapshotJob
+=======================
+*/
+static void SV_WriteSnapshotJob( void *data, int index ) {
+	snapshotJob_t	*job = ((snapshotJob_t **)data)[index];
+
+	SV_WriteClientMessage( job->client, job->oldframe, job->lastframe, &job->msg );
+}
+
+/*
+=======================
+SV_FixEntityNumbers
+
+SV_AddEntitiesVisibleFromPoint repairs bad entity numbers as it goes,
+do that up front instead so the culling jobs only ever read entities
+=======================
+*/
+static void SV_FixEntityNumbers( void ) {
+	int				e;
+	sharedEntity_t	*ent;
+
+	for ( e = 0 ; e < sv.num_entities ; e++ ) {
+		ent = SV_GentityNum( e );
+
+		if ( ent->r.linked && ent->s.number != e ) {
+			Com_DPrintf ("FIXING ENT->S.NUMBER!!!\n");
+			ent->s.number = e;
+		}
+	}
+}
+
+/*
+=======================
+SV_SendClientSnapshotsThreaded
+=======================
+*/
+static void SV_SendClientSnapshotsThreaded( client_t **clients, int numClients, int numThreads ) {
+	snapshotJob_t	*build[MAX_CLIENTS];
+	snapshotJob_t	*write[MAX_CLIENTS];
+	snapshotJob_t	*job;
+	int				i, numWrite;
+
+	if ( sv.state ) {
+		SV_FixEntityNumbers();
+	}
+
+	for ( i = 0 ; i < numClients ; i++ ) {
+		build[i] = &snapshotJobs[i];
+		build[i]->client = clients[i];
+	}
+
+	Com_RunJobs( SV_BuildSnapshotJob, build, numClients, numThreads );
+
+	numWrite = 0;
+	for ( i = 0 ; i < numClients ; i++ ) {
+		job = build[i];
+
+		if ( job->built ) {
+			SV_CopySnapshotEntities( job->client, &job->entityNumbers );
+		} else if ( job->entityNumbers.error ) {
+			Com_Error( ERR_DROP, "%s", job->entityNumbers.error );
+		}
+
+		// bots need to have their snapshots build, but
+		// the query them directly without needing to be sent
+		if ( job->client->gentity && job->client->gentity->r.svFlags & SVF_BOT ) {
+			continue;
+		}
+
+		write[numWrite++] = job;
+	}
+
+	// delta frames are checked against the ring only after every new
+	// snapshot is in it, nothing written above can be read back stale
+	for ( i = 0 ; i < numWrite ; i++ ) {
+		job = write[i];
+		job->oldframe = SV_SnapshotDeltaFrame( job->client, &job->lastframe );
+
+		MSG_Init( &job->msg, job->msgBuf, sizeof( job->msgBuf ) );
+		job->msg.allowoverflow = qtrue;
 	}
 
-	SV_SendMessageToClient( &msg, client );
+	Com_RunJobs( SV_WriteSnapshotJob, write, numWrite, numThreads );
+
+	for ( i = 0 ; i < numWrite ; i++ ) {
+		SV_FinishClientMessage( write[i]->client, &write[i]->msg );
+	}
 }
 
+/*
+=======================
+SV_SnapshotStats_f
+
+Average time spent building and sending snapshots per server frame,
+for comparing sv_snapshotThreads settings
+=======================
+*/
+void SV_SnapshotStats_f( void ) {
+	int		i;
+
+	Com_Printf( "mode          frames  clients  avg usec  max usec\n" );
+
+	for ( i = 0 ; i < 2 ; i++ ) {
+		snapshotStats_t *stats = &snapshotStats[i];
+		const char *mode = i ? va( "%i threads", stats->threads ) : "serial";
+
+		if ( !stats->frames ) {
+			continue;
+		}
+
+		Com_Printf( "%-12s %7i %8.1f %9i %9i\n", mode, stats->frames,
+			(float)stats->clients / stats->frames, (int)( stats->usec / stats->frames ),
+			(int)stats->maxUsec );
+	}
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		Com_Memset( snapshotStats, 0, sizeof( snapshotStats ) );
+	}
+}
 
 /*
 =======================
@@ -642,10 +1103,17 @@ SV_SendClientMessages
 */
 void SV_SendClientMessages(void)
 {
-	int		i;
+	int		i, numClients, numThreads;
+	qboolean	threaded;
 	client_t	*c;
+	client_t	*clients[MAX_CLIENTS];
+	int64_t		start, usec;
+	snapshotStats_t	*stats;
 
-	// send a message to each connected client
+	start = Sys_Microseconds();
+
+	// find each connected client that is due a message
+	numClients = 0;
 	for(i=0; i < sv_maxclients->integer; i++)
 	{
 		c = &svs.clients[i];
@@ -677,9 +1145,39 @@ void SV_SendClientMessages(void)
 			}
 		}
 
-		// generate and send a new message
-		SV_SendClientSnapshot(c);
-		c->lastSnapshotTime = svs.time;
-		c->rateDelayed = qfalse;
+		clients[numClients++] = c;
+	}
+
+	if ( !numClients ) {
+		return;
+	}
+
+	// generate and send the new messages
+	SV_ClearDeltaCache();
+
+	numThreads = sv_snapshotThreads->integer;
+	threaded = numThreads > 1 && numClients > 1;
+	if ( threaded ) {
+		SV_SendClientSnapshotsThreaded( clients, numClients, numThreads );
+	} else {
+		for ( i = 0 ; i < numClients ; i++ ) {
+			SV_SendClientSnapshot( clients[i] );
+		}
+	}
+
+	for ( i = 0 ; i < numClients ; i++ ) {
+		clients[i]->lastSnapshotTime = svs.time;
+		clients[i]->rateDelayed = qfalse;
+	}
+
+	usec = Sys_Microseconds() - start;
+
+	stats = &snapshotStats[threaded];
+	stats->frames++;
+	stats->clients += numClients;
+	stats->usec += usec;
+	if ( usec > stats->maxUsec ) {
+		stats->maxUsec = usec;
 	}
+	stats->threads = numThreads;
 }
@@ -75,6 +75,472 @@ worldSector_t	sv_worldSectors[AREA_NODES];
 int			sv_numworldSectors;
 
 
+/*
+===============================================================================
+
+DYNAMIC WORLD TREE
+
+With sv_worldTree set, entities are linked into a balanced tree of bounding
+boxes instead of the sectors, so a query only descends where entities actually
+are.  Leaf boxes are fattened, and an entity that is relinked inside its fat
+box doesn't touch the tree at all.  When it moves out, the leaf is removed
+and inserted again, rotating nodes on the way back up to keep the tree
+balanced.  The mode is sampled on SV_ClearWorld, so it changes with the map.
+
+===============================================================================
+*/
+
+#define	WORLDTREE_NODES			(MAX_GENTITIES * 2)	// node 0 is the null node
+#define	WORLDTREE_MARGIN		16		// fattening on every side of a leaf
+#define	WORLDTREE_PREDICT		2		// times the last move a leaf is stretched ahead
+#define	WORLDTREE_MAX_PREDICT	64		// so teleports don't leave huge leafs behind
+#define	WORLDTREE_STACK			256
+
+typedef struct {
+	vec3_t		mins, maxs;		// fattened on leafs
+	vec3_t		center;			// of the real box when the leaf was inserted
+	int			parent;			// next free node while on the free list
+	int			children[2];	// 0 on leafs
+	int			height;			// 0 on leafs
+	int			entityNum;
+} worldNode_t;
+
+typedef struct {
+	worldNode_t	nodes[WORLDTREE_NODES];
+	int			root;
+	int			freeNodes;
+	int			numLeafs;
+
+	// counters for sectorlist
+	int64_t		links;
+	int64_t		keeps;			// links that stayed inside their fat box
+	int64_t		inserts;
+	int64_t		queries;
+	int64_t		nodesVisited;
+	int64_t		candidates;		// leafs whose fat box touched a query
+} worldTree_t;
+
+static worldTree_t	sv_entityTree;
+static qboolean		sv_entityTreeActive;
+
+
+/*
+===============
+SV_TreeClear
+===============
+*/
+static void SV_TreeClear( worldTree_t *tree ) {
+	int		i;
+
+	Com_Memset( tree, 0, sizeof( *tree ) );
+
+	for ( i = 1 ; i < WORLDTREE_NODES - 1 ; i++ ) {
+		tree->nodes[i].parent = i + 1;
+	}
+	tree->freeNodes = 1;
+}
+
+/*
+===============
+SV_TreeAllocNode
+===============
+*/
+static int SV_TreeAllocNode( worldTree_t *tree ) {
+	worldNode_t	*node;
+	int			index;
+
+	// there are always enough nodes for MAX_GENTITIES leafs
+	index = tree->freeNodes;
+	if ( !index ) {
+		Com_Error( ERR_DROP, "SV_TreeAllocNode: out of nodes" );
+	}
+
+	node = &tree->nodes[index];
+	tree->freeNodes = node->parent;
+
+	node->parent = 0;
+	node->children[0] = node->children[1] = 0;
+	node->height = 0;
+	node->entityNum = -1;
+
+	return index;
+}
+
+/*
+===============
+SV_TreeFreeNode
+===============
+*/
+static void SV_TreeFreeNode( worldTree_t *tree, int index ) {
+	tree->nodes[index].parent = tree->freeNodes;
+	tree->nodes[index].height = -1;
+	tree->freeNodes = index;
+}
+
+/*
+===============
+SV_TreeBoxCost
+
+Half the surface area, the chance of a random query hitting the box
+===============
+*/
+static float SV_TreeBoxCost( const vec3_t mins, const vec3_t maxs ) {
+	vec3_t	size;
+
+	VectorSubtract( maxs, mins, size );
+	return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+/*
+===============
+SV_TreeUnion
+===============
+*/
+static void SV_TreeUnion( const worldNode_t *a, const worldNode_t *b, vec3_t mins, vec3_t maxs ) {
+	int		i;
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		mins[i] = MIN( a->mins[i], b->mins[i] );
+		maxs[i] = MAX( a->maxs[i], b->maxs[i] );
+	}
+}
+
+/*
+===============
+SV_TreeRefit
+===============
+*/
+static void SV_TreeRefit( worldTree_t *tree, int index ) {
+	worldNode_t	*node = &tree->nodes[index];
+	worldNode_t	*child0 = &tree->nodes[node->children[0]];
+	worldNode_t	*child1 = &tree->nodes[node->children[1]];
+
+	SV_TreeUnion( child0, child1, node->mins, node->maxs );
+	node->height = 1 + MAX( child0->height, child1->height );
+}
+
+/*
+===============
+SV_TreeBalance
+
+If one side of the node is more than one level taller than the other,
+its child is rotated up to take the node's place.  Returns the index
+now at the node's position.
+===============
+*/
+static int SV_TreeBalance( worldTree_t *tree, int indexA ) {
+	worldNode_t	*a, *c, *parent;
+	int			side, indexC, keep, give;
+	int			balance;
+
+	a = &tree->nodes[indexA];
+	if ( !a->children[0] || a->height < 2 ) {
+		return indexA;
+	}
+
+	balance = tree->nodes[a->children[1]].height - tree->nodes[a->children[0]].height;
+	if ( balance > 1 ) {
+		side = 1;
+	} else if ( balance < -1 ) {
+		side = 0;
+	} else {
+		return indexA;
+	}
+
+	indexC = a->children[side];
+	c = &tree->nodes[indexC];
+
+	// c takes the place of a
+	c->parent = a->parent;
+	if ( c->parent ) {
+		parent = &tree->nodes[c->parent];
+		parent->children[ parent->children[1] == indexA ] = indexC;
+	} else {
+		tree->root = indexC;
+	}
+
+	// the taller child of c stays, the other one moves down under a
+	if ( tree->nodes[c->children[0]].height > tree->nodes[c->children[1]].height ) {
+		keep = c->children[0];
+		give = c->children[1];
+	} else {
+		keep = c->children[1];
+		give = c->children[0];
+	}
+
+	c->children[0] = indexA;
+	c->children[1] = keep;
+	a->parent = indexC;
+	a->children[side] = give;
+	tree->nodes[give].parent = indexA;
+
+	SV_TreeRefit( tree, indexA );
+	SV_TreeRefit( tree, indexC );
+
+	return indexC;
+}
+
+/*
+===============
+SV_TreeFixUpwards
+
+Rebalances and refits every node from index to the root
+===============
+*/
+static void SV_TreeFixUpwards( worldTree_t *tree, int index ) {
+	while ( index ) {
+		index = SV_TreeBalance( tree, index );
+		SV_TreeRefit( tree, index );
+		index = tree->nodes[index].parent;
+	}
+}
+
+/*
+===============
+SV_TreeInsertLeaf
+===============
+*/
+static void SV_TreeInsertLeaf( worldTree_t *tree, int leaf ) {
+	worldNode_t	*node, *child;
+	vec3_t		mins, maxs;
+	float		cost, inherited, childCost[2];
+	int			index, parent, oldParent;
+	int			i;
+
+	tree->inserts++;
+
+	if ( !tree->root ) {
+		tree->root = leaf;
+		tree->nodes[leaf].parent = 0;
+		return;
+	}
+
+	// walk down to the sibling that grows the total box cost the least
+	index = tree->root;
+	while ( tree->nodes[index].children[0] ) {
+		node = &tree->nodes[index];
+
+		SV_TreeUnion( node, &tree->nodes[leaf], mins, maxs );
+		cost = 2 * SV_TreeBoxCost( mins, maxs );
+
+		// going further down still grows this node
+		inherited = cost - 2 * SV_TreeBoxCost( node->mins, node->maxs );
+
+		for ( i = 0 ; i < 2 ; i++ ) {
+			child = &tree->nodes[node->children[i]];
+			SV_TreeUnion( child, &tree->nodes[leaf], mins, maxs );
+			childCost[i] = SV_TreeBoxCost( mins, maxs ) + inherited;
+			if ( child->children[0] ) {
+				childCost[i] -= SV_TreeBoxCost( child->mins, child->maxs );
+			}
+		}
+
+		if ( cost < childCost[0] && cost < childCost[1] ) {
+			break;
+		}
+		index = node->children[ childCost[1] < childCost[0] ];
+	}
+
+	// pair the leaf with the sibling under a new parent
+	oldParent = tree->nodes[index].parent;
+	parent = SV_TreeAllocNode( tree );
+	node = &tree->nodes[parent];
+	node->parent = oldParent;
+	node->children[0] = index;
+	node->children[1] = leaf;
+	tree->nodes[index].parent = parent;
+	tree->nodes[leaf].parent = parent;
+
+	if ( oldParent ) {
+		node = &tree->nodes[oldParent];
+		node->children[ node->children[1] == index ] = parent;
+	} else {
+		tree->root = parent;
+	}
+
+	SV_TreeFixUpwards( tree, parent );
+}
+
+/*
+===============
+SV_TreeRemoveLeaf
+===============
+*/
+static void SV_TreeRemoveLeaf( worldTree_t *tree, int leaf ) {
+	worldNode_t	*node;
+	int			parent, grandParent, sibling;
+
+	parent = tree->nodes[leaf].parent;
+	if ( !parent ) {
+		tree->root = 0;
+		return;
+	}
+
+	// the sibling takes the place of the parent
+	node = &tree->nodes[parent];
+	grandParent = node->parent;
+	sibling = node->children[ node->children[0] == leaf ];
+	tree->nodes[sibling].parent = grandParent;
+
+	if ( grandParent ) {
+		node = &tree->nodes[grandParent];
+		node->children[ node->children[1] == parent ] = sibling;
+	} else {
+		tree->root = sibling;
+	}
+
+	SV_TreeFreeNode( tree, parent );
+	SV_TreeFixUpwards( tree, grandParent );
+}
+
+/*
+===============
+SV_TreeLink
+
+Links a box or moves an already linked leaf, returns the leaf
+===============
+*/
+static int SV_TreeLink( worldTree_t *tree, int leaf, int entityNum, const vec3_t absmin, const vec3_t absmax ) {
+	worldNode_t	*node;
+	float		center, move;
+	int			i;
+
+	tree->links++;
+
+	if ( leaf ) {
+		node = &tree->nodes[leaf];
+		if ( absmin[0] >= node->mins[0] && absmax[0] <= node->maxs[0]
+			&& absmin[1] >= node->mins[1] && absmax[1] <= node->maxs[1]
+			&& absmin[2] >= node->mins[2] && absmax[2] <= node->maxs[2] ) {
+			tree->keeps++;
+			return leaf;
+		}
+		SV_TreeRemoveLeaf( tree, leaf );
+	} else {
+		leaf = SV_TreeAllocNode( tree );
+		node = &tree->nodes[leaf];
+		node->entityNum = entityNum;
+		for ( i = 0 ; i < 3 ; i++ ) {
+			node->center[i] = 0.5f * ( absmin[i] + absmax[i] );
+		}
+		tree->numLeafs++;
+	}
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		center = 0.5f * ( absmin[i] + absmax[i] );
+
+		// stretch the leaf in the direction the entity was moving
+		move = WORLDTREE_PREDICT * ( center - node->center[i] );
+		if ( move > WORLDTREE_MAX_PREDICT ) {
+			move = WORLDTREE_MAX_PREDICT;
+		} else if ( move < -WORLDTREE_MAX_PREDICT ) {
+			move = -WORLDTREE_MAX_PREDICT;
+		}
+
+		node->mins[i] = absmin[i] - WORLDTREE_MARGIN;
+		node->maxs[i] = absmax[i] + WORLDTREE_MARGIN;
+		if ( move < 0 ) {
+			node->mins[i] += move;
+		} else {
+			node->maxs[i] += move;
+		}
+		node->center[i] = center;
+	}
+
+	SV_TreeInsertLeaf( tree, leaf );
+
+	return leaf;
+}
+
+/*
+===============
+SV_TreeUnlink
+===============
+*/
+static void SV_TreeUnlink( worldTree_t *tree, int leaf ) {
+	SV_TreeRemoveLeaf( tree, leaf );
+	SV_TreeFreeNode( tree, leaf );
+	tree->numLeafs--;
+}
+
+/*
+===============
+SV_TreeQuery
+
+Lists the entities whose fattened leaf touches the bounds, the caller
+still has to check the real boxes
+===============
+*/
+static int SV_TreeQuery( worldTree_t *tree, const vec3_t mins, const vec3_t maxs, int *list, int maxcount ) {
+	int			stack[WORLDTREE_STACK];
+	int			depth, count;
+	worldNode_t	*node;
+
+	tree->queries++;
+
+	if ( !tree->root ) {
+		return 0;
+	}
+
+	count = 0;
+	depth = 0;
+	stack[depth++] = tree->root;
+
+	while ( depth ) {
+		node = &tree->nodes[stack[--depth]];
+		tree->nodesVisited++;
+
+		if ( node->mins[0] > maxs[0]
+		|| node->mins[1] > maxs[1]
+		|| node->mins[2] > maxs[2]
+		|| node->maxs[0] < mins[0]
+		|| node->maxs[1] < mins[1]
+		|| node->maxs[2] < mins[2] ) {
+			continue;
+		}
+
+		if ( node->children[0] ) {
+			// the tree is balanced, so this is never hit
+			if ( depth > WORLDTREE_STACK - 2 ) {
+				Com_Error( ERR_DROP, "SV_TreeQuery: stack overflow" );
+			}
+			stack[depth++] = node->children[0];
+			stack[depth++] = node->children[1];
+			continue;
+		}
+
+		if ( count == maxcount ) {
+			break;
+		}
+		list[count++] = node->entityNum;
+	}
+
+	tree->candidates += count;
+
+	return count;
+}
+
+/*
+===============
+SV_TreeStats
+===============
+*/
+static void SV_TreeStats( worldTree_t *tree ) {
+	int64_t		queries = tree->queries ? tree->queries : 1;
+	int64_t		links = tree->links ? tree->links : 1;
+
+	Com_Printf( "world tree: %i entities, %i nodes, height %i\n", tree->numLeafs,
+		tree->numLeafs ? tree->numLeafs * 2 - 1 : 0,
+		tree->root ? tree->nodes[tree->root].height : 0 );
+	Com_Printf( "%12lld links\n", (long long)tree->links );
+	Com_Printf( "%12.1f%% kept in their leaf\n", 100.0 * tree->keeps / links );
+	Com_Printf( "%12lld inserts\n", (long long)tree->inserts );
+	Com_Printf( "%12lld queries\n", (long long)tree->queries );
+	Com_Printf( "%12.1f nodes visited per query\n", (double)tree->nodesVisited / queries );
+	Com_Printf( "%12.1f candidates per query\n", (double)tree->candidates / queries );
+}
+
+
 /*
 ===============
 SV_SectorList_f
@@ -85,6 +551,16 @@ void SV_SectorList_f( void ) {
 	worldSector_t	*sec;
 	svEntity_t		*ent;
 
+	if ( sv_entityTreeActive ) {
+		SV_TreeStats( &sv_entityTree );
+
+		if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+			sv_entityTree.links = sv_entityTree.keeps = sv_entityTree.inserts = 0;
+			sv_entityTree.queries = sv_entityTree.nodesVisited = sv_entityTree.candidates = 0;
+		}
+		return;
+	}
+
 	for ( i = 0 ; i < AREA_NODES ; i++ ) {
 		sec = &sv_worldSectors[i];
 
@@ -103,13 +579,13 @@ SV_CreateworldSector
 Builds a uniformly subdivided tree for the given world size
 ===============
 */
-static worldSector_t *SV_CreateworldSector( int depth, vec3_t mins, vec3_t maxs ) {
+static worldSector_t *SV_CreateworldSector( worldSector_t *sectors, int *numSectors, int depth, vec3_t mins, vec3_t maxs ) {
 	worldSector_t	*anode;
 	vec3_t		size;
 	vec3_t		mins1, maxs1, mins2, maxs2;
 
-	anode = &sv_worldSectors[sv_numworldSectors];
-	sv_numworldSectors++;
+	anode = &sectors[*numSectors];
+	(*numSectors)++;
 
 	if (depth == AREA_DEPTH) {
 		anode->axis = -1;
@@ -132,8 +608,8 @@ static worldSector_t *SV_CreateworldSector( int depth, vec3_t mins, vec3_t maxs
 	
 	maxs1[anode->axis] = mins2[anode->axis] = anode->dist;
 	
-	anode->children[0] = SV_CreateworldSector (depth+1, mins2, maxs2);
-	anode->children[1] = SV_CreateworldSector (depth+1, mins1, maxs1);
+	anode->children[0] = SV_CreateworldSector (sectors, numSectors, depth+1, mins2, maxs2);
+	anode->children[1] = SV_CreateworldSector (sectors, numSectors, depth+1, mins1, maxs1);
 
 	return anode;
 }
@@ -154,7 +630,10 @@ void SV_ClearWorld( void ) {
 	// get world map bounds
 	h = CM_InlineModel( 0 );
 	CM_ModelBounds( h, mins, maxs );
-	SV_CreateworldSector( 0, mins, maxs );
+	SV_CreateworldSector( sv_worldSectors, &sv_numworldSectors, 0, mins, maxs );
+
+	SV_TreeClear( &sv_entityTree );
+	sv_entityTreeActive = sv_worldTree->integer ? qtrue : qfalse;
 }
 
 
@@ -173,6 +652,12 @@ void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linked = qfalse;
 
+	if ( ent->worldNode ) {
+		SV_TreeUnlink( &sv_entityTree, ent->worldNode );
+		ent->worldNode = 0;
+		return;
+	}
+
 	ws = ent->worldSector;
 	if ( !ws ) {
 		return;		// not linked in anywhere
@@ -291,6 +776,9 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	// if none of the leafs were inside the map, the
 	// entity is outside the world and can be considered unlinked
 	if ( !num_leafs ) {
+		if ( ent->worldNode ) {
+			SV_UnlinkEntity( gEnt );
+		}
 		return;
 	}
 
@@ -332,6 +820,14 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linkcount++;
 
+	// the tree leaves the entity where it is if it hasn't moved far
+	if ( sv_entityTreeActive ) {
+		ent->worldNode = SV_TreeLink( &sv_entityTree, ent->worldNode, ent - sv.svEntities,
+			gEnt->r.absmin, gEnt->r.absmax );
+		gEnt->r.linked = qtrue;
+		return;
+	}
+
 	// find the first world sector node that the ent's box crosses
 	node = sv_worldSectors;
 	while (1)
@@ -418,6 +914,61 @@ static void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
 	}
 }
 
+/*
+================
+SV_CompareEntityNumbers
+================
+*/
+static int QDECL SV_CompareEntityNumbers( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+================
+SV_AreaEntitiesTree
+
+The order of the leaves depends on how the tree was built, so the
+entities are handed out by number to keep traces and touches from
+depending on the link history
+================
+*/
+static int SV_AreaEntitiesTree( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount ) {
+	int				candidates[MAX_GENTITIES];
+	int				i, num, count;
+	sharedEntity_t	*gcheck;
+
+	num = SV_TreeQuery( &sv_entityTree, mins, maxs, candidates, MAX_GENTITIES );
+
+	count = 0;
+	for ( i = 0 ; i < num ; i++ ) {
+		gcheck = SV_GentityNum( candidates[i] );
+
+		if ( gcheck->r.absmin[0] > maxs[0]
+		|| gcheck->r.absmin[1] > maxs[1]
+		|| gcheck->r.absmin[2] > maxs[2]
+		|| gcheck->r.absmax[0] < mins[0]
+		|| gcheck->r.absmax[1] < mins[1]
+		|| gcheck->r.absmax[2] < mins[2]) {
+			continue;
+		}
+
+		candidates[count++] = candidates[i];
+	}
+
+	if ( count > 1 ) {
+		qsort( candidates, count, sizeof( candidates[0] ), SV_CompareEntityNumbers );
+	}
+
+	if ( count > maxcount ) {
+		Com_Printf ("SV_AreaEntities: MAXCOUNT\n");
+		count = maxcount;
+	}
+
+	Com_Memcpy( entityList, candidates, count * sizeof( entityList[0] ) );
+
+	return count;
+}
+
 /*
 ================
 SV_AreaEntities
@@ -426,6 +977,10 @@ SV_AreaEntities
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount ) {
 	areaParms_t		ap;
 
+	if ( sv_entityTreeActive ) {
+		return SV_AreaEntitiesTree( mins, maxs, entityList, maxcount );
+	}
+
 	ap.mins = mins;
 	ap.maxs = maxs;
 	ap.list = entityList;
@@ -587,27 +1142,18 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 
 /*
 ==================
-SV_Trace
+SV_ClipTraceToEntities
 
-Moves the given mins/maxs volume through the world from start to end.
-passEntityNum and entities owned by passEntityNum are explicitly not checked.
+Continues a trace that has been clipped to the world with the entities
 ==================
 */
-void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
+static void SV_ClipTraceToEntities( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
 	moveclip_t	clip;
 	int			i;
 
-	if ( !mins ) {
-		mins = vec3_origin;
-	}
-	if ( !maxs ) {
-		maxs = vec3_origin;
-	}
-
 	Com_Memset ( &clip, 0, sizeof ( moveclip_t ) );
 
-	// clip to world
-	CM_BoxTrace( &clip.trace, start, end, mins, maxs, 0, contentmask, capsule );
+	clip.trace = *results;
 	clip.trace.entityNum = clip.trace.fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
 	if ( clip.trace.fraction == 0 ) {
 		*results = clip.trace;
@@ -643,6 +1189,51 @@ void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, c
 	*results = clip.trace;
 }
 
+/*
+==================
+SV_Trace
+
+Moves the given mins/maxs volume through the world from start to end.
+passEntityNum and entities owned by passEntityNum are explicitly not checked.
+==================
+*/
+void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
+	trace_t		trace;
+
+	if ( !mins ) {
+		mins = vec3_origin;
+	}
+	if ( !maxs ) {
+		maxs = vec3_origin;
+	}
+
+	// clip to world
+	CM_BoxTrace( &trace, start, end, mins, maxs, 0, contentmask, capsule );
+
+	SV_ClipTraceToEntities( &trace, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+
+	*results = trace;
+}
+
+/*
+==================
+SV_TraceBatch
+
+The world traces don't depend on each other and run as one batch,
+the entities are clipped one trace at a time after it
+==================
+*/
+void SV_TraceBatch( trace_t *results, const traceRequest_t *reqs, int count ) {
+	int		i;
+
+	CM_BoxTraceBatch( results, reqs, count, 0 );
+
+	for ( i = 0 ; i < count ; i++ ) {
+		SV_ClipTraceToEntities( &results[i], reqs[i].start, reqs[i].mins, reqs[i].maxs, reqs[i].end,
+			reqs[i].passEntityNum, reqs[i].contentmask, reqs[i].capsule );
+	}
+}
+
 
 
 /*
@@ -685,3 +1276,480 @@ int SV_PointContents( const vec3_t p, int passEntityNum ) {
 }
 
 
+
+#ifdef USE_WORLD_BENCH
+/*
+===============================================================================
+
+WORLD BENCHMARK
+
+worldbench replays a set of entity boxes through both the sectors and the
+dynamic tree.  Every pass moves the moving entities a little, relinks them
+and runs a query around each one, like a frame of movement traces.  The set
+is captured from the running map, or loaded from a file written with
+"worldbench save", so the same set can be replayed on any build.
+
+Development only, configure with -DUSE_WORLD_BENCH=ON to get it.
+
+===============================================================================
+*/
+
+#define	WORLDBENCH_QUERY_SIZE	64		// query reach around an entity
+#define	WORLDBENCH_STEP			16		// largest move per pass on each axis
+
+typedef struct {
+	vec3_t			worldMins, worldMaxs;
+	int				numEntities;
+	int				entityNums[MAX_GENTITIES];
+	qboolean		moving[MAX_GENTITIES];
+	vec3_t			absmin[MAX_GENTITIES];
+	vec3_t			absmax[MAX_GENTITIES];
+
+	// sectors chained by index instead of through svEntity_t
+	worldSector_t	sectors[AREA_NODES];
+	int				numSectors;
+	int				sectorHead[AREA_NODES];
+	int				sector[MAX_GENTITIES];		// -1 when not linked
+	int				next[MAX_GENTITIES];
+	int64_t			sectorTests;
+
+	worldTree_t		tree;
+	int				leafs[MAX_GENTITIES];
+
+	// results of one pass, compared between the two
+	int				list[MAX_GENTITIES];
+	int				sectorCount[MAX_GENTITIES], treeCount[MAX_GENTITIES];
+	unsigned		sectorHash[MAX_GENTITIES], treeHash[MAX_GENTITIES];
+} worldBench_t;
+
+/*
+===============
+SV_BenchCapture
+===============
+*/
+static qboolean SV_BenchCapture( worldBench_t *wb ) {
+	sharedEntity_t	*gEnt;
+	int				i, n;
+
+	if ( sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return qfalse;
+	}
+
+	CM_ModelBounds( CM_InlineModel( 0 ), wb->worldMins, wb->worldMaxs );
+
+	n = 0;
+	for ( i = 0 ; i < sv.num_entities ; i++ ) {
+		gEnt = SV_GentityNum( i );
+		if ( !gEnt->r.linked ) {
+			continue;
+		}
+		wb->entityNums[n] = i;
+		wb->moving[n] = ( gEnt->s.eType == ET_PLAYER || gEnt->s.pos.trType != TR_STATIONARY );
+		VectorCopy( gEnt->r.absmin, wb->absmin[n] );
+		VectorCopy( gEnt->r.absmax, wb->absmax[n] );
+		n++;
+	}
+	wb->numEntities = n;
+
+	return qtrue;
+}
+
+/*
+===============
+SV_BenchSave
+===============
+*/
+static void SV_BenchSave( worldBench_t *wb, const char *filename ) {
+	fileHandle_t	f;
+	int				i;
+
+	f = FS_FOpenFileWrite( filename );
+	if ( !f ) {
+		Com_Printf( "Couldn't write %s.\n", filename );
+		return;
+	}
+
+	FS_Printf( f, "worldbench 1\n" );
+	FS_Printf( f, "%f %f %f %f %f %f\n", wb->worldMins[0], wb->worldMins[1], wb->worldMins[2],
+		wb->worldMaxs[0], wb->worldMaxs[1], wb->worldMaxs[2] );
+	FS_Printf( f, "%i\n", wb->numEntities );
+	for ( i = 0 ; i < wb->numEntities ; i++ ) {
+		FS_Printf( f, "%i %i %f %f %f %f %f %f\n", wb->entityNums[i], wb->moving[i],
+			wb->absmin[i][0], wb->absmin[i][1], wb->absmin[i][2],
+			wb->absmax[i][0], wb->absmax[i][1], wb->absmax[i][2] );
+	}
+
+	FS_FCloseFile( f );
+	Com_Printf( "Wrote %i entities to %s.\n", wb->numEntities, filename );
+}
+
+/*
+===============
+SV_BenchParseVector
+===============
+*/
+static void SV_BenchParseVector( char **text, vec3_t v ) {
+	v[0] = atof( COM_Parse( text ) );
+	v[1] = atof( COM_Parse( text ) );
+	v[2] = atof( COM_Parse( text ) );
+}
+
+/*
+===============
+SV_BenchLoad
+===============
+*/
+static qboolean SV_BenchLoad( worldBench_t *wb, const char *filename ) {
+	union {
+		char	*c;
+		void	*v;
+	} buffer;
+	char		*text;
+	int			i;
+
+	if ( FS_ReadFile( filename, &buffer.v ) < 0 ) {
+		Com_Printf( "Couldn't read %s.\n", filename );
+		return qfalse;
+	}
+
+	text = buffer.c;
+	if ( strcmp( COM_Parse( &text ), "worldbench" ) || atoi( COM_Parse( &text ) ) != 1 ) {
+		Com_Printf( "%s is not a worldbench capture.\n", filename );
+		FS_FreeFile( buffer.v );
+		return qfalse;
+	}
+
+	SV_BenchParseVector( &text, wb->worldMins );
+	SV_BenchParseVector( &text, wb->worldMaxs );
+
+	wb->numEntities = atoi( COM_Parse( &text ) );
+	if ( wb->numEntities < 0 || wb->numEntities > MAX_GENTITIES ) {
+		Com_Printf( "%s has a bad entity count.\n", filename );
+		FS_FreeFile( buffer.v );
+		return qfalse;
+	}
+
+	for ( i = 0 ; i < wb->numEntities ; i++ ) {
+		wb->entityNums[i] = atoi( COM_Parse( &text ) );
+		wb->moving[i] = atoi( COM_Parse( &text ) ) ? qtrue : qfalse;
+		SV_BenchParseVector( &text, wb->absmin[i] );
+		SV_BenchParseVector( &text, wb->absmax[i] );
+	}
+
+	FS_FreeFile( buffer.v );
+	return qtrue;
+}
+
+/*
+===============
+SV_BenchSectorLink
+
+Same steps as SV_UnlinkEntity and SV_LinkEntity
+===============
+*/
+static void SV_BenchSectorLink( worldBench_t *wb, int num ) {
+	worldSector_t	*node;
+	int				*scan;
+
+	if ( wb->sector[num] != -1 ) {
+		for ( scan = &wb->sectorHead[wb->sector[num]] ; *scan != -1 ; scan = &wb->next[*scan] ) {
+			if ( *scan == num ) {
+				*scan = wb->next[num];
+				break;
+			}
+		}
+	}
+
+	node = wb->sectors;
+	while ( node->axis != -1 ) {
+		if ( wb->absmin[num][node->axis] > node->dist )
+			node = node->children[0];
+		else if ( wb->absmax[num][node->axis] < node->dist )
+			node = node->children[1];
+		else
+			break;
+	}
+
+	wb->sector[num] = node - wb->sectors;
+	wb->next[num] = wb->sectorHead[wb->sector[num]];
+	wb->sectorHead[wb->sector[num]] = num;
+}
+
+/*
+===============
+SV_BenchBoxesTouch
+===============
+*/
+static qboolean SV_BenchBoxesTouch( worldBench_t *wb, int num, const vec3_t mins, const vec3_t maxs ) {
+	return !( wb->absmin[num][0] > maxs[0]
+		|| wb->absmin[num][1] > maxs[1]
+		|| wb->absmin[num][2] > maxs[2]
+		|| wb->absmax[num][0] < mins[0]
+		|| wb->absmax[num][1] < mins[1]
+		|| wb->absmax[num][2] < mins[2] );
+}
+
+/*
+===============
+SV_BenchSectorQuery_r
+===============
+*/
+static void SV_BenchSectorQuery_r( worldBench_t *wb, worldSector_t *node, const vec3_t mins, const vec3_t maxs, int *count ) {
+	int		num;
+
+	for ( num = wb->sectorHead[node - wb->sectors] ; num != -1 ; num = wb->next[num] ) {
+		wb->sectorTests++;
+		if ( SV_BenchBoxesTouch( wb, num, mins, maxs ) ) {
+			wb->list[(*count)++] = num;
+		}
+	}
+
+	if ( node->axis == -1 ) {
+		return;
+	}
+	if ( maxs[node->axis] > node->dist ) {
+		SV_BenchSectorQuery_r( wb, node->children[0], mins, maxs, count );
+	}
+	if ( mins[node->axis] < node->dist ) {
+		SV_BenchSectorQuery_r( wb, node->children[1], mins, maxs, count );
+	}
+}
+
+/*
+===============
+SV_BenchHash
+
+Order independent, the two structures list entities in different orders
+===============
+*/
+static unsigned SV_BenchHash( const int *list, int count ) {
+	unsigned	hash = 0;
+	int			i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		hash += ( (unsigned)list[i] + 1 ) * 2654435761u;
+	}
+	return hash;
+}
+
+/*
+===============
+SV_BenchMove
+===============
+*/
+static void SV_BenchMove( worldBench_t *wb, int num, int *seed ) {
+	float	move;
+	int		i;
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		move = ( ( Q_rand( seed ) >> 8 ) & 0xffff ) % ( 2 * WORLDBENCH_STEP + 1 ) - WORLDBENCH_STEP;
+		if ( wb->absmin[num][i] + move < wb->worldMins[i] || wb->absmax[num][i] + move > wb->worldMaxs[i] ) {
+			move = -move;
+		}
+		wb->absmin[num][i] += move;
+		wb->absmax[num][i] += move;
+	}
+}
+
+/*
+===============
+SV_BenchRun
+===============
+*/
+static void SV_BenchRun( worldBench_t *wb, int passes ) {
+	int64_t		start, sectorLink, sectorQuery, treeLink, treeQuery;
+	int64_t		sectorResults, numQueries;
+	vec3_t		mins, maxs;
+	vec3_t		reach = { WORLDBENCH_QUERY_SIZE, WORLDBENCH_QUERY_SIZE, WORLDBENCH_QUERY_SIZE };
+	int			pass, i, j, q, count, numMoving, mismatches;
+	int			seed = 0x1234;
+
+	// initial link of the whole set
+	Com_Memset( wb->sectors, 0, sizeof( wb->sectors ) );
+	wb->numSectors = 0;
+	SV_CreateworldSector( wb->sectors, &wb->numSectors, 0, wb->worldMins, wb->worldMaxs );
+	for ( i = 0 ; i < AREA_NODES ; i++ ) {
+		wb->sectorHead[i] = -1;
+	}
+	SV_TreeClear( &wb->tree );
+
+	start = Sys_Microseconds();
+	for ( i = 0 ; i < wb->numEntities ; i++ ) {
+		wb->sector[i] = -1;
+		SV_BenchSectorLink( wb, i );
+	}
+	sectorLink = Sys_Microseconds() - start;
+
+	start = Sys_Microseconds();
+	for ( i = 0 ; i < wb->numEntities ; i++ ) {
+		wb->leafs[i] = SV_TreeLink( &wb->tree, 0, i, wb->absmin[i], wb->absmax[i] );
+	}
+	treeLink = Sys_Microseconds() - start;
+
+	Com_Printf( "linked %i entities: sectors %lld usec, tree %lld usec\n", wb->numEntities,
+		(long long)sectorLink, (long long)treeLink );
+
+	numMoving = 0;
+	for ( i = 0 ; i < wb->numEntities ; i++ ) {
+		if ( wb->moving[i] ) {
+			numMoving++;
+		}
+	}
+	if ( !numMoving ) {
+		Com_Printf( "No moving entities to replay.\n" );
+		return;
+	}
+
+	sectorLink = sectorQuery = treeLink = treeQuery = 0;
+	sectorResults = numQueries = 0;
+	mismatches = 0;
+	wb->sectorTests = 0;
+	wb->tree.links = wb->tree.keeps = wb->tree.inserts = 0;
+	wb->tree.queries = wb->tree.nodesVisited = wb->tree.candidates = 0;
+
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		for ( i = 0 ; i < wb->numEntities ; i++ ) {
+			if ( wb->moving[i] ) {
+				SV_BenchMove( wb, i, &seed );
+			}
+		}
+
+		start = Sys_Microseconds();
+		for ( i = 0 ; i < wb->numEntities ; i++ ) {
+			if ( wb->moving[i] ) {
+				SV_BenchSectorLink( wb, i );
+			}
+		}
+		sectorLink += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for ( i = 0 ; i < wb->numEntities ; i++ ) {
+			if ( wb->moving[i] ) {
+				wb->leafs[i] = SV_TreeLink( &wb->tree, wb->leafs[i], i, wb->absmin[i], wb->absmax[i] );
+			}
+		}
+		treeLink += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for ( i = 0, q = 0 ; i < wb->numEntities ; i++ ) {
+			if ( !wb->moving[i] ) {
+				continue;
+			}
+			VectorSubtract( wb->absmin[i], reach, mins );
+			VectorAdd( wb->absmax[i], reach, maxs );
+
+			count = 0;
+			SV_BenchSectorQuery_r( wb, wb->sectors, mins, maxs, &count );
+			wb->sectorCount[q] = count;
+			wb->sectorHash[q] = SV_BenchHash( wb->list, count );
+			q++;
+		}
+		sectorQuery += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for ( i = 0, q = 0 ; i < wb->numEntities ; i++ ) {
+			if ( !wb->moving[i] ) {
+				continue;
+			}
+			VectorSubtract( wb->absmin[i], reach, mins );
+			VectorAdd( wb->absmax[i], reach, maxs );
+
+			count = SV_TreeQuery( &wb->tree, mins, maxs, wb->list, MAX_GENTITIES );
+			for ( j = 0 ; j < count ; ) {
+				if ( SV_BenchBoxesTouch( wb, wb->list[j], mins, maxs ) ) {
+					j++;
+				} else {
+					wb->list[j] = wb->list[--count];
+				}
+			}
+			wb->treeCount[q] = count;
+			wb->treeHash[q] = SV_BenchHash( wb->list, count );
+			q++;
+		}
+		treeQuery += Sys_Microseconds() - start;
+
+		for ( q = 0 ; q < numMoving ; q++ ) {
+			if ( wb->sectorCount[q] != wb->treeCount[q] || wb->sectorHash[q] != wb->treeHash[q] ) {
+				mismatches++;
+			}
+			sectorResults += wb->sectorCount[q];
+		}
+		numQueries += numMoving;
+	}
+
+	Com_Printf( "%i passes, %i moving entities, %lld queries, %.1f entities per query\n",
+		passes, numMoving, (long long)numQueries, (double)sectorResults / numQueries );
+	Com_Printf( "           link usec  query usec  boxes tested per query\n" );
+	Com_Printf( "sectors %12lld %11lld %12.1f\n", (long long)sectorLink, (long long)sectorQuery,
+		(double)wb->sectorTests / numQueries );
+	Com_Printf( "tree    %12lld %11lld %12.1f\n", (long long)treeLink, (long long)treeQuery,
+		(double)( wb->tree.nodesVisited + wb->tree.candidates ) / numQueries );
+	Com_Printf( "tree height %i, %.1f%% of links kept in their leaf\n",
+		wb->tree.root ? wb->tree.nodes[wb->tree.root].height : 0,
+		100.0 * wb->tree.keeps / ( wb->tree.links ? wb->tree.links : 1 ) );
+
+	if ( mismatches ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: %i queries differ between sectors and tree\n", mismatches );
+	} else {
+		Com_Printf( "all queries matched\n" );
+	}
+}
+
+/*
+===============
+SV_WorldBench_f
+
+worldbench [passes]
+worldbench save <file>
+worldbench load <file> [passes]
+===============
+*/
+void SV_WorldBench_f( void ) {
+	worldBench_t	*wb;
+	char			filename[MAX_QPATH];
+	const char		*cmd;
+	int				passes, arg;
+
+	cmd = Cmd_Argv( 1 );
+	if ( ( !Q_stricmp( cmd, "save" ) || !Q_stricmp( cmd, "load" ) ) && Cmd_Argc() < 3 ) {
+		Com_Printf( "usage: worldbench [passes] | save <file> | load <file> [passes]\n" );
+		return;
+	}
+
+	wb = Z_Malloc( sizeof( *wb ) );
+
+	arg = 1;
+	if ( !Q_stricmp( cmd, "save" ) || !Q_stricmp( cmd, "load" ) ) {
+		Q_strncpyz( filename, Cmd_Argv( 2 ), sizeof( filename ) );
+		COM_DefaultExtension( filename, sizeof( filename ), ".txt" );
+		arg = 3;
+	}
+
+	if ( !Q_stricmp( cmd, "load" ) ) {
+		if ( !SV_BenchLoad( wb, filename ) ) {
+			Z_Free( wb );
+			return;
+		}
+	} else if ( !SV_BenchCapture( wb ) ) {
+		Z_Free( wb );
+		return;
+	}
+
+	if ( !Q_stricmp( cmd, "save" ) ) {
+		SV_BenchSave( wb, filename );
+		Z_Free( wb );
+		return;
+	}
+
+	passes = atoi( Cmd_Argv( arg ) );
+	if ( passes <= 0 ) {
+		passes = 100;
+	}
+
+	SV_BenchRun( wb, passes );
+
+	Z_Free( wb );
+}
+
+#endif // USE_WORLD_BENCH
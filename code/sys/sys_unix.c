@@ -20,6 +20,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ===========================================================================
 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE		// dladdr and the register names of ucontext_t
+#endif
+
 #include "../qcommon/q_shared.h"
 #include "../qcommon/qcommon.h"
 #include "sys_local.h"
@@ -40,6 +44,17 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <fenv.h>
 #include <sys/wait.h>
 #include <time.h>
+#ifndef __EMSCRIPTEN__
+#include <pthread.h>
+#include <dlfcn.h>
+#endif
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+#define USE_PROFILER
+#include <ucontext.h>
+#ifdef __GLIBC__
+#include <execinfo.h>
+#endif
+#endif
 
 qboolean stdinIsATTY;
 
@@ -176,6 +191,416 @@ int Sys_Milliseconds (void)
 	return curtime;
 }
 
+/*
+================
+Sys_Microseconds
+
+Monotonic, only meaningful as a difference between two calls
+================
+*/
+int64_t Sys_Microseconds( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+==============================================================
+
+THREADS
+
+Thin wrappers around pthreads for the job pool.  Emscripten builds
+are single threaded, so Sys_CreateThread always fails there and
+callers fall back to doing the work inline.
+
+==============================================================
+*/
+
+#ifndef __EMSCRIPTEN__
+struct sysThread_s {
+	pthread_t	handle;
+	void		(*func)( void *arg );
+	void		*arg;
+};
+
+struct sysMutex_s {
+	pthread_mutex_t	handle;
+};
+
+struct sysCond_s {
+	pthread_cond_t	handle;
+};
+
+static void *Sys_ThreadMain( void *arg )
+{
+	sysThread_t *thread = arg;
+
+	thread->func( thread->arg );
+	Com_ProfileThreadExit();
+
+	return NULL;
+}
+#endif
+
+/*
+================
+Sys_CreateThread
+================
+*/
+sysThread_t *Sys_CreateThread( void (*func)( void *arg ), void *arg )
+{
+#ifdef __EMSCRIPTEN__
+	return NULL;
+#else
+	sysThread_t *thread;
+
+	thread = malloc( sizeof( *thread ) );
+	if ( !thread )
+		return NULL;
+
+	thread->func = func;
+	thread->arg = arg;
+
+	if ( pthread_create( &thread->handle, NULL, Sys_ThreadMain, thread ) != 0 )
+	{
+		free( thread );
+		return NULL;
+	}
+
+	return thread;
+#endif
+}
+
+/*
+================
+Sys_JoinThread
+================
+*/
+void Sys_JoinThread( sysThread_t *thread )
+{
+#ifndef __EMSCRIPTEN__
+	pthread_join( thread->handle, NULL );
+	free( thread );
+#endif
+}
+
+/*
+================
+Sys_CreateMutex
+================
+*/
+sysMutex_t *Sys_CreateMutex( void )
+{
+#ifdef __EMSCRIPTEN__
+	return NULL;
+#else
+	sysMutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if ( !mutex )
+		return NULL;
+
+	pthread_mutex_init( &mutex->handle, NULL );
+
+	return mutex;
+#endif
+}
+
+/*
+================
+Sys_DestroyMutex
+================
+*/
+void Sys_DestroyMutex( sysMutex_t *mutex )
+{
+#ifndef __EMSCRIPTEN__
+	pthread_mutex_destroy( &mutex->handle );
+	free( mutex );
+#endif
+}
+
+/*
+================
+Sys_LockMutex
+================
+*/
+void Sys_LockMutex( sysMutex_t *mutex )
+{
+#ifndef __EMSCRIPTEN__
+	pthread_mutex_lock( &mutex->handle );
+#endif
+}
+
+/*
+================
+Sys_UnlockMutex
+================
+*/
+void Sys_UnlockMutex( sysMutex_t *mutex )
+{
+#ifndef __EMSCRIPTEN__
+	pthread_mutex_unlock( &mutex->handle );
+#endif
+}
+
+/*
+================
+Sys_CreateCond
+================
+*/
+sysCond_t *Sys_CreateCond( void )
+{
+#ifdef __EMSCRIPTEN__
+	return NULL;
+#else
+	sysCond_t *cond;
+
+	cond = malloc( sizeof( *cond ) );
+	if ( !cond )
+		return NULL;
+
+	pthread_cond_init( &cond->handle, NULL );
+
+	return cond;
+#endif
+}
+
+/*
+================
+Sys_DestroyCond
+================
+*/
+void Sys_DestroyCond( sysCond_t *cond )
+{
+#ifndef __EMSCRIPTEN__
+	pthread_cond_destroy( &cond->handle );
+	free( cond );
+#endif
+}
+
+/*
+================
+Sys_WaitCond
+
+The mutex must be held by the caller; it is released while waiting
+================
+*/
+void Sys_WaitCond( sysCond_t *cond, sysMutex_t *mutex )
+{
+#ifndef __EMSCRIPTEN__
+	pthread_cond_wait( &cond->handle, &mutex->handle );
+#endif
+}
+
+/*
+================
+Sys_SignalCond
+================
+*/
+void Sys_SignalCond( sysCond_t *cond )
+{
+#ifndef __EMSCRIPTEN__
+	pthread_cond_signal( &cond->handle );
+#endif
+}
+
+/*
+================
+Sys_BroadcastCond
+================
+*/
+void Sys_BroadcastCond( sysCond_t *cond )
+{
+#ifndef __EMSCRIPTEN__
+	pthread_cond_broadcast( &cond->handle );
+#endif
+}
+
+/*
+================
+Sys_NumProcessors
+================
+*/
+int Sys_NumProcessors( void )
+{
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+
+	return count > 0 ? (int)count : 1;
+}
+
+/*
+==============================================================
+
+PROFILER
+
+SIGPROF timer for vmprof.  The interrupted registers are only read
+on Linux, elsewhere Sys_StartProfiler fails.  glibc can unwind the
+native frames from the handler, the first backtrace() loads libgcc
+so it is done before the timer starts.
+
+==============================================================
+*/
+
+#ifdef USE_PROFILER
+#define PROFILE_MAX_FRAMES	64
+
+static sysProfileFunc_t sys_profileFunc;
+
+/*
+================
+Sys_ProfileSignal
+================
+*/
+static void Sys_ProfileSignal( int sig, siginfo_t *info, void *context )
+{
+	ucontext_t *uc = context;
+	sysProfileFunc_t func = sys_profileFunc;
+	void *frames[PROFILE_MAX_FRAMES];
+	void *pc, *sp;
+	int numFrames = 0;
+	int savedErrno = errno;
+
+	if( !func )
+		return;
+
+#if defined(__x86_64__)
+	pc = (void *)uc->uc_mcontext.gregs[REG_RIP];
+	sp = (void *)uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__i386__)
+	pc = (void *)uc->uc_mcontext.gregs[REG_EIP];
+	sp = (void *)uc->uc_mcontext.gregs[REG_ESP];
+#else
+	pc = (void *)uc->uc_mcontext.pc;
+	sp = (void *)uc->uc_mcontext.sp;
+#endif
+
+#ifdef __GLIBC__
+	{
+		int i;
+
+		// drop the frames of the handler, the unwinder steps over the
+		// signal frame to the interrupted pc
+		numFrames = backtrace( frames, ARRAY_LEN( frames ) );
+		for( i = 0; i < numFrames && frames[i] != pc; i++ )
+			;
+
+		if( i < numFrames )
+		{
+			numFrames -= i;
+			memmove( frames, frames + i, numFrames * sizeof( frames[0] ) );
+		}
+		else
+			numFrames = 0;
+	}
+#endif
+
+	func( pc, sp, frames, numFrames );
+
+	errno = savedErrno;
+}
+
+/*
+================
+Sys_StartProfiler
+================
+*/
+qboolean Sys_StartProfiler( int hz, sysProfileFunc_t func )
+{
+	struct sigaction action;
+	struct itimerval timer;
+
+#ifdef __GLIBC__
+	void *frame;
+
+	backtrace( &frame, 1 );
+#endif
+
+	sys_profileFunc = func;
+
+	memset( &action, 0, sizeof( action ) );
+	action.sa_sigaction = Sys_ProfileSignal;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset( &action.sa_mask );
+
+	if( sigaction( SIGPROF, &action, NULL ) == -1 )
+		return qfalse;
+
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = 1000000 / hz;
+	timer.it_value = timer.it_interval;
+
+	if( setitimer( ITIMER_PROF, &timer, NULL ) == -1 )
+	{
+		signal( SIGPROF, SIG_IGN );
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+/*
+================
+Sys_StopProfiler
+================
+*/
+void Sys_StopProfiler( void )
+{
+	struct itimerval timer;
+
+	memset( &timer, 0, sizeof( timer ) );
+	setitimer( ITIMER_PROF, &timer, NULL );
+
+	// a signal may still be pending
+	signal( SIGPROF, SIG_IGN );
+	sys_profileFunc = NULL;
+}
+#else
+qboolean Sys_StartProfiler( int hz, sysProfileFunc_t func )
+{
+	return qfalse;
+}
+
+void Sys_StopProfiler( void )
+{
+}
+#endif
+
+/*
+================
+Sys_AddressToSymbol
+
+Names code in the engine and in loaded modules
+================
+*/
+qboolean Sys_AddressToSymbol( const void *address, char *buf, int size )
+{
+#ifndef __EMSCRIPTEN__
+	Dl_info info;
+	const char *module;
+
+	if( !dladdr( address, &info ) || !info.dli_fname )
+		return qfalse;
+
+	if( info.dli_sname )
+	{
+		Q_strncpyz( buf, info.dli_sname, size );
+		return qtrue;
+	}
+
+	module = strrchr( info.dli_fname, '/' );
+	module = module ? module + 1 : info.dli_fname;
+
+	Com_sprintf( buf, size, "%s+0x%lx", module,
+		(unsigned long)( (const char *)address - (const char *)info.dli_fbase ) );
+	return qtrue;
+#else
+	return qfalse;
+#endif
+}
+
 /*
 ==================
 Sys_RandomBytes
@@ -280,6 +705,63 @@ qboolean Sys_Mkdir( const char *path )
 	return qtrue;
 }
 
+/*
+==================
+Sys_MapFile
+
+Maps a whole file read only, so processes mapping the same file
+share its pages
+==================
+*/
+void *Sys_MapFile( const char *ospath, long *length )
+{
+	struct stat	buf;
+	void		*data;
+	int			fd;
+
+	fd = open( ospath, O_RDONLY );
+	if( fd == -1 )
+		return NULL;
+
+	if( fstat( fd, &buf ) == -1 || !S_ISREG( buf.st_mode ) || buf.st_size <= 0 )
+	{
+		close( fd );
+		return NULL;
+	}
+
+	data = mmap( NULL, buf.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );
+
+	if( data == MAP_FAILED )
+		return NULL;
+
+	*length = buf.st_size;
+	return data;
+}
+
+/*
+==================
+Sys_UnmapFile
+==================
+*/
+void Sys_UnmapFile( void *data, long length )
+{
+	munmap( data, length );
+}
+
+/*
+==================
+Sys_Rename
+
+Replaces to with from, processes that still have to open or mapped keep
+the old file
+==================
+*/
+qboolean Sys_Rename( const char *from, const char *to )
+{
+	return rename( from, to ) == 0;
+}
+
 /*
 ==================
 Sys_Mkfifo
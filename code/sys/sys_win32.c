@@ -266,6 +266,246 @@ int Sys_Milliseconds (void)
 	return sys_curtime;
 }
 
+/*
+================
+Sys_Microseconds
+
+Monotonic, only meaningful as a difference between two calls
+================
+*/
+int64_t Sys_Microseconds( void )
+{
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if ( !frequency.QuadPart )
+		QueryPerformanceFrequency( &frequency );
+
+	QueryPerformanceCounter( &counter );
+
+	return (int64_t)( counter.QuadPart / frequency.QuadPart ) * 1000000 +
+		( counter.QuadPart % frequency.QuadPart ) * 1000000 / frequency.QuadPart;
+}
+
+/*
+==============================================================
+
+THREADS
+
+Thin wrappers around Win32 threads for the job pool
+
+==============================================================
+*/
+
+struct sysThread_s {
+	HANDLE	handle;
+	void	(*func)( void *arg );
+	void	*arg;
+};
+
+struct sysMutex_s {
+	CRITICAL_SECTION	handle;
+};
+
+struct sysCond_s {
+	CONDITION_VARIABLE	handle;
+};
+
+static DWORD WINAPI Sys_ThreadMain( LPVOID arg )
+{
+	sysThread_t *thread = arg;
+
+	thread->func( thread->arg );
+	Com_ProfileThreadExit();
+
+	return 0;
+}
+
+/*
+================
+Sys_CreateThread
+================
+*/
+sysThread_t *Sys_CreateThread( void (*func)( void *arg ), void *arg )
+{
+	sysThread_t *thread;
+
+	thread = malloc( sizeof( *thread ) );
+	if ( !thread )
+		return NULL;
+
+	thread->func = func;
+	thread->arg = arg;
+	thread->handle = CreateThread( NULL, 0, Sys_ThreadMain, thread, 0, NULL );
+
+	if ( !thread->handle )
+	{
+		free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+/*
+================
+Sys_JoinThread
+================
+*/
+void Sys_JoinThread( sysThread_t *thread )
+{
+	WaitForSingleObject( thread->handle, INFINITE );
+	CloseHandle( thread->handle );
+	free( thread );
+}
+
+/*
+================
+Sys_CreateMutex
+================
+*/
+sysMutex_t *Sys_CreateMutex( void )
+{
+	sysMutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if ( !mutex )
+		return NULL;
+
+	InitializeCriticalSection( &mutex->handle );
+
+	return mutex;
+}
+
+/*
+================
+Sys_DestroyMutex
+================
+*/
+void Sys_DestroyMutex( sysMutex_t *mutex )
+{
+	DeleteCriticalSection( &mutex->handle );
+	free( mutex );
+}
+
+/*
+================
+Sys_LockMutex
+================
+*/
+void Sys_LockMutex( sysMutex_t *mutex )
+{
+	EnterCriticalSection( &mutex->handle );
+}
+
+/*
+================
+Sys_UnlockMutex
+================
+*/
+void Sys_UnlockMutex( sysMutex_t *mutex )
+{
+	LeaveCriticalSection( &mutex->handle );
+}
+
+/*
+================
+Sys_CreateCond
+================
+*/
+sysCond_t *Sys_CreateCond( void )
+{
+	sysCond_t *cond;
+
+	cond = malloc( sizeof( *cond ) );
+	if ( !cond )
+		return NULL;
+
+	InitializeConditionVariable( &cond->handle );
+
+	return cond;
+}
+
+/*
+================
+Sys_DestroyCond
+================
+*/
+void Sys_DestroyCond( sysCond_t *cond )
+{
+	free( cond );
+}
+
+/*
+================
+Sys_WaitCond
+
+The mutex must be held by the caller; it is released while waiting
+================
+*/
+void Sys_WaitCond( sysCond_t *cond, sysMutex_t *mutex )
+{
+	SleepConditionVariableCS( &cond->handle, &mutex->handle, INFINITE );
+}
+
+/*
+================
+Sys_SignalCond
+================
+*/
+void Sys_SignalCond( sysCond_t *cond )
+{
+	WakeConditionVariable( &cond->handle );
+}
+
+/*
+================
+Sys_BroadcastCond
+================
+*/
+void Sys_BroadcastCond( sysCond_t *cond )
+{
+	WakeAllConditionVariable( &cond->handle );
+}
+
+/*
+================
+Sys_NumProcessors
+================
+*/
+int Sys_NumProcessors( void )
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+/*
+==============================================================
+
+PROFILER
+
+There is no profiling signal on Windows, vmprof is unavailable
+
+==============================================================
+*/
+
+qboolean Sys_StartProfiler( int hz, sysProfileFunc_t func )
+{
+	return qfalse;
+}
+
+void Sys_StopProfiler( void )
+{
+}
+
+qboolean Sys_AddressToSymbol( const void *address, char *buf, int size )
+{
+	return qfalse;
+}
+
 /*
 ================
 Sys_RandomBytes
@@ -408,6 +648,70 @@ qboolean Sys_Mkdir( const char *path )
 	return qtrue;
 }
 
+/*
+==================
+Sys_MapFile
+
+Maps a whole file read only, so processes mapping the same file
+share its pages
+==================
+*/
+void *Sys_MapFile( const char *ospath, long *length )
+{
+	HANDLE			file, mapping;
+	LARGE_INTEGER	size;
+	void			*data;
+
+	file = CreateFile( ospath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( file == INVALID_HANDLE_VALUE )
+		return NULL;
+
+	if( !GetFileSizeEx( file, &size ) || size.QuadPart <= 0 || size.QuadPart > 0x7fffffff )
+	{
+		CloseHandle( file );
+		return NULL;
+	}
+
+	mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( file );
+	if( !mapping )
+		return NULL;
+
+	// the view keeps the mapping alive
+	data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );
+
+	if( !data )
+		return NULL;
+
+	*length = (long)size.QuadPart;
+	return data;
+}
+
+/*
+==================
+Sys_UnmapFile
+==================
+*/
+void Sys_UnmapFile( void *data, long length )
+{
+	UnmapViewOfFile( data );
+}
+
+/*
+==================
+Sys_Rename
+
+Replaces to with from in one step.  Fails and leaves to alone while
+another process still has it mapped
+==================
+*/
+qboolean Sys_Rename( const char *from, const char *to )
+{
+	return MoveFileEx( from, to, MOVEFILE_REPLACE_EXISTING ) != 0;
+}
+
 /*
 ==================
 Sys_Mkfifo
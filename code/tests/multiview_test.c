@@ -0,0 +1,956 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// multiview_test.c -- draws a fixed scene with the GL2 renderer on a
+// headless EGL context, with r_ext_multiview 1 and 0, and compares the
+// eye layers.  Each eye is also checked against a mono frame drawn from
+// that eye's position, so the two-pass path is covered on drivers
+// without GL_OVR_multiview2 such as llvmpipe.
+
+#ifdef USE_INTERNAL_SDL_HEADERS
+#	include "SDL.h"
+#else
+#	include <SDL.h>
+#endif
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../renderercommon/tr_common.h"
+
+Q_EXPORT refexport_t * QDECL GetRefAPI( int apiVersion, refimport_t *rimp );
+
+// ctest treats this as skipped
+#define TEST_SKIPPED		77
+
+#define EYE_SIZE			128
+#define EYE_SEPARATION		320		// r_stereoSeparation, eyes 10.24 units apart at vr_worldscale 32
+
+static EGLDisplay	eglDisplay = EGL_NO_DISPLAY;
+static EGLSurface	eglSurface = EGL_NO_SURFACE;
+static EGLContext	eglContext = EGL_NO_CONTEXT;
+
+int qglMajorVersion, qglMinorVersion;
+int qglesMajorVersion, qglesMinorVersion;
+
+void (APIENTRYP qglActiveTextureARB) (GLenum texture);
+void (APIENTRYP qglClientActiveTextureARB) (GLenum texture);
+void (APIENTRYP qglMultiTexCoord2fARB) (GLenum target, GLfloat s, GLfloat t);
+
+void (APIENTRYP qglLockArraysEXT) (GLint first, GLsizei count);
+void (APIENTRYP qglUnlockArraysEXT) (void);
+
+#define GLE(ret, name, ...) name##proc * qgl##name = NULL;
+QGL_1_1_PROCS;
+QGL_1_1_FIXED_FUNCTION_PROCS;
+QGL_DESKTOP_1_1_PROCS;
+QGL_DESKTOP_1_1_FIXED_FUNCTION_PROCS;
+QGL_ES_1_1_PROCS;
+QGL_ES_1_1_FIXED_FUNCTION_PROCS;
+QGL_1_3_PROCS;
+QGL_DESKTOP_1_3_PROCS;
+QGL_1_5_PROCS;
+QGL_2_0_PROCS;
+QGL_3_0_PROCS;
+QGL_3_1_PROCS;
+QGL_3_2_PROCS;
+QGL_4_3_PROCS;
+QGL_4_5_PROCS;
+QGL_OVR_multiview_PROCS;
+QGL_ARB_occlusion_query_PROCS;
+QGL_ARB_framebuffer_object_PROCS;
+QGL_ARB_vertex_array_object_PROCS;
+QGL_EXT_direct_state_access_PROCS;
+#undef GLE
+
+// not in the renderer's lists
+static void (APIENTRYP qglTexStorage3D) (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+static void (APIENTRYP qglReadBuffer) (GLenum src);
+static void (APIENTRYP qglPixelStorei) (GLenum pname, GLint param);
+
+// set up by the VR client otherwise
+cvar_t *vr_worldscale;
+cvar_t *vr_worldscaleScaler;
+cvar_t *vr_hudDepth;
+cvar_t *vr_currentHudDrawStatus;
+
+/*
+==============================================================================
+
+CVARS AND IMPORTS
+
+Just enough of the engine for the renderer to start up without any files
+
+==============================================================================
+*/
+
+static cvar_t	*cvars;
+
+/*
+============
+Cvar_Find
+============
+*/
+static cvar_t *Cvar_Find( const char *name ) {
+	cvar_t	*var;
+
+	for ( var = cvars ; var ; var = var->next ) {
+		if ( !Q_stricmp( var->name, name ) ) {
+			return var;
+		}
+	}
+	return NULL;
+}
+
+/*
+============
+Cvar_Set
+============
+*/
+void Cvar_Set( const char *name, const char *value ) {
+	cvar_t	*var;
+
+	var = Cvar_Find( name );
+	if ( !var ) {
+		var = calloc( 1, sizeof( *var ) );
+		var->name = strdup( name );
+		var->resetString = strdup( value );
+		var->next = cvars;
+		cvars = var;
+	} else {
+		free( var->string );
+	}
+	var->string = strdup( value );
+	var->value = atof( value );
+	var->integer = atoi( value );
+	var->modified = qtrue;
+	var->modificationCount++;
+}
+
+/*
+============
+Cvar_Get
+============
+*/
+cvar_t *Cvar_Get( const char *name, const char *value, int flags ) {
+	cvar_t	*var;
+
+	var = Cvar_Find( name );
+	if ( !var ) {
+		Cvar_Set( name, value );
+		var = Cvar_Find( name );
+	}
+	var->flags |= flags;
+	return var;
+}
+
+static void Cvar_SetValue( const char *name, float value ) {
+	Cvar_Set( name, va( "%g", value ) );
+}
+
+static void Cvar_CheckRange( cvar_t *cv, float minVal, float maxVal, qboolean shouldBeIntegral ) {
+}
+
+static void Cvar_SetDescription( cvar_t *cv, const char *description ) {
+}
+
+static int Cvar_VariableIntegerValue( const char *name ) {
+	cvar_t	*var = Cvar_Find( name );
+
+	return var ? var->integer : 0;
+}
+
+static void QDECL Test_Printf( int printLevel, const char *fmt, ... ) Q_PRINTF_FUNC(2, 3);
+static void Q_NO_RETURN QDECL Test_Error( int errorLevel, const char *fmt, ... ) Q_PRINTF_FUNC(2, 3);
+
+static void QDECL Test_Printf( int printLevel, const char *fmt, ... ) {
+	va_list		argptr;
+
+	// only warnings and errors, the rest is the usual startup log
+	if ( printLevel < PRINT_WARNING ) {
+		return;
+	}
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+static void Q_NO_RETURN QDECL Test_Error( int errorLevel, const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+	printf( "\n" );
+	exit( 1 );
+}
+
+static int Test_Milliseconds( void ) {
+	struct timespec	ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+#ifdef HUNK_DEBUG
+static void *Test_HunkAlloc( int size, ha_pref pref, char *label, char *file, int line ) {
+#else
+static void *Test_HunkAlloc( int size, ha_pref pref ) {
+#endif
+	return calloc( 1, size );
+}
+
+static void *Test_Malloc( int bytes ) {
+	return calloc( 1, bytes );
+}
+
+static void Test_AddCommand( const char *name, void(*cmd)(void) ) {
+}
+
+static void Test_RemoveCommand( const char *name ) {
+}
+
+static int Test_Argc( void ) {
+	return 0;
+}
+
+static char *Test_Argv( int i ) {
+	return "";
+}
+
+static void Test_ExecuteText( int exec_when, const char *text ) {
+}
+
+static byte *Test_ClusterPVS( int cluster ) {
+	return NULL;
+}
+
+static void Test_DrawDebugSurface( void (*drawPoly)(int color, int numPoints, float *points) ) {
+}
+
+static int Test_FileIsInPAK( const char *name, int *pCheckSum ) {
+	return -1;
+}
+
+static long Test_ReadFile( const char *name, void **buf ) {
+	if ( buf ) {
+		*buf = NULL;
+	}
+	return -1;
+}
+
+static void Test_FreeFile( void *buf ) {
+}
+
+static char **Test_ListFiles( const char *name, const char *extension, int *numfilesfound ) {
+	*numfilesfound = 0;
+	return NULL;
+}
+
+static void Test_FreeFileList( char **filelist ) {
+}
+
+static void Test_WriteFile( const char *qpath, const void *buffer, int size ) {
+}
+
+static qboolean Test_FileExists( const char *file ) {
+	return qfalse;
+}
+
+static void Test_UploadCinematic( int handle ) {
+}
+
+static int Test_PlayCinematic( const char *arg0, int xpos, int ypos, int width, int height, int bits ) {
+	return -1;
+}
+
+static e_status Test_RunCinematic( int handle ) {
+	return FMV_EOF;
+}
+
+static void Test_WriteAVIVideoFrame( const byte *buffer, int size ) {
+}
+
+static void Test_IN_Init( void *windowData ) {
+}
+
+static void Test_IN_Void( void ) {
+}
+
+static long Test_ftol( float f ) {
+	return (long)f;
+}
+
+static void Test_SetEnv( const char *name, const char *value ) {
+}
+
+static qboolean Test_LowPhysicalMemory( void ) {
+	return qfalse;
+}
+
+static qboolean	profiling;
+
+static void Test_Profile( int zone ) {
+}
+
+static void Test_RunJobs( void (*func)( void *data, int index ), void *data, int count, int numThreads ) {
+	int		i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		func( data, i );
+	}
+}
+
+/*
+==============================================================================
+
+GLIMP
+
+An EGL pbuffer context in place of the SDL window
+
+==============================================================================
+*/
+
+SDL_bool SDL_GL_ExtensionSupported( const char *extension ) {
+	GLint	i, numExtensions;
+
+	if ( !qglGetStringi ) {
+		return SDL_FALSE;
+	}
+
+	qglGetIntegerv( GL_NUM_EXTENSIONS, &numExtensions );
+	for ( i = 0 ; i < numExtensions ; i++ ) {
+		if ( !strcmp( (const char *)qglGetStringi( GL_EXTENSIONS, i ), extension ) ) {
+			return SDL_TRUE;
+		}
+	}
+	return SDL_FALSE;
+}
+
+void *SDL_GL_GetProcAddress( const char *proc ) {
+	return (void *)eglGetProcAddress( proc );
+}
+
+/*
+===============
+GLimp_CreateContext
+===============
+*/
+static qboolean GLimp_CreateContext( void ) {
+	static const EGLint	configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_STENCIL_SIZE, 8,
+		EGL_NONE
+	};
+	static const EGLint	surfaceAttribs[] = {
+		EGL_WIDTH, EYE_SIZE,
+		EGL_HEIGHT, EYE_SIZE,
+		EGL_NONE
+	};
+	PFNEGLGETPLATFORMDISPLAYEXTPROC	getPlatformDisplay;
+	EGLConfig	config;
+	EGLint		major, minor, numConfigs;
+
+	getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+	if ( getPlatformDisplay ) {
+		eglDisplay = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+	}
+	if ( eglDisplay == EGL_NO_DISPLAY ) {
+		eglDisplay = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+	}
+	if ( eglDisplay == EGL_NO_DISPLAY || !eglInitialize( eglDisplay, &major, &minor ) ) {
+		return qfalse;
+	}
+
+	if ( !eglBindAPI( EGL_OPENGL_API ) ) {
+		return qfalse;
+	}
+
+	if ( !eglChooseConfig( eglDisplay, configAttribs, &config, 1, &numConfigs ) || !numConfigs ) {
+		return qfalse;
+	}
+
+	// stands in for the desktop window the renderer blits to
+	eglSurface = eglCreatePbufferSurface( eglDisplay, config, surfaceAttribs );
+	if ( eglSurface == EGL_NO_SURFACE ) {
+		return qfalse;
+	}
+
+	eglContext = eglCreateContext( eglDisplay, config, EGL_NO_CONTEXT, NULL );
+	if ( eglContext == EGL_NO_CONTEXT ) {
+		return qfalse;
+	}
+
+	return eglMakeCurrent( eglDisplay, eglSurface, eglSurface, eglContext );
+}
+
+/*
+===============
+GLimp_GetProcAddresses
+===============
+*/
+static qboolean GLimp_GetProcAddresses( void ) {
+	qboolean success = qtrue;
+
+#define GLE( ret, name, ... ) qgl##name = (name##proc *) SDL_GL_GetProcAddress("gl" #name); \
+	if ( qgl##name == NULL ) { \
+		ri.Printf( PRINT_ALL, "ERROR: Missing OpenGL function %s\n", "gl" #name ); \
+		success = qfalse; \
+	}
+
+	GLE(const GLubyte *, GetString, GLenum name)
+	sscanf( (const char *)qglGetString( GL_VERSION ), "%d.%d", &qglMajorVersion, &qglMinorVersion );
+
+	if ( !QGL_VERSION_ATLEAST( 4, 5 ) ) {
+		return qfalse;
+	}
+
+	QGL_1_1_PROCS;
+	QGL_DESKTOP_1_1_PROCS;
+	QGL_1_3_PROCS;
+	QGL_DESKTOP_1_3_PROCS;
+	QGL_1_5_PROCS;
+	QGL_2_0_PROCS;
+	QGL_3_0_PROCS;
+	QGL_3_1_PROCS;
+	QGL_3_2_PROCS;
+	QGL_4_3_PROCS;
+	QGL_4_5_PROCS;
+
+#undef GLE
+
+	qglTexStorage3D = SDL_GL_GetProcAddress( "glTexStorage3D" );
+	qglReadBuffer = SDL_GL_GetProcAddress( "glReadBuffer" );
+	qglPixelStorei = SDL_GL_GetProcAddress( "glPixelStorei" );
+	if ( !qglTexStorage3D || !qglReadBuffer || !qglPixelStorei ) {
+		success = qfalse;
+	}
+
+	return success;
+}
+
+/*
+===============
+GLimp_Init
+===============
+*/
+void GLimp_Init( qboolean fixedFunction ) {
+	if ( !GLimp_CreateContext() || !GLimp_GetProcAddresses() ) {
+		printf( "no EGL context with OpenGL 4.5, skipped\n" );
+		exit( TEST_SKIPPED );
+	}
+
+	glConfig.vidWidth = EYE_SIZE;
+	glConfig.vidHeight = EYE_SIZE;
+	glConfig.windowAspect = 1.0f;
+	glConfig.colorBits = 32;
+	glConfig.depthBits = 24;
+	glConfig.stencilBits = 8;
+	glConfig.driverType = GLDRV_ICD;
+	glConfig.hardwareType = GLHW_GENERIC;
+
+	Q_strncpyz( glConfig.vendor_string, (char *) qglGetString( GL_VENDOR ), sizeof( glConfig.vendor_string ) );
+	Q_strncpyz( glConfig.renderer_string, (char *) qglGetString( GL_RENDERER ), sizeof( glConfig.renderer_string ) );
+	Q_strncpyz( glConfig.version_string, (char *) qglGetString( GL_VERSION ), sizeof( glConfig.version_string ) );
+}
+
+void GLimp_Shutdown( void ) {
+	eglMakeCurrent( eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+	eglDestroyContext( eglDisplay, eglContext );
+	eglContext = EGL_NO_CONTEXT;
+	eglDestroySurface( eglDisplay, eglSurface );
+	eglSurface = EGL_NO_SURFACE;
+
+	Com_Memset( &glConfig, 0, sizeof( glConfig ) );
+}
+
+void GLimp_InitVR( void ) {
+}
+
+void GLimp_LogComment( char *comment ) {
+}
+
+void GLimp_Minimize( void ) {
+}
+
+void GLimp_SetGamma( unsigned char red[256], unsigned char green[256], unsigned char blue[256] ) {
+}
+
+qboolean GLimp_SpawnRenderThread( void (*function)( void ) ) {
+	return qfalse;
+}
+
+void GLimp_ShutdownRenderThread( void ) {
+}
+
+void *GLimp_RendererSleep( void ) {
+	return NULL;
+}
+
+void GLimp_FrontEndSleep( void ) {
+}
+
+void GLimp_WakeRenderer( void *data ) {
+}
+
+void GLimp_AcquireContext( void ) {
+}
+
+qboolean VR_Gameplay_ShouldRenderInVirtualScreen( void ) {
+	return qfalse;
+}
+
+/*
+==============================================================================
+
+SWAPCHAIN
+
+A two layer color and depth texture array, attached like the VR code does
+
+==============================================================================
+*/
+
+static GLuint	eyeColor, eyeDepth, eyeFramebuffer, readFramebuffer;
+
+/*
+===============
+Test_ClearEye
+===============
+*/
+static void Test_ClearEye( void ) {
+	qglViewport( 0, 0, EYE_SIZE, EYE_SIZE );
+	qglDisable( GL_SCISSOR_TEST );
+	qglClearColor( 0.0f, 0.0f, 0.0f, 1.0f );
+	qglClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+}
+
+/*
+===============
+Test_SelectEye
+===============
+*/
+static void Test_SelectEye( int eye ) {
+	qglFramebufferTextureLayer( GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, eyeColor, 0, eye );
+	qglFramebufferTextureLayer( GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, eyeDepth, 0, eye );
+}
+
+/*
+===============
+Test_CreateSwapchain
+===============
+*/
+static void Test_CreateSwapchain( void ) {
+	GLint	oldFramebuffer;
+
+	qglGenTextures( 1, &eyeColor );
+	qglBindTexture( GL_TEXTURE_2D_ARRAY, eyeColor );
+	qglTexStorage3D( GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, EYE_SIZE, EYE_SIZE, 2 );
+
+	qglGenTextures( 1, &eyeDepth );
+	qglBindTexture( GL_TEXTURE_2D_ARRAY, eyeDepth );
+	qglTexStorage3D( GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, EYE_SIZE, EYE_SIZE, 2 );
+	qglBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
+
+	qglGetIntegerv( GL_DRAW_FRAMEBUFFER_BINDING, &oldFramebuffer );
+	qglGenFramebuffers( 1, &eyeFramebuffer );
+	qglBindFramebuffer( GL_DRAW_FRAMEBUFFER, eyeFramebuffer );
+	if ( qglFramebufferTextureMultiviewOVR ) {
+		qglFramebufferTextureMultiviewOVR( GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, eyeColor, 0, 0, 2 );
+		qglFramebufferTextureMultiviewOVR( GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, eyeDepth, 0, 0, 2 );
+	} else {
+		Test_SelectEye( 0 );
+	}
+	if ( qglCheckFramebufferStatus( GL_DRAW_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE ) {
+		ri.Error( ERR_FATAL, "eye framebuffer incomplete" );
+	}
+	qglBindFramebuffer( GL_DRAW_FRAMEBUFFER, oldFramebuffer );
+
+	qglGenFramebuffers( 1, &readFramebuffer );
+}
+
+/*
+===============
+Test_DestroySwapchain
+===============
+*/
+static void Test_DestroySwapchain( void ) {
+	qglDeleteFramebuffers( 1, &readFramebuffer );
+	qglDeleteFramebuffers( 1, &eyeFramebuffer );
+	qglDeleteTextures( 1, &eyeDepth );
+	qglDeleteTextures( 1, &eyeColor );
+}
+
+/*
+===============
+Test_BeginFrameGL
+
+Clears both eye layers and leaves the eye framebuffer bound, like
+VR_Renderer_BeginFrameGL
+===============
+*/
+static int Test_BeginFrameGL( void *data ) {
+	qglBindFramebuffer( GL_DRAW_FRAMEBUFFER, eyeFramebuffer );
+	Test_ClearEye();
+	if ( !qglFramebufferTextureMultiviewOVR ) {
+		// only the left eye's layer is attached without multiview
+		Test_SelectEye( 1 );
+		Test_ClearEye();
+		Test_SelectEye( 0 );
+	}
+
+	return eyeFramebuffer;
+}
+
+static int Test_EndFrameGL( void *data ) {
+	return 0;
+}
+
+/*
+===============
+Test_ReadEye
+===============
+*/
+static void Test_ReadEye( int eye, byte *pixels ) {
+	GLint	oldFramebuffer;
+	GLenum	err;
+
+	if ( ( err = qglGetError() ) != GL_NO_ERROR ) {
+		ri.Error( ERR_FATAL, "drawing failed (0x%x)", err );
+	}
+
+	// the renderer keeps track of its bindings, so put it back
+	qglGetIntegerv( GL_READ_FRAMEBUFFER_BINDING, &oldFramebuffer );
+	qglBindFramebuffer( GL_READ_FRAMEBUFFER, readFramebuffer );
+	qglFramebufferTextureLayer( GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, eyeColor, 0, eye );
+	qglReadBuffer( GL_COLOR_ATTACHMENT0 );
+	qglPixelStorei( GL_PACK_ALIGNMENT, 1 );
+	qglReadPixels( 0, 0, EYE_SIZE, EYE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+	qglBindFramebuffer( GL_READ_FRAMEBUFFER, oldFramebuffer );
+
+	if ( ( err = qglGetError() ) != GL_NO_ERROR ) {
+		ri.Error( ERR_FATAL, "reading eye %d failed (0x%x)", eye, err );
+	}
+}
+
+/*
+==============================================================================
+
+SCENE
+
+==============================================================================
+*/
+
+typedef struct {
+	float	dist;		// in front of the viewer
+	float	y, z;		// center, left and up
+	float	size;
+	byte	color[4];
+} testQuad_t;
+
+// overlapping quads at different depths, so the eyes see them shifted apart
+static const testQuad_t testQuads[] = {
+	{ 200, 0, 0, 300, { 40, 40, 160, 255 } },
+	{ 100, 20, 10, 40, { 200, 40, 40, 255 } },
+	{ 40, -8, -6, 10, { 40, 200, 40, 255 } },
+};
+
+/*
+===============
+Test_Projection
+
+Symmetric 90 degree projection with an infinite far plane, as the VR code
+builds it
+===============
+*/
+static void Test_Projection( float *m ) {
+	const float	zNear = 1.0f;
+
+	Com_Memset( m, 0, 16 * sizeof( float ) );
+	m[0] = 1.0f;
+	m[5] = 1.0f;
+	m[10] = -1.0f;
+	m[11] = -1.0f;
+	m[14] = -2.0f * zNear;
+}
+
+/*
+===============
+Test_DrawFrame
+
+Draws the scene as seen from y to the left of the origin, and reads back
+both eyes.  The scene is moved rather than the view, the world model matrix
+already holds the view origin.  The view matrices are loaded by the next
+frame's RE_BeginFrame, so the frame is drawn twice.
+===============
+*/
+static void Test_DrawFrame( refexport_t *re, qhandle_t shader, float y, byte *pixels[2] ) {
+	float		projection[16];
+	polyVert_t	verts[4];
+	refdef_t	refdef;
+	int			frame, i, j;
+
+	for ( frame = 0 ; frame < 2 ; frame++ ) {
+	re->BeginVRFrame( Test_BeginFrameGL, NULL );
+	Test_Projection( projection );
+	re->SetVRHeadsetParms( projection, projection, eyeFramebuffer );
+
+	re->BeginFrame( STEREO_CENTER );
+	re->ClearScene();
+
+	for ( i = 0 ; i < ARRAY_LEN( testQuads ) ; i++ ) {
+		const testQuad_t *q = &testQuads[i];
+
+		for ( j = 0 ; j < 4 ; j++ ) {
+			VectorSet( verts[j].xyz, q->dist,
+				q->y - y + ( ( j == 1 || j == 2 ) ? -q->size : q->size ) * 0.5f,
+				q->z + ( j < 2 ? q->size : -q->size ) * 0.5f );
+			verts[j].st[0] = ( j == 1 || j == 2 );
+			verts[j].st[1] = ( j >= 2 );
+			Byte4Copy( q->color, verts[j].modulate );
+		}
+		re->AddPolyToScene( shader, 4, verts, 1 );
+	}
+
+	Com_Memset( &refdef, 0, sizeof( refdef ) );
+	refdef.width = EYE_SIZE;
+	refdef.height = EYE_SIZE;
+	refdef.fov_x = 90;
+	refdef.fov_y = 90;
+	AxisClear( refdef.viewaxis );
+	refdef.rdflags = RDF_NOWORLDMODEL;
+	re->RenderScene( &refdef );
+
+	re->EndFrame( NULL, NULL );
+	re->EndVRFrame( Test_EndFrameGL, NULL );
+	}
+
+	Test_ReadEye( 0, pixels[0] );
+	Test_ReadEye( 1, pixels[1] );
+}
+
+/*
+===============
+Test_Compare
+
+Returns the number of pixels that differ
+===============
+*/
+static int Test_Compare( const byte *a, const byte *b ) {
+	int		i, different;
+
+	different = 0;
+	for ( i = 0 ; i < EYE_SIZE * EYE_SIZE * 4 ; i += 4 ) {
+		if ( memcmp( a + i, b + i, 3 ) ) {
+			different++;
+		}
+	}
+	return different;
+}
+
+/*
+===============
+Test_Covered
+
+Returns the number of pixels drawn over the clear color
+===============
+*/
+static int Test_Covered( const byte *a ) {
+	int		i, covered;
+
+	covered = 0;
+	for ( i = 0 ; i < EYE_SIZE * EYE_SIZE * 4 ; i += 4 ) {
+		if ( a[i] || a[i + 1] || a[i + 2] ) {
+			covered++;
+		}
+	}
+	return covered;
+}
+
+/*
+===============
+Test_Run
+
+Draws the stereo frame and a mono frame from each eye's position,
+returns qtrue if multiview was used
+===============
+*/
+static qboolean Test_Run( const char *multiview, byte *stereo[2], byte *mono[2] ) {
+	refimport_t		rimp;
+	refexport_t		*re;
+	glconfig_t		config;
+	qhandle_t		shader;
+	qboolean		used;
+	byte			*unused[2];
+	float			eyeOffset;
+
+	Com_Memset( &rimp, 0, sizeof( rimp ) );
+	rimp.Printf = Test_Printf;
+	rimp.Error = Test_Error;
+	rimp.Milliseconds = Test_Milliseconds;
+#ifdef HUNK_DEBUG
+	rimp.Hunk_AllocDebug = Test_HunkAlloc;
+#else
+	rimp.Hunk_Alloc = Test_HunkAlloc;
+#endif
+	rimp.Hunk_AllocateTempMemory = Test_Malloc;
+	rimp.Hunk_FreeTempMemory = free;
+	rimp.Malloc = Test_Malloc;
+	rimp.Free = free;
+	rimp.Cvar_Get = Cvar_Get;
+	rimp.Cvar_Set = Cvar_Set;
+	rimp.Cvar_SetValue = Cvar_SetValue;
+	rimp.Cvar_CheckRange = Cvar_CheckRange;
+	rimp.Cvar_SetDescription = Cvar_SetDescription;
+	rimp.Cvar_VariableIntegerValue = Cvar_VariableIntegerValue;
+	rimp.Cmd_AddCommand = Test_AddCommand;
+	rimp.Cmd_RemoveCommand = Test_RemoveCommand;
+	rimp.Cmd_Argc = Test_Argc;
+	rimp.Cmd_Argv = Test_Argv;
+	rimp.Cmd_ExecuteText = Test_ExecuteText;
+	rimp.CM_ClusterPVS = Test_ClusterPVS;
+	rimp.CM_DrawDebugSurface = Test_DrawDebugSurface;
+	rimp.FS_FileIsInPAK = Test_FileIsInPAK;
+	rimp.FS_ReadFile = Test_ReadFile;
+	rimp.FS_FreeFile = Test_FreeFile;
+	rimp.FS_ListFiles = Test_ListFiles;
+	rimp.FS_FreeFileList = Test_FreeFileList;
+	rimp.FS_WriteFile = Test_WriteFile;
+	rimp.FS_FileExists = Test_FileExists;
+	rimp.CIN_UploadCinematic = Test_UploadCinematic;
+	rimp.CIN_PlayCinematic = Test_PlayCinematic;
+	rimp.CIN_RunCinematic = Test_RunCinematic;
+	rimp.CL_WriteAVIVideoFrame = Test_WriteAVIVideoFrame;
+	rimp.IN_Init = Test_IN_Init;
+	rimp.IN_Shutdown = Test_IN_Void;
+	rimp.IN_Restart = Test_IN_Void;
+	rimp.ftol = Test_ftol;
+	rimp.Sys_SetEnv = Test_SetEnv;
+	rimp.Sys_GLimpSafeInit = Test_IN_Void;
+	rimp.Sys_GLimpInit = Test_IN_Void;
+	rimp.Sys_LowPhysicalMemory = Test_LowPhysicalMemory;
+	rimp.profiling = &profiling;
+	rimp.ProfileBegin = Test_Profile;
+	rimp.ProfileEnd = Test_Profile;
+	rimp.RunJobs = Test_RunJobs;
+
+	Cvar_Set( "r_ext_multiview", multiview );
+	Cvar_Set( "r_stereoSeparation", va( "%d", EYE_SEPARATION ) );
+
+	re = GetRefAPI( REF_API_VERSION, &rimp );
+	if ( !re ) {
+		ri.Error( ERR_FATAL, "GetRefAPI failed" );
+	}
+	re->BeginRegistration( &config );
+	shader = re->RegisterShader( "*white" );
+	re->EndRegistration();
+
+	Test_CreateSwapchain();
+	used = qglFramebufferTextureMultiviewOVR != NULL;
+
+	Test_DrawFrame( re, shader, 0, stereo );
+
+	// the same frame from each eye's position, without separation
+	eyeOffset = ( EYE_SEPARATION / 1000.0f / 2.0f ) * vr_worldscale->value * vr_worldscaleScaler->value;
+	Cvar_Set( "r_stereoSeparation", "0" );
+	unused[0] = malloc( EYE_SIZE * EYE_SIZE * 4 );
+	unused[1] = malloc( EYE_SIZE * EYE_SIZE * 4 );
+	Test_DrawFrame( re, shader, eyeOffset, (byte *[2]){ mono[0], unused[0] } );
+	Test_DrawFrame( re, shader, -eyeOffset, (byte *[2]){ unused[1], mono[1] } );
+	free( unused[0] );
+	free( unused[1] );
+
+	Test_DestroySwapchain();
+	re->Shutdown( qtrue );
+
+	return used;
+}
+
+/*
+===============
+main
+===============
+*/
+int main( int argc, char **argv ) {
+	static const char	*modes[2] = { "1", "0" };
+	byte		*stereo[2][2], *mono[2][2];
+	qboolean	multiview[2];
+	int			i, eye, different, failed;
+
+	vr_worldscale = Cvar_Get( "vr_worldscale", "32.0", 0 );
+	vr_worldscaleScaler = Cvar_Get( "vr_worldscaleScaler", "1.0", 0 );
+	vr_hudDepth = Cvar_Get( "vr_hudDepth", "10", 0 );
+	vr_currentHudDrawStatus = Cvar_Get( "vr_currentHudDrawStatus", "1", 0 );
+
+	failed = 0;
+	for ( i = 0 ; i < 2 ; i++ ) {
+		for ( eye = 0 ; eye < 2 ; eye++ ) {
+			stereo[i][eye] = malloc( EYE_SIZE * EYE_SIZE * 4 );
+			mono[i][eye] = malloc( EYE_SIZE * EYE_SIZE * 4 );
+		}
+
+		multiview[i] = Test_Run( modes[i], stereo[i], mono[i] );
+		printf( "r_ext_multiview %s: %s\n", modes[i], multiview[i] ? "multiview" : "two passes" );
+
+		for ( eye = 0 ; eye < 2 ; eye++ ) {
+			if ( Test_Covered( stereo[i][eye] ) < EYE_SIZE * EYE_SIZE / 2 ) {
+				printf( "FAIL: r_ext_multiview %s eye %d is mostly empty\n", modes[i], eye );
+				failed++;
+			}
+			different = Test_Compare( stereo[i][eye], mono[i][eye] );
+			if ( different ) {
+				printf( "FAIL: r_ext_multiview %s eye %d differs from its mono frame in %d pixels\n", modes[i], eye, different );
+				failed++;
+			}
+		}
+		if ( !Test_Compare( stereo[i][0], stereo[i][1] ) ) {
+			printf( "FAIL: r_ext_multiview %s eyes are the same\n", modes[i] );
+			failed++;
+		}
+	}
+
+	if ( multiview[0] ) {
+		for ( eye = 0 ; eye < 2 ; eye++ ) {
+			different = Test_Compare( stereo[0][eye], stereo[1][eye] );
+			if ( different ) {
+				printf( "FAIL: eye %d differs between multiview and two passes in %d pixels\n", eye, different );
+				failed++;
+			}
+		}
+	} else {
+		printf( "GL_OVR_multiview2 not supported, only the two-pass path was tested\n" );
+	}
+
+	printf( "%s\n", failed ? "FAILED" : "passed" );
+	return failed ? 1 : 0;
+}
@@ -1468,7 +1468,9 @@ static void Assemble( void ) {
 		}
 	}
 
-	// reserve the stack in bss
+	// reserve the stack in bss, the symbols belong there and not
+	// into the code segment the last file ended in
+	currentSegment = &segment[BSSSEG];
 	DefineSymbol( "_stackStart", segment[BSSSEG].imageUsed );
 	segment[BSSSEG].imageUsed += stackSize;
 	DefineSymbol( "_stackEnd", segment[BSSSEG].imageUsed );
@@ -32,19 +32,35 @@ XrTime lastPredictedDisplayTime = 0;
 qboolean frameStarted = qfalse;
 qboolean needRecenter = qtrue;
 
-// Data per-frame data held between BeginFrame and EndFrame
-XrFovf fov = { 0 };
-XrView views[2];
-uint32_t viewCount = 2;
-uint32_t swapchainColorIndex = 0;
-uint32_t swapchainDepthIndex = 0;
+// Per-frame data held between BeginFrame and EndFrame.  With r_smp the
+// render thread finishes a frame while the next one is being set up, so
+// they alternate between two of these.
+typedef struct
+{
+	VR_Engine* engine;
+	XrFovf fov;
+	XrView views[2];
+	uint32_t viewCount;
+	XrTime predictedDisplayTime;
+	XrSpace space;
+	uint32_t swapchainColorIndex;
+	uint32_t swapchainDepthIndex;
+	int renderBuffer;
+	qboolean spectatorClear;
+	qboolean useVirtualScreen;
+	XrDesktopViewConfiguration desktopView;
+	float menuYaw;
+} vrFrame_t;
+
+static vrFrame_t frames[2];
+static int frameNum = 0;
 
 void VR_Renderer_BeginFrame(VR_Engine* engine, XrBool32 needsRecenter);
 void VR_Renderer_EndFrame(VR_Engine* engine);
 void VR_Recenter(VR_Engine* engine, XrTime predictedDisplayTime);
-void VR_ClearFrameBuffer( int width, int height);
+void VR_ClearFrameBuffer( int width, int height, qboolean spectator );
 void VR_UpdatePerFrameState( void );
-void VR_DrawVirtualScreen(VR_SwapchainInfos* swapchains, uint32_t swapchainImageIndex, XrFovf fov, XrView* views, uint32_t viewCount);
+void VR_DrawVirtualScreen(VR_SwapchainInfos* swapchains, uint32_t swapchainImageIndex, uint32_t swapchainDepthIndex, XrFovf fov, XrView* views, uint32_t viewCount);
 XrDesktopViewConfiguration VR_GetDesktopViewConfiguration( void );
 
 void VR_GetResolution(VR_Engine* engine, int *pWidth, int *pHeight)
@@ -162,8 +178,71 @@ void VR_Renderer_RestoreState(VR_Engine* engine)
 	VR_Renderer_BeginFrame(engine, needsRecenter);
 }
 
+// Runs where the renderer executes the frame's commands, the render
+// thread with r_smp
+static int VR_Renderer_BeginFrameGL(void* data)
+{
+	vrFrame_t* frame = data;
+	VR_SwapchainInfos* swapchains = &frame->engine->appState.Renderer.Swapchains;
+
+	VR_BeginFrame(frame->engine->appState.Session);
+
+	VR_Swapchains_Acquire(swapchains, &frame->swapchainColorIndex, &frame->swapchainDepthIndex);
+	VR_Swapchains_BindFramebuffers(swapchains, frame->swapchainColorIndex, frame->swapchainDepthIndex);
+	VR_ClearFrameBuffer(swapchains->color.width, swapchains->color.height, frame->spectatorClear);
+	if (!qglFramebufferTextureMultiviewOVR)
+	{
+		// Only the left eye's layer is attached without multiview
+		VR_Swapchains_SelectEye(swapchains, frame->swapchainColorIndex, frame->swapchainDepthIndex, 1);
+		VR_ClearFrameBuffer(swapchains->color.width, swapchains->color.height, frame->spectatorClear);
+		VR_Swapchains_SelectEye(swapchains, frame->swapchainColorIndex, frame->swapchainDepthIndex, 0);
+	}
+
+	frame->renderBuffer = swapchains->framebuffers[frame->swapchainColorIndex];
+	return frame->renderBuffer;
+}
+
+static int VR_Renderer_EndFrameGL(void* data)
+{
+	vrFrame_t* frame = data;
+	VR_SwapchainInfos* swapchains = &frame->engine->appState.Renderer.Swapchains;
+
+	// Draw Virtual Screen if needed
+	if (frame->useVirtualScreen)
+	{
+		VR_DrawVirtualScreen(swapchains, frame->swapchainColorIndex, frame->swapchainDepthIndex, frame->fov, frame->views, frame->viewCount);
+		frame->menuYaw = VR_VirtualScreen_GetCurrentYaw();
+	}
+	else
+	{
+		VR_VirtualScreen_ResetPosition();
+	}
+
+	VR_Swapchains_Release(swapchains);
+	VR_Swapchains_BindFramebuffers(NULL, 0, 0);
+
+	// Blit left eye's view to main FBO (desktop window)
+	VR_Swapchains_BlitXRToMainFbo(swapchains, frame->swapchainColorIndex, frame->desktopView);
+
+	VR_EndFrame(
+		frame->engine->appState.Session,
+		swapchains,
+		frame->views,
+		frame->viewCount,
+		frame->fov,
+		frame->space,
+		frame->predictedDisplayTime);
+
+	// Flip desktop window's buffer
+	GLimp_EndFrame();
+
+	return 0;
+}
+
 void VR_Renderer_BeginFrame(VR_Engine* engine, XrBool32 needsRecenter)
 {
+	vrFrame_t* frame = &frames[frameNum];
+
 	frameStarted = qtrue;
 	lastPredictedDisplayTime = VR_WaitFrame(engine->appState.Session).predictedDisplayTime;
 
@@ -172,83 +251,80 @@ void VR_Renderer_BeginFrame(VR_Engine* engine, XrBool32 needsRecenter)
 		VR_Recenter(engine, lastPredictedDisplayTime);
 	}
 
-	VR_BeginFrame(engine->appState.Session);
+	frame->engine = engine;
+	frame->predictedDisplayTime = lastPredictedDisplayTime;
+	frame->space = engine->appState.CurrentSpace;
+	frame->viewCount = 2;
 
 	const XrViewState viewState = VR_LocateViews(
 		engine->appState.Session,
 		lastPredictedDisplayTime,
-		engine->appState.CurrentSpace,
-		views,
-		&viewCount);
+		frame->space,
+		frame->views,
+		&frame->viewCount);
 
 	// Update HMD position/views
-	IN_VRUpdateHMD(views, viewCount, &fov);
+	IN_VRUpdateHMD(frame->views, frame->viewCount, &frame->fov);
 
 	// [Input] poll actions, update controller state, issue action commands
 	IN_VRSyncActions(engine);
 	IN_VRUpdateControllers(engine, lastPredictedDisplayTime);
 
-	VR_SwapchainInfos* swapchains = &engine->appState.Renderer.Swapchains;
-
-	VR_Swapchains_Acquire(swapchains, &swapchainColorIndex, &swapchainDepthIndex);
-	VR_Swapchains_BindFramebuffers(swapchains, swapchainColorIndex, swapchainDepthIndex);
-	VR_ClearFrameBuffer(swapchains->color.width, swapchains->color.height);
+	// xrBeginFrame and the swapchain acquire; with r_smp they are queued
+	// and renderBuffer stays 0 until the render thread gets to them
+	frame->spectatorClear = Cvar_VariableIntegerValue("vr_thirdPersonSpectator") ? qtrue : qfalse;
+	frame->renderBuffer = 0;
+	re.BeginVRFrame(VR_Renderer_BeginFrameGL, frame);
 
 	// Set renderer params
 	XrMatrix4x4f vrMatrixMono, vrMatrixProjection;
 	const XrFovf monoFov = { -hudScale, hudScale, hudScale, -hudScale };
 	const XrFovf projectionFov =
 	{
-		fov.angleLeft / vr.weapon_zoomLevel,
-		fov.angleRight / vr.weapon_zoomLevel,
-		fov.angleUp / vr.weapon_zoomLevel,
-		fov.angleDown / vr.weapon_zoomLevel,
+		frame->fov.angleLeft / vr.weapon_zoomLevel,
+		frame->fov.angleRight / vr.weapon_zoomLevel,
+		frame->fov.angleUp / vr.weapon_zoomLevel,
+		frame->fov.angleDown / vr.weapon_zoomLevel,
 	};
 	XrMatrix4x4f_CreateProjectionFov(&vrMatrixMono, GRAPHICS_OPENGL, monoFov, 1.0f, 0.0f);
 	XrMatrix4x4f_CreateProjectionFov(&vrMatrixProjection, GRAPHICS_OPENGL, projectionFov, 1.0f, 0.0f);
-	re.SetVRHeadsetParms(vrMatrixProjection.m, vrMatrixMono.m, swapchains->framebuffers[swapchainColorIndex]);
+	re.SetVRHeadsetParms(vrMatrixProjection.m, vrMatrixMono.m, frame->renderBuffer);
 }
 
 void VR_Renderer_EndFrame(VR_Engine* engine)
 {
-	VR_SwapchainInfos* swapchains = &engine->appState.Renderer.Swapchains;
+	vrFrame_t* frame = &frames[frameNum];
+	vrFrame_t* done = frame;
 
-	// Draw Virtual Screen if needed
-	const int use_virtual_screen = VR_Gameplay_ShouldRenderInVirtualScreen() || ((cl.snap.ps.pm_flags & PMF_FOLLOW) && (vr.follow_mode == VRFM_FIRSTPERSON));
-	if (use_virtual_screen)
-	{
-		VR_DrawVirtualScreen(swapchains, swapchainColorIndex, fov, views, viewCount);
-		vr.menuYaw = VR_VirtualScreen_GetCurrentYaw();
-	}
-	else
+	frame->useVirtualScreen = VR_Gameplay_ShouldRenderInVirtualScreen() || ((cl.snap.ps.pm_flags & PMF_FOLLOW) && (vr.follow_mode == VRFM_FIRSTPERSON));
+	frame->desktopView = VR_GetDesktopViewConfiguration();
+	frame->menuYaw = vr.hmdorientation[YAW];
+
+	if (re.EndVRFrame(VR_Renderer_EndFrameGL, frame))
 	{
-		VR_VirtualScreen_ResetPosition();
-		vr.menuYaw = vr.hmdorientation[YAW];
+		// The render thread may still be drawing this frame, the one
+		// before it is finished
+		done = &frames[frameNum ^ 1];
 	}
+	frameNum ^= 1;
 
-	VR_Swapchains_Release(swapchains);
-	VR_Swapchains_BindFramebuffers(NULL, 0, 0);
-
-	// Blit left eye's view to main FBO (desktop window)
-	VR_Swapchains_BlitXRToMainFbo(swapchains, swapchainColorIndex, VR_GetDesktopViewConfiguration());
-
-	VR_EndFrame(
-		engine->appState.Session,
-		swapchains,
-		views,
-		viewCount,
-		fov,
-		engine->appState.CurrentSpace,
-		lastPredictedDisplayTime);
+	// Update menu orientation
+	vr.menuYaw = frame->useVirtualScreen ? done->menuYaw : vr.hmdorientation[YAW];
 
-	// Flip desktop window's buffer
-	GLimp_EndFrame();
+	// The render thread leaves window changes to the main thread
+	GLimp_CheckFullscreen();
 
 	frameStarted = qfalse;
 }
 
 void VR_Recenter(VR_Engine* engine, XrTime predictedDisplayTime)
 {
+	// Frames still on the render thread use the spaces destroyed below
+	if (re.SyncRenderThread)
+	{
+		re.SyncRenderThread();
+	}
+
 	// Calculate recenter reference
 	XrReferenceSpaceCreateInfo spaceCreateInfo = {};
 	spaceCreateInfo.type = XR_TYPE_REFERENCE_SPACE_CREATE_INFO;
@@ -312,12 +388,12 @@ void VR_Recenter(VR_Engine* engine, XrTime predictedDisplayTime)
 	VR_VirtualScreen_ResetPosition();
 }
 
-void VR_ClearFrameBuffer( int width, int height)
+void VR_ClearFrameBuffer( int width, int height, qboolean spectator )
 {
 	glEnable( GL_SCISSOR_TEST );
 	glViewport( 0, 0, width, height );
 
-	if (Cvar_VariableIntegerValue("vr_thirdPersonSpectator"))
+	if (spectator)
 	{
 		//Blood red.. ish
 		glClearColor( 0.12f, 0.0f, 0.05f, 1.0f );
@@ -352,17 +428,27 @@ void VR_UpdatePerFrameState( void )
 	}
 }
 
-void VR_DrawVirtualScreen(VR_SwapchainInfos* swapchains, uint32_t swapchainImageIndex, XrFovf fov, XrView* views, uint32_t viewCount)
+void VR_DrawVirtualScreen(VR_SwapchainInfos* swapchains, uint32_t swapchainImageIndex, uint32_t swapchainDepthIndex, XrFovf fov, XrView* views, uint32_t viewCount)
 {
 	// Copy current image to Virtual Screen's texture
 	VR_Swapchains_BlitXRToVirtualScreen(swapchains, swapchainImageIndex);
 
-	// Clear everything
-	glClearColor(0.0, 0.0f, 0.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// Without multiview each eye is cleared and drawn on its own
+	const uint32_t passes = qglFramebufferTextureMultiviewOVR ? 1 : viewCount;
+	for (uint32_t eye = 0; eye < passes; ++eye)
+	{
+		if (!qglFramebufferTextureMultiviewOVR)
+		{
+			VR_Swapchains_SelectEye(swapchains, swapchainImageIndex, swapchainDepthIndex, eye);
+		}
+
+		// Clear everything
+		glClearColor(0.0, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// Render VS
-	VR_VirtualScreen_Draw(fov, &views[0].pose, &views[viewCount - 1].pose, swapchains->color.virtualScreenImage);
+		// Render VS
+		VR_VirtualScreen_Draw(fov, &views[0].pose, &views[viewCount - 1].pose, swapchains->color.virtualScreenImage, eye);
+	}
 }
 
 XrDesktopViewConfiguration VR_GetDesktopViewConfiguration( void )
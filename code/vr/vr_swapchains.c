@@ -138,19 +138,34 @@ int64_t VR_GetBestDepthSwapchainFormat(int64_t* formats, uint32_t formatCount)
 	return formats[0];
 }
 
-// Framebuffer creation
-GLuint VR_CreateImageView(GLuint colorImage, GLuint depthImage, uint32_t viewCount)
+// Attaches all eye layers to the bound draw framebuffer, or only the first
+// one without multiview, the renderer then moves it along for each eye
+static void VR_AttachEyeImages(GLuint colorImage, GLuint depthImage, uint32_t viewCount)
 {
 	const int baseMipLevel = 0;
 	const int baseArrayLayer = 0;
 
+	if (qglFramebufferTextureMultiviewOVR)
+	{
+		qglFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorImage, baseMipLevel, baseArrayLayer, viewCount);
+		qglFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthImage, baseMipLevel, baseArrayLayer, viewCount);
+	}
+	else
+	{
+		qglFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorImage, baseMipLevel, baseArrayLayer);
+		qglFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthImage, baseMipLevel, baseArrayLayer);
+	}
+}
+
+// Framebuffer creation
+GLuint VR_CreateImageView(GLuint colorImage, GLuint depthImage, uint32_t viewCount)
+{
 	GLuint framebuffer = 0;
 	qglGenFramebuffers(1, &framebuffer);
 	CHECK(framebuffer != 0, "Failed to create GL framebuffer");
 
 	qglBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-	qglFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorImage, baseMipLevel, baseArrayLayer, viewCount);
-	qglFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthImage, baseMipLevel, baseArrayLayer, viewCount);
+	VR_AttachEyeImages(colorImage, depthImage, viewCount);
 
 	GLenum result = qglCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
 	CHECK(result == GL_FRAMEBUFFER_COMPLETE, "Failed to create complete Framebuffer");
@@ -419,8 +434,13 @@ void VR_Swapchains_BindFramebuffers(VR_SwapchainInfos* swapchains, uint32_t swap
 		"Invalid swapchainImageIndex value - out of bounds");
 
 	qglBindFramebuffer(GL_DRAW_FRAMEBUFFER, swapchains->framebuffers[swapchainColorIndex]);
-	qglFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, swapchains->color.images[swapchainColorIndex], 0, 0, 2);
-	qglFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, swapchains->depth.images[swapchainDepthIndex], 0, 0, 2);
+	VR_AttachEyeImages(swapchains->color.images[swapchainColorIndex], swapchains->depth.images[swapchainDepthIndex], swapchains->viewCount);
+}
+
+void VR_Swapchains_SelectEye(VR_SwapchainInfos* swapchains, uint32_t swapchainColorIndex, uint32_t swapchainDepthIndex, uint32_t eye)
+{
+	qglFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, swapchains->color.images[swapchainColorIndex], 0, eye);
+	qglFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, swapchains->depth.images[swapchainDepthIndex], 0, eye);
 }
 
 void VR_Swapchains_BlitXRToMainFbo(VR_SwapchainInfos* swapchains, uint32_t swapchainImageIndex, XrDesktopViewConfiguration viewConfig)
@@ -26,12 +26,22 @@ unsigned int quadIndices[] =
 	1, 2, 3,   // second triangle
 };
 
-const char* vsVertexShaderSource =
+// Vertex shaders get one of these in front, without multiview each eye
+// is drawn on its own and viewIndex picks its view matrix
+const char* multiviewShaderHeader =
 	"#version 430 core\n"
 	"\n"
 	"#define NUM_VIEWS 2\n"
 	"#extension GL_OVR_multiview2 : enable\n"
 	"layout(num_views=NUM_VIEWS) in;\n"
+	"#define VIEW_ID gl_ViewID_OVR\n";
+const char* singleViewShaderHeader =
+	"#version 430 core\n"
+	"\n"
+	"uniform int viewIndex;\n"
+	"#define VIEW_ID viewIndex\n";
+
+const char* vsVertexShaderSource =
 	"\n"
 	"layout (location = 0) in vec3 aPos;\n"
 	"layout (location = 1) in vec2 aTexCoord;\n"
@@ -44,7 +54,7 @@ const char* vsVertexShaderSource =
 	"\n"
 	"void main()\n"
 	"{\n"
-	"    gl_Position = (proj * (view[gl_ViewID_OVR] * (model * vec4(aPos.x, aPos.y, aPos.z, 1.0))));\n"
+	"    gl_Position = (proj * (view[VIEW_ID] * (model * vec4(aPos.x, aPos.y, aPos.z, 1.0))));\n"
 	"    TexCoord = aTexCoord;\n"
 	"}\n";
 const char* vsFragmentShaderSource =
@@ -61,11 +71,6 @@ const char* vsFragmentShaderSource =
 	"}\n";
 
 const char* floorVertexShaderSource =
-	"#version 430 core\n"
-	"\n"
-	"#define NUM_VIEWS 2\n"
-	"#extension GL_OVR_multiview2 : enable\n"
-	"layout(num_views=NUM_VIEWS) in;\n"
 	"\n"
 	"layout (location = 0) in vec3 aPos;\n"
 	"layout (location = 1) in vec2 aTexCoord;\n"
@@ -78,7 +83,7 @@ const char* floorVertexShaderSource =
 	"\n"
 	"void main()\n"
 	"{\n"
-	"    gl_Position = (proj * (view[gl_ViewID_OVR] * (model * vec4(aPos.xzy, 1.0))));\n"
+	"    gl_Position = (proj * (view[VIEW_ID] * (model * vec4(aPos.xzy, 1.0))));\n"
 	"    Pos = aTexCoord - vec2(0.5);"
 	"}\n";
 const char* floorFragmentShaderSource =
@@ -132,11 +137,11 @@ unsigned int quadEBO = 0;
 unsigned int vsShaderProgram = 0;
 unsigned int floorShaderProgram = 0;
 
-unsigned int _VR_CreateAndCompileShader(GLenum shaderType, const GLchar** source)
+unsigned int _VR_CreateAndCompileShader(GLenum shaderType, GLsizei count, const GLchar** source)
 {
 	const unsigned int shader = qglCreateShader(shaderType);
 	CHECK(shader != 0, "Failed to create shader");
-	qglShaderSource(shader, 1, source, NULL);
+	qglShaderSource(shader, count, source, NULL);
 	qglCompileShader(shader);
 
 	int success;
@@ -248,8 +253,13 @@ unsigned int _VR_CreateVaoAndProgram(
 	qglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *EBO);
 	qglBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
 	// Shaders
-	unsigned int vertexShader = _VR_CreateAndCompileShader(GL_VERTEX_SHADER, &vertexShaderSrc);
-	unsigned int fragmentShader = _VR_CreateAndCompileShader(GL_FRAGMENT_SHADER, &framgnetShaderSrc);
+	const GLchar* vertexShaderSrcs[2] =
+	{
+		qglFramebufferTextureMultiviewOVR ? multiviewShaderHeader : singleViewShaderHeader,
+		vertexShaderSrc,
+	};
+	unsigned int vertexShader = _VR_CreateAndCompileShader(GL_VERTEX_SHADER, 2, vertexShaderSrcs);
+	unsigned int fragmentShader = _VR_CreateAndCompileShader(GL_FRAGMENT_SHADER, 1, &framgnetShaderSrc);
 	unsigned int shaderProgram = _VR_CreateAndLinkShaderProgram(vertexShader, fragmentShader);
 	qglDeleteShader(vertexShader);
 	qglDeleteShader(fragmentShader);
@@ -502,7 +512,7 @@ void VR_VirtualScreen_ResetPosition(void)
 	updateTarget = 1;
 }
 
-void VR_VirtualScreen_Draw(XrFovf fov, XrPosef* left, XrPosef* right, GLuint virtualScreenImage)
+void VR_VirtualScreen_Draw(XrFovf fov, XrPosef* left, XrPosef* right, GLuint virtualScreenImage, int viewIndex)
 {
 	GLuint previousVAO, previousProgram, previousTexture;
 	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&previousVAO);
@@ -552,6 +562,10 @@ void VR_VirtualScreen_Draw(XrFovf fov, XrPosef* left, XrPosef* right, GLuint vir
 		qglUniformMatrix4fv(viewLoc + 1, 1, GL_FALSE, (float*)view[1].m);
 		qglUniformMatrix4fv(projLoc, 1, GL_FALSE, (float*)projection.m);
 		qglUniform3f(cameraLoc, left->position.x, left->position.y, left->position.z);
+		if (!qglFramebufferTextureMultiviewOVR)
+		{
+			qglUniform1i(qglGetUniformLocation(floorShaderProgram, "viewIndex"), viewIndex);
+		}
 
 		glDrawElements(GL_TRIANGLES, quadIndexCount, GL_UNSIGNED_INT, 0);
 	}
@@ -574,6 +588,10 @@ void VR_VirtualScreen_Draw(XrFovf fov, XrPosef* left, XrPosef* right, GLuint vir
 		qglUniformMatrix4fv(viewLoc + 0, 1, GL_FALSE, (float*)view[0].m);
 		qglUniformMatrix4fv(viewLoc + 1, 1, GL_FALSE, (float*)view[1].m);
 		qglUniformMatrix4fv(projLoc, 1, GL_FALSE, (float*)projection.m);
+		if (!qglFramebufferTextureMultiviewOVR)
+		{
+			qglUniform1i(qglGetUniformLocation(vsShaderProgram, "viewIndex"), viewIndex);
+		}
 
 		glBindTexture(GL_TEXTURE_2D, virtualScreenImage);
 		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
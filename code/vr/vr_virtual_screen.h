@@ -12,7 +12,8 @@
 void VR_VirtualScreen_Init(void);
 void VR_VirtualScreen_Destroy(void);
 void VR_VirtualScreen_ResetPosition(void);
-void VR_VirtualScreen_Draw(XrFovf fov, XrPosef* left, XrPosef* right, GLuint virtualScreenImage);
+// viewIndex is the eye being drawn when there is no multiview
+void VR_VirtualScreen_Draw(XrFovf fov, XrPosef* left, XrPosef* right, GLuint virtualScreenImage, int viewIndex);
 float VR_VirtualScreen_GetCurrentYaw(void);
 
 #endif